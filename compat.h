@@ -2,4 +2,5 @@
 #include <assert.h>
 # define luaL_newlib(L,l) (lua_newtable(L), luaL_register(L,NULL,l))
 # define luaL_setfuncs(L,l,n) (assert(n==0), luaL_register(L,NULL,l))
+# define lua_rawlen(L,i) lua_objlen(L,i)
 #endif
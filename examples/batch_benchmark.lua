@@ -0,0 +1,86 @@
+#!/usr/bin/env lua
+
+--[[
+ @filename  batch_benchmark.lua
+ @version   1.0
+ @licence   MIT licence
+
+ Compares drawing a chart-like page (a grid of lines, a set of bars and
+ their labels) with one call per element against the batch calls
+ add_lines, add_rects and add_texts, which take flat arrays and draw
+ everything in a single call.
+]]--
+
+local pdfgen = require("../pdfgen")
+
+PDF_LETTER_WIDTH  =  612.0
+PDF_LETTER_HEIGHT = 792.0
+
+local grey = pdfgen.rgb(200, 200, 200)
+local blue = pdfgen.rgb(0, 0, 255)
+local black = pdfgen.rgb(0, 0, 0)
+
+-- Build the page contents once, as flat arrays, so both runs draw
+-- exactly the same thing
+local lines, rects, texts = {}, {}, {}
+for x = 0, PDF_LETTER_WIDTH, 4 do
+  for _, v in ipairs({x, 0, x, PDF_LETTER_HEIGHT}) do lines[#lines + 1] = v end
+end
+for y = 0, PDF_LETTER_HEIGHT, 4 do
+  for _, v in ipairs({0, y, PDF_LETTER_WIDTH, y}) do lines[#lines + 1] = v end
+end
+for i = 0, 99 do
+  local x, h = 30 + i * 5.5, 50 + (i * 37) % 600
+  for _, v in ipairs({x, 60, 4, h}) do rects[#rects + 1] = v end
+  for _, v in ipairs({tostring(h), x, 50}) do texts[#texts + 1] = v end
+end
+
+local function single(pdf)
+  for i = 1, #lines, 4 do
+    pdf:add_line(nil, lines[i], lines[i + 1], lines[i + 2], lines[i + 3],
+                 0.1, grey)
+  end
+  for i = 1, #rects, 4 do
+    pdf:add_filled_rectangle(nil, rects[i], rects[i + 1], rects[i + 2],
+                             rects[i + 3], 0, blue, blue)
+  end
+  for i = 1, #texts, 3 do
+    pdf:add_text(nil, texts[i], 4, texts[i + 1], texts[i + 2], black)
+  end
+end
+
+local function batch(pdf)
+  pdf:add_lines(nil, lines, 0.1, grey)
+  pdf:add_rects(nil, rects, 0, blue, blue)
+  pdf:add_texts(nil, texts, 4, black)
+end
+
+local function run(draw, pagecount)
+  local pdf = pdfgen:new()
+  pdf:create(PDF_LETTER_WIDTH, PDF_LETTER_HEIGHT)
+  pdf:set_font("Helvetica")
+
+  local start = os.clock()
+  for i = 1, pagecount do
+    pdf:append_page()
+    draw(pdf)
+  end
+  local added = os.clock()
+  local data = pdf:tostring()
+  local saved = os.clock()
+  pdf:destroy()
+
+  return added - start, saved - added, #data
+end
+
+print(("%d lines, %d rectangles & %d labels per page"):format(
+  #lines / 4, #rects / 4, #texts / 3))
+print("mode      pages   add (us/page)  save (us/page)  bytes")
+for _, pagecount in ipairs({100, 200, 400}) do
+  for _, mode in ipairs({"single", "batch"}) do
+    local add, save, size = run(mode == "single" and single or batch,
+                                pagecount)
+    print(("%-9s %-7d %-14.1f %-15.1f %d"):format(
+      mode, pagecount, add * 1e6 / pagecount, save * 1e6 / pagecount, size))
+  end
+end
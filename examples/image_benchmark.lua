@@ -0,0 +1,47 @@
+#!/usr/bin/env lua
+
+--[[
+ @filename  image_benchmark.lua
+ @version   1.0
+ @licence   MIT licence
+
+ Checks that adding and saving images scales linearly: the document is
+ built with an increasing number of pages, each drawing every image in
+ data/, and the time per page should stay roughly constant.
+]]--
+
+local pdfgen = require("../pdfgen")
+
+PDF_LETTER_WIDTH  =  612.0
+PDF_LETTER_HEIGHT = 792.0
+
+local images = {
+  "data/penguin.jpg", "data/grey.jpg", "data/coal.png", "data/grey.png",
+  "data/indexed.png", "data/bee.bmp", "data/bee.pgm", "data/teapot.ppm",
+}
+
+local function run(pagecount)
+  local pdf = pdfgen:new()
+  pdf:create(PDF_LETTER_WIDTH, PDF_LETTER_HEIGHT)
+
+  local start = os.clock()
+  for i = 1, pagecount do
+    pdf:append_page()
+    for j, image in ipairs(images) do
+      pdf:add_image_file(nil, 60 * j, 500, 50, -1, image)
+    end
+  end
+  local added = os.clock()
+  local data = pdf:tostring()
+  local saved = os.clock()
+  pdf:destroy()
+
+  return added - start, saved - added, #data
+end
+
+print("pages     add (us/page)  save (us/page)  bytes")
+for _, pagecount in ipairs({1000, 2000, 4000, 8000, 16000}) do
+  local add, save, size = run(pagecount)
+  print(("%-9d %-14.1f %-15.1f %d"):format(
+    pagecount, add * 1e6 / pagecount, save * 1e6 / pagecount, size))
+end
@@ -0,0 +1,67 @@
+#!/usr/bin/env lua
+
+--[[
+ @filename  reset_benchmark.lua
+ @version   1.0
+ @licence   MIT licence
+
+ Compares generating many small documents (such as one per request in a
+ server) with a new document object for each one, against a single
+ document which is reset between them, re-using its memory.
+]]--
+
+local pdfgen = require("../pdfgen")
+
+PDF_LETTER_WIDTH  =  612.0
+PDF_LETTER_HEIGHT = 792.0
+
+local black = pdfgen.rgb(0, 0, 0)
+
+local function draw(pdf, n)
+  pdf:set_font("Helvetica")
+  pdf:append_page()
+  pdf:add_text(nil, "Invoice " .. n, 18, 50, 720, black)
+  for i = 1, 20 do
+    pdf:add_text(nil, ("Item %d ........ %d.00"):format(i, i * 3), 10, 50,
+                 680 - i * 14, black)
+  end
+  pdf:add_line(nil, 50, 380, 560, 380, 1, black)
+  pdf:add_barcode(nil, 0, 50, 300, 200, 50, "INV" .. n, black)
+end
+
+-- Each document is written out through save_to, so that only building the
+-- document is compared, rather than also the strings from tostring
+local function discard(chunk) end
+
+local function fresh(count)
+  for n = 1, count do
+    local pdf = pdfgen:new()
+    pdf:create(PDF_LETTER_WIDTH, PDF_LETTER_HEIGHT)
+    draw(pdf, n)
+    pdf:save_to(discard)
+    pdf:destroy()
+  end
+end
+
+local function reuse(count)
+  local pdf = pdfgen:new()
+  pdf:create(PDF_LETTER_WIDTH, PDF_LETTER_HEIGHT)
+  for n = 1, count do
+    if n > 1 then
+      pdf:reset(PDF_LETTER_WIDTH, PDF_LETTER_HEIGHT)
+    end
+    draw(pdf, n)
+    pdf:save_to(discard)
+  end
+  pdf:destroy()
+end
+
+print("mode      documents  us/document")
+for _, count in ipairs({1000, 5000, 20000}) do
+  for _, mode in ipairs({"fresh", "reuse"}) do
+    local start = os.clock()
+    if mode == "fresh" then fresh(count) else reuse(count) end
+    local elapsed = os.clock() - start
+    print(("%-9s %-10d %.1f"):format(mode, count, elapsed * 1e6 / count))
+  end
+end
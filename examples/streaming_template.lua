@@ -0,0 +1,58 @@
+#!/usr/bin/env lua
+
+--[[
+ @filename  streaming_template.lua
+ @version   1.0
+ @licence   MIT licence
+
+ Checks when a template is written out in a streaming document which is
+ flushed while the template is still being recorded: not by that flush,
+ but as soon as the template has been ended, and only once.
+]]--
+
+local pdfgen = require("pdfgen")
+
+PDF_LETTER_WIDTH  =  612.0
+PDF_LETTER_HEIGHT = 792.0
+
+local filename = "streaming_template.pdf"
+local black = pdfgen.rgb(0, 0, 0)
+
+-- Number of Form XObjects written to the file so far
+local function forms_written()
+  local f = assert(io.open(filename, "rb"))
+  local data = f:read("a")
+  f:close()
+  local count = 0
+  for _ in data:gmatch("/Subtype /Form") do
+    count = count + 1
+  end
+  return count
+end
+
+local pdf = pdfgen:new()
+assert(pdf:create_streaming(filename, PDF_LETTER_WIDTH, PDF_LETTER_HEIGHT))
+pdf:set_font("Helvetica")
+pdf:append_page()
+pdf:add_text(nil, "Page 1", 18, 50, 720, black)
+
+local template = assert(pdf:begin_template(200, 200))
+-- Plenty of content, so the template isn't left sitting in the file's
+-- buffer once it has been written
+for i = 1, 2000 do
+  pdf:add_line(nil, 0, i % 200, 200, (i * 7) % 200, 0.1, black)
+end
+
+assert(pdf:flush())
+assert(forms_written() == 0, "template written while being recorded")
+
+assert(pdf:end_template())
+assert(forms_written() == 1, "template not written once ended")
+
+local page = pdf:append_page()
+assert(pdf:place_template(page, template, 50, 50))
+assert(pdf:save())
+assert(forms_written() == 1, "template written more than once")
+pdf:destroy()
+os.remove(filename)
+print("ok")
@@ -48,17 +48,27 @@
 #include "pdfgen.h"
 
 #define PDFGEN "PDFGEN"
+#define PDFGEN_TEXT_LAYOUT "PDFGEN_TEXT_LAYOUT"
 
 typedef struct ctx_t{
   lua_State *L ;
   struct pdf_doc *pdf;
   struct pdf_info info;
+  FILE *fp; /* Output file of a streaming document */
 } ctx_t;
 
 static ctx_t * ctx_check(lua_State *L, int i) {
 	return (ctx_t *) luaL_checkudata(L, i, PDFGEN);
 }
 
+typedef struct layout_t{
+  struct pdf_text_layout *layout;
+} layout_t;
+
+static layout_t * layout_check(lua_State *L, int i) {
+	return (layout_t *) luaL_checkudata(L, i, PDFGEN_TEXT_LAYOUT);
+}
+
 /**
  * Initializes the library
  * @function new
@@ -67,6 +77,8 @@ static ctx_t * ctx_check(lua_State *L, int i) {
 static int l_new (lua_State *L) {
   ctx_t *ctx = (ctx_t *)lua_newuserdata(L, sizeof(ctx_t));
   ctx->L = L;
+  ctx->pdf = NULL;
+  ctx->fp = NULL;
   luaL_getmetatable(L, PDFGEN);
   lua_setmetatable(L, -2);
   return 1;
@@ -79,34 +91,31 @@ static int l_new (lua_State *L) {
  * @param height Height of the page
  * @param table info Optional information to be put into the PDF header
  */
-static int l_pdf_create( lua_State * L ) {
-  ctx_t *ctx = ctx_check(L, 1);
+static void get_info( lua_State * L, int idx, ctx_t *ctx ) {
   char *creator  = "IspCore";
   char *producer = "IspCore";
   char *title    = "Default";
   char *author   = "IspCore";
   char *subject  = "Test";
   char *date     = "Default";
-  float width    = luaL_checknumber(L, 2);
-  float height   = luaL_checknumber(L, 3);
 
-  if ( lua_istable(L, 4) ) {
-    lua_getfield(L, 4, "creator");
+  if ( lua_istable(L, idx) ) {
+    lua_getfield(L, idx, "creator");
       creator = (char *)luaL_checkstring(L, -1);
     lua_pop(L, 1);
-    lua_getfield(L, 4, "producer");
+    lua_getfield(L, idx, "producer");
       producer = (char *)luaL_checkstring(L, -1);
     lua_pop(L, 1);
-    lua_getfield(L, 4, "title");
+    lua_getfield(L, idx, "title");
       title = (char *)luaL_checkstring(L, -1);
     lua_pop(L, 1);
-    lua_getfield(L, 4, "author");
+    lua_getfield(L, idx, "author");
       author = (char *)luaL_checkstring(L, -1);
     lua_pop(L, 1);
-    lua_getfield(L, 4, "subject");
+    lua_getfield(L, idx, "subject");
       subject = (char *)luaL_checkstring(L, -1);
     lua_pop(L, 1);
-    lua_getfield(L, 4, "date");
+    lua_getfield(L, idx, "date");
       date = (char *)luaL_checkstring(L, -1);
     lua_pop(L, 1);
   }
@@ -117,6 +126,14 @@ static int l_pdf_create( lua_State * L ) {
   strcpy( ctx->info.author, author );
   strcpy( ctx->info.subject, subject );
   strcpy( ctx->info.date, date );
+}
+
+static int l_pdf_create( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  float width    = luaL_checknumber(L, 2);
+  float height   = luaL_checknumber(L, 3);
+
+  get_info(L, 4, ctx);
 
   ctx->pdf = pdf_create(width,height, &ctx->info);
 
@@ -126,13 +143,136 @@ static int l_pdf_create( lua_State * L ) {
   return 1;
 }
 
+/**
+ * Empty the document, so that it can be used to generate another one as
+ * though it had just been created. Memory allocated by the document is
+ * re-used, so this is quicker than creating a new document for each one.
+ * Pages & templates from before the reset must not be used again.
+ * Streaming documents can't be reset.
+ * @function reset
+ * @param width Width of the page
+ * @param height Height of the page
+ * @param table info Optional information to be put into the PDF header
+ * @treturn boolean false on failure, true on success
+ */
+static int l_pdf_reset( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  float width    = luaL_checknumber(L, 2);
+  float height   = luaL_checknumber(L, 3);
+
+  get_info(L, 4, ctx);
+
+  lua_pushboolean(L, pdf_reset(ctx->pdf, width, height, &ctx->info) >= 0);
+  return 1;
+}
+
+/**
+ * Create a new streaming PDF object, with the given page width/height.
+ * Each page is written to the file, and freed, as soon as the next page
+ * is appended (or flush is called), so memory use does not grow with the
+ * number of pages. Pages which have been written can no longer be drawn on.
+ * The document is completed by calling save.
+ * @function create_streaming
+ * @param filename Name of the file to write the PDF into
+ * @param width Width of the page
+ * @param height Height of the page
+ * @param table info Optional information to be put into the PDF header
+ * @treturn boolean false on failure, true on success
+ */
+static int l_pdf_create_streaming( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  char const * filename = luaL_checkstring(L, 2);
+  float width    = luaL_checknumber(L, 3);
+  float height   = luaL_checknumber(L, 4);
+
+  get_info(L, 5, ctx);
+
+  ctx->fp = fopen(filename, "wb");
+  if ( ctx->fp == NULL ){
+    lua_pushboolean(L, 0);
+    return 1;
+  }
+  ctx->pdf = pdf_create_streaming(width, height, &ctx->info, ctx->fp);
+  if ( ctx->pdf == NULL ){
+    fclose(ctx->fp);
+    ctx->fp = NULL;
+    lua_pushboolean(L, 0);
+    return 1;
+  }
+
+  lua_pushboolean(L, 1);
+  return 1;
+}
+
+/**
+ * Write out all pages of a streaming document, including the current one.
+ * No further drawing is possible on those pages.
+ * @function flush
+ * @treturn boolean false on failure, true on success
+ */
+static int l_pdf_flush( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  int result = pdf_flush(ctx->pdf);
+  if ( result < 0 ){
+    lua_pushboolean(L, 0);
+  }else{
+    lua_pushboolean(L, 1);
+  }
+
+  return 1;
+}
+
+/**
+ * Enable FlateDecode compression of page content streams and raw
+ * (RGB/grayscale/PPM/BMP) images.
+ * Content streams are compressed when the document is saved, images as
+ * they are added. Compression is disabled by default.
+ * @function set_compression
+ * @param level Compression level, 0 (disabled) to 9 (smallest output)
+ * @treturn boolean false on failure, true on success
+ */
+static int l_pdf_set_compression( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  int level = luaL_checkinteger(L, 2);
+  int result = pdf_set_compression(ctx->pdf, level);
+  if ( result < 0 ){
+    lua_pushboolean(L, 0);
+  }else{
+    lua_pushboolean(L, 1);
+  }
+
+  return 1;
+}
+
+/**
+ * Enable kerning of text in the standard PDF fonts, using the kerning
+ * pairs from their Adobe font metrics. Text drawn, measured or wrapped
+ * after this call is kerned. Kerning is disabled by default.
+ * @function set_kerning
+ * @param kerning true to enable kerning, false to disable it
+ * @treturn boolean false on failure, true on success
+ */
+static int l_pdf_set_kerning( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  int kerning = lua_toboolean(L, 2);
+  int result = pdf_set_kerning(ctx->pdf, kerning);
+  if ( result < 0 ){
+    lua_pushboolean(L, 0);
+  }else{
+    lua_pushboolean(L, 1);
+  }
+
+  return 1;
+}
+
 /**
  * Sets the font to use for text objects. Default value is Times-Roman if
  * this function is not called.
  * Note: The font selection should be done before text is output,
  * and will remain until pdf_set_font is called again.
  * @function set_font
- * @param font New font to use. This must be one of the standard PDF fonts:
+ * @param font New font to use, either a handle returned by font or
+ *  load_font, or one of the standard PDF fonts:
  *  Courier, Courier-Bold, Courier-BoldOblique, Courier-Oblique,
  *  Helvetica, Helvetica-Bold, Helvetica-BoldOblique, Helvetica-Oblique,
  *  Times-Roman, Times-Bold, Times-Italic, Times-BoldItalic,
@@ -141,8 +281,12 @@ static int l_pdf_create( lua_State * L ) {
  */
 static int l_pdf_set_font( lua_State * L ) {
   ctx_t *ctx = ctx_check(L, 1);
-  char const  * font  = luaL_checkstring(L, 2);
-  int result = pdf_set_font(ctx->pdf, font);
+  int result;
+  if ( lua_type(L, 2) == LUA_TNUMBER ) {
+    result = pdf_set_font_handle(ctx->pdf, luaL_checkinteger(L, 2));
+  }else{
+    result = pdf_set_font(ctx->pdf, luaL_checkstring(L, 2));
+  }
   if ( result < 0 ){
     lua_pushboolean(L, 0);
   }else{
@@ -152,6 +296,47 @@ static int l_pdf_set_font( lua_State * L ) {
   return 1;
 }
 
+/**
+ * Retrieve a handle for a font, adding it to the document if needed.
+ * Passing the handle to set_font is cheaper than passing the font name.
+ * @function font
+ * @param font Name of the font, as for set_font
+ * @treturn mixed false on failure, the font handle on success
+ */
+static int l_pdf_font( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  char const  * font  = luaL_checkstring(L, 2);
+  int result = pdf_get_font_handle(ctx->pdf, font);
+  if ( result < 0 ){
+    lua_pushboolean(L, 0);
+  }else{
+    lua_pushinteger(L, result);
+  }
+
+  return 1;
+}
+
+/**
+ * Load a TrueType font file, to be embedded in the document.
+ * Only the glyphs that are drawn are embedded, and text in the font may use
+ * any Unicode character the font has a glyph for.
+ * @function load_font
+ * @param filename Filename of the TrueType (.ttf) font
+ * @treturn mixed false on failure, the font handle on success
+ */
+static int l_pdf_load_font( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  char const  * filename  = luaL_checkstring(L, 2);
+  int result = pdf_add_font_file(ctx->pdf, filename);
+  if ( result < 0 ){
+    lua_pushboolean(L, 0);
+  }else{
+    lua_pushinteger(L, result);
+  }
+
+  return 1;
+}
+
 /**
  * Calculate the width of a given string in the current font
  * @function get_font_text_width
@@ -185,6 +370,29 @@ static int l_pdf_get_font_text_width( lua_State * L ) {
   return 1;
 }
 
+/* Copy the flat array of numbers at idx into a scratch userdata, so the
+ * whole batch can be handed to pdfgen in one call. The array length must
+ * be a multiple of stride, and count is set to the number of entries
+ * (length / stride). The userdata is pushed on top of the stack, so this
+ * must be called after all other arguments have been read. */
+static float * get_numbers( lua_State * L, int idx, int stride, int *count ) {
+  luaL_checktype(L, idx, LUA_TTABLE);
+  size_t len = lua_rawlen(L, idx);
+  luaL_argcheck(L, len % stride == 0, idx, "incomplete entry in array");
+
+  float *values = (float *)lua_newuserdata(L, len * sizeof(float));
+  for ( size_t i = 0; i < len; i++ ) {
+    lua_rawgeti(L, idx, i + 1);
+    luaL_argcheck(L, lua_isnumber(L, -1), idx,
+      "array entries must be numbers");
+    values[i] = lua_tonumber(L, -1);
+    lua_pop(L, 1);
+  }
+  *count = len / stride;
+
+  return values;
+}
+
 /**
  * Add a text string to the document
  * @function add_text
@@ -333,6 +541,117 @@ static int l_pdf_add_line( lua_State * L ) {
   return 1;
 }
 
+/**
+ * Add a set of lines to the document, drawn as a single path.
+ * This is much faster than calling add_line for each one
+ * @function add_lines
+ * @param page Page to add object to (NULL => most recently added page)
+ * @param points Flat array of line coordinates: {x1, y1, x2, y2, ...}
+ * @param width Width of the lines
+ * @param colour Colour to draw the lines
+ * @treturn boolean true success, false on failure
+ */
+static int l_pdf_add_lines( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  struct pdf_object *page = NULL;
+  if ( lua_islightuserdata(L, 2) ){
+    page = lua_touserdata(L, 2);
+  }
+  float width  = luaL_checknumber(L, 4);
+  uint32_t colour= luaL_checknumber(L, 5);
+  int count;
+  float *points = get_numbers(L, 3, 4, &count);
+
+  int result = pdf_add_lines(ctx->pdf,page,points,count,width,colour);
+  if ( result == 0 ){
+    lua_pushboolean(L, 1);
+  }else{
+    lua_pushboolean(L, 0);
+  }
+
+  return 1;
+}
+
+/**
+ * Add a set of rectangles to the document, drawn as a single path.
+ * This is much faster than calling add_rectangle for each one
+ * @function add_rects
+ * @param page Page to add object to (NULL => most recently added page)
+ * @param rects Flat array of rectangles: {x, y, width, height, ...}
+ * @param border_width Width of rectangle borders
+ * @param colour Colour to draw the rectangle borders
+ * @param colour_fill Optional colour to fill the rectangles
+ * @treturn boolean true success, false on failure
+ */
+static int l_pdf_add_rects( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  struct pdf_object *page = NULL;
+  if ( lua_islightuserdata(L, 2) ){
+    page = lua_touserdata(L, 2);
+  }
+  float border_width  = luaL_checknumber(L, 4);
+  uint32_t colour= luaL_checknumber(L, 5);
+  uint32_t colour_fill= luaL_optnumber(L, 6, PDF_TRANSPARENT);
+  int count;
+  float *rects = get_numbers(L, 3, 4, &count);
+
+  int result = pdf_add_rectangles(
+    ctx->pdf,page,rects,count,border_width,colour,colour_fill
+  );
+  if ( result == 0 ){
+    lua_pushboolean(L, 1);
+  }else{
+    lua_pushboolean(L, 0);
+  }
+
+  return 1;
+}
+
+/**
+ * Add a set of text strings to the document, all in the same size and
+ * colour, with a single call
+ * @function add_texts
+ * @param page Page to add object to (NULL => most recently added page)
+ * @param texts Flat array of strings and positions: {text, x, y, ...}
+ * @param size Point size of the font
+ * @param colour Colour to draw the text
+ * @treturn boolean true on success, false on failure
+ */
+static int l_pdf_add_texts( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  struct pdf_object *page = NULL;
+  if ( lua_islightuserdata(L, 2) ){
+    page = lua_touserdata(L, 2);
+  }
+  luaL_checktype(L, 3, LUA_TTABLE);
+  size_t len = lua_rawlen(L, 3);
+  float size  = luaL_checknumber(L, 4);
+  uint32_t colour= luaL_checknumber(L, 5);
+  luaL_argcheck(L, len % 3 == 0, 3, "incomplete entry in array");
+
+  int result = 0;
+  for ( size_t i = 1; i <= len && result == 0; i += 3 ) {
+    lua_rawgeti(L, 3, i);
+    lua_rawgeti(L, 3, i + 1);
+    lua_rawgeti(L, 3, i + 2);
+    luaL_argcheck(L,
+      lua_isstring(L, -3) && lua_isnumber(L, -2) && lua_isnumber(L, -1), 3,
+      "entries must be {text, x, y, ...}");
+    const char *text = lua_tostring(L, -3);
+    float xoff = lua_tonumber(L, -2);
+    float yoff = lua_tonumber(L, -1);
+    result = pdf_add_text(ctx->pdf,page,text,size,xoff,yoff,colour);
+    lua_pop(L, 3);
+  }
+  if ( result == 0 ){
+    lua_pushboolean(L, 1);
+  }else{
+    lua_pushboolean(L, 0);
+  }
+
+  return 1;
+}
+
 /**
  * Add an image file as an image to the document.
  * Passing 0 for either the display width or height will
@@ -374,6 +693,82 @@ static int l_pdf_add_image_file( lua_State * L ) {
   return 1;
 }
 
+/**
+ * Start recording a template, which can then be placed on any number of
+ * pages. Until end_template is called, drawing with a nil page is
+ * recorded into the template.
+ * @function begin_template
+ * @param width Width of the template
+ * @param height Height of the template
+ * @return nil on failure, template object on success
+ */
+static int l_pdf_begin_template( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  float width   = luaL_checknumber(L, 2);
+  float height  = luaL_checknumber(L, 3);
+
+  struct pdf_object *tmpl = pdf_begin_template(ctx->pdf,width,height);
+  if ( !tmpl ){
+    lua_pushnil(L);
+  }else{
+    lua_pushlightuserdata(L, tmpl);
+  }
+
+  return 1;
+}
+
+/**
+ * Finish recording the current template
+ * @function end_template
+ * @treturn boolean true success, false on failure
+ */
+static int l_pdf_end_template( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+
+  int result = pdf_end_template(ctx->pdf);
+  if ( result == 0 ){
+    lua_pushboolean(L, 1);
+  }else{
+    lua_pushboolean(L, 0);
+  }
+
+  return 1;
+}
+
+/**
+ * Draw a recorded template on a page
+ * @function place_template
+ * @param page Page to draw on (NULL => most recently added page)
+ * @param template Template from begin_template
+ * @param x X offset to put the template at
+ * @param y Y offset to put the template at
+ * @param scale Optional scale factor (default 1)
+ * @param angle Optional rotation angle, in radians (default 0)
+ * @treturn boolean true success, false on failure
+ */
+static int l_pdf_place_template( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  struct pdf_object *page = NULL;
+  if ( lua_islightuserdata(L, 2) ){
+    page = lua_touserdata(L, 2);
+  }
+  luaL_checktype(L, 3, LUA_TLIGHTUSERDATA);
+  struct pdf_object *tmpl = lua_touserdata(L, 3);
+  float x      = luaL_checknumber(L, 4);
+  float y      = luaL_checknumber(L, 5);
+  float scale  = luaL_optnumber(L, 6, 1);
+  float angle  = luaL_optnumber(L, 7, 0);
+
+  int result = pdf_place_template(ctx->pdf,page,tmpl,x,y,scale,angle);
+  if ( result == 0 ){
+    lua_pushboolean(L, 1);
+  }else{
+    lua_pushboolean(L, 0);
+  }
+
+  return 1;
+}
+
 /**
  * Add a bookmark to the document
  * @function add_bookmark 
@@ -484,6 +879,18 @@ static int l_pdf_get_page( lua_State * L ) {
   return 1;
 }
 
+/**
+ * Retrieve the number of pages in the document
+ * @function page_count
+ * @treturn number number of pages added via append_page
+ */
+static int l_pdf_page_count( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  lua_pushinteger(L, pdf_page_count(ctx->pdf));
+
+  return 1;
+}
+
 /***
  * Adjust the width/height of a specific page
  * @function page_set_size
@@ -558,6 +965,140 @@ static int l_pdf_add_text_wrap( lua_State * L ) {
   return 1;
 }
 
+/**
+ * Break text into lines in the current font, without drawing it.
+ * The returned layout has methods height(), line_count() and lines(),
+ * and can be drawn any number of times with add_text_layout.
+ * @function layout_text
+ * @param text String to lay out
+ * @param size Point size of the font
+ * @param wrap_width Width at which to wrap the text
+ * @treturn mixed false on failure, the text layout on success
+ */
+static int l_pdf_layout_text( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  const char *text = luaL_checkstring(L, 2);
+  float size       = luaL_checknumber(L, 3);
+  float wrap_width = luaL_checknumber(L, 4);
+  layout_t *lt = (layout_t *)lua_newuserdata(L, sizeof(layout_t));
+
+  lt->layout = NULL;
+  luaL_getmetatable(L, PDFGEN_TEXT_LAYOUT);
+  lua_setmetatable(L, -2);
+
+  lt->layout = pdf_create_text_layout(ctx->pdf, text, size, wrap_width);
+  if ( lt->layout == NULL ){
+    lua_pushboolean(L, 0);
+  }
+
+  return 1;
+}
+
+/**
+ * Add text laid out by layout_text to the document
+ * @function add_text_layout
+ * @param page Page to add object to (NULL => most recently added page)
+ * @param layout Text layout to draw
+ * @param xoff X location to put it in
+ * @param yoff Y location to put it in
+ * @param angle Rotation angle of text (in radians)
+ * @param colour Colour to draw the text
+ * @param align Text alignment (see PDF_ALIGN_xxx)
+ * @treturn boolean true on success, false on failure
+ */
+static int l_pdf_add_text_layout( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  struct pdf_object *page = NULL;
+  if ( lua_islightuserdata(L, 2) ){
+    page = lua_touserdata(L, 2);
+  }
+  layout_t *lt     = layout_check(L, 3);
+  float xoff       = luaL_checknumber(L, 4);
+  float yoff       = luaL_checknumber(L, 5);
+  float angle      = luaL_checknumber(L, 6);
+  uint32_t colour  = luaL_checknumber(L, 7);
+  int align        = luaL_checkinteger(L, 8);
+
+  luaL_argcheck(L, lt->layout != NULL, 3, "text layout has been freed");
+  int result = pdf_add_text_layout(
+    ctx->pdf,page,lt->layout,xoff,yoff,angle,colour,align
+  );
+  if ( result < 0 ){
+    lua_pushboolean(L, 0);
+  }else{
+    lua_pushboolean(L, 1);
+  }
+
+  return 1;
+}
+
+/**
+ * Retrieve the height of a text layout
+ * @function layout:height
+ * @treturn number height of the text
+ */
+static int l_layout_height( lua_State * L ) {
+  layout_t *lt = layout_check(L, 1);
+  luaL_argcheck(L, lt->layout != NULL, 1, "text layout has been freed");
+  lua_pushnumber(L, pdf_text_layout_height(lt->layout));
+
+  return 1;
+}
+
+/**
+ * Retrieve the number of lines in a text layout
+ * @function layout:line_count
+ * @treturn number number of lines
+ */
+static int l_layout_line_count( lua_State * L ) {
+  layout_t *lt = layout_check(L, 1);
+  luaL_argcheck(L, lt->layout != NULL, 1, "text layout has been freed");
+  lua_pushinteger(L, pdf_text_layout_line_count(lt->layout));
+
+  return 1;
+}
+
+/**
+ * Retrieve the lines of a text layout. Each line is a table with the
+ * fields offset and length, giving the part of the text it came from
+ * (so text:sub(offset, offset + length - 1) is the line), and width.
+ * @function layout:lines
+ * @treturn table list of lines
+ */
+static int l_layout_lines( lua_State * L ) {
+  layout_t *lt = layout_check(L, 1);
+  luaL_argcheck(L, lt->layout != NULL, 1, "text layout has been freed");
+  int count = pdf_text_layout_line_count(lt->layout);
+
+  lua_createtable(L, count, 0);
+  for ( int i = 0; i < count; i++ ) {
+    struct pdf_text_line line;
+    pdf_text_layout_get_line(lt->layout, i, &line);
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, line.offset + 1);
+    lua_setfield(L, -2, "offset");
+    lua_pushinteger(L, line.length);
+    lua_setfield(L, -2, "length");
+    lua_pushnumber(L, line.width);
+    lua_setfield(L, -2, "width");
+    lua_rawseti(L, -2, i + 1);
+  }
+
+  return 1;
+}
+
+/**
+ * Free a text layout. This is done automatically when it is collected.
+ * @function layout:destroy
+ */
+static int l_layout_destroy( lua_State * L ) {
+  layout_t *lt = layout_check(L, 1);
+  pdf_destroy_text_layout(lt->layout);
+  lt->layout = NULL;
+
+  return 0;
+}
+
 /**
  * Add a text string to the document at a rotated angle
  * @function add_text_rotate
@@ -597,8 +1138,75 @@ static int l_pdf_add_text_rotate( lua_State * L ) {
   return 1;
 }
 
+typedef struct writer_t {
+  lua_State *L;
+  int failed; /* The callback raised an error, which is left on the stack */
+} writer_t;
+
+static int lua_writer( void *user, const void *data, size_t len ) {
+  writer_t *w = (writer_t *)user;
+  lua_State *L = w->L;
+  int ok;
+
+  lua_pushvalue(L, 2);
+  lua_pushlstring(L, (const char *)data, len);
+  if ( lua_pcall(L, 1, 1, 0) != 0 ){
+    w->failed = 1;
+    return -EIO;
+  }
+  /* Returning nothing (or anything but false) means success */
+  ok = lua_isnil(L, -1) || lua_toboolean(L, -1);
+  lua_pop(L, 1);
+  return ok ? 0 : -EIO;
+}
+
+/**
+ * Save the given pdf document by passing it, in chunks, to a function.
+ * This allows the document to be sent to a socket etc... without going via
+ * a temporary file. Errors raised by the function are propagated.
+ * @function save_to
+ * @param writer Function called with each chunk of the document (a string).
+ *  Returning false stops the save.
+ * @treturn boolean false on failure, true on success
+ */
+static int l_pdf_save_to( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  writer_t w = { L, 0 };
+  int result;
+
+  luaL_checktype(L, 2, LUA_TFUNCTION);
+  lua_settop(L, 2);
+  result = pdf_save_writer(ctx->pdf, lua_writer, &w);
+  if ( w.failed ){
+    return lua_error(L);
+  }
+  lua_pushboolean(L, result >= 0);
+  return 1;
+}
+
+/**
+ * Save the given pdf document into a string
+ * @function tostring
+ * @treturn string the PDF document, or nil on failure
+ */
+static int l_pdf_tostring( lua_State * L ) {
+  ctx_t *ctx = ctx_check(L, 1);
+  char *data;
+  size_t len;
+  int result = pdf_save_buffer(ctx->pdf, &data, &len);
+  if ( result < 0 ){
+    lua_pushnil(L);
+    return 1;
+  }
+  lua_pushlstring(L, data, len);
+  free(data);
+  return 1;
+}
+
 /**
  * Save the given pdf document to the supplied filename.
+ * Documents from create_streaming are instead completed, and their file
+ * closed.
  * @function save
  * @param filename Name of the file to store the PDF into (NULL for stdout)
  * @treturn boolean false on failure, true on success
@@ -606,10 +1214,20 @@ static int l_pdf_add_text_rotate( lua_State * L ) {
 static int l_pdf_save( lua_State * L ) {
   ctx_t *ctx = ctx_check(L, 1);
   char const  * filename = NULL;
+  int result;
+  if ( ctx->fp ) {
+    /* Streaming documents are already being written to their file */
+    result = pdf_finish(ctx->pdf);
+    if ( fclose(ctx->fp) != 0 )
+      result = -1;
+    ctx->fp = NULL;
+    lua_pushboolean(L, result >= 0);
+    return 1;
+  }
   if ( lua_isstring(L, 2) ) {
     filename  = luaL_checkstring(L, 2);
   }
-  int result = pdf_save(ctx->pdf, filename);
+  result = pdf_save(ctx->pdf, filename);
   if ( result >= 0 ){
     lua_pushboolean(L, 1);
   }else{
@@ -801,6 +1419,10 @@ static int l_pdf_clear_err( lua_State * L ) {
 static int l_pdf_destroy( lua_State * L ) {
   ctx_t *ctx = ctx_check(L, 1);
   pdf_destroy(ctx->pdf);
+  if ( ctx->fp ) {
+    fclose(ctx->fp);
+    ctx->fp = NULL;
+  }
 
   /* remove all methods operating on ctx */
 	lua_newtable(L);
@@ -809,20 +1431,43 @@ static int l_pdf_destroy( lua_State * L ) {
   return 1;
 }
 
+/**
+ * Free the fonts loaded with load_font that are no longer used by any
+ * document. Loaded fonts are shared by all documents (and Lua states) in
+ * the process, and are otherwise kept for later documents.
+ * @function clear_font_cache
+ */
+static int l_pdf_clear_font_cache( lua_State * L ) {
+  (void)L;
+  pdf_clear_font_cache();
+  return 0;
+}
+
 static const struct luaL_Reg funcs [] = {
   {"new", l_new},
   {"rgb", l_pdf_rgb},
   {"argb", l_pdf_argb},
+  {"clear_font_cache", l_pdf_clear_font_cache},
   {NULL, NULL}
 };
 
 static const struct luaL_Reg meths [] = {
   {"create", l_pdf_create},
+  {"reset", l_pdf_reset},
+  {"create_streaming", l_pdf_create_streaming},
+  {"flush", l_pdf_flush},
   {"set_font", l_pdf_set_font},
+  {"font", l_pdf_font},
+  {"load_font", l_pdf_load_font},
+  {"set_compression", l_pdf_set_compression},
+  {"set_kerning", l_pdf_set_kerning},
   {"append_page", l_pdf_append_page},
   {"add_text", l_pdf_add_text},
   {"add_rectangle", l_pdf_add_rectangle},
   {"add_image_file", l_pdf_add_image_file},
+  {"begin_template", l_pdf_begin_template},
+  {"end_template", l_pdf_end_template},
+  {"place_template", l_pdf_place_template},
   {"height", l_pdf_height},
   {"width", l_pdf_width},
   {"page_width", l_pdf_page_width},
@@ -830,13 +1475,21 @@ static const struct luaL_Reg meths [] = {
   {"add_bookmark", l_pdf_add_bookmark},
   {"add_link", l_pdf_add_link},
   {"get_page", l_pdf_get_page},
+  {"page_count", l_pdf_page_count},
   {"page_set_size", l_pdf_page_set_size},
   {"add_text_wrap", l_pdf_add_text_wrap},
+  {"layout_text", l_pdf_layout_text},
+  {"add_text_layout", l_pdf_add_text_layout},
   {"add_text_rotate", l_pdf_add_text_rotate},
   {"add_filled_rectangle", l_pdf_add_filled_rectangle},
   {"get_font_text_width", l_pdf_get_font_text_width},
   {"add_line", l_pdf_add_line},
+  {"add_lines", l_pdf_add_lines},
+  {"add_rects", l_pdf_add_rects},
+  {"add_texts", l_pdf_add_texts},
   {"save", l_pdf_save},
+  {"tostring", l_pdf_tostring},
+  {"save_to", l_pdf_save_to},
   {"get_err", l_pdf_get_err},
   {"mm_to_point", l_pdf_mm_to_point},
   {"inch_to_point", l_pdf_inch_to_point},
@@ -846,7 +1499,22 @@ static const struct luaL_Reg meths [] = {
   {NULL, NULL}
 };
 
+static const struct luaL_Reg layout_meths [] = {
+  {"height", l_layout_height},
+  {"line_count", l_layout_line_count},
+  {"lines", l_layout_lines},
+  {"destroy", l_layout_destroy},
+  {"__gc", l_layout_destroy},
+  {NULL, NULL}
+};
+
 int luaopen_pdfgen (lua_State *L) {
+  luaL_newmetatable(L, PDFGEN_TEXT_LAYOUT);
+  lua_pushvalue(L, -1);
+  lua_setfield(L, -2, "__index");
+  luaL_setfuncs(L, layout_meths, 0);
+  lua_pop(L, 1);
+
   luaL_newmetatable(L, PDFGEN);
   lua_pushvalue(L, -1);
 
@@ -114,7 +114,6 @@ typedef SSIZE_T ssize_t;
 #include <errno.h>
 #include <inttypes.h>
 #include <limits.h>
-#include <locale.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -125,8 +124,25 @@ typedef SSIZE_T ssize_t;
 #include <sys/stat.h>
 #include <time.h>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define O_BINARY 0
+#endif
+
 #include "pdfgen.h"
 
+#ifdef PDFGEN_USE_ZLIB
+#include <zlib.h>
+#endif
+
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
 #define PDF_RGB_R(c) (float)((((c) >> 16) & 0xff) / 255.0)
@@ -222,16 +238,76 @@ enum {
     OBJ_pages,
     OBJ_image,
     OBJ_link,
+    OBJ_resources,
+    OBJ_font_part,
+    OBJ_template,
 
     OBJ_count,
 };
 
+/**
+ * Resource dictionaries shared between all pages. Pages without images
+ * refer to RESOURCES_PAGE, while pages with images have their own
+ * dictionary, which refers to the shared font & ExtGState dictionaries.
+ */
+enum {
+    RESOURCES_FONTS,     /* Every font in the document */
+    RESOURCES_EXTGSTATE, /* Transparency levels */
+    RESOURCES_PAGE,      /* Fonts & ExtGState, with no XObjects */
+
+    RESOURCES_count,
+};
+
+/**
+ * Objects making up an embedded TrueType font, besides the Type0 font
+ * dictionary itself
+ */
+enum {
+    FONT_PART_CIDFONT,    /* CIDFontType2 dictionary, with the widths */
+    FONT_PART_DESCRIPTOR, /* Font descriptor */
+    FONT_PART_FILE,       /* Subset of the font file */
+    FONT_PART_TO_UNICODE, /* CMap from glyphs back to the text */
+
+    FONT_PART_count,
+};
+
+/**
+ * Tables copied from a TrueType font into its embedded subset, in the
+ * (sorted by tag) order they are written
+ */
+enum {
+    TTF_CVT,
+    TTF_FPGM,
+    TTF_GLYF,
+    TTF_HEAD,
+    TTF_HHEA,
+    TTF_HMTX,
+    TTF_LOCA,
+    TTF_MAXP,
+    TTF_PREP,
+
+    TTF_TABLE_count,
+};
+
 struct flexarray {
     void ***bins;
     int item_count;
     int bin_count;
 };
 
+/**
+ * Short list of objects belonging to another object, such as the links on
+ * a page. Most hold only a handful of entries, so rather than starting
+ * with a large flexarray bin, the list grows geometrically from a few.
+ * Entries are allocated from the document's arena, so are never freed
+ * individually.
+ */
+struct objlist {
+    struct pdf_object **items;
+    int count;
+    int alloc_count;
+};
+
 /**
  * Simple dynamic string object. Tries to store a reasonable amount on the
  * stack before falling back to malloc once things get large
@@ -243,33 +319,51 @@ struct dstr {
     size_t used_len;
 };
 
+/**
+ * Growable byte buffer for data held by objects, such as page content.
+ * Unlike dstr it has no inline storage, so it's cheap to embed in every
+ * object, and it starts small, so short streams don't carry a large
+ * allocation around.
+ */
+struct dbuf {
+    char *data;
+    size_t len;
+    size_t alloc_len;
+};
+
 struct pdf_object {
     int type;                /* See OBJ_xxxx */
     int index;               /* PDF output index */
-    int offset;              /* Byte position within the output file */
+    size_t offset;           /* Byte position within the output file */
     struct pdf_object *prev; /* Previous of this type */
     struct pdf_object *next; /* Next of this type */
     union {
         struct {
             struct pdf_object *page;
-            char name[64];
+            char *name; /* Allocated from the document's arena */
             struct pdf_object *parent;
-            struct flexarray children;
+            struct objlist children;
         } bookmark;
         struct {
-            struct pdf_object *page;
-            struct dstr stream;
+            struct pdf_object *page; /* Owning page (latest listing, for images) */
+            struct dbuf stream;
+            uint32_t width; /* Image dimensions, for cached images */
+            uint32_t height;
         } stream;
         struct {
             float width;
             float height;
-            struct flexarray children;
-            struct flexarray annotations;
+            struct pdf_object *contents; /* Single content stream */
+            struct objlist annotations;
+            struct objlist images; /* Images drawn on this page */
         } page;
         struct pdf_info *info;
         struct {
             char name[64];
-            int index;
+            int index;              /* /Fn resource number, and handle */
+            const uint16_t *widths; /* Character widths, if known */
+            const struct kern_table *kerns; /* Kerning pairs, if any */
+            struct pdf_font_embed *embed;   /* TrueType font, if embedded */
         } font;
         struct {
             struct pdf_object *page; /* Page containing link */
@@ -281,18 +375,183 @@ struct pdf_object {
             float target_x;                 /* Target location */
             float target_y;
         } link;
+        struct {
+            int kind; /* See RESOURCES_xxx */
+        } resources;
+        struct {
+            struct pdf_object *font; /* Font this is part of */
+            int kind;                /* See FONT_PART_xxx */
+        } font_part;
+        struct {
+            struct pdf_object *page; /* Latest page listing this template */
+            struct dbuf stream;      /* Recorded drawing operations */
+            float width;             /* Bounding box */
+            float height;
+            struct objlist xobjects; /* Images & templates drawn in it */
+        } form;
     };
 };
 
+/**
+ * Objects, and small pieces of data belonging to them, are carved out of
+ * chunks which are only released when the document is destroyed, so adding
+ * an object rarely needs an allocation. Each object only takes up as much
+ * space as its type needs, rather than that of the largest type.
+ * Each chunk is twice the size of the previous one, up to a limit.
+ */
+#define ARENA_CHUNK_MIN 4096
+#define ARENA_CHUNK_MAX (256 * 1024)
+#define ARENA_ALIGN 8
+
+/* Number of page content buffers kept for re-use when a document is reset */
+#define PDF_SPARE_BUFFERS 16
+
+struct pdf_arena_chunk {
+    struct pdf_arena_chunk *next; /* Previously allocated chunk */
+    size_t used;                  /* Bytes handed out so far */
+    size_t size;                  /* Bytes following this header */
+};
+
+/**
+ * Image cache entry, mapping either a file (path, mtime & size) or
+ * a block of image data onto a previously embedded image.
+ * The key is a pair of independent 64-bit hashes.
+ */
+struct pdf_image_cache_entry {
+    uint64_t key[2];
+    struct pdf_object *image;
+};
+
+/* Output is batched up to this size before being written */
+#define PDF_OUTPUT_CHUNK 65536
+/* Blocks at least this large are written by reference, rather than copied */
+#define PDF_OUTPUT_REF_MIN 8192
+#define PDF_OUTPUT_MAX_SEGS 64
+
+/**
+ * A pending piece of output: either a range of the batched data, or a
+ * reference to a large block (such as a stream body) owned by the caller
+ */
+struct pdf_output_seg {
+    const void *data; /* NULL => range of 'pending' */
+    size_t offset;    /* Start within 'pending', if data is NULL */
+    size_t len;
+};
+
+/**
+ * Destination for a document being saved: a memory buffer, a writer
+ * callback, or a file descriptor (in that order of precedence).
+ * The offset is tracked here rather than with ftell, so that non-seekable
+ * outputs work too. Errors are sticky, and checked once writing is
+ * complete.
+ */
+struct pdf_output {
+    struct dstr *buf;      /* Output buffer */
+    pdf_writer_fn writer;  /* Output callback */
+    void *user;            /* Callback context */
+    int fd;                /* Output file, if neither of the above */
+    struct dstr pending;   /* Batched up output */
+    size_t seg_start;      /* Start of the pending data not yet in segs */
+    struct pdf_output_seg segs[PDF_OUTPUT_MAX_SEGS];
+    int nsegs;
+    bool has_refs;         /* segs refers to caller owned data */
+    size_t offset;         /* Bytes written so far */
+    int error;
+};
+
+/**
+ * Text decoded into the PDF encoding, along with the byte offset and the
+ * running width of each character, so that the width of any span of it can
+ * be found without decoding the UTF-8 again.
+ */
+struct pdf_glyphs {
+    uint8_t *codes;    /* PDF encoded characters (ASCII for TrueType fonts) */
+    uint16_t *gids;    /* Glyph IDs, for TrueType fonts */
+    uint32_t *offsets; /* Byte offset of each character, plus the end */
+    uint32_t *widths;  /* Width of all the characters before each one */
+    int count;
+    size_t alloc; /* Number of characters allocated */
+};
+
+/**
+ * A parsed TrueType font file, which isn't changed once it is loaded
+ */
+struct pdf_ttf {
+    uint8_t *data;
+    size_t len;
+    char name[64]; /* PostScript name */
+    struct {
+        uint32_t offset;
+        uint32_t len; /* 0 => not in the font */
+    } tables[TTF_TABLE_count];
+    bool loca_long; /* Glyph offsets are 32-bit */
+    uint16_t units_per_em;
+    uint16_t glyph_count;
+    int16_t bbox[4];
+    int16_t ascent;
+    int16_t descent;
+    int16_t cap_height;
+    float italic_angle;
+    bool fixed_pitch;
+    uint16_t *advances;         /* Width of each glyph */
+    uint16_t *cmap[256];        /* Glyph of each BMP character, by high byte */
+    const uint8_t *cmap_groups; /* Format 12 groups, for other characters */
+    uint32_t cmap_group_count;
+
+    /* Font cache entry, protected by font_cache_mutex */
+    struct pdf_ttf *next;
+    uint32_t hash;  /* Adler-32 of the data, to rule out most compares */
+    int refs;       /* Number of documents using the font */
+    char *filename; /* File the font was loaded from, if any */
+    time_t mtime;   /* Modification time of that file */
+};
+
+/**
+ * A TrueType font embedded in a document. Only the glyphs which are drawn
+ * are included in the font file, which is built when the document is saved.
+ */
+struct pdf_font_embed {
+    struct pdf_ttf *ttf;
+    uint8_t *used; /* Bitmap of the glyphs drawn in the document */
+    struct pdf_object *parts[FONT_PART_count];
+    char subset_name[80]; /* Name of the font subset, with its tag */
+    uint8_t *file;        /* Subset font file */
+    size_t file_len;
+    struct dstr to_unicode; /* ToUnicode CMap */
+};
+
 struct pdf_doc {
     char errstr[128];
     int errval;
     struct flexarray objects;
+    struct flexarray pages; /* Page objects, in page order */
 
     float width;
     float height;
 
     struct pdf_object *current_font;
+    struct flexarray fonts;         /* Font objects, by handle - 1 */
+    struct pdf_object **font_table; /* Open addressed, keyed by name */
+    size_t font_table_size;         /* Power of two, 0 => not allocated */
+
+    int compression;       /* FlateDecode level, 0 => disabled */
+    struct flate *flate;   /* Compressor, re-used for each stream */
+    bool kerning;          /* Apply the kerning pairs of the standard fonts */
+
+    struct pdf_image_cache_entry *image_cache; /* Open addressed table */
+    size_t image_cache_count;
+    size_t image_cache_size; /* Power of two, 0 => not allocated */
+
+    struct pdf_output *stream; /* Output of a streaming document */
+
+    struct pdf_object *resources[RESOURCES_count]; /* Shared resources */
+    struct pdf_object *current_template; /* Template being recorded */
+    struct pdf_arena_chunk *arena; /* Most recent first */
+    struct dbuf spare_buffers[PDF_SPARE_BUFFERS]; /* Kept by pdf_reset */
+    int spare_count;
+    struct dstr output_pending; /* Output batching buffer, kept for re-use */
+    struct pdf_glyphs glyphs; /* Scratch space for decoding text */
+    int flushed_objects; /* Objects before this have already been flushed */
 
     struct pdf_object *last_objects[OBJ_count];
     struct pdf_object *first_objects[OBJ_count];
@@ -380,10 +639,17 @@ static void flexarray_clear(struct flexarray *flex)
     for (int i = 0; i < flex->bin_count; i++)
         free(flex->bins[i]);
     free(flex->bins);
+    flex->bins = NULL;
     flex->bin_count = 0;
     flex->item_count = 0;
 }
 
+/* Empty the array, keeping its bins for re-use */
+static void flexarray_reset(struct flexarray *flex)
+{
+    flex->item_count = 0;
+}
+
 static inline int flexarray_size(const struct flexarray *flex)
 {
     return flex->item_count;
@@ -419,6 +685,13 @@ static inline int flexarray_append(struct flexarray *flex, void *data)
     return flexarray_set(flex, flexarray_size(flex), data);
 }
 
+/* Drop the last item, keeping its bin for re-use */
+static inline void flexarray_pop(struct flexarray *flex)
+{
+    if (flex->item_count > 0)
+        flex->item_count--;
+}
+
 static inline void *flexarray_get(const struct flexarray *flex, int index)
 {
     int bin;
@@ -461,7 +734,10 @@ static ssize_t dstr_ensure(struct dstr *str, size_t len)
     else if (str->alloc_len < len) {
         size_t new_len;
 
+        /* Grow geometrically, so appending is amortised O(1) */
         new_len = len + 4096;
+        if (new_len < str->alloc_len * 2)
+            new_len = str->alloc_len * 2;
 
         if (str->data) {
             char *new_data = (char *)realloc((void *)str->data, new_len);
@@ -481,25 +757,215 @@ static ssize_t dstr_ensure(struct dstr *str, size_t len)
     return 0;
 }
 
-// Locales can replace the decimal character with a ','.
-// This breaks the PDF output, so we force a 'safe' locale.
-static void force_locale(char *buf, int len)
+static ssize_t dstr_append_data(struct dstr *str, const void *extend,
+                                size_t len);
+
+/**
+ * Fast, locale independent number formatting.
+ * Content streams are made up almost entirely of numbers, so these avoid
+ * the setlocale()/vsnprintf() overhead of the C library and always use '.'
+ * as the decimal separator, which is what PDF requires.
+ */
+
+static const double pow10_table[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+};
+
+/* Write an unsigned integer in the given base to the end of buf, returning
+ * a pointer to the first digit */
+static char *format_uint(char *end, uint64_t value, unsigned base,
+                         bool upper)
 {
-    char *saved_locale = setlocale(LC_ALL, NULL);
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
 
-    if (!saved_locale) {
-        *buf = '\0';
-    } else {
-        strncpy(buf, saved_locale, len - 1);
-        buf[len - 1] = '\0';
+    do {
+        *--end = digits[value % base];
+        value /= base;
+    } while (value);
+    return end;
+}
+
+/**
+ * Format value in fixed point notation with at most 'precision' fractional
+ * digits into buf (which must hold at least 32 bytes). Trailing zeros (and
+ * a trailing '.') are dropped, since PDF doesn't need them.
+ * @return Number of characters written
+ */
+static int format_float(char *buf, double value, int precision)
+{
+    char digits[32];
+    char *end = digits + sizeof(digits);
+    char *p;
+    uint64_t scaled, scale;
+    bool negative = false;
+    int len = 0;
+
+    if (precision < 0)
+        precision = 0;
+    if (precision >= (int)ARRAY_SIZE(pow10_table))
+        precision = ARRAY_SIZE(pow10_table) - 1;
+
+    if (value != value) /* NaN */
+        value = 0;
+    if (value < 0) {
+        negative = true;
+        value = -value;
+    }
+    /* Keep everything within range of a 64-bit integer, dropping
+     * fractional digits if needed */
+    while (precision > 0 && value * pow10_table[precision] >= 9e18)
+        precision--;
+    if (value >= 9e18)
+        value = 9e18;
+
+    scale = (uint64_t)pow10_table[precision];
+    scaled = (uint64_t)(value * pow10_table[precision] + 0.5);
+
+    if (negative && scaled)
+        buf[len++] = '-';
+
+    p = format_uint(end, scaled / scale, 10, false);
+    memcpy(&buf[len], p, end - p);
+    len += end - p;
+
+    if (precision > 0 && scaled % scale) {
+        uint64_t frac = scaled % scale;
+        int nfrac = precision;
+
+        while (frac % 10 == 0) {
+            frac /= 10;
+            nfrac--;
+        }
+        buf[len++] = '.';
+        p = format_uint(end, frac, 10, false);
+        /* Leading zeros of the fractional part */
+        for (int i = end - p; i < nfrac; i++)
+            buf[len++] = '0';
+        memcpy(&buf[len], p, end - p);
+        len += end - p;
     }
 
-    setlocale(LC_NUMERIC, "POSIX");
+    return len;
 }
 
-static void restore_locale(char *buf)
+/**
+ * Minimal printf implementation for building PDF data.
+ * Supports the conversions %d, %i, %u, %x, %X, %c, %s, %f & %%, with the
+ * '0' flag, field width, precision and the 'l', 'll' & 'z' length
+ * modifiers. Unlike printf, %f never uses the locale's decimal separator
+ * and drops trailing zeros (so "%f" of 12.5 gives "12.5").
+ */
+static int dstr_vprintf(struct dstr *str, const char *fmt, va_list ap)
 {
-    setlocale(LC_ALL, buf);
+    size_t start = str->used_len;
+
+    while (*fmt) {
+        const char *next = strchr(fmt, '%');
+        char buf[64];
+        char *end = buf + sizeof(buf);
+        const char *out = NULL;
+        size_t out_len = 0;
+        bool zero_pad = false;
+        int width = 0, precision = -1, lng = 0;
+        bool is_size = false;
+
+        if (!next)
+            next = fmt + strlen(fmt);
+        if (next != fmt && dstr_append_data(str, fmt, next - fmt) < 0)
+            return -ENOMEM;
+        if (!*next)
+            break;
+        fmt = next + 1;
+
+        if (*fmt == '0') {
+            zero_pad = true;
+            fmt++;
+        }
+        while (*fmt >= '0' && *fmt <= '9')
+            width = width * 10 + (*fmt++ - '0');
+        if (*fmt == '.') {
+            precision = 0;
+            fmt++;
+            while (*fmt >= '0' && *fmt <= '9')
+                precision = precision * 10 + (*fmt++ - '0');
+        }
+        if (*fmt == 'z') {
+            is_size = true;
+            fmt++;
+        }
+        while (*fmt == 'l') {
+            lng++;
+            fmt++;
+        }
+
+        switch (*fmt) {
+        case 'd':
+        case 'i': {
+            int64_t v = is_size  ? (int64_t)va_arg(ap, ssize_t)
+                        : lng > 1 ? (int64_t)va_arg(ap, long long)
+                        : lng     ? (int64_t)va_arg(ap, long)
+                                  : (int64_t)va_arg(ap, int);
+            out = format_uint(end, v < 0 ? -(uint64_t)v : (uint64_t)v, 10,
+                              false);
+            while (end - out < precision)
+                *(char *)--out = '0';
+            if (v < 0) {
+                /* Zero padding goes between the sign and the digits */
+                if (zero_pad && width > 0) {
+                    while (end - out < width - 1)
+                        *(char *)--out = '0';
+                    width = 0;
+                }
+                *(char *)--out = '-';
+            }
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X': {
+            uint64_t v = is_size  ? (uint64_t)va_arg(ap, size_t)
+                         : lng > 1 ? (uint64_t)va_arg(ap, unsigned long long)
+                         : lng     ? (uint64_t)va_arg(ap, unsigned long)
+                                   : (uint64_t)va_arg(ap, unsigned int);
+            out = format_uint(end, v, *fmt == 'u' ? 10 : 16, *fmt == 'X');
+            while (end - out < precision)
+                *(char *)--out = '0';
+            break;
+        }
+        case 'c':
+            buf[0] = (char)va_arg(ap, int);
+            out = buf;
+            end = buf + 1;
+            break;
+        case 's':
+            out = va_arg(ap, const char *);
+            if (!out)
+                out = "(null)";
+            end = (char *)out + strlen(out);
+            break;
+        case 'f':
+            out = buf;
+            end = buf + format_float(buf, va_arg(ap, double),
+                                     precision < 0 ? 6 : precision);
+            break;
+        case '%':
+            out = "%";
+            end = (char *)out + 1;
+            break;
+        default:
+            return -EINVAL;
+        }
+        fmt++;
+
+        out_len = end - out;
+        for (; width > (int)out_len; width--)
+            if (dstr_append_data(str, zero_pad ? "0" : " ", 1) < 0)
+                return -ENOMEM;
+        if (dstr_append_data(str, out, out_len) < 0)
+            return -ENOMEM;
+    }
+
+    return (int)(str->used_len - start);
 }
 
 #ifndef SKIP_ATTRIBUTE
@@ -508,26 +974,12 @@ static int dstr_printf(struct dstr *str, const char *fmt, ...)
 #endif
 static int dstr_printf(struct dstr *str, const char *fmt, ...)
 {
-    va_list ap, aq;
+    va_list ap;
     int len;
-    char saved_locale[32];
-
-    force_locale(saved_locale, sizeof(saved_locale));
 
     va_start(ap, fmt);
-    va_copy(aq, ap);
-    len = vsnprintf(NULL, 0, fmt, ap);
-    if (dstr_ensure(str, str->used_len + len + 1) < 0) {
-        va_end(ap);
-        va_end(aq);
-        restore_locale(saved_locale);
-        return -ENOMEM;
-    }
-    vsprintf(dstr_data(str) + str->used_len, fmt, aq);
-    str->used_len += len;
+    len = dstr_vprintf(str, fmt, ap);
     va_end(ap);
-    va_end(aq);
-    restore_locale(saved_locale);
 
     return len;
 }
@@ -555,129 +1007,684 @@ static void dstr_free(struct dstr *str)
     *str = INIT_DSTR;
 }
 
+/* Initial allocation of a dbuf, enough for a short content stream */
+#define DBUF_MIN 256
+
+static const char *dbuf_data(const struct dbuf *buf)
+{
+    return buf->data ? buf->data : "";
+}
+
+static size_t dbuf_len(const struct dbuf *buf)
+{
+    return buf->len;
+}
+
+static int dbuf_append_data(struct dbuf *buf, const void *extend, size_t len)
+{
+    if (!len)
+        return 0;
+    if (buf->len + len > buf->alloc_len) {
+        size_t new_len = buf->alloc_len ? buf->alloc_len * 2 : DBUF_MIN;
+        char *new_data;
+
+        while (new_len < buf->len + len)
+            new_len *= 2;
+        new_data = (char *)realloc(buf->data, new_len);
+        if (!new_data)
+            return -ENOMEM;
+        buf->data = new_data;
+        buf->alloc_len = new_len;
+    }
+    memcpy(buf->data + buf->len, extend, len);
+    buf->len += len;
+    return 0;
+}
+
 /**
- * PDF Implementation
+ * Move the contents of a dstr into an empty dbuf, taking over its heap
+ * allocation if it has one, and leaving the dstr empty
  */
+static int dbuf_take_dstr(struct dbuf *buf, struct dstr *str)
+{
+    int e = 0;
 
-#ifndef SKIP_ATTRIBUTE
-static int pdf_set_err(struct pdf_doc *doc, int errval, const char *buffer,
-                       ...) __attribute__((format(printf, 3, 4)));
-#endif
-static int pdf_set_err(struct pdf_doc *doc, int errval, const char *buffer,
-                       ...)
+    if (str->data) {
+        buf->data = str->data;
+        buf->len = str->used_len;
+        buf->alloc_len = str->alloc_len;
+        *str = INIT_DSTR;
+    } else {
+        e = dbuf_append_data(buf, dstr_data(str), dstr_len(str));
+        dstr_free(str);
+    }
+    return e;
+}
+
+static void dbuf_free(struct dbuf *buf)
 {
-    va_list ap;
-    int len;
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = 0;
+    buf->alloc_len = 0;
+}
 
-    va_start(ap, buffer);
-    len = vsnprintf(doc->errstr, sizeof(doc->errstr) - 1, buffer, ap);
-    va_end(ap);
+/**
+ * Update a running Adler-32 checksum (start with 1) with more data
+ */
+static uint32_t adler32_update(uint32_t adler, const void *data, size_t len)
+{
+    const uint8_t *d8 = (const uint8_t *)data;
+    uint32_t a = adler & 0xffff, b = adler >> 16;
 
-    if (len < 0) {
-        doc->errstr[0] = '\0';
-        return errval;
+    while (len) {
+        /* The most bytes that can be summed before b could overflow */
+        size_t n = len < 5552 ? len : 5552;
+
+        len -= n;
+        while (n--) {
+            a += *d8++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
     }
+    return (b << 16) | a;
+}
 
-    if (len >= (int)(sizeof(doc->errstr) - 1))
-        len = (int)(sizeof(doc->errstr) - 1);
+/**
+ * Streaming zlib (RFC 1950/1951) encoder, used for FlateDecode streams.
+ * This is a deliberately small implementation: greedy LZ77 matching over
+ * hash chains, emitted as a single block using the fixed Huffman codes.
+ * That captures most of the redundancy in PDF content streams without any
+ * external dependency. Define PDFGEN_USE_ZLIB to use the system zlib
+ * instead.
+ */
+#define FLATE_WSIZE 32768
+#define FLATE_HASH_BITS 15
+#define FLATE_HASH_SIZE (1 << FLATE_HASH_BITS)
+#define FLATE_MIN_MATCH 3
+#define FLATE_MAX_MATCH 258
+#define FLATE_MIN_LOOKAHEAD (FLATE_MAX_MATCH + FLATE_MIN_MATCH + 1)
+#define FLATE_MAX_DIST (FLATE_WSIZE - FLATE_MIN_LOOKAHEAD)
+
+struct flate {
+    struct dstr *out;
+    int level;
+    int error;
+#ifdef PDFGEN_USE_ZLIB
+    z_stream zs;
+#else
+    uint8_t window[2 * FLATE_WSIZE];
+    int32_t head[FLATE_HASH_SIZE]; /* Most recent position for each hash */
+    int32_t prev[FLATE_WSIZE];     /* Previous position with the same hash */
+    uint32_t strstart;             /* Next position to be encoded */
+    uint32_t lookahead;            /* Bytes available from strstart */
+    int max_chain;
+    uint32_t bitbuf;
+    int bitcount;
+    uint32_t adler;
+    uint8_t pending[4096]; /* Encoded data waiting to be appended to out */
+    size_t pending_len;
+#endif
+};
 
-    doc->errstr[len] = '\0';
-    doc->errval = errval;
+#ifdef PDFGEN_USE_ZLIB
 
-    return errval;
+static int flate_deflate(struct flate *f, int mode)
+{
+    do {
+        if (dstr_ensure(f->out, f->out->used_len + 16384 + 1) < 0)
+            return -ENOMEM;
+        f->zs.next_out = (Bytef *)dstr_data(f->out) + f->out->used_len;
+        f->zs.avail_out = 16384;
+        int e = deflate(&f->zs, mode);
+        if (e == Z_STREAM_ERROR)
+            return -EINVAL;
+        f->out->used_len += 16384 - f->zs.avail_out;
+        if (e == Z_STREAM_END)
+            break;
+    } while (f->zs.avail_out == 0 || (mode == Z_FINISH));
+    dstr_data(f->out)[f->out->used_len] = '\0';
+    return 0;
 }
 
-const char *pdf_get_err(const struct pdf_doc *pdf, int *errval)
+static struct flate *flate_init(int level)
 {
-    if (!pdf)
+    struct flate *f = (struct flate *)calloc(1, sizeof(*f));
+
+    if (!f)
         return NULL;
-    if (pdf->errstr[0] == '\0')
+    f->level = level;
+    if (deflateInit(&f->zs, level) != Z_OK) {
+        free(f);
         return NULL;
-    if (errval)
-        *errval = pdf->errval;
-    return pdf->errstr;
+    }
+    return f;
 }
 
-void pdf_clear_err(struct pdf_doc *pdf)
+static void flate_reset(struct flate *f, struct dstr *out)
 {
-    if (!pdf)
-        return;
-    pdf->errstr[0] = '\0';
-    pdf->errval = 0;
+    deflateReset(&f->zs);
+    f->out = out;
+    f->error = 0;
 }
 
-static int pdf_get_errval(struct pdf_doc *pdf)
+static int flate_write(struct flate *f, const void *data, size_t len)
 {
-    if (!pdf)
-        return 0;
-    return pdf->errval;
+    f->zs.next_in = (Bytef *)data;
+    f->zs.avail_in = len;
+    if (!f->error)
+        f->error = flate_deflate(f, Z_NO_FLUSH);
+    return f->error;
 }
 
-static struct pdf_object *pdf_get_object(const struct pdf_doc *pdf, int index)
+static int flate_finish(struct flate *f)
 {
-    return (struct pdf_object *)flexarray_get(&pdf->objects, index);
+    f->zs.next_in = NULL;
+    f->zs.avail_in = 0;
+    if (!f->error)
+        f->error = flate_deflate(f, Z_FINISH);
+    return f->error;
 }
 
-static int pdf_append_object(struct pdf_doc *pdf, struct pdf_object *obj)
+static void flate_free(struct flate *f)
 {
-    int index = flexarray_append(&pdf->objects, obj);
+    if (f)
+        deflateEnd(&f->zs);
+    free(f);
+}
 
-    if (index < 0)
-        return index;
-    obj->index = index;
+#else
 
-    if (pdf->last_objects[obj->type]) {
-        obj->prev = pdf->last_objects[obj->type];
-        pdf->last_objects[obj->type]->next = obj;
+static void flate_flush_pending(struct flate *f)
+{
+    if (f->pending_len && !f->error &&
+        dstr_append_data(f->out, f->pending, f->pending_len) < 0)
+        f->error = -ENOMEM;
+    f->pending_len = 0;
+}
+
+static inline void flate_put_bits(struct flate *f, uint32_t bits, int count)
+{
+    f->bitbuf |= bits << f->bitcount;
+    f->bitcount += count;
+    while (f->bitcount >= 8) {
+        if (f->pending_len == sizeof(f->pending))
+            flate_flush_pending(f);
+        f->pending[f->pending_len++] = f->bitbuf & 0xff;
+        f->bitbuf >>= 8;
+        f->bitcount -= 8;
     }
-    pdf->last_objects[obj->type] = obj;
+}
 
-    if (!pdf->first_objects[obj->type])
-        pdf->first_objects[obj->type] = obj;
+/* Huffman codes are stored most-significant bit first */
+static inline void flate_put_code(struct flate *f, uint32_t code, int count)
+{
+    uint32_t rev = 0;
 
-    return 0;
+    for (int i = 0; i < count; i++, code >>= 1)
+        rev = (rev << 1) | (code & 1);
+    flate_put_bits(f, rev, count);
 }
 
-static void pdf_object_destroy(struct pdf_object *object)
+/* Emit a literal/length symbol using the fixed Huffman table */
+static void flate_put_symbol(struct flate *f, int sym)
 {
-    switch (object->type) {
-    case OBJ_stream:
-    case OBJ_image:
-        dstr_free(&object->stream.stream);
-        break;
-    case OBJ_page:
-        flexarray_clear(&object->page.children);
-        flexarray_clear(&object->page.annotations);
-        break;
-    case OBJ_info:
-        free(object->info);
-        break;
-    case OBJ_bookmark:
-        flexarray_clear(&object->bookmark.children);
-        break;
-    }
-    free(object);
+    if (sym < 144)
+        flate_put_code(f, 0x30 + sym, 8);
+    else if (sym < 256)
+        flate_put_code(f, 0x190 + sym - 144, 9);
+    else if (sym < 280)
+        flate_put_code(f, sym - 256, 7);
+    else
+        flate_put_code(f, 0xc0 + sym - 280, 8);
 }
 
-static struct pdf_object *pdf_add_object(struct pdf_doc *pdf, int type)
+static inline int flate_log2(uint32_t v)
 {
-    struct pdf_object *obj;
+    int n = 0;
 
-    if (!pdf)
-        return NULL;
+    while (v >>= 1)
+        n++;
+    return n;
+}
 
-    obj = (struct pdf_object *)calloc(1, sizeof(*obj));
-    if (!obj) {
-        pdf_set_err(pdf, -errno,
-                    "Unable to allocate object %d of type %d: %s",
-                    flexarray_size(&pdf->objects) + 1, type, strerror(errno));
+static void flate_put_match(struct flate *f, uint32_t len, uint32_t dist)
+{
+    uint32_t l = len - FLATE_MIN_MATCH;
+    uint32_t d = dist - 1;
+
+    /* Length codes 257..285 */
+    if (l < 8) {
+        flate_put_symbol(f, 257 + l);
+    } else if (len == FLATE_MAX_MATCH) {
+        flate_put_symbol(f, 285);
+    } else {
+        int n = flate_log2(l);
+        flate_put_symbol(f, 257 + 4 * (n - 1) + ((l >> (n - 2)) & 3));
+        flate_put_bits(f, l & ((1u << (n - 2)) - 1), n - 2);
+    }
+
+    /* Distance codes 0..29, always 5 bits in the fixed table */
+    if (d < 4) {
+        flate_put_code(f, d, 5);
+    } else {
+        int n = flate_log2(d);
+        flate_put_code(f, 2 * n + ((d >> (n - 1)) & 1), 5);
+        flate_put_bits(f, d & ((1u << (n - 1)) - 1), n - 1);
+    }
+}
+
+static inline uint32_t flate_hash(const uint8_t *p)
+{
+    return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (FLATE_HASH_SIZE - 1);
+}
+
+static inline void flate_insert(struct flate *f, uint32_t pos)
+{
+    uint32_t h = flate_hash(&f->window[pos]);
+
+    f->prev[pos & (FLATE_WSIZE - 1)] = f->head[h];
+    f->head[h] = pos;
+}
+
+static void flate_compress(struct flate *f, bool flush)
+{
+    uint32_t min_lookahead = flush ? 1 : FLATE_MIN_LOOKAHEAD;
+
+    while (f->lookahead >= min_lookahead) {
+        uint32_t best_len = 0, best_dist = 0;
+
+        if (f->lookahead >= FLATE_MIN_MATCH) {
+            const uint8_t *scan = &f->window[f->strstart];
+            uint32_t limit = f->strstart > FLATE_MAX_DIST
+                                 ? f->strstart - FLATE_MAX_DIST
+                                 : 0;
+            uint32_t max_len = f->lookahead < FLATE_MAX_MATCH
+                                   ? f->lookahead
+                                   : FLATE_MAX_MATCH;
+            int32_t cand = f->head[flate_hash(scan)];
+            int chain = f->max_chain;
+
+            flate_insert(f, f->strstart);
+            while (cand >= (int32_t)limit && chain-- > 0) {
+                const uint8_t *match = &f->window[cand];
+                if (match[best_len] == scan[best_len] &&
+                    match[0] == scan[0] && match[1] == scan[1]) {
+                    uint32_t len = 2;
+                    while (len < max_len && match[len] == scan[len])
+                        len++;
+                    if (len > best_len) {
+                        best_len = len;
+                        best_dist = f->strstart - cand;
+                        if (len == max_len)
+                            break;
+                    }
+                }
+                cand = f->prev[cand & (FLATE_WSIZE - 1)];
+            }
+        }
+
+        if (best_len >= FLATE_MIN_MATCH) {
+            flate_put_match(f, best_len, best_dist);
+            /* Only index the whole match at higher levels */
+            for (uint32_t i = 1; i < best_len; i++)
+                if (f->level > 3 &&
+                    f->strstart + i + FLATE_MIN_MATCH <=
+                        f->strstart + f->lookahead)
+                    flate_insert(f, f->strstart + i);
+            f->strstart += best_len;
+            f->lookahead -= best_len;
+        } else {
+            flate_put_symbol(f, f->window[f->strstart]);
+            f->strstart++;
+            f->lookahead--;
+        }
+    }
+}
+
+/* Drop the oldest half of the window, keeping the hash chains valid */
+static void flate_slide(struct flate *f)
+{
+    memmove(f->window, &f->window[FLATE_WSIZE], FLATE_WSIZE);
+    f->strstart -= FLATE_WSIZE;
+    for (int i = 0; i < FLATE_HASH_SIZE; i++)
+        f->head[i] = f->head[i] >= FLATE_WSIZE ? f->head[i] - FLATE_WSIZE : -1;
+    for (int i = 0; i < FLATE_WSIZE; i++)
+        f->prev[i] = f->prev[i] >= FLATE_WSIZE ? f->prev[i] - FLATE_WSIZE : -1;
+}
+
+static struct flate *flate_init(int level)
+{
+    static const int chain_lengths[] = {0,  4,   8,   16,   32,
+                                        64, 128, 256, 1024, 4096};
+    struct flate *f = (struct flate *)malloc(sizeof(*f));
+
+    if (!f)
+        return NULL;
+    if (level < 1)
+        level = 1;
+    if (level > 9)
+        level = 9;
+    f->level = level;
+    f->max_chain = chain_lengths[level];
+    return f;
+}
+
+static void flate_reset(struct flate *f, struct dstr *out)
+{
+    f->out = out;
+    f->error = 0;
+    memset(f->head, 0xff, sizeof(f->head));
+    f->strstart = 0;
+    f->lookahead = 0;
+    f->bitbuf = 0;
+    f->bitcount = 0;
+    f->adler = 1;
+    f->pending_len = 0;
+
+    /* zlib header (32K window, no dictionary) */
+    flate_put_bits(f, 0x78, 8);
+    flate_put_bits(f, 0x01, 8);
+    /* Final block, fixed Huffman codes */
+    flate_put_bits(f, 1, 1);
+    flate_put_bits(f, 1, 2);
+}
+
+static int flate_write(struct flate *f, const void *data, size_t len)
+{
+    const uint8_t *d8 = (const uint8_t *)data;
+
+    while (len && !f->error) {
+        uint32_t end = f->strstart + f->lookahead;
+        size_t n = 2 * FLATE_WSIZE - end;
+
+        if (n > len)
+            n = len;
+        memcpy(&f->window[end], d8, n);
+        f->adler = adler32_update(f->adler, d8, n);
+        f->lookahead += n;
+        d8 += n;
+        len -= n;
+
+        flate_compress(f, false);
+        if (f->strstart >= 2 * FLATE_WSIZE - FLATE_MIN_LOOKAHEAD)
+            flate_slide(f);
+    }
+    return f->error;
+}
+
+static int flate_finish(struct flate *f)
+{
+    uint32_t adler = f->adler;
+
+    flate_compress(f, true);
+    flate_put_symbol(f, 256); /* End of block */
+    if (f->bitcount)
+        flate_put_bits(f, 0, 8 - f->bitcount);
+    for (int i = 24; i >= 0; i -= 8)
+        flate_put_bits(f, (adler >> i) & 0xff, 8);
+    flate_flush_pending(f);
+    return f->error;
+}
+
+static void flate_free(struct flate *f)
+{
+    free(f);
+}
+
+#endif
+
+/**
+ * PDF Implementation
+ */
+
+#ifndef SKIP_ATTRIBUTE
+static int pdf_set_err(struct pdf_doc *doc, int errval, const char *buffer,
+                       ...) __attribute__((format(printf, 3, 4)));
+#endif
+static int pdf_set_err(struct pdf_doc *doc, int errval, const char *buffer,
+                       ...)
+{
+    va_list ap;
+    int len;
+
+    va_start(ap, buffer);
+    len = vsnprintf(doc->errstr, sizeof(doc->errstr) - 1, buffer, ap);
+    va_end(ap);
+
+    if (len < 0) {
+        doc->errstr[0] = '\0';
+        return errval;
+    }
+
+    if (len >= (int)(sizeof(doc->errstr) - 1))
+        len = (int)(sizeof(doc->errstr) - 1);
+
+    doc->errstr[len] = '\0';
+    doc->errval = errval;
+
+    return errval;
+}
+
+const char *pdf_get_err(const struct pdf_doc *pdf, int *errval)
+{
+    if (!pdf)
+        return NULL;
+    if (pdf->errstr[0] == '\0')
+        return NULL;
+    if (errval)
+        *errval = pdf->errval;
+    return pdf->errstr;
+}
+
+void pdf_clear_err(struct pdf_doc *pdf)
+{
+    if (!pdf)
+        return;
+    pdf->errstr[0] = '\0';
+    pdf->errval = 0;
+}
+
+static int pdf_get_errval(struct pdf_doc *pdf)
+{
+    if (!pdf)
+        return 0;
+    return pdf->errval;
+}
+
+static struct pdf_object *pdf_get_object(const struct pdf_doc *pdf, int index)
+{
+    return (struct pdf_object *)flexarray_get(&pdf->objects, index);
+}
+
+static int pdf_append_object(struct pdf_doc *pdf, struct pdf_object *obj)
+{
+    int index = flexarray_append(&pdf->objects, obj);
+
+    if (index < 0)
+        return index;
+    obj->index = index;
+
+    if (pdf->last_objects[obj->type]) {
+        obj->prev = pdf->last_objects[obj->type];
+        pdf->last_objects[obj->type]->next = obj;
+    }
+    pdf->last_objects[obj->type] = obj;
+
+    if (!pdf->first_objects[obj->type])
+        pdf->first_objects[obj->type] = obj;
+
+    return 0;
+}
+
+static void pdf_font_embed_free(struct pdf_font_embed *embed);
+
+static void pdf_object_destroy(struct pdf_object *object)
+{
+    switch (object->type) {
+    case OBJ_stream:
+    case OBJ_image:
+        dbuf_free(&object->stream.stream);
+        break;
+    case OBJ_font:
+        pdf_font_embed_free(object->font.embed);
+        break;
+    case OBJ_template:
+        dbuf_free(&object->form.stream);
+        break;
+    }
+    /* The object's memory belongs to the arena, so it is left unused */
+    object->type = OBJ_none;
+}
+
+/**
+ * Allocate zeroed memory from the document's current arena chunk, starting
+ * a new chunk once that is full
+ */
+static void *pdf_arena_alloc(struct pdf_doc *pdf, size_t size)
+{
+    struct pdf_arena_chunk *chunk = pdf->arena;
+    void *ptr;
+
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (!chunk || chunk->size - chunk->used < size) {
+        size_t chunk_size = chunk ? chunk->size * 2 : ARENA_CHUNK_MIN;
+
+        if (chunk_size > ARENA_CHUNK_MAX)
+            chunk_size = ARENA_CHUNK_MAX;
+        if (chunk_size < size)
+            chunk_size = size;
+        chunk = (struct pdf_arena_chunk *)calloc(1, sizeof(*chunk) +
+                                                        chunk_size);
+        if (!chunk)
+            return NULL;
+        chunk->size = chunk_size;
+        chunk->next = pdf->arena;
+        pdf->arena = chunk;
+    }
+
+    ptr = (char *)(chunk + 1) + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+static char *pdf_arena_strdup(struct pdf_doc *pdf, const char *str)
+{
+    size_t len = strlen(str);
+    char *copy = (char *)pdf_arena_alloc(pdf, len + 1);
+
+    if (copy)
+        memcpy(copy, str, len + 1);
+    return copy;
+}
+
+#define OBJLIST_MIN 4
+
+static int objlist_append(struct pdf_doc *pdf, struct objlist *list,
+                          struct pdf_object *obj)
+{
+    if (list->count == list->alloc_count) {
+        int alloc_count = list->alloc_count ? list->alloc_count * 2
+                                            : OBJLIST_MIN;
+        struct pdf_object **items = (struct pdf_object **)pdf_arena_alloc(
+            pdf, alloc_count * sizeof(*items));
+
+        if (!items)
+            return -ENOMEM;
+        if (list->count)
+            memcpy(items, list->items, list->count * sizeof(*items));
+        list->items = items;
+        list->alloc_count = alloc_count;
+    }
+    list->items[list->count] = obj;
+    return list->count++;
+}
+
+static inline int objlist_size(const struct objlist *list)
+{
+    return list->count;
+}
+
+static inline struct pdf_object *objlist_get(const struct objlist *list,
+                                             int index)
+{
+    return list->items[index];
+}
+
+/**
+ * Release everything allocated from the arena, keeping its most recent (and
+ * largest) chunk for re-use
+ */
+static void pdf_arena_reset(struct pdf_doc *pdf)
+{
+    struct pdf_arena_chunk *chunk = pdf->arena;
+
+    if (!chunk)
+        return;
+    while (chunk->next) {
+        struct pdf_arena_chunk *next = chunk->next;
+
+        chunk->next = next->next;
+        free(next);
+    }
+    memset(chunk + 1, 0, chunk->used);
+    chunk->used = 0;
+}
+
+/* Size of an object whose type specific data is the given union member */
+#define PDF_OBJECT_SIZE(member)                                              \
+    (offsetof(struct pdf_object, member) +                                   \
+     sizeof(((struct pdf_object *)0)->member))
+
+static size_t pdf_object_size(int type)
+{
+    switch (type) {
+    case OBJ_info:
+        return PDF_OBJECT_SIZE(info);
+    case OBJ_stream:
+    case OBJ_image:
+        return PDF_OBJECT_SIZE(stream);
+    case OBJ_font:
+        return PDF_OBJECT_SIZE(font);
+    case OBJ_page:
+        return PDF_OBJECT_SIZE(page);
+    case OBJ_bookmark:
+        return PDF_OBJECT_SIZE(bookmark);
+    case OBJ_link:
+        return PDF_OBJECT_SIZE(link);
+    case OBJ_resources:
+        return PDF_OBJECT_SIZE(resources);
+    case OBJ_font_part:
+        return PDF_OBJECT_SIZE(font_part);
+    case OBJ_template:
+        return PDF_OBJECT_SIZE(form);
+    default:
+        /* No type specific data, just the common header */
+        return offsetof(struct pdf_object, info);
+    }
+}
+
+static struct pdf_object *pdf_add_object(struct pdf_doc *pdf, int type)
+{
+    struct pdf_object *obj;
+
+    if (!pdf)
+        return NULL;
+
+    obj = (struct pdf_object *)pdf_arena_alloc(pdf, pdf_object_size(type));
+    if (!obj) {
+        pdf_set_err(pdf, -errno,
+                    "Unable to allocate object %d of type %d: %s",
+                    flexarray_size(&pdf->objects) + 1, type, strerror(errno));
         return NULL;
     }
 
     obj->type = type;
 
     if (pdf_append_object(pdf, obj) < 0) {
-        free(obj);
+        obj->type = OBJ_none;
         return NULL;
     }
 
@@ -711,32 +1718,24 @@ static void pdf_del_object(struct pdf_doc *pdf, struct pdf_object *obj)
     pdf_object_destroy(obj);
 }
 
-struct pdf_doc *pdf_create(float width, float height,
-                           const struct pdf_info *info)
+/**
+ * Add the objects every document starts with to an empty document
+ */
+static int pdf_init(struct pdf_doc *pdf, const struct pdf_info *info)
 {
-    struct pdf_doc *pdf;
     struct pdf_object *obj;
 
-    pdf = (struct pdf_doc *)calloc(1, sizeof(*pdf));
-    if (!pdf)
-        return NULL;
-    pdf->width = width;
-    pdf->height = height;
-
     /* We don't want to use ID 0 */
-    pdf_add_object(pdf, OBJ_none);
+    if (!pdf_add_object(pdf, OBJ_none))
+        return pdf->errval;
 
     /* Create the 'info' object */
     obj = pdf_add_object(pdf, OBJ_info);
-    if (!obj) {
-        pdf_destroy(pdf);
-        return NULL;
-    }
-    obj->info = (struct pdf_info *)calloc(sizeof(*obj->info), 1);
-    if (!obj->info) {
-        pdf_destroy(pdf);
-        return NULL;
-    }
+    if (!obj)
+        return pdf->errval;
+    obj->info = (struct pdf_info *)pdf_arena_alloc(pdf, sizeof(*obj->info));
+    if (!obj->info)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate document info");
     if (info) {
         *obj->info = *info;
         obj->info->creator[sizeof(obj->info->creator) - 1] = '\0';
@@ -761,16 +1760,34 @@ struct pdf_doc *pdf_create(float width, float height,
                  &tm);
     }
 
-    if (!pdf_add_object(pdf, OBJ_pages)) {
-        pdf_destroy(pdf);
-        return NULL;
+    if (!pdf_add_object(pdf, OBJ_pages))
+        return pdf->errval;
+    if (!pdf_add_object(pdf, OBJ_catalog))
+        return pdf->errval;
+
+    for (int i = 0; i < RESOURCES_count; i++) {
+        obj = pdf_add_object(pdf, OBJ_resources);
+        if (!obj)
+            return pdf->errval;
+        obj->resources.kind = i;
+        pdf->resources[i] = obj;
     }
-    if (!pdf_add_object(pdf, OBJ_catalog)) {
-        pdf_destroy(pdf);
+
+    return pdf_set_font(pdf, "Times-Roman");
+}
+
+struct pdf_doc *pdf_create(float width, float height,
+                           const struct pdf_info *info)
+{
+    struct pdf_doc *pdf;
+
+    pdf = (struct pdf_doc *)calloc(1, sizeof(*pdf));
+    if (!pdf)
         return NULL;
-    }
+    pdf->width = width;
+    pdf->height = height;
 
-    if (pdf_set_font(pdf, "Times-Roman") < 0) {
+    if (pdf_init(pdf, info) < 0) {
         pdf_destroy(pdf);
         return NULL;
     }
@@ -790,25 +1807,118 @@ float pdf_height(const struct pdf_doc *pdf)
 
 float pdf_page_width(const struct pdf_object *page)
 {
-    return page->page.width;
+    if (!page)
+        return 0;
+    if (page->type == OBJ_page)
+        return page->page.width;
+    if (page->type == OBJ_template)
+        return page->form.width;
+    return 0;
 }
 
 float pdf_page_height(const struct pdf_object *page)
 {
-    return page->page.height;
+    if (!page)
+        return 0;
+    if (page->type == OBJ_page)
+        return page->page.height;
+    if (page->type == OBJ_template)
+        return page->form.height;
+    return 0;
 }
 
-void pdf_destroy(struct pdf_doc *pdf)
+/* Destroy every object, leaving their memory to the arena */
+static void pdf_destroy_objects(struct pdf_doc *pdf)
 {
-    if (pdf) {
-        for (int i = 0; i < flexarray_size(&pdf->objects); i++)
-            pdf_object_destroy(pdf_get_object(pdf, i));
-        flexarray_clear(&pdf->objects);
-        free(pdf);
+    /* Newest first, handing memory back in the reverse order to which it
+     * was allocated */
+    for (int i = flexarray_size(&pdf->objects) - 1; i >= 0; i--) {
+        struct pdf_object *obj = pdf_get_object(pdf, i);
+
+        if (obj)
+            pdf_object_destroy(obj);
     }
 }
 
-static struct pdf_object *pdf_find_first_object(const struct pdf_doc *pdf,
+int pdf_reset(struct pdf_doc *pdf, float width, float height,
+              const struct pdf_info *info)
+{
+    if (!pdf)
+        return -EINVAL;
+    if (pdf->stream)
+        return pdf_set_err(pdf, -EINVAL,
+                           "Streaming documents can't be reset");
+
+    /* Keep some page content buffers, for the pages of the next document */
+    for (int i = 0; i < flexarray_size(&pdf->objects) &&
+                    pdf->spare_count < PDF_SPARE_BUFFERS;
+         i++) {
+        struct pdf_object *obj = pdf_get_object(pdf, i);
+
+        if (obj && obj->type == OBJ_stream && obj->stream.stream.data) {
+            struct dbuf *spare = &pdf->spare_buffers[pdf->spare_count++];
+
+            *spare = obj->stream.stream;
+            spare->len = 0;
+            obj->stream.stream.data = NULL;
+        }
+    }
+    pdf_destroy_objects(pdf);
+    pdf_arena_reset(pdf);
+    flexarray_reset(&pdf->objects);
+    flexarray_reset(&pdf->pages);
+    flexarray_reset(&pdf->fonts);
+    if (pdf->font_table)
+        memset(pdf->font_table, 0,
+               pdf->font_table_size * sizeof(*pdf->font_table));
+    if (pdf->image_cache)
+        memset(pdf->image_cache, 0,
+               pdf->image_cache_size * sizeof(*pdf->image_cache));
+    pdf->image_cache_count = 0;
+    memset(pdf->resources, 0, sizeof(pdf->resources));
+    memset(pdf->first_objects, 0, sizeof(pdf->first_objects));
+    memset(pdf->last_objects, 0, sizeof(pdf->last_objects));
+    pdf->current_font = NULL;
+    pdf->current_template = NULL;
+    pdf->flushed_objects = 0;
+    pdf_clear_err(pdf);
+    pdf->width = width;
+    pdf->height = height;
+
+    return pdf_init(pdf, info);
+}
+
+void pdf_destroy(struct pdf_doc *pdf)
+{
+    if (pdf) {
+        pdf_destroy_objects(pdf);
+        while (pdf->arena) {
+            struct pdf_arena_chunk *chunk = pdf->arena;
+
+            pdf->arena = chunk->next;
+            free(chunk);
+        }
+        for (int i = 0; i < pdf->spare_count; i++)
+            dbuf_free(&pdf->spare_buffers[i]);
+        dstr_free(&pdf->output_pending);
+        flexarray_clear(&pdf->objects);
+        flexarray_clear(&pdf->pages);
+        flexarray_clear(&pdf->fonts);
+        free(pdf->font_table);
+        free(pdf->glyphs.codes);
+        free(pdf->glyphs.gids);
+        free(pdf->glyphs.offsets);
+        free(pdf->glyphs.widths);
+        flate_free(pdf->flate);
+        free(pdf->image_cache);
+        if (pdf->stream)
+            dstr_free(&pdf->stream->pending);
+        free(pdf->stream);
+        free(pdf);
+    }
+}
+
+static struct pdf_object *pdf_find_first_object(const struct pdf_doc *pdf,
                                                 int type)
 {
     if (!pdf)
@@ -824,882 +1934,2909 @@ static struct pdf_object *pdf_find_last_object(const struct pdf_doc *pdf,
     return pdf->last_objects[type];
 }
 
-int pdf_set_font(struct pdf_doc *pdf, const char *font)
+int pdf_set_compression(struct pdf_doc *pdf, int level)
 {
-    struct pdf_object *obj;
-    int last_index = 0;
-
-    /* See if we've used this font before */
-    for (obj = pdf_find_first_object(pdf, OBJ_font); obj; obj = obj->next) {
-        if (strcmp(obj->font.name, font) == 0)
-            break;
-        last_index = obj->font.index;
-    }
-
-    /* Create a new font object if we need it */
-    if (!obj) {
-        obj = pdf_add_object(pdf, OBJ_font);
-        if (!obj)
-            return pdf->errval;
-        strncpy(obj->font.name, font, sizeof(obj->font.name) - 1);
-        obj->font.name[sizeof(obj->font.name) - 1] = '\0';
-        obj->font.index = last_index + 1;
-    }
-
-    pdf->current_font = obj;
-
+    if (level < 0 || level > 9)
+        return pdf_set_err(pdf, -EINVAL, "Invalid compression level %d",
+                           level);
+    if (pdf->flate && pdf->flate->level != level) {
+        flate_free(pdf->flate);
+        pdf->flate = NULL;
+    }
+    pdf->compression = level;
     return 0;
 }
 
-struct pdf_object *pdf_append_page(struct pdf_doc *pdf)
+int pdf_set_kerning(struct pdf_doc *pdf, int kerning)
 {
-    struct pdf_object *page;
-
-    page = pdf_add_object(pdf, OBJ_page);
+    pdf->kerning = kerning != 0;
+    return 0;
+}
 
-    if (!page)
-        return NULL;
+static const uint16_t *find_font_widths(const char *font_name);
+static const struct kern_table *find_font_kerns(const char *font_name);
+static int font_kerning(const struct kern_table *kerns, uint8_t left,
+                        uint8_t right);
+static uint64_t hash(uint64_t hash, const void *data, size_t len);
+static uint8_t *get_file(struct pdf_doc *pdf, const char *file_name,
+                         size_t *length);
 
-    page->page.width = pdf->width;
-    page->page.height = pdf->height;
+static struct pdf_object **font_table_slot(const struct pdf_doc *pdf,
+                                           const char *font)
+{
+    size_t mask = pdf->font_table_size - 1;
 
-    return page;
+    for (size_t i = hash(5381, font, strlen(font)) & mask;;
+         i = (i + 1) & mask) {
+        struct pdf_object **slot = &pdf->font_table[i];
+        if (!*slot || strcmp((*slot)->font.name, font) == 0)
+            return slot;
+    }
 }
 
-struct pdf_object *pdf_get_page(struct pdf_doc *pdf, int page_number)
+/**
+ * Find a font which has already been added to the document
+ */
+static struct pdf_object *pdf_find_font(const struct pdf_doc *pdf,
+                                        const char *font)
 {
-    if (page_number <= 0) {
-        pdf_set_err(pdf, -EINVAL, "page number must be >= 1");
+    if (!pdf->font_table_size)
         return NULL;
-    }
+    return *font_table_slot(pdf, font);
+}
 
-    for (struct pdf_object *obj = pdf_find_first_object(pdf, OBJ_page); obj;
-         obj = obj->next, page_number--) {
-        if (page_number == 1) {
-            return obj;
+static int font_table_add(struct pdf_doc *pdf, struct pdf_object *font)
+{
+    /* Keep the table at most half full */
+    if ((size_t)flexarray_size(&pdf->fonts) * 2 > pdf->font_table_size) {
+        struct pdf_object **old = pdf->font_table;
+        size_t old_size = pdf->font_table_size;
+        size_t new_size = old_size ? old_size * 2 : 32;
+
+        pdf->font_table =
+            (struct pdf_object **)calloc(new_size, sizeof(*pdf->font_table));
+        if (!pdf->font_table) {
+            pdf->font_table = old;
+            return pdf_set_err(pdf, -ENOMEM, "Unable to allocate font table");
         }
+        pdf->font_table_size = new_size;
+        for (size_t i = 0; i < old_size; i++)
+            if (old[i])
+                *font_table_slot(pdf, old[i]->font.name) = old[i];
+        free(old);
     }
 
-    pdf_set_err(pdf, -EINVAL, "no such page");
-    return NULL;
+    *font_table_slot(pdf, font->font.name) = font;
+    return 0;
 }
 
-int pdf_page_set_size(struct pdf_doc *pdf, struct pdf_object *page,
-                      float width, float height)
+int pdf_get_font_handle(struct pdf_doc *pdf, const char *font)
 {
-    if (!page)
-        page = pdf_find_last_object(pdf, OBJ_page);
+    struct pdf_object *obj;
 
-    if (!page || page->type != OBJ_page)
-        return pdf_set_err(pdf, -EINVAL, "Invalid PDF page");
-    page->page.width = width;
-    page->page.height = height;
-    return 0;
+    if (!font)
+        return pdf_set_err(pdf, -EINVAL, "No font name supplied");
+
+    /* See if we've used this font before */
+    obj = pdf_find_font(pdf, font);
+    if (obj)
+        return obj->font.index;
+
+    /* Create a new font object if we need it */
+    obj = pdf_add_object(pdf, OBJ_font);
+    if (!obj)
+        return pdf->errval;
+    strncpy(obj->font.name, font, sizeof(obj->font.name) - 1);
+    obj->font.name[sizeof(obj->font.name) - 1] = '\0';
+    obj->font.widths = find_font_widths(obj->font.name);
+    obj->font.kerns = find_font_kerns(obj->font.name);
+    if (flexarray_append(&pdf->fonts, obj) < 0)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to grow font list");
+    obj->font.index = flexarray_size(&pdf->fonts);
+    if (font_table_add(pdf, obj) < 0)
+        return pdf->errval;
+
+    return obj->font.index;
 }
 
-// Recursively scan for the number of children
-static int pdf_get_bookmark_count(const struct pdf_object *obj)
+int pdf_set_font_handle(struct pdf_doc *pdf, int handle)
 {
-    int count = 0;
-    if (obj->type == OBJ_bookmark) {
-        int nchildren = flexarray_size(&obj->bookmark.children);
-        count += nchildren;
-        for (int i = 0; i < nchildren; i++) {
-            count += pdf_get_bookmark_count(
-                (const struct pdf_object *)flexarray_get(
-                    &obj->bookmark.children, i));
-        }
-    }
-    return count;
+    struct pdf_object *obj;
+
+    obj = (struct pdf_object *)flexarray_get(&pdf->fonts, handle - 1);
+    if (handle <= 0 || !obj)
+        return pdf_set_err(pdf, -EINVAL, "Invalid font handle %d", handle);
+
+    pdf->current_font = obj;
+
+    return 0;
 }
 
-static int pdf_save_object(struct pdf_doc *pdf, FILE *fp, int index)
+int pdf_set_font(struct pdf_doc *pdf, const char *font)
 {
-    struct pdf_object *object = pdf_get_object(pdf, index);
-    if (!object)
-        return -ENOENT;
-
-    if (object->type == OBJ_none)
-        return -ENOENT;
+    int handle = pdf_get_font_handle(pdf, font);
 
-    object->offset = ftell(fp);
+    if (handle < 0)
+        return handle;
+    return pdf_set_font_handle(pdf, handle);
+}
 
-    fprintf(fp, "%d 0 obj\r\n", index);
+/*
+ * TrueType fonts
+ *
+ * These are embedded as a Type0 font with a CIDFontType2 descendant, and
+ * text is drawn with 2 byte glyph IDs (Identity-H). The embedded font file
+ * keeps the original glyph IDs, but only has the outlines of the glyphs
+ * which were drawn, so it is only as large as the text needs.
+ */
 
-    switch (object->type) {
-    case OBJ_stream:
-    case OBJ_image: {
-        fwrite(dstr_data(&object->stream.stream),
-               dstr_len(&object->stream.stream), 1, fp);
-        break;
-    }
-    case OBJ_info: {
-        struct pdf_info *info = object->info;
+static inline uint16_t ttf_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
 
-        fprintf(fp, "<<\r\n");
-        if (info->creator[0])
-            fprintf(fp, "  /Creator (%s)\r\n", info->creator);
-        if (info->producer[0])
-            fprintf(fp, "  /Producer (%s)\r\n", info->producer);
-        if (info->title[0])
-            fprintf(fp, "  /Title (%s)\r\n", info->title);
-        if (info->author[0])
-            fprintf(fp, "  /Author (%s)\r\n", info->author);
-        if (info->subject[0])
-            fprintf(fp, "  /Subject (%s)\r\n", info->subject);
-        if (info->date[0])
-            fprintf(fp, "  /CreationDate (D:%s)\r\n", info->date);
-        fprintf(fp, ">>\r\n");
-        break;
-    }
+static inline int16_t ttf_s16(const uint8_t *p)
+{
+    return (int16_t)ttf_u16(p);
+}
 
-    case OBJ_page: {
-        struct pdf_object *pages = pdf_find_first_object(pdf, OBJ_pages);
-        bool printed_xobjects = false;
+static inline uint32_t ttf_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+}
 
-        fprintf(fp,
-                "<<\r\n"
-                "  /Type /Page\r\n"
-                "  /Parent %d 0 R\r\n",
-                pages->index);
-        fprintf(fp, "  /MediaBox [0 0 %f %f]\r\n", object->page.width,
-                object->page.height);
-        fprintf(fp, "  /Resources <<\r\n");
-        fprintf(fp, "    /Font <<\r\n");
-        for (struct pdf_object *font = pdf_find_first_object(pdf, OBJ_font);
-             font; font = font->next)
-            fprintf(fp, "      /F%d %d 0 R\r\n", font->font.index,
-                    font->index);
-        fprintf(fp, "    >>\r\n");
-        // We trim transparency to just 4-bits
-        fprintf(fp, "    /ExtGState <<\r\n");
-        for (int i = 0; i < 16; i++) {
-            fprintf(fp, "      /GS%d <</ca %f>>\r\n", i,
-                    (float)(15 - i) / 15);
-        }
-        fprintf(fp, "    >>\r\n");
-
-        for (struct pdf_object *image = pdf_find_first_object(pdf, OBJ_image);
-             image; image = image->next) {
-            if (image->stream.page == object) {
-                if (!printed_xobjects) {
-                    fprintf(fp, "    /XObject <<");
-                    printed_xobjects = true;
-                }
-                fprintf(fp, "      /Image%d %d 0 R ", image->index,
-                        image->index);
-            }
-        }
-        if (printed_xobjects)
-            fprintf(fp, "    >>\r\n");
-        fprintf(fp, "  >>\r\n");
-
-        fprintf(fp, "  /Contents [\r\n");
-        for (int i = 0; i < flexarray_size(&object->page.children); i++) {
-            struct pdf_object *child =
-                (struct pdf_object *)flexarray_get(&object->page.children, i);
-            fprintf(fp, "%d 0 R\r\n", child->index);
-        }
-        fprintf(fp, "]\r\n");
+static inline void ttf_put16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
 
-        if (flexarray_size(&object->page.annotations)) {
-            fprintf(fp, "  /Annots [\r\n");
-            for (int i = 0; i < flexarray_size(&object->page.annotations);
-                 i++) {
-                struct pdf_object *child = (struct pdf_object *)flexarray_get(
-                    &object->page.annotations, i);
-                fprintf(fp, "%d 0 R\r\n", child->index);
-            }
-            fprintf(fp, "]\r\n");
-        }
+static inline void ttf_put32(uint8_t *p, uint32_t value)
+{
+    ttf_put16(p, (uint16_t)(value >> 16));
+    ttf_put16(p + 2, (uint16_t)value);
+}
 
-        fprintf(fp, ">>\r\n");
-        break;
-    }
+static const char ttf_table_tags[TTF_TABLE_count][5] = {
+    "cvt ", "fpgm", "glyf", "head", "hhea", "hmtx", "loca", "maxp", "prep",
+};
 
-    case OBJ_bookmark: {
-        struct pdf_object *parent, *other;
+/**
+ * Find a table in a font file
+ * @return Start of the table, or NULL if it isn't there
+ */
+static const uint8_t *ttf_find_table(const uint8_t *data, size_t len,
+                                     const char *tag, uint32_t *table_len)
+{
+    uint16_t count;
 
-        parent = object->bookmark.parent;
-        if (!parent)
-            parent = pdf_find_first_object(pdf, OBJ_outline);
-        if (!object->bookmark.page)
-            break;
-        fprintf(fp,
-                "<<\r\n"
-                "  /Dest [%d 0 R /XYZ 0 %f null]\r\n"
-                "  /Parent %d 0 R\r\n"
-                "  /Title (%s)\r\n",
-                object->bookmark.page->index, pdf->height, parent->index,
-                object->bookmark.name);
-        int nchildren = flexarray_size(&object->bookmark.children);
-        if (nchildren > 0) {
-            struct pdf_object *f, *l;
-            f = (struct pdf_object *)flexarray_get(&object->bookmark.children,
-                                                   0);
-            l = (struct pdf_object *)flexarray_get(&object->bookmark.children,
-                                                   nchildren - 1);
-            fprintf(fp, "  /First %d 0 R\r\n", f->index);
-            fprintf(fp, "  /Last %d 0 R\r\n", l->index);
-            fprintf(fp, "  /Count %d\r\n", pdf_get_bookmark_count(object));
-        }
-        // Find the previous bookmark with the same parent
-        for (other = object->prev;
-             other && other->bookmark.parent != object->bookmark.parent;
-             other = other->prev)
-            ;
-        if (other)
-            fprintf(fp, "  /Prev %d 0 R\r\n", other->index);
-        // Find the next bookmark with the same parent
-        for (other = object->next;
-             other && other->bookmark.parent != object->bookmark.parent;
-             other = other->next)
-            ;
-        if (other)
-            fprintf(fp, "  /Next %d 0 R\r\n", other->index);
-        fprintf(fp, ">>\r\n");
-        break;
+    if (len < 12)
+        return NULL;
+    count = ttf_u16(data + 4);
+    for (uint32_t i = 0; i < count && 12 + (i + 1) * 16 <= len; i++) {
+        const uint8_t *record = data + 12 + i * 16;
+        uint32_t offset = ttf_u32(record + 8);
+        uint32_t length = ttf_u32(record + 12);
+
+        if (memcmp(record, tag, 4) != 0)
+            continue;
+        if (offset > len || length > len - offset)
+            return NULL;
+        *table_len = length;
+        return data + offset;
     }
+    return NULL;
+}
 
-    case OBJ_outline: {
-        struct pdf_object *first, *last, *cur;
-        first = pdf_find_first_object(pdf, OBJ_bookmark);
-        last = pdf_find_last_object(pdf, OBJ_bookmark);
+static void ttf_free(struct pdf_ttf *ttf)
+{
+    if (!ttf)
+        return;
+    for (size_t i = 0; i < ARRAY_SIZE(ttf->cmap); i++)
+        free(ttf->cmap[i]);
+    free(ttf->advances);
+    free(ttf->data);
+    free(ttf->filename);
+    free(ttf);
+}
 
-        if (first && last) {
-            int count = 0;
-            cur = first;
-            while (cur) {
-                if (!cur->bookmark.parent)
-                    count += pdf_get_bookmark_count(cur) + 1;
-                cur = cur->next;
-            }
+/**
+ * Find the glyph for a character
+ * @return Glyph ID, or 0 (.notdef) if the font doesn't have the character
+ */
+static uint16_t ttf_glyph(const struct pdf_ttf *ttf, uint32_t code)
+{
+    uint32_t lo = 0, hi = ttf->cmap_group_count;
 
-            /* Bookmark outline */
-            fprintf(fp,
-                    "<<\r\n"
-                    "  /Count %d\r\n"
-                    "  /Type /Outlines\r\n"
-                    "  /First %d 0 R\r\n"
-                    "  /Last %d 0 R\r\n"
-                    ">>\r\n",
-                    count, first->index, last->index);
-        }
-        break;
+    if (code <= 0xffff) {
+        const uint16_t *page = ttf->cmap[code >> 8];
+        return page ? page[code & 0xff] : 0;
     }
 
-    case OBJ_font:
-        fprintf(fp,
-                "<<\r\n"
-                "  /Type /Font\r\n"
-                "  /Subtype /Type1\r\n"
-                "  /BaseFont /%s\r\n"
-                "  /Encoding /WinAnsiEncoding\r\n"
-                ">>\r\n",
-                object->font.name);
-        break;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const uint8_t *group = ttf->cmap_groups + mid * 12;
 
-    case OBJ_pages: {
-        int npages = 0;
-
-        fprintf(fp, "<<\r\n"
-                    "  /Type /Pages\r\n"
-                    "  /Kids [ ");
-        for (struct pdf_object *page = pdf_find_first_object(pdf, OBJ_page);
-             page; page = page->next) {
-            npages++;
-            fprintf(fp, "%d 0 R ", page->index);
+        if (code < ttf_u32(group)) {
+            hi = mid;
+        } else if (code > ttf_u32(group + 4)) {
+            lo = mid + 1;
+        } else {
+            uint32_t glyph = ttf_u32(group + 8) + code - ttf_u32(group);
+            return glyph < ttf->glyph_count ? (uint16_t)glyph : 0;
         }
-        fprintf(fp, "]\r\n");
-        fprintf(fp, "  /Count %d\r\n", npages);
-        fprintf(fp, ">>\r\n");
-        break;
     }
+    return 0;
+}
 
-    case OBJ_catalog: {
-        struct pdf_object *outline = pdf_find_first_object(pdf, OBJ_outline);
-        struct pdf_object *pages = pdf_find_first_object(pdf, OBJ_pages);
+static int ttf_set_glyph(struct pdf_doc *pdf, struct pdf_ttf *ttf,
+                         uint32_t code, uint32_t glyph)
+{
+    uint16_t **page = &ttf->cmap[code >> 8];
 
-        fprintf(fp, "<<\r\n"
-                    "  /Type /Catalog\r\n");
-        if (outline)
-            fprintf(fp,
-                    "  /Outlines %d 0 R\r\n"
-                    "  /PageMode /UseOutlines\r\n",
-                    outline->index);
-        fprintf(fp,
-                "  /Pages %d 0 R\r\n"
-                ">>\r\n",
-                pages->index);
-        break;
+    if (code > 0xffff || glyph == 0 || glyph >= ttf->glyph_count)
+        return 0;
+    if (!*page) {
+        *page = (uint16_t *)calloc(256, sizeof(**page));
+        if (!*page)
+            return pdf_set_err(pdf, -ENOMEM,
+                               "Unable to allocate font character map");
     }
+    (*page)[code & 0xff] = (uint16_t)glyph;
+    return 0;
+}
 
-    case OBJ_link: {
-        fprintf(fp,
-                "<<\r\n"
-                "  /Type /Annot\r\n"
-                "  /Subtype /Link\r\n"
-                "  /Rect [%f %f %f %f]\r\n"
-                "  /Dest [%u 0 R /XYZ %f %f null]\r\n"
-                "  /Border [0 0 0]\r\n"
-                ">>\r\n",
-                object->link.llx, object->link.lly, object->link.urx,
-                object->link.ury, object->link.target_page->index,
-                object->link.target_x, object->link.target_y);
-        break;
+/**
+ * Load the Unicode character map of the font. Characters in the BMP are
+ * put in a lookup table, so that finding their glyphs is cheap.
+ */
+static int ttf_parse_cmap(struct pdf_doc *pdf, struct pdf_ttf *ttf)
+{
+    const uint8_t *cmap, *format4 = NULL, *format12 = NULL;
+    uint32_t cmap_len, len4 = 0, len12 = 0;
+
+    cmap = ttf_find_table(ttf->data, ttf->len, "cmap", &cmap_len);
+    if (!cmap || cmap_len < 4)
+        return pdf_set_err(pdf, -EINVAL, "Font has no character map");
+
+    for (uint32_t i = 0;
+         i < ttf_u16(cmap + 2) && 4 + (i + 1) * 8 <= cmap_len; i++) {
+        const uint8_t *record = cmap + 4 + i * 8;
+        uint16_t platform = ttf_u16(record);
+        uint16_t encoding = ttf_u16(record + 2);
+        uint32_t offset = ttf_u32(record + 4);
+
+        /* Only the Unicode character maps are of any use */
+        if (platform != 0 &&
+            !(platform == 3 && (encoding == 1 || encoding == 10)))
+            continue;
+        if (offset > cmap_len - 4)
+            continue;
+        if (ttf_u16(cmap + offset) == 4 && cmap_len - offset >= 14) {
+            format4 = cmap + offset;
+            len4 = cmap_len - offset;
+        } else if (ttf_u16(cmap + offset) == 12 && cmap_len - offset >= 16) {
+            format12 = cmap + offset;
+            len12 = cmap_len - offset;
+        }
     }
 
-    default:
-        return pdf_set_err(pdf, -EINVAL, "Invalid PDF object type %d",
-                           object->type);
+    if (format12) {
+        uint32_t count = ttf_u32(format12 + 12);
+        uint32_t next = 0;
+
+        if (count > (len12 - 16) / 12)
+            return pdf_set_err(pdf, -EINVAL, "Invalid font character map");
+        ttf->cmap_groups = format12 + 16;
+        ttf->cmap_group_count = count;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint8_t *group = ttf->cmap_groups + i * 12;
+            uint32_t start = ttf_u32(group);
+            uint32_t end = ttf_u32(group + 4);
+            uint32_t glyph = ttf_u32(group + 8);
+
+            /* Groups must be sorted, which also limits the work here */
+            if (start < next || end < start || end > 0x10ffff)
+                return pdf_set_err(pdf, -EINVAL,
+                                   "Invalid font character map");
+            next = end + 1;
+            for (uint32_t code = start; code <= end && code <= 0xffff;
+                 code++)
+                if (ttf_set_glyph(pdf, ttf, code, glyph + code - start) < 0)
+                    return pdf->errval;
+        }
+    } else if (format4) {
+        uint32_t seg_x2 = ttf_u16(format4 + 6);
+        const uint8_t *ends = format4 + 14;
+        const uint8_t *starts = ends + seg_x2 + 2;
+        const uint8_t *deltas = starts + seg_x2;
+        const uint8_t *range_offsets = deltas + seg_x2;
+        uint32_t next = 0;
+
+        if (16 + seg_x2 * 4 > len4)
+            return pdf_set_err(pdf, -EINVAL, "Invalid font character map");
+        for (uint32_t i = 0; i < seg_x2; i += 2) {
+            uint32_t start = ttf_u16(starts + i);
+            uint32_t end = ttf_u16(ends + i);
+            uint16_t delta = ttf_u16(deltas + i);
+            uint32_t range_offset = ttf_u16(range_offsets + i);
+            uint32_t pos = (uint32_t)(range_offsets + i - format4);
+
+            /* Segments must be sorted, which also limits the work here */
+            if (start < next || end < start)
+                return pdf_set_err(pdf, -EINVAL,
+                                   "Invalid font character map");
+            next = end + 1;
+            for (uint32_t code = start; code <= end && code < 0xffff;
+                 code++) {
+                uint32_t glyph;
+
+                if (range_offset == 0) {
+                    glyph = (code + delta) & 0xffff;
+                } else {
+                    uint32_t at = pos + range_offset + (code - start) * 2;
+                    if (at + 2 > len4)
+                        continue;
+                    glyph = ttf_u16(format4 + at);
+                    if (glyph)
+                        glyph = (glyph + delta) & 0xffff;
+                }
+                if (ttf_set_glyph(pdf, ttf, code, glyph) < 0)
+                    return pdf->errval;
+            }
+        }
+    } else {
+        return pdf_set_err(pdf, -EINVAL, "Font has no Unicode character map");
     }
 
-    fprintf(fp, "endobj\r\n");
-
     return 0;
 }
 
-// Slightly modified djb2 hash algorithm to get pseudo-random ID
-static uint64_t hash(uint64_t hash, const void *data, size_t len)
+/**
+ * Find the PostScript name of the font, leaving out anything which isn't
+ * allowed in a PDF name
+ */
+static void ttf_parse_name(struct pdf_ttf *ttf)
 {
-    const uint8_t *d8 = (const uint8_t *)data;
-    for (; len; len--) {
-        hash = (((hash & 0x03ffffffffffffff) << 5) +
-                (hash & 0x7fffffffffffffff)) +
-               *d8++;
+    const uint8_t *name;
+    uint32_t name_len;
+    size_t n = 0;
+
+    name = ttf_find_table(ttf->data, ttf->len, "name", &name_len);
+    if (name && name_len >= 6) {
+        uint32_t strings = ttf_u16(name + 4);
+
+        for (uint32_t i = 0;
+             i < ttf_u16(name + 2) && 6 + (i + 1) * 12 <= name_len && !n;
+             i++) {
+            const uint8_t *record = name + 6 + i * 12;
+            uint16_t platform = ttf_u16(record);
+            uint32_t length = ttf_u16(record + 8);
+            uint32_t offset = strings + ttf_u16(record + 10);
+            /* Windows & Unicode names are UTF-16, Mac ones are 8-bit */
+            uint32_t step = platform == 1 ? 1 : 2;
+
+            if (ttf_u16(record + 6) != 6 || offset + length > name_len)
+                continue;
+            for (uint32_t j = 0; j + step <= length; j += step) {
+                uint8_t ch = name[offset + j + step - 1];
+
+                if (n >= sizeof(ttf->name) - 1)
+                    break;
+                if ((step == 2 && name[offset + j]) || ch <= ' ' ||
+                    ch >= 0x7f || strchr("()<>[]{}/%#", ch))
+                    continue;
+                ttf->name[n++] = (char)ch;
+            }
+        }
     }
-    return hash;
+    ttf->name[n] = '\0';
+    if (!n)
+        strcpy(ttf->name, "TrueTypeFont");
 }
 
-int pdf_save_file(struct pdf_doc *pdf, FILE *fp)
+/**
+ * Parse a TrueType font file, which is taken over (and freed on failure)
+ * @return Parsed font, or NULL on failure
+ */
+static struct pdf_ttf *ttf_load(struct pdf_doc *pdf, uint8_t *data,
+                                size_t len)
 {
-    struct pdf_object *obj;
-    int xref_offset;
-    int xref_count = 0;
-    uint64_t id1, id2;
-    time_t now = time(NULL);
-    char saved_locale[32];
+    struct pdf_ttf *ttf;
+    const uint8_t *head, *hhea, *maxp, *hmtx, *table;
+    uint32_t table_len;
+    uint16_t metric_count;
+
+    ttf = (struct pdf_ttf *)calloc(1, sizeof(*ttf));
+    if (!ttf) {
+        free(data);
+        pdf_set_err(pdf, -ENOMEM, "Unable to allocate font");
+        return NULL;
+    }
+    ttf->data = data;
+    ttf->len = len;
 
-    force_locale(saved_locale, sizeof(saved_locale));
+    if (len < 12 || (ttf_u32(data) != 0x00010000 &&
+                     ttf_u32(data) != 0x74727565 /* 'true' */)) {
+        if (len >= 4 && ttf_u32(data) == 0x4f54544f /* 'OTTO' */)
+            pdf_set_err(pdf, -EINVAL,
+                        "OpenType fonts with CFF outlines are not supported");
+        else
+            pdf_set_err(pdf, -EINVAL, "Not a TrueType font");
+        goto fail;
+    }
+
+    for (int i = 0; i < TTF_TABLE_count; i++) {
+        table = ttf_find_table(data, len, ttf_table_tags[i], &table_len);
+        if (table) {
+            ttf->tables[i].offset = (uint32_t)(table - data);
+            ttf->tables[i].len = table_len;
+        } else if (i != TTF_CVT && i != TTF_FPGM && i != TTF_PREP) {
+            pdf_set_err(pdf, -EINVAL, "Font has no '%s' table",
+                        ttf_table_tags[i]);
+            goto fail;
+        }
+    }
 
-    fprintf(fp, "%%PDF-1.3\r\n");
-    /* Hibit bytes */
-    fprintf(fp, "%c%c%c%c%c\r\n", 0x25, 0xc7, 0xec, 0x8f, 0xa2);
+    head = data + ttf->tables[TTF_HEAD].offset;
+    hhea = data + ttf->tables[TTF_HHEA].offset;
+    maxp = data + ttf->tables[TTF_MAXP].offset;
+    hmtx = data + ttf->tables[TTF_HMTX].offset;
+    if (ttf->tables[TTF_HEAD].len < 54 || ttf->tables[TTF_HHEA].len < 36 ||
+        ttf->tables[TTF_MAXP].len < 6)
+        goto invalid;
+
+    ttf->units_per_em = ttf_u16(head + 18);
+    for (int i = 0; i < 4; i++)
+        ttf->bbox[i] = ttf_s16(head + 36 + i * 2);
+    ttf->loca_long = ttf_s16(head + 50) != 0;
+    ttf->glyph_count = ttf_u16(maxp + 4);
+    ttf->ascent = ttf_s16(hhea + 4);
+    ttf->descent = ttf_s16(hhea + 6);
+    ttf->cap_height = ttf->ascent;
+    metric_count = ttf_u16(hhea + 34);
+    if (ttf->units_per_em < 16 || ttf->units_per_em > 16384 ||
+        !ttf->glyph_count || !metric_count ||
+        metric_count > ttf->glyph_count ||
+        metric_count * 4u > ttf->tables[TTF_HMTX].len ||
+        (ttf->glyph_count + 1u) * (ttf->loca_long ? 4 : 2) >
+            ttf->tables[TTF_LOCA].len)
+        goto invalid;
+
+    ttf->advances =
+        (uint16_t *)malloc(ttf->glyph_count * sizeof(*ttf->advances));
+    if (!ttf->advances) {
+        pdf_set_err(pdf, -ENOMEM, "Unable to allocate font metrics");
+        goto fail;
+    }
+    for (uint32_t i = 0; i < ttf->glyph_count; i++)
+        ttf->advances[i] = i < metric_count ? ttf_u16(hmtx + i * 4)
+                                            : ttf->advances[i - 1];
+
+    table = ttf_find_table(data, len, "OS/2", &table_len);
+    if (table && table_len >= 90 && ttf_u16(table) >= 2)
+        ttf->cap_height = ttf_s16(table + 88);
+    table = ttf_find_table(data, len, "post", &table_len);
+    if (table && table_len >= 16) {
+        ttf->italic_angle = (int32_t)ttf_u32(table + 4) / 65536.0f;
+        ttf->fixed_pitch = ttf_u32(table + 12) != 0;
+    }
+
+    ttf_parse_name(ttf);
+    if (ttf_parse_cmap(pdf, ttf) < 0)
+        goto fail;
+
+    return ttf;
+
+invalid:
+    pdf_set_err(pdf, -EINVAL, "Invalid TrueType font");
+fail:
+    ttf_free(ttf);
+    return NULL;
+}
 
-    /* Dump all the objects & get their file offsets */
-    for (int i = 0; i < flexarray_size(&pdf->objects); i++)
-        if (pdf_save_object(pdf, fp, i) >= 0)
-            xref_count++;
+/*
+ * Parsed fonts never change, so they are shared by all the documents in the
+ * process (each document only tracks which glyphs it has used). They stay
+ * cached when no document is using them, until pdf_clear_font_cache().
+ */
+#ifdef _WIN32
+static SRWLOCK font_cache_mutex = SRWLOCK_INIT;
+#define font_cache_lock() AcquireSRWLockExclusive(&font_cache_mutex)
+#define font_cache_unlock() ReleaseSRWLockExclusive(&font_cache_mutex)
+#else
+static pthread_mutex_t font_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define font_cache_lock() pthread_mutex_lock(&font_cache_mutex)
+#define font_cache_unlock() pthread_mutex_unlock(&font_cache_mutex)
+#endif
+static struct pdf_ttf *font_cache;
 
-    /* xref */
-    xref_offset = ftell(fp);
-    fprintf(fp, "xref\r\n");
-    fprintf(fp, "0 %d\r\n", xref_count + 1);
-    fprintf(fp, "0000000000 65535 f\r\n");
-    for (int i = 0; i < flexarray_size(&pdf->objects); i++) {
-        obj = pdf_get_object(pdf, i);
-        if (obj->type != OBJ_none)
-            fprintf(fp, "%10.10d 00000 n\r\n", obj->offset);
-    }
+/**
+ * Find a cached font loaded from a file, which hasn't changed since
+ * @return Font with a reference taken, or NULL if it isn't cached
+ */
+static struct pdf_ttf *ttf_cache_find_file(const char *filename,
+                                           const struct stat *st)
+{
+    struct pdf_ttf *ttf;
 
-    fprintf(fp,
-            "trailer\r\n"
-            "<<\r\n"
-            "/Size %d\r\n",
-            xref_count + 1);
-    obj = pdf_find_first_object(pdf, OBJ_catalog);
-    fprintf(fp, "/Root %d 0 R\r\n", obj->index);
-    obj = pdf_find_first_object(pdf, OBJ_info);
-    fprintf(fp, "/Info %d 0 R\r\n", obj->index);
-    /* Generate document unique IDs */
-    id1 = hash(5381, obj->info, sizeof(struct pdf_info));
-    id1 = hash(id1, &xref_count, sizeof(xref_count));
-    id2 = hash(5381, &now, sizeof(now));
-    fprintf(fp, "/ID [<%16.16" PRIx64 "> <%16.16" PRIx64 ">]\r\n", id1, id2);
-    fprintf(fp, ">>\r\n"
-                "startxref\r\n");
-    fprintf(fp, "%d\r\n", xref_offset);
-    fprintf(fp, "%%%%EOF\r\n");
+    font_cache_lock();
+    for (ttf = font_cache; ttf; ttf = ttf->next)
+        if (ttf->filename && strcmp(ttf->filename, filename) == 0 &&
+            ttf->len == (size_t)st->st_size && ttf->mtime == st->st_mtime)
+            break;
+    if (ttf)
+        ttf->refs++;
+    font_cache_unlock();
+    return ttf;
+}
 
-    restore_locale(saved_locale);
+/**
+ * Find a cached font with the given contents
+ * @return Font with a reference taken, or NULL if it isn't cached
+ */
+static struct pdf_ttf *ttf_cache_find_data(const void *data, size_t len,
+                                           uint32_t hash)
+{
+    struct pdf_ttf *ttf;
 
-    return 0;
+    font_cache_lock();
+    for (ttf = font_cache; ttf; ttf = ttf->next)
+        if (ttf->len == len && ttf->hash == hash &&
+            memcmp(ttf->data, data, len) == 0)
+            break;
+    if (ttf)
+        ttf->refs++;
+    font_cache_unlock();
+    return ttf;
 }
 
-int pdf_save(struct pdf_doc *pdf, const char *filename)
+/**
+ * Add a newly parsed font to the cache. If another thread cached the same
+ * font in the meantime, ours is freed and theirs is used instead.
+ * @return Font with a reference taken
+ */
+static struct pdf_ttf *ttf_cache_add(struct pdf_ttf *ttf)
 {
-    FILE *fp;
-    int e;
-
-    if (filename == NULL)
-        fp = stdout;
-    else if ((fp = fopen(filename, "wb")) == NULL)
-        return pdf_set_err(pdf, -errno, "Unable to open '%s': %s", filename,
-                           strerror(errno));
+    struct pdf_ttf *cached;
 
-    e = pdf_save_file(pdf, fp);
+    font_cache_lock();
+    for (cached = font_cache; cached; cached = cached->next)
+        if (cached->len == ttf->len && cached->hash == ttf->hash &&
+            memcmp(cached->data, ttf->data, ttf->len) == 0)
+            break;
+    if (!cached) {
+        ttf->next = font_cache;
+        font_cache = ttf;
+        cached = ttf;
+        ttf = NULL;
+    } else if (!cached->filename && ttf->filename) {
+        cached->filename = ttf->filename;
+        cached->mtime = ttf->mtime;
+        ttf->filename = NULL;
+    }
+    cached->refs++;
+    font_cache_unlock();
+
+    ttf_free(ttf);
+    return cached;
+}
 
-    if (fp != stdout)
-        if (fclose(fp) != 0 && e >= 0)
-            return pdf_set_err(pdf, -errno, "Unable to close '%s': %s",
-                               filename, strerror(errno));
+/**
+ * Record the file a cached font was loaded from, if it was first loaded
+ * from memory, so that loading the file again finds it without reading it
+ */
+static void ttf_cache_set_file(struct pdf_ttf *ttf, const char *filename,
+                               time_t mtime)
+{
+    font_cache_lock();
+    if (!ttf->filename) {
+        ttf->filename = (char *)malloc(strlen(filename) + 1);
+        if (ttf->filename) {
+            strcpy(ttf->filename, filename);
+            ttf->mtime = mtime;
+        }
+    }
+    font_cache_unlock();
+}
 
-    return e;
+static void ttf_release(struct pdf_ttf *ttf)
+{
+    if (!ttf)
+        return;
+    font_cache_lock();
+    ttf->refs--;
+    font_cache_unlock();
 }
 
-static int pdf_add_stream(struct pdf_doc *pdf, struct pdf_object *page,
-                          const char *buffer)
+void pdf_clear_font_cache(void)
 {
-    struct pdf_object *obj;
-    size_t len;
+    struct pdf_ttf **link = &font_cache;
 
-    if (!page)
-        page = pdf_find_last_object(pdf, OBJ_page);
+    font_cache_lock();
+    while (*link) {
+        struct pdf_ttf *ttf = *link;
 
-    if (!page)
-        return pdf_set_err(pdf, -EINVAL, "Invalid pdf page");
+        if (ttf->refs) {
+            link = &ttf->next;
+            continue;
+        }
+        *link = ttf->next;
+        ttf_free(ttf);
+    }
+    font_cache_unlock();
+}
 
-    len = strlen(buffer);
-    /* We don't want any trailing whitespace in the stream */
-    while (len >= 1 && (buffer[len - 1] == '\r' || buffer[len - 1] == '\n'))
-        len--;
+/**
+ * Find the outline of a glyph
+ * @return Length of the outline, 0 if the glyph doesn't have one
+ */
+static uint32_t ttf_glyph_data(const struct pdf_ttf *ttf, uint32_t glyph,
+                               const uint8_t **data)
+{
+    const uint8_t *loca = ttf->data + ttf->tables[TTF_LOCA].offset;
+    uint32_t start, end;
 
-    obj = pdf_add_object(pdf, OBJ_stream);
-    if (!obj)
-        return pdf->errval;
+    if (ttf->loca_long) {
+        start = ttf_u32(loca + glyph * 4);
+        end = ttf_u32(loca + glyph * 4 + 4);
+    } else {
+        start = ttf_u16(loca + glyph * 2) * 2u;
+        end = ttf_u16(loca + glyph * 2 + 2) * 2u;
+    }
+    if (end <= start || end > ttf->tables[TTF_GLYF].len)
+        return 0;
+    *data = ttf->data + ttf->tables[TTF_GLYF].offset + start;
+    return end - start;
+}
+
+#define TTF_GLYPH_SET(bits, glyph) ((bits)[(glyph) >> 3] & (1 << ((glyph)&7)))
 
-    dstr_printf(&obj->stream.stream, "<< /Length %zu >>stream\r\n", len);
-    dstr_append_data(&obj->stream.stream, buffer, len);
-    dstr_append(&obj->stream.stream, "\r\nendstream\r\n");
+/* Font units to the thousandths of an em used by PDF font metrics */
+#define TTF_SCALE(ttf, units)                                                \
+    ((int)floorf((units)*1000.0f / (ttf)->units_per_em + 0.5f))
+
+/**
+ * Add the glyphs that composite glyphs are made from to a set of glyphs
+ */
+static int ttf_add_components(struct pdf_doc *pdf, const struct pdf_ttf *ttf,
+                              uint8_t *glyphs)
+{
+    uint16_t *stack;
+    uint32_t count = 0;
+
+    stack = (uint16_t *)malloc(ttf->glyph_count * sizeof(*stack));
+    if (!stack)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate font subset");
+    for (uint32_t i = 0; i < ttf->glyph_count; i++)
+        if (TTF_GLYPH_SET(glyphs, i))
+            stack[count++] = (uint16_t)i;
+
+    while (count) {
+        const uint8_t *data;
+        uint32_t len = ttf_glyph_data(ttf, stack[--count], &data);
+        uint32_t pos = 10;
+
+        /* Composite glyphs have a negative number of contours */
+        if (len < 10 || ttf_s16(data) >= 0)
+            continue;
+        while (pos + 4 <= len) {
+            uint16_t flags = ttf_u16(data + pos);
+            uint16_t component = ttf_u16(data + pos + 2);
+
+            pos += flags & 0x0001 ? 8 : 6; /* ARG_1_AND_2_ARE_WORDS */
+            if (flags & 0x0008) /* WE_HAVE_A_SCALE */
+                pos += 2;
+            else if (flags & 0x0040) /* WE_HAVE_AN_X_AND_Y_SCALE */
+                pos += 4;
+            else if (flags & 0x0080) /* WE_HAVE_A_TWO_BY_TWO */
+                pos += 8;
+            if (component < ttf->glyph_count &&
+                !TTF_GLYPH_SET(glyphs, component)) {
+                glyphs[component >> 3] |= 1 << (component & 7);
+                stack[count++] = component;
+            }
+            if (!(flags & 0x0020)) /* MORE_COMPONENTS */
+                break;
+        }
+    }
 
-    return flexarray_append(&page->page.children, obj);
+    free(stack);
+    return 0;
 }
 
-int pdf_add_bookmark(struct pdf_doc *pdf, struct pdf_object *page, int parent,
-                     const char *name)
+static uint32_t ttf_checksum(const uint8_t *data, size_t len)
 {
-    struct pdf_object *obj, *outline = NULL;
+    uint32_t sum = 0;
 
-    if (!page)
-        page = pdf_find_last_object(pdf, OBJ_page);
+    /* Tables are zero padded to a multiple of 4 bytes */
+    for (size_t i = 0; i < len; i += 4)
+        sum += ttf_u32(data + i);
+    return sum;
+}
 
-    if (!page)
-        return pdf_set_err(pdf, -EINVAL,
-                           "Unable to add bookmark, no pages available");
+#define TTF_PAD(len) (((len) + 3) & ~(size_t)3)
 
-    if (!pdf_find_first_object(pdf, OBJ_outline)) {
-        outline = pdf_add_object(pdf, OBJ_outline);
-        if (!outline)
-            return pdf->errval;
+/**
+ * Build a font file with the outlines of just the given glyphs. The glyph
+ * IDs are unchanged, so the other glyphs are left empty.
+ */
+static int ttf_build_subset(struct pdf_doc *pdf, struct pdf_font_embed *embed,
+                            const uint8_t *glyphs)
+{
+    const struct pdf_ttf *ttf = embed->ttf;
+    size_t lens[TTF_TABLE_count];
+    size_t total, pos;
+    int table_count = 0, search = 1, selector = 0;
+    uint8_t *out, *head = NULL, *record;
+
+    for (int i = 0; i < TTF_TABLE_count; i++) {
+        lens[i] = ttf->tables[i].len;
+        if (i == TTF_GLYF) {
+            lens[i] = 0;
+            for (uint32_t g = 0; g < ttf->glyph_count; g++) {
+                const uint8_t *data;
+                if (TTF_GLYPH_SET(glyphs, g))
+                    lens[i] += TTF_PAD(ttf_glyph_data(ttf, g, &data));
+            }
+        } else if (i == TTF_LOCA) {
+            lens[i] = (ttf->glyph_count + 1) * 4;
+        }
+        if (lens[i] || i == TTF_GLYF)
+            table_count++;
+    }
+    while (search * 2 <= table_count) {
+        search *= 2;
+        selector++;
+    }
+
+    total = 12 + table_count * 16;
+    for (int i = 0; i < TTF_TABLE_count; i++)
+        total += TTF_PAD(lens[i]);
+    out = (uint8_t *)calloc(1, total);
+    if (!out)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate font subset");
+
+    ttf_put32(out, 0x00010000);
+    ttf_put16(out + 4, (uint16_t)table_count);
+    ttf_put16(out + 6, (uint16_t)(search * 16));
+    ttf_put16(out + 8, (uint16_t)selector);
+    ttf_put16(out + 10, (uint16_t)(table_count * 16 - search * 16));
+    record = out + 12;
+    pos = 12 + table_count * 16;
+
+    for (int i = 0; i < TTF_TABLE_count; i++) {
+        uint8_t *table = out + pos;
+
+        if (!lens[i] && i != TTF_GLYF)
+            continue;
+        switch (i) {
+        case TTF_GLYF:
+        case TTF_LOCA: {
+            /* Both are built from the same walk through the glyphs */
+            uint32_t offset = 0;
+
+            for (uint32_t g = 0; g < ttf->glyph_count; g++) {
+                const uint8_t *data;
+                uint32_t len;
+
+                if (i == TTF_LOCA)
+                    ttf_put32(table + g * 4, offset);
+                if (!TTF_GLYPH_SET(glyphs, g))
+                    continue;
+                len = ttf_glyph_data(ttf, g, &data);
+                if (i == TTF_GLYF && len)
+                    memcpy(table + offset, data, len);
+                offset += (uint32_t)TTF_PAD(len);
+            }
+            if (i == TTF_LOCA)
+                ttf_put32(table + ttf->glyph_count * 4, offset);
+            break;
+        }
+        default:
+            memcpy(table, ttf->data + ttf->tables[i].offset, lens[i]);
+            break;
+        }
+        if (i == TTF_HEAD) {
+            head = table;
+            ttf_put32(head + 8, 0);  /* checkSumAdjustment */
+            ttf_put16(head + 50, 1); /* indexToLocFormat: 32-bit */
+        }
+
+        memcpy(record, ttf_table_tags[i], 4);
+        ttf_put32(record + 4, ttf_checksum(table, TTF_PAD(lens[i])));
+        ttf_put32(record + 8, (uint32_t)pos);
+        ttf_put32(record + 12, (uint32_t)lens[i]);
+        record += 16;
+        pos += TTF_PAD(lens[i]);
     }
+    ttf_put32(head + 8, 0xb1b0afba - ttf_checksum(out, total));
 
-    obj = pdf_add_object(pdf, OBJ_bookmark);
-    if (!obj) {
-        if (outline)
-            pdf_del_object(pdf, outline);
-        return pdf->errval;
+    free(embed->file);
+    embed->file = out;
+    embed->file_len = total;
+    return 0;
+}
+
+/**
+ * Build the CMap which maps the glyphs that were drawn back to Unicode,
+ * so that text can be extracted from the document
+ */
+static int ttf_build_to_unicode(struct pdf_doc *pdf,
+                                struct pdf_font_embed *embed)
+{
+    const struct pdf_ttf *ttf = embed->ttf;
+    struct dstr *str = &embed->to_unicode;
+    uint32_t *codes;
+    int count = 0, done = 0;
+    bool failed = false;
+
+    codes = (uint32_t *)calloc(ttf->glyph_count, sizeof(*codes));
+    if (!codes)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate font CMap");
+    for (uint32_t code = 0; code <= 0xffff; code++) {
+        const uint16_t *page = ttf->cmap[code >> 8];
+        uint16_t glyph = page ? page[code & 0xff] : 0;
+
+        if (!page)
+            code |= 0xff;
+        else if (glyph && TTF_GLYPH_SET(embed->used, glyph) && !codes[glyph])
+            codes[glyph] = code;
+    }
+    for (uint32_t i = 0; i < ttf->cmap_group_count; i++) {
+        const uint8_t *group = ttf->cmap_groups + i * 12;
+        uint32_t start = ttf_u32(group);
+
+        for (uint32_t code = start > 0xffff ? start : 0x10000;
+             code <= ttf_u32(group + 4); code++) {
+            uint32_t glyph = ttf_u32(group + 8) + code - start;
+            if (glyph < ttf->glyph_count &&
+                TTF_GLYPH_SET(embed->used, glyph) && !codes[glyph])
+                codes[glyph] = code;
+        }
+    }
+    for (uint32_t g = 0; g < ttf->glyph_count; g++)
+        if (codes[g])
+            count++;
+
+    dstr_free(str);
+    failed |= dstr_append(str, "/CIDInit /ProcSet findresource begin\n"
+                          "12 dict begin\n"
+                          "begincmap\n"
+                          "/CIDSystemInfo << /Registry (Adobe) "
+                          "/Ordering (UCS) /Supplement 0 >> def\n"
+                          "/CMapName /Adobe-Identity-UCS def\n"
+                          "/CMapType 2 def\n"
+                          "1 begincodespacerange\n"
+                          "<0000> <FFFF>\n"
+                          "endcodespacerange\n") < 0;
+    for (uint32_t g = 0; g < ttf->glyph_count; g++) {
+        uint32_t code = codes[g];
+
+        if (!code)
+            continue;
+        /* Entries are limited to 100 per block */
+        if (done % 100 == 0)
+            failed |= dstr_printf(str, "%d beginbfchar\n",
+                                  count - done < 100 ? count - done : 100) < 0;
+        if (code > 0xffff) {
+            code -= 0x10000;
+            failed |= dstr_printf(str, "<%04X> <%04X%04X>\n", g,
+                                  0xd800 + (code >> 10),
+                                  0xdc00 + (code & 0x3ff)) < 0;
+        } else {
+            failed |= dstr_printf(str, "<%04X> <%04X>\n", g, code) < 0;
+        }
+        if (++done % 100 == 0 || done == count)
+            failed |= dstr_append(str, "endbfchar\n") < 0;
     }
+    failed |= dstr_append(str, "endcmap\n"
+                          "CMapName currentdict /CMap defineresource pop\n"
+                          "end\n"
+                          "end\n") < 0;
+    free(codes);
 
-    strncpy(obj->bookmark.name, name, sizeof(obj->bookmark.name) - 1);
-    obj->bookmark.name[sizeof(obj->bookmark.name) - 1] = '\0';
-    obj->bookmark.page = page;
-    if (parent >= 0) {
-        struct pdf_object *parent_obj = pdf_get_object(pdf, parent);
-        if (!parent_obj)
-            return pdf_set_err(pdf, -EINVAL, "Invalid parent ID %d supplied",
-                               parent);
-        obj->bookmark.parent = parent_obj;
-        flexarray_append(&parent_obj->bookmark.children, obj);
+    if (failed)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate font CMap");
+    return 0;
+}
+
+/**
+ * Build the font files for all embedded fonts, ready to save the document
+ */
+static int pdf_prepare_fonts(struct pdf_doc *pdf)
+{
+    for (int i = 0; i < flexarray_size(&pdf->fonts); i++) {
+        struct pdf_object *font =
+            (struct pdf_object *)flexarray_get(&pdf->fonts, i);
+        struct pdf_font_embed *embed = font->font.embed;
+        size_t bytes;
+        uint8_t *glyphs;
+        uint64_t tag;
+        int e;
+
+        if (!embed)
+            continue;
+        bytes = (embed->ttf->glyph_count + 7) / 8;
+        glyphs = (uint8_t *)malloc(bytes);
+        if (!glyphs)
+            return pdf_set_err(pdf, -ENOMEM,
+                               "Unable to allocate font subset");
+        memcpy(glyphs, embed->used, bytes);
+        glyphs[0] |= 1; /* .notdef is always needed */
+        e = ttf_add_components(pdf, embed->ttf, glyphs);
+        if (e >= 0)
+            e = ttf_build_subset(pdf, embed, glyphs);
+        free(glyphs);
+        if (e >= 0)
+            e = ttf_build_to_unicode(pdf, embed);
+        if (e < 0)
+            return e;
+
+        /* Subsets are named with a tag of six capital letters */
+        tag = hash(5381, embed->used, bytes);
+        for (int j = 0; j < 6; j++) {
+            embed->subset_name[j] = 'A' + tag % 26;
+            tag /= 26;
+        }
+        embed->subset_name[6] = '+';
+        strcpy(&embed->subset_name[7], embed->ttf->name);
     }
+    return 0;
+}
 
-    return obj->index;
+static void pdf_font_embed_free(struct pdf_font_embed *embed)
+{
+    if (!embed)
+        return;
+    ttf_release(embed->ttf);
+    free(embed->used);
+    free(embed->file);
+    dstr_free(&embed->to_unicode);
+    free(embed);
 }
 
-int pdf_add_link(struct pdf_doc *pdf, struct pdf_object *page, float x,
-                 float y, float width, float height,
-                 struct pdf_object *target_page, float target_x,
-                 float target_y)
+/**
+ * Add a cached TrueType font (whose reference is taken over) to the document
+ */
+static int pdf_add_ttf(struct pdf_doc *pdf, struct pdf_ttf *ttf)
 {
+    struct pdf_font_embed *embed;
     struct pdf_object *obj;
 
-    if (!page)
-        page = pdf_find_last_object(pdf, OBJ_page);
-
-    if (!page)
-        return pdf_set_err(pdf, -EINVAL,
-                           "Unable to add link, no pages available");
+    /* See if we've loaded this font before */
+    obj = pdf_find_font(pdf, ttf->name);
+    if (obj) {
+        ttf_release(ttf);
+        return obj->font.index;
+    }
 
-    if (!target_page)
-        return pdf_set_err(pdf, -EINVAL, "Unable to link, no target page");
+    embed = (struct pdf_font_embed *)calloc(1, sizeof(*embed));
+    if (embed) {
+        embed->ttf = ttf;
+        embed->used = (uint8_t *)calloc((ttf->glyph_count + 7) / 8, 1);
+    }
+    if (!embed || !embed->used) {
+        if (embed)
+            pdf_font_embed_free(embed);
+        else
+            ttf_release(ttf);
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate font");
+    }
 
-    obj = pdf_add_object(pdf, OBJ_link);
+    obj = pdf_add_object(pdf, OBJ_font);
     if (!obj) {
+        pdf_font_embed_free(embed);
         return pdf->errval;
     }
+    obj->font.embed = embed;
+    strcpy(obj->font.name, ttf->name);
+    for (int i = 0; i < FONT_PART_count; i++) {
+        struct pdf_object *part = pdf_add_object(pdf, OBJ_font_part);
+        if (!part)
+            return pdf->errval;
+        part->font_part.font = obj;
+        part->font_part.kind = i;
+        embed->parts[i] = part;
+    }
 
-    obj->link.target_page = target_page;
-    obj->link.target_x = target_x;
-    obj->link.target_y = target_y;
-    obj->link.llx = x;
-    obj->link.lly = y;
-    obj->link.urx = x + width;
-    obj->link.ury = y + height;
-    flexarray_append(&page->page.annotations, obj);
+    if (flexarray_append(&pdf->fonts, obj) < 0)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to grow font list");
+    obj->font.index = flexarray_size(&pdf->fonts);
+    if (font_table_add(pdf, obj) < 0)
+        return pdf->errval;
 
-    return obj->index;
+    return obj->font.index;
 }
 
-static int utf8_to_utf32(const char *utf8, int len, uint32_t *utf32)
+int pdf_add_font_data(struct pdf_doc *pdf, const void *data, size_t length)
 {
-    uint32_t ch;
-    uint8_t mask;
+    struct pdf_ttf *ttf;
+    uint8_t *copy;
+    uint32_t hash;
+
+    if (!data || !length)
+        return pdf_set_err(pdf, -EINVAL, "No font data supplied");
+    hash = adler32_update(1, data, length);
+    ttf = ttf_cache_find_data(data, length, hash);
+    if (ttf)
+        return pdf_add_ttf(pdf, ttf);
+
+    copy = (uint8_t *)malloc(length);
+    if (!copy)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate font");
+    memcpy(copy, data, length);
+    ttf = ttf_load(pdf, copy, length);
+    if (!ttf)
+        return pdf->errval;
+    ttf->hash = hash;
+    return pdf_add_ttf(pdf, ttf_cache_add(ttf));
+}
 
-    if (len <= 0 || !utf8 || !utf32)
-        return -EINVAL;
+int pdf_add_font_file(struct pdf_doc *pdf, const char *filename)
+{
+    struct pdf_ttf *ttf;
+    struct stat st;
+    uint8_t *data;
+    size_t len;
+    uint32_t hash;
 
-    ch = *(uint8_t *)utf8;
-    if ((ch & 0x80) == 0) {
-        len = 1;
-        mask = 0x7f;
-    } else if ((ch & 0xe0) == 0xc0 && len >= 2) {
-        len = 2;
-        mask = 0x1f;
-    } else if ((ch & 0xf0) == 0xe0 && len >= 3) {
-        len = 3;
-        mask = 0xf;
-    } else if ((ch & 0xf8) == 0xf0 && len >= 4) {
-        len = 4;
-        mask = 0x7;
-    } else
-        return -EINVAL;
+    /* Fonts that are already loaded don't need to be read again */
+    if (stat(filename, &st) < 0)
+        return pdf_set_err(pdf, -errno, "Unable to access %s: %s", filename,
+                           strerror(errno));
+    ttf = ttf_cache_find_file(filename, &st);
+    if (ttf)
+        return pdf_add_ttf(pdf, ttf);
 
-    ch = 0;
-    for (int i = 0; i < len; i++) {
-        int shift = (len - i - 1) * 6;
-        if (!*utf8)
-            return -EINVAL;
-        if (i == 0)
-            ch |= ((uint32_t)(*utf8++) & mask) << shift;
-        else
-            ch |= ((uint32_t)(*utf8++) & 0x3f) << shift;
+    data = get_file(pdf, filename, &len);
+    if (!data)
+        return pdf->errval;
+    hash = adler32_update(1, data, len);
+    ttf = ttf_cache_find_data(data, len, hash);
+    if (ttf) {
+        free(data);
+        ttf_cache_set_file(ttf, filename, st.st_mtime);
+        return pdf_add_ttf(pdf, ttf);
+    }
+    ttf = ttf_load(pdf, data, len);
+    if (!ttf)
+        return pdf->errval;
+    ttf->hash = hash;
+    ttf->filename = (char *)malloc(strlen(filename) + 1);
+    if (ttf->filename) {
+        strcpy(ttf->filename, filename);
+        ttf->mtime = st.st_mtime;
     }
+    return pdf_add_ttf(pdf, ttf_cache_add(ttf));
+}
 
-    *utf32 = ch;
+/**
+ * Number of width units in a point of font size
+ */
+static float pdf_font_units(const struct pdf_object *font)
+{
+    if (font->font.embed)
+        return font->font.embed->ttf->units_per_em;
+    /* Our widths arrays are for 14pt fonts */
+    return 14.0f * 72.0f;
+}
 
-    return len;
+/* Kerning is in thousandths of an em, like the PDF text operators, and
+ * is converted to the units of our widths arrays when measuring */
+#define KERN_WIDTH(kern) ((kern) * (14 * 72) / 1000)
+
+/**
+ * Kerning pairs to apply to text in a font
+ * @return Kerning pairs, or NULL if the text isn't kerned
+ */
+static const struct kern_table *pdf_font_kerns(const struct pdf_doc *pdf,
+                                               const struct pdf_object *font)
+{
+    return pdf->kerning ? font->font.kerns : NULL;
 }
 
-static int utf8_to_pdfencoding(struct pdf_doc *pdf, const char *utf8, int len,
-                               uint8_t *res)
+/**
+ * Has this page already been written out in streaming mode?
+ */
+static bool pdf_page_is_flushed(const struct pdf_doc *pdf,
+                                const struct pdf_object *page)
 {
-    uint32_t code;
-    int code_len;
+    return pdf->stream && page->offset > 0;
+}
 
-    *res = 0;
+/**
+ * Find the page to draw on when none is given: the template being
+ * recorded, if there is one, otherwise the most recently added page
+ */
+static struct pdf_object *pdf_default_page(const struct pdf_doc *pdf)
+{
+    if (pdf->current_template)
+        return pdf->current_template;
+    return pdf_find_last_object(pdf, OBJ_page);
+}
 
-    code_len = utf8_to_utf32(utf8, len, &code);
-    if (code_len < 0) {
-        return pdf_set_err(pdf, -EINVAL, "Invalid UTF-8 encoding");
-    }
+/**
+ * Check that drawing operations can still be added to a page or template
+ */
+static int pdf_check_drawable(struct pdf_doc *pdf,
+                              const struct pdf_object *page)
+{
+    if (!page)
+        return pdf_set_err(pdf, -EINVAL, "Invalid pdf page");
 
-    if (code > 255) {
-        /* We support *some* minimal UTF-8 characters */
-        // See Appendix D of
-        // https://opensource.adobe.com/dc-acrobat-sdk-docs/pdfstandards/pdfreference1.7old.pdf
-        // These are all in WinAnsiEncoding
-        switch (code) {
-        case 0x152: // Latin Capital Ligature OE
-            *res = 0214;
-            break;
-        case 0x153: // Latin Small Ligature oe
-            *res = 0234;
-            break;
-        case 0x160: // Latin Capital Letter S with caron
-            *res = 0212;
-            break;
-        case 0x161: // Latin Small Letter S with caron
-            *res = 0232;
-            break;
-        case 0x178: // Latin Capital Letter y with diaeresis
-            *res = 0237;
-            break;
-        case 0x17d: // Latin Capital Letter Z with caron
-            *res = 0216;
-            break;
-        case 0x17e: // Latin Small Letter Z with caron
-            *res = 0236;
-            break;
-        case 0x192: // Latin Small Letter F with hook
-            *res = 0203;
-            break;
-        case 0x2c6: // Modifier Letter Circumflex Accent
-            *res = 0210;
-            break;
-        case 0x2dc: // Small Tilde
-            *res = 0230;
-            break;
-        case 0x2013: // Endash
-            *res = 0226;
-            break;
-        case 0x2014: // Emdash
-            *res = 0227;
-            break;
-        case 0x2018: // Left Single Quote
-            *res = 0221;
-            break;
-        case 0x2019: // Right Single Quote
-            *res = 0222;
-            break;
-        case 0x201a: // Single low-9 Quotation Mark
-            *res = 0202;
-            break;
-        case 0x201c: // Left Double Quote
-            *res = 0223;
-            break;
-        case 0x201d: // Right Double Quote
-            *res = 0224;
-            break;
-        case 0x201e: // Double low-9 Quotation Mark
-            *res = 0204;
-            break;
-        case 0x2020: // Dagger
-            *res = 0206;
-            break;
-        case 0x2021: // Double Dagger
-            *res = 0207;
-            break;
-        case 0x2022: // Bullet
-            *res = 0225;
-            break;
-        case 0x2026: // Horizontal Ellipsis
-            *res = 0205;
-            break;
-        case 0x2030: // Per Mille Sign
-            *res = 0211;
-            break;
-        case 0x2039: // Single Left-pointing Angle Quotation Mark
-            *res = 0213;
-            break;
-        case 0x203a: // Single Right-pointing Angle Quotation Mark
-            *res = 0233;
-            break;
-        case 0x20ac: // Euro
-            *res = 0200;
-            break;
-        case 0x2122: // Trade Mark Sign
-            *res = 0231;
-            break;
-        default:
+    if (page->type == OBJ_template) {
+        if (page != pdf->current_template)
             return pdf_set_err(pdf, -EINVAL,
-                               "Unsupported UTF-8 character: 0x%x 0o%o %s",
-                               code, code, utf8);
-        }
-    } else {
-        *res = code;
+                               "Template is not being recorded");
+        return 0;
     }
-    return code_len;
+
+    if (page->type != OBJ_page)
+        return pdf_set_err(pdf, -EINVAL, "Invalid pdf page");
+
+    if (pdf_page_is_flushed(pdf, page))
+        return pdf_set_err(pdf, -EINVAL, "Page has already been written");
+
+    return 0;
 }
 
-static int pdf_add_text_spacing(struct pdf_doc *pdf, struct pdf_object *page,
-                                const char *text, float size, float xoff,
-                                float yoff, uint32_t colour, float spacing,
-                                float angle)
+struct pdf_object *pdf_append_page(struct pdf_doc *pdf)
 {
-    int ret;
-    size_t len = text ? strlen(text) : 0;
-    struct dstr str = INIT_DSTR;
-    int alpha = (colour >> 24) >> 4;
+    struct pdf_object *page;
 
-    /* Don't bother adding empty/null strings */
-    if (!len)
-        return 0;
+    /* Previous pages are finished, so streaming documents can write them */
+    if (pdf->stream && pdf_flush(pdf) < 0)
+        return NULL;
 
-    dstr_append(&str, "BT ");
-    dstr_printf(&str, "/GS%d gs ", alpha);
-    if (angle != 0) {
-        dstr_printf(&str, "%f %f %f %f %f %f Tm ", cosf(angle), sinf(angle),
-                    -sinf(angle), cosf(angle), xoff, yoff);
-    } else {
-        dstr_printf(&str, "%f %f TD ", xoff, yoff);
+    /* Make room in the page index first, so that failing to do so doesn't
+     * leave a page object behind which isn't in it */
+    if (flexarray_append(&pdf->pages, NULL) < 0) {
+        pdf_set_err(pdf, -ENOMEM, "Unable to grow page index");
+        return NULL;
     }
-    dstr_printf(&str, "/F%d %f Tf ", pdf->current_font->font.index, size);
-    dstr_printf(&str, "%f %f %f rg ", PDF_RGB_R(colour), PDF_RGB_G(colour),
-                PDF_RGB_B(colour));
-    dstr_printf(&str, "%f Tc ", spacing);
-    dstr_append(&str, "(");
+    flexarray_pop(&pdf->pages);
 
-    /* Escape magic characters properly */
-    for (size_t i = 0; i < len;) {
-        int code_len;
-        uint8_t pdf_char;
-        code_len = utf8_to_pdfencoding(pdf, &text[i], len - i, &pdf_char);
-        if (code_len < 0) {
-            dstr_free(&str);
-            return code_len;
-        }
+    page = pdf_add_object(pdf, OBJ_page);
 
-        if (strchr("()\\", pdf_char)) {
-            char buf[3];
-            /* Escape some characters */
-            buf[0] = '\\';
-            buf[1] = pdf_char;
-            buf[2] = '\0';
-            dstr_append(&str, buf);
-        } else if (strrchr("\n\r\t\b\f", pdf_char)) {
-            /* Skip over these characters */
-            ;
-        } else {
-            dstr_append_data(&str, &pdf_char, 1);
-        }
+    if (!page)
+        return NULL;
 
-        i += code_len;
-    }
-    dstr_append(&str, ") Tj ");
-    dstr_append(&str, "ET");
+    /* Can't fail, the bin for it exists now */
+    flexarray_append(&pdf->pages, page);
 
-    ret = pdf_add_stream(pdf, page, dstr_data(&str));
-    dstr_free(&str);
-    return ret;
+    page->page.width = pdf->width;
+    page->page.height = pdf->height;
+
+    return page;
 }
 
-int pdf_add_text(struct pdf_doc *pdf, struct pdf_object *page,
-                 const char *text, float size, float xoff, float yoff,
-                 uint32_t colour)
+struct pdf_object *pdf_get_page(struct pdf_doc *pdf, int page_number)
 {
-    return pdf_add_text_spacing(pdf, page, text, size, xoff, yoff, colour, 0,
-                                0);
+    struct pdf_object *page;
+
+    if (page_number <= 0) {
+        pdf_set_err(pdf, -EINVAL, "page number must be >= 1");
+        return NULL;
+    }
+
+    page = (struct pdf_object *)flexarray_get(&pdf->pages, page_number - 1);
+    if (!page)
+        pdf_set_err(pdf, -EINVAL, "no such page");
+    return page;
 }
 
-int pdf_add_text_rotate(struct pdf_doc *pdf, struct pdf_object *page,
-                        const char *text, float size, float xoff, float yoff,
-                        float angle, uint32_t colour)
+int pdf_page_count(const struct pdf_doc *pdf)
 {
-    return pdf_add_text_spacing(pdf, page, text, size, xoff, yoff, colour, 0,
-                                angle);
+    return flexarray_size(&pdf->pages);
 }
 
-/* How wide is each character, in points, at size 14 */
-static const uint16_t helvetica_widths[256] = {
-    280, 280, 280, 280,  280, 280, 280, 280,  280,  280, 280,  280, 280,
-    280, 280, 280, 280,  280, 280, 280, 280,  280,  280, 280,  280, 280,
-    280, 280, 280, 280,  280, 280, 280, 280,  357,  560, 560,  896, 672,
-    192, 335, 335, 392,  588, 280, 335, 280,  280,  560, 560,  560, 560,
-    560, 560, 560, 560,  560, 560, 280, 280,  588,  588, 588,  560, 1023,
-    672, 672, 727, 727,  672, 615, 784, 727,  280,  504, 672,  560, 839,
-    727, 784, 672, 784,  727, 672, 615, 727,  672,  951, 672,  672, 615,
-    280, 280, 280, 472,  560, 335, 560, 560,  504,  560, 560,  280, 560,
-    560, 223, 223, 504,  223, 839, 560, 560,  560,  560, 335,  504, 280,
-    560, 504, 727, 504,  504, 504, 336, 262,  336,  588, 352,  560, 352,
-    223, 560, 335, 1008, 560, 560, 335, 1008, 672,  335, 1008, 352, 615,
-    352, 352, 223, 223,  335, 335, 352, 560,  1008, 335, 1008, 504, 335,
-    951, 352, 504, 672,  280, 335, 560, 560,  560,  560, 262,  560, 335,
-    742, 372, 560, 588,  335, 742, 335, 403,  588,  335, 335,  335, 560,
-    541, 280, 335, 335,  367, 560, 840, 840,  840,  615, 672,  672, 672,
-    672, 672, 672, 1008, 727, 672, 672, 672,  672,  280, 280,  280, 280,
-    727, 727, 784, 784,  784, 784, 784, 588,  784,  727, 727,  727, 727,
-    672, 672, 615, 560,  560, 560, 560, 560,  560,  896, 504,  560, 560,
-    560, 560, 280, 280,  280, 280, 560, 560,  560,  560, 560,  560, 560,
-    588, 615, 560, 560,  560, 560, 504, 560,  504,
-};
+int pdf_page_set_size(struct pdf_doc *pdf, struct pdf_object *page,
+                      float width, float height)
+{
+    if (!page)
+        page = pdf_find_last_object(pdf, OBJ_page);
 
-static const uint16_t helvetica_bold_widths[256] = {
-    280,  280, 280,  280, 280, 280, 280, 280,  280, 280, 280, 280,  280, 280,
-    280,  280, 280,  280, 280, 280, 280, 280,  280, 280, 280, 280,  280, 280,
-    280,  280, 280,  280, 280, 335, 477, 560,  560, 896, 727, 239,  335, 335,
-    392,  588, 280,  335, 280, 280, 560, 560,  560, 560, 560, 560,  560, 560,
-    560,  560, 335,  335, 588, 588, 588, 615,  982, 727, 727, 727,  727, 672,
-    615,  784, 727,  280, 560, 727, 615, 839,  727, 784, 672, 784,  727, 672,
-    615,  727, 672,  951, 672, 672, 615, 335,  280, 335, 588, 560,  335, 560,
-    615,  560, 615,  560, 335, 615, 615, 280,  280, 560, 280, 896,  615, 615,
-    615,  615, 392,  560, 335, 615, 560, 784,  560, 560, 504, 392,  282, 392,
-    588,  352, 560,  352, 280, 560, 504, 1008, 560, 560, 335, 1008, 672, 335,
-    1008, 352, 615,  352, 352, 280, 280, 504,  504, 352, 560, 1008, 335, 1008,
-    560,  335, 951,  352, 504, 672, 280, 335,  560, 560, 560, 560,  282, 560,
-    335,  742, 372,  560, 588, 335, 742, 335,  403, 588, 335, 335,  335, 615,
-    560,  280, 335,  335, 367, 560, 840, 840,  840, 615, 727, 727,  727, 727,
-    727,  727, 1008, 727, 672, 672, 672, 672,  280, 280, 280, 280,  727, 727,
-    784,  784, 784,  784, 784, 588, 784, 727,  727, 727, 727, 672,  672, 615,
-    560,  560, 560,  560, 560, 560, 896, 560,  560, 560, 560, 560,  280, 280,
-    280,  280, 615,  615, 615, 615, 615, 615,  615, 588, 615, 615,  615, 615,
-    615,  560, 615,  560,
-};
+    if (!page || page->type != OBJ_page)
+        return pdf_set_err(pdf, -EINVAL, "Invalid PDF page");
+    if (pdf_page_is_flushed(pdf, page))
+        return pdf_set_err(pdf, -EINVAL, "Page has already been written");
+    page->page.width = width;
+    page->page.height = height;
+    return 0;
+}
 
-static const uint16_t helvetica_bold_oblique_widths[256] = {
-    280,  280, 280,  280, 280, 280, 280, 280,  280, 280, 280, 280,  280, 280,
-    280,  280, 280,  280, 280, 280, 280, 280,  280, 280, 280, 280,  280, 280,
-    280,  280, 280,  280, 280, 335, 477, 560,  560, 896, 727, 239,  335, 335,
-    392,  588, 280,  335, 280, 280, 560, 560,  560, 560, 560, 560,  560, 560,
-    560,  560, 335,  335, 588, 588, 588, 615,  982, 727, 727, 727,  727, 672,
-    615,  784, 727,  280, 560, 727, 615, 839,  727, 784, 672, 784,  727, 672,
-    615,  727, 672,  951, 672, 672, 615, 335,  280, 335, 588, 560,  335, 560,
-    615,  560, 615,  560, 335, 615, 615, 280,  280, 560, 280, 896,  615, 615,
-    615,  615, 392,  560, 335, 615, 560, 784,  560, 560, 504, 392,  282, 392,
-    588,  352, 560,  352, 280, 560, 504, 1008, 560, 560, 335, 1008, 672, 335,
-    1008, 352, 615,  352, 352, 280, 280, 504,  504, 352, 560, 1008, 335, 1008,
-    560,  335, 951,  352, 504, 672, 280, 335,  560, 560, 560, 560,  282, 560,
-    335,  742, 372,  560, 588, 335, 742, 335,  403, 588, 335, 335,  335, 615,
-    560,  280, 335,  335, 367, 560, 840, 840,  840, 615, 727, 727,  727, 727,
-    727,  727, 1008, 727, 672, 672, 672, 672,  280, 280, 280, 280,  727, 727,
-    784,  784, 784,  784, 784, 588, 784, 727,  727, 727, 727, 672,  672, 615,
-    560,  560, 560,  560, 560, 560, 896, 560,  560, 560, 560, 560,  280, 280,
-    280,  280, 615,  615, 615, 615, 615, 615,  615, 588, 615, 615,  615, 615,
-    615,  560, 615,  560,
-};
+// Recursively scan for the number of children
+static int pdf_get_bookmark_count(const struct pdf_object *obj)
+{
+    int count = 0;
+    if (obj->type == OBJ_bookmark) {
+        int nchildren = objlist_size(&obj->bookmark.children);
+        count += nchildren;
+        for (int i = 0; i < nchildren; i++) {
+            count += pdf_get_bookmark_count(
+                objlist_get(&obj->bookmark.children, i));
+        }
+    }
+    return count;
+}
 
-static const uint16_t helvetica_oblique_widths[256] = {
-    280, 280, 280, 280,  280, 280, 280, 280,  280,  280, 280,  280, 280,
-    280, 280, 280, 280,  280, 280, 280, 280,  280,  280, 280,  280, 280,
-    280, 280, 280, 280,  280, 280, 280, 280,  357,  560, 560,  896, 672,
-    192, 335, 335, 392,  588, 280, 335, 280,  280,  560, 560,  560, 560,
-    560, 560, 560, 560,  560, 560, 280, 280,  588,  588, 588,  560, 1023,
-    672, 672, 727, 727,  672, 615, 784, 727,  280,  504, 672,  560, 839,
-    727, 784, 672, 784,  727, 672, 615, 727,  672,  951, 672,  672, 615,
-    280, 280, 280, 472,  560, 335, 560, 560,  504,  560, 560,  280, 560,
-    560, 223, 223, 504,  223, 839, 560, 560,  560,  560, 335,  504, 280,
-    560, 504, 727, 504,  504, 504, 336, 262,  336,  588, 352,  560, 352,
-    223, 560, 335, 1008, 560, 560, 335, 1008, 672,  335, 1008, 352, 615,
-    352, 352, 223, 223,  335, 335, 352, 560,  1008, 335, 1008, 504, 335,
-    951, 352, 504, 672,  280, 335, 560, 560,  560,  560, 262,  560, 335,
-    742, 372, 560, 588,  335, 742, 335, 403,  588,  335, 335,  335, 560,
-    541, 280, 335, 335,  367, 560, 840, 840,  840,  615, 672,  672, 672,
-    672, 672, 672, 1008, 727, 672, 672, 672,  672,  280, 280,  280, 280,
-    727, 727, 784, 784,  784, 784, 784, 588,  784,  727, 727,  727, 727,
-    672, 672, 615, 560,  560, 560, 560, 560,  560,  896, 504,  560, 560,
-    560, 560, 280, 280,  280, 280, 560, 560,  560,  560, 560,  560, 560,
-    588, 615, 560, 560,  560, 560, 504, 560,  504,
-};
+/**
+ * Start a new deflate stream into 'out', using the document's compression
+ * level
+ */
+static int pdf_compress_begin(struct pdf_doc *pdf, struct dstr *out)
+{
+    if (!pdf->flate) {
+        pdf->flate = flate_init(pdf->compression);
+        if (!pdf->flate)
+            return pdf_set_err(pdf, -ENOMEM, "Unable to allocate compressor");
+    }
+    flate_reset(pdf->flate, out);
+    return 0;
+}
 
-static const uint16_t symbol_widths[256] = {
-    252, 252, 252, 252,  252, 252, 252,  252, 252,  252,  252, 252, 252, 252,
-    252, 252, 252, 252,  252, 252, 252,  252, 252,  252,  252, 252, 252, 252,
-    252, 252, 252, 252,  252, 335, 718,  504, 553,  839,  784, 442, 335, 335,
-    504, 553, 252, 553,  252, 280, 504,  504, 504,  504,  504, 504, 504, 504,
-    504, 504, 280, 280,  553, 553, 553,  447, 553,  727,  672, 727, 616, 615,
-    769, 607, 727, 335,  636, 727, 691,  896, 727,  727,  774, 746, 560, 596,
-    615, 695, 442, 774,  650, 801, 615,  335, 869,  335,  663, 504, 504, 636,
-    553, 553, 497, 442,  525, 414, 607,  331, 607,  553,  553, 580, 525, 553,
-    553, 525, 553, 607,  442, 580, 718,  691, 496,  691,  497, 483, 201, 483,
-    553, 0,   0,   0,    0,   0,   0,    0,   0,    0,    0,   0,   0,   0,
-    0,   0,   0,   0,    0,   0,   0,    0,   0,    0,    0,   0,   0,   0,
-    0,   0,   0,   0,    0,   0,   756,  624, 248,  553,  168, 718, 504, 759,
-    759, 759, 759, 1050, 994, 607, 994,  607, 403,  553,  414, 553, 553, 718,
-    497, 463, 553, 553,  553, 553, 1008, 607, 1008, 663,  829, 691, 801, 994,
-    774, 774, 829, 774,  774, 718, 718,  718, 718,  718,  718, 718, 774, 718,
-    796, 796, 897, 829,  553, 252, 718,  607, 607,  1050, 994, 607, 994, 607,
-    497, 331, 796, 796,  792, 718, 387,  387, 387,  387,  387, 387, 497, 497,
-    497, 497, 0,   331,  276, 691, 691,  691, 387,  387,  387, 387, 387, 387,
-    497, 497, 497, 0,
-};
+/**
+ * Deflate a buffer into 'out', using the document's compression level
+ */
+static int pdf_compress(struct pdf_doc *pdf, struct dstr *out,
+                        const void *data, size_t len)
+{
+    int e;
 
-static const uint16_t times_widths[256] = {
-    252, 252, 252, 252, 252, 252, 252, 252,  252, 252, 252, 252,  252, 252,
-    252, 252, 252, 252, 252, 252, 252, 252,  252, 252, 252, 252,  252, 252,
-    252, 252, 252, 252, 252, 335, 411, 504,  504, 839, 784, 181,  335, 335,
-    504, 568, 252, 335, 252, 280, 504, 504,  504, 504, 504, 504,  504, 504,
-    504, 504, 280, 280, 568, 568, 568, 447,  928, 727, 672, 672,  727, 615,
-    560, 727, 727, 335, 392, 727, 615, 896,  727, 727, 560, 727,  672, 560,
-    615, 727, 727, 951, 727, 727, 615, 335,  280, 335, 472, 504,  335, 447,
-    504, 447, 504, 447, 335, 504, 504, 280,  280, 504, 280, 784,  504, 504,
+    e = pdf_compress_begin(pdf, out);
+    if (e < 0)
+        return e;
+    e = flate_write(pdf->flate, data, len);
+    if (e >= 0)
+        e = flate_finish(pdf->flate);
+    if (e < 0)
+        return pdf_set_err(pdf, e, "Unable to compress stream");
+    return 0;
+}
+
+/**
+ * Write a set of segments to a file descriptor, with as few system calls
+ * as possible
+ */
+static int pdf_output_write_fd(struct pdf_output *out)
+{
+#ifdef _WIN32
+    for (int i = 0; i < out->nsegs; i++) {
+        const struct pdf_output_seg *seg = &out->segs[i];
+        const char *data = seg->data ? (const char *)seg->data
+                                     : dstr_data(&out->pending) + seg->offset;
+        size_t len = seg->len;
+
+        while (len) {
+            unsigned int chunk = len > INT_MAX ? INT_MAX : (unsigned int)len;
+            int n = _write(out->fd, data, chunk);
+            if (n < 0)
+                return -errno;
+            data += n;
+            len -= n;
+        }
+    }
+#else
+    struct iovec iov[PDF_OUTPUT_MAX_SEGS];
+    struct iovec *cur = iov;
+    int count = out->nsegs;
+
+    for (int i = 0; i < out->nsegs; i++) {
+        iov[i].iov_base =
+            out->segs[i].data ? (void *)out->segs[i].data
+                              : dstr_data(&out->pending) + out->segs[i].offset;
+        iov[i].iov_len = out->segs[i].len;
+    }
+    while (count) {
+        ssize_t n = writev(out->fd, cur, count);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        /* Skip over whatever was written, which may be a partial segment */
+        while (count && (size_t)n >= cur->iov_len) {
+            n -= cur->iov_len;
+            cur++;
+            count--;
+        }
+        if (count) {
+            cur->iov_base = (char *)cur->iov_base + n;
+            cur->iov_len -= n;
+        }
+    }
+#endif
+    return 0;
+}
+
+/* End the current range of batched data */
+static void pdf_output_close_seg(struct pdf_output *out)
+{
+    size_t used = dstr_len(&out->pending);
+
+    if (used > out->seg_start) {
+        struct pdf_output_seg *seg = &out->segs[out->nsegs++];
+        seg->data = NULL;
+        seg->offset = out->seg_start;
+        seg->len = used - out->seg_start;
+        out->seg_start = used;
+    }
+}
+
+/**
+ * Pass all batched up data on to the writer or file
+ */
+static void pdf_output_flush(struct pdf_output *out)
+{
+    if (out->buf)
+        return;
+    pdf_output_close_seg(out);
+    if (out->nsegs && out->error >= 0) {
+        int e = 0;
+
+        if (out->writer) {
+            for (int i = 0; i < out->nsegs && e >= 0; i++) {
+                const struct pdf_output_seg *seg = &out->segs[i];
+                e = out->writer(out->user,
+                                seg->data ? seg->data
+                                          : dstr_data(&out->pending) +
+                                                seg->offset,
+                                seg->len);
+            }
+        } else {
+            e = pdf_output_write_fd(out);
+        }
+        if (e < 0)
+            out->error = e;
+    }
+    out->pending.used_len = 0;
+    out->seg_start = 0;
+    out->nsegs = 0;
+    out->has_refs = false;
+}
+
+/**
+ * Write a block of data. Large blocks are not copied, so must remain valid
+ * until pdf_output_flush or pdf_output_release is called.
+ */
+static void pdf_output_write(struct pdf_output *out, const void *data,
+                             size_t len)
+{
+    if (out->error < 0)
+        return;
+    out->offset += len;
+    if (out->buf) {
+        if (dstr_append_data(out->buf, data, len) < 0)
+            out->error = -ENOMEM;
+        return;
+    }
+    if (len >= PDF_OUTPUT_REF_MIN) {
+        /* Leave room for the current range, and this block */
+        if (out->nsegs >= PDF_OUTPUT_MAX_SEGS - 2)
+            pdf_output_flush(out);
+        pdf_output_close_seg(out);
+        out->segs[out->nsegs].data = data;
+        out->segs[out->nsegs].len = len;
+        out->nsegs++;
+        out->has_refs = true;
+        return;
+    }
+    if (dstr_len(&out->pending) + len > PDF_OUTPUT_CHUNK)
+        pdf_output_flush(out);
+    if (dstr_append_data(&out->pending, data, len) < 0)
+        out->error = -ENOMEM;
+}
+
+/**
+ * The caller is about to free data passed to pdf_output_write, so make sure
+ * it isn't referenced any more
+ */
+static void pdf_output_release(struct pdf_output *out)
+{
+    if (out->has_refs)
+        pdf_output_flush(out);
+}
+
+#ifndef SKIP_ATTRIBUTE
+static void pdf_output_printf(struct pdf_output *out, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+#endif
+
+static void pdf_output_printf(struct pdf_output *out, const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    if (out->error < 0)
+        return;
+    va_start(ap, fmt);
+    len = dstr_vprintf(out->buf ? out->buf : &out->pending, fmt, ap);
+    va_end(ap);
+    if (len < 0) {
+        out->error = len;
+        return;
+    }
+    out->offset += len;
+    if (!out->buf && dstr_len(&out->pending) >= PDF_OUTPUT_CHUNK)
+        pdf_output_flush(out);
+}
+
+static int pdf_file_writer(void *user, const void *data, size_t len)
+{
+    if (fwrite(data, len, 1, (FILE *)user) != 1)
+        return errno ? -errno : -EIO;
+    return 0;
+}
+
+/**
+ * Resource name prefix of an image or template
+ */
+static const char *pdf_xobject_name(const struct pdf_object *xobject)
+{
+    return xobject->type == OBJ_template ? "Form" : "Image";
+}
+
+/**
+ * Write the resources of a page or template. Without any images or
+ * templates to list, the shared dictionary is used.
+ */
+static void pdf_save_resources(struct pdf_doc *pdf, struct pdf_output *out,
+                               const struct objlist *xobjects)
+{
+    int count = objlist_size(xobjects);
+
+    if (count == 0) {
+        pdf_output_printf(out, "  /Resources %d 0 R\r\n",
+                          pdf->resources[RESOURCES_PAGE]->index);
+        return;
+    }
+
+    pdf_output_printf(out,
+                      "  /Resources <<\r\n"
+                      "    /Font %d 0 R\r\n"
+                      "    /ExtGState %d 0 R\r\n"
+                      "    /XObject <<",
+                      pdf->resources[RESOURCES_FONTS]->index,
+                      pdf->resources[RESOURCES_EXTGSTATE]->index);
+    for (int i = 0; i < count; i++) {
+        const struct pdf_object *xobject = objlist_get(xobjects, i);
+        pdf_output_printf(out, "      /%s%d %d 0 R ",
+                          pdf_xobject_name(xobject), xobject->index,
+                          xobject->index);
+    }
+    pdf_output_printf(out, "    >>\r\n"
+                      "  >>\r\n");
+}
+
+static int pdf_save_object(struct pdf_doc *pdf, struct pdf_output *out,
+                           int index)
+{
+    struct pdf_object *object = pdf_get_object(pdf, index);
+    if (!object)
+        return -ENOENT;
+
+    if (object->type == OBJ_none)
+        return -ENOENT;
+
+    object->offset = out->offset;
+
+    pdf_output_printf(out, "%d 0 obj\r\n", index);
+
+    switch (object->type) {
+    case OBJ_stream: {
+        struct dstr packed = INIT_DSTR;
+        const char *data = dbuf_data(&object->stream.stream);
+        size_t len = dbuf_len(&object->stream.stream);
+
+        if (pdf->compression) {
+            int e = pdf_compress(pdf, &packed, data, len);
+            if (e < 0) {
+                dstr_free(&packed);
+                return e;
+            }
+            data = dstr_data(&packed);
+            len = dstr_len(&packed);
+            pdf_output_printf(out,
+                              "<< /Length %zu /Filter /FlateDecode >>stream\r\n",
+                              len);
+        } else {
+            pdf_output_printf(out, "<< /Length %zu >>stream\r\n", len);
+        }
+        pdf_output_write(out, data, len);
+        pdf_output_printf(out, "\r\nendstream\r\n");
+        if (pdf->compression)
+            pdf_output_release(out);
+        dstr_free(&packed);
+        break;
+    }
+    case OBJ_image: {
+        pdf_output_write(out, dbuf_data(&object->stream.stream),
+                         dbuf_len(&object->stream.stream));
+        break;
+    }
+    case OBJ_info: {
+        struct pdf_info *info = object->info;
+
+        pdf_output_printf(out, "<<\r\n");
+        if (info->creator[0])
+            pdf_output_printf(out, "  /Creator (%s)\r\n", info->creator);
+        if (info->producer[0])
+            pdf_output_printf(out, "  /Producer (%s)\r\n", info->producer);
+        if (info->title[0])
+            pdf_output_printf(out, "  /Title (%s)\r\n", info->title);
+        if (info->author[0])
+            pdf_output_printf(out, "  /Author (%s)\r\n", info->author);
+        if (info->subject[0])
+            pdf_output_printf(out, "  /Subject (%s)\r\n", info->subject);
+        if (info->date[0])
+            pdf_output_printf(out, "  /CreationDate (D:%s)\r\n", info->date);
+        pdf_output_printf(out, ">>\r\n");
+        break;
+    }
+
+    case OBJ_page: {
+        struct pdf_object *pages = pdf_find_first_object(pdf, OBJ_pages);
+
+        pdf_output_printf(out,
+                          "<<\r\n"
+                          "  /Type /Page\r\n"
+                          "  /Parent %d 0 R\r\n",
+                          pages->index);
+        pdf_output_printf(out, "  /MediaBox [0 0 %f %f]\r\n",
+                          object->page.width, object->page.height);
+
+        pdf_save_resources(pdf, out, &object->page.images);
+
+        if (object->page.contents)
+            pdf_output_printf(out, "  /Contents %d 0 R\r\n",
+                              object->page.contents->index);
+
+        if (objlist_size(&object->page.annotations)) {
+            pdf_output_printf(out, "  /Annots [\r\n");
+            for (int i = 0; i < objlist_size(&object->page.annotations);
+                 i++) {
+                struct pdf_object *child =
+                    objlist_get(&object->page.annotations, i);
+                pdf_output_printf(out, "%d 0 R\r\n", child->index);
+            }
+            pdf_output_printf(out, "]\r\n");
+        }
+
+        pdf_output_printf(out, ">>\r\n");
+        break;
+    }
+
+    case OBJ_bookmark: {
+        struct pdf_object *parent, *other;
+
+        parent = object->bookmark.parent;
+        if (!parent)
+            parent = pdf_find_first_object(pdf, OBJ_outline);
+        if (!object->bookmark.page)
+            break;
+        pdf_output_printf(out,
+                          "<<\r\n"
+                          "  /Dest [%d 0 R /XYZ 0 %f null]\r\n"
+                          "  /Parent %d 0 R\r\n"
+                          "  /Title (%s)\r\n",
+                          object->bookmark.page->index, pdf->height,
+                          parent->index, object->bookmark.name);
+        int nchildren = objlist_size(&object->bookmark.children);
+        if (nchildren > 0) {
+            struct pdf_object *f, *l;
+            f = objlist_get(&object->bookmark.children, 0);
+            l = objlist_get(&object->bookmark.children, nchildren - 1);
+            pdf_output_printf(out, "  /First %d 0 R\r\n", f->index);
+            pdf_output_printf(out, "  /Last %d 0 R\r\n", l->index);
+            pdf_output_printf(out, "  /Count %d\r\n",
+                              pdf_get_bookmark_count(object));
+        }
+        // Find the previous bookmark with the same parent
+        for (other = object->prev;
+             other && other->bookmark.parent != object->bookmark.parent;
+             other = other->prev)
+            ;
+        if (other)
+            pdf_output_printf(out, "  /Prev %d 0 R\r\n", other->index);
+        // Find the next bookmark with the same parent
+        for (other = object->next;
+             other && other->bookmark.parent != object->bookmark.parent;
+             other = other->next)
+            ;
+        if (other)
+            pdf_output_printf(out, "  /Next %d 0 R\r\n", other->index);
+        pdf_output_printf(out, ">>\r\n");
+        break;
+    }
+
+    case OBJ_outline: {
+        struct pdf_object *first, *last, *cur;
+        first = pdf_find_first_object(pdf, OBJ_bookmark);
+        last = pdf_find_last_object(pdf, OBJ_bookmark);
+
+        if (first && last) {
+            int count = 0;
+            cur = first;
+            while (cur) {
+                if (!cur->bookmark.parent)
+                    count += pdf_get_bookmark_count(cur) + 1;
+                cur = cur->next;
+            }
+
+            /* Bookmark outline */
+            pdf_output_printf(out,
+                              "<<\r\n"
+                              "  /Count %d\r\n"
+                              "  /Type /Outlines\r\n"
+                              "  /First %d 0 R\r\n"
+                              "  /Last %d 0 R\r\n"
+                              ">>\r\n",
+                              count, first->index, last->index);
+        }
+        break;
+    }
+
+    case OBJ_font: {
+        const struct pdf_font_embed *embed = object->font.embed;
+
+        if (embed)
+            pdf_output_printf(
+                out,
+                "<<\r\n"
+                "  /Type /Font\r\n"
+                "  /Subtype /Type0\r\n"
+                "  /BaseFont /%s\r\n"
+                "  /Encoding /Identity-H\r\n"
+                "  /DescendantFonts [ %d 0 R ]\r\n"
+                "  /ToUnicode %d 0 R\r\n"
+                ">>\r\n",
+                embed->subset_name, embed->parts[FONT_PART_CIDFONT]->index,
+                embed->parts[FONT_PART_TO_UNICODE]->index);
+        else
+            pdf_output_printf(out,
+                              "<<\r\n"
+                              "  /Type /Font\r\n"
+                              "  /Subtype /Type1\r\n"
+                              "  /BaseFont /%s\r\n"
+                              "  /Encoding /WinAnsiEncoding\r\n"
+                              ">>\r\n",
+                              object->font.name);
+        break;
+    }
+
+    case OBJ_font_part: {
+        struct pdf_font_embed *embed = object->font_part.font->font.embed;
+        const struct pdf_ttf *ttf = embed->ttf;
+
+        switch (object->font_part.kind) {
+        case FONT_PART_CIDFONT: {
+            uint32_t g = 0;
+
+            pdf_output_printf(out,
+                              "<<\r\n"
+                              "  /Type /Font\r\n"
+                              "  /Subtype /CIDFontType2\r\n"
+                              "  /BaseFont /%s\r\n"
+                              "  /CIDSystemInfo << /Registry (Adobe) "
+                              "/Ordering (Identity) /Supplement 0 >>\r\n"
+                              "  /FontDescriptor %d 0 R\r\n"
+                              "  /CIDToGIDMap /Identity\r\n"
+                              "  /W [",
+                              embed->subset_name,
+                              embed->parts[FONT_PART_DESCRIPTOR]->index);
+            /* Widths of each run of glyphs drawn in the document */
+            while (g < ttf->glyph_count) {
+                if (!TTF_GLYPH_SET(embed->used, g)) {
+                    g++;
+                    continue;
+                }
+                pdf_output_printf(out, " %u [", g);
+                for (; g < ttf->glyph_count && TTF_GLYPH_SET(embed->used, g);
+                     g++)
+                    pdf_output_printf(out, " %d",
+                                      TTF_SCALE(ttf, ttf->advances[g]));
+                pdf_output_printf(out, " ]");
+            }
+            pdf_output_printf(out, " ]\r\n>>\r\n");
+            break;
+        }
+
+        case FONT_PART_DESCRIPTOR: {
+            int flags = 4; /* Symbolic: we use our own character codes */
+
+            if (ttf->fixed_pitch)
+                flags |= 1;
+            if (ttf->italic_angle != 0)
+                flags |= 64;
+            pdf_output_printf(
+                out,
+                "<<\r\n"
+                "  /Type /FontDescriptor\r\n"
+                "  /FontName /%s\r\n"
+                "  /Flags %d\r\n"
+                "  /FontBBox [ %d %d %d %d ]\r\n"
+                "  /ItalicAngle %f\r\n"
+                "  /Ascent %d\r\n"
+                "  /Descent %d\r\n"
+                "  /CapHeight %d\r\n"
+                "  /StemV 80\r\n"
+                "  /FontFile2 %d 0 R\r\n"
+                ">>\r\n",
+                embed->subset_name, flags, TTF_SCALE(ttf, ttf->bbox[0]),
+                TTF_SCALE(ttf, ttf->bbox[1]), TTF_SCALE(ttf, ttf->bbox[2]),
+                TTF_SCALE(ttf, ttf->bbox[3]), ttf->italic_angle,
+                TTF_SCALE(ttf, ttf->ascent), TTF_SCALE(ttf, ttf->descent),
+                TTF_SCALE(ttf, ttf->cap_height),
+                embed->parts[FONT_PART_FILE]->index);
+            break;
+        }
+
+        case FONT_PART_FILE:
+        case FONT_PART_TO_UNICODE: {
+            const void *data = embed->file;
+            size_t len = embed->file_len;
+            struct dstr packed = INIT_DSTR;
+
+            if (object->font_part.kind == FONT_PART_TO_UNICODE) {
+                data = dstr_data(&embed->to_unicode);
+                len = dstr_len(&embed->to_unicode);
+            }
+            pdf_output_printf(out, "<<\r\n");
+            if (object->font_part.kind == FONT_PART_FILE)
+                pdf_output_printf(out, "  /Length1 %zu\r\n", len);
+            if (pdf->compression) {
+                int e = pdf_compress(pdf, &packed, data, len);
+                if (e < 0) {
+                    dstr_free(&packed);
+                    return e;
+                }
+                data = dstr_data(&packed);
+                len = dstr_len(&packed);
+                pdf_output_printf(out, "  /Filter /FlateDecode\r\n");
+            }
+            pdf_output_printf(out, "  /Length %zu\r\n>>stream\r\n", len);
+            pdf_output_write(out, data, len);
+            pdf_output_printf(out, "\r\nendstream\r\n");
+            if (pdf->compression)
+                pdf_output_release(out);
+            dstr_free(&packed);
+            break;
+        }
+        }
+        break;
+    }
+
+    case OBJ_pages: {
+        int npages = flexarray_size(&pdf->pages);
+
+        pdf_output_printf(out, "<<\r\n"
+                          "  /Type /Pages\r\n"
+                          "  /Kids [ ");
+        for (int i = 0; i < npages; i++) {
+            struct pdf_object *page =
+                (struct pdf_object *)flexarray_get(&pdf->pages, i);
+            pdf_output_printf(out, "%d 0 R ", page->index);
+        }
+        pdf_output_printf(out, "]\r\n");
+        pdf_output_printf(out, "  /Count %d\r\n", npages);
+        pdf_output_printf(out, ">>\r\n");
+        break;
+    }
+
+    case OBJ_catalog: {
+        struct pdf_object *outline = pdf_find_first_object(pdf, OBJ_outline);
+        struct pdf_object *pages = pdf_find_first_object(pdf, OBJ_pages);
+
+        pdf_output_printf(out, "<<\r\n"
+                          "  /Type /Catalog\r\n");
+        if (outline)
+            pdf_output_printf(out,
+                              "  /Outlines %d 0 R\r\n"
+                              "  /PageMode /UseOutlines\r\n",
+                              outline->index);
+        pdf_output_printf(out,
+                          "  /Pages %d 0 R\r\n"
+                          ">>\r\n",
+                          pages->index);
+        break;
+    }
+
+    case OBJ_resources:
+        pdf_output_printf(out, "<<\r\n");
+        switch (object->resources.kind) {
+        case RESOURCES_FONTS:
+            for (struct pdf_object *font = pdf_find_first_object(pdf, OBJ_font);
+                 font; font = font->next)
+                pdf_output_printf(out, "  /F%d %d 0 R\r\n", font->font.index,
+                                  font->index);
+            break;
+        case RESOURCES_EXTGSTATE:
+            // We trim transparency to just 4-bits
+            for (int i = 0; i < 16; i++)
+                pdf_output_printf(out, "  /GS%d <</ca %f>>\r\n", i,
+                                  (float)(15 - i) / 15);
+            break;
+        case RESOURCES_PAGE:
+            pdf_output_printf(out,
+                              "  /Font %d 0 R\r\n"
+                              "  /ExtGState %d 0 R\r\n",
+                              pdf->resources[RESOURCES_FONTS]->index,
+                              pdf->resources[RESOURCES_EXTGSTATE]->index);
+            break;
+        }
+        pdf_output_printf(out, ">>\r\n");
+        break;
+
+    case OBJ_link: {
+        pdf_output_printf(out,
+                          "<<\r\n"
+                          "  /Type /Annot\r\n"
+                          "  /Subtype /Link\r\n"
+                          "  /Rect [%f %f %f %f]\r\n"
+                          "  /Dest [%u 0 R /XYZ %f %f null]\r\n"
+                          "  /Border [0 0 0]\r\n"
+                          ">>\r\n",
+                          object->link.llx, object->link.lly, object->link.urx,
+                          object->link.ury, object->link.target_page->index,
+                          object->link.target_x, object->link.target_y);
+        break;
+    }
+
+    case OBJ_template: {
+        struct dstr packed = INIT_DSTR;
+        const char *data = dbuf_data(&object->form.stream);
+        size_t len = dbuf_len(&object->form.stream);
+
+        pdf_output_printf(out,
+                          "<<\r\n"
+                          "  /Type /XObject\r\n"
+                          "  /Subtype /Form\r\n"
+                          "  /BBox [0 0 %f %f]\r\n",
+                          object->form.width, object->form.height);
+        pdf_save_resources(pdf, out, &object->form.xobjects);
+        if (pdf->compression) {
+            int e = pdf_compress(pdf, &packed, data, len);
+            if (e < 0) {
+                dstr_free(&packed);
+                return e;
+            }
+            data = dstr_data(&packed);
+            len = dstr_len(&packed);
+            pdf_output_printf(out, "  /Filter /FlateDecode\r\n");
+        }
+        pdf_output_printf(out, "  /Length %zu\r\n>>stream\r\n", len);
+        pdf_output_write(out, data, len);
+        pdf_output_printf(out, "\r\nendstream\r\n");
+        if (pdf->compression)
+            pdf_output_release(out);
+        dstr_free(&packed);
+        break;
+    }
+
+    default:
+        return pdf_set_err(pdf, -EINVAL, "Invalid PDF object type %d",
+                           object->type);
+    }
+
+    pdf_output_printf(out, "endobj\r\n");
+
+    return 0;
+}
+
+// Slightly modified djb2 hash algorithm to get pseudo-random ID
+static uint64_t hash(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *d8 = (const uint8_t *)data;
+    for (; len; len--) {
+        hash = (((hash & 0x03ffffffffffffff) << 5) +
+                (hash & 0x7fffffffffffffff)) +
+               *d8++;
+    }
+    return hash;
+}
+
+static void pdf_save_header(struct pdf_output *out)
+{
+    pdf_output_printf(out, "%%PDF-1.3\r\n");
+    /* Hibit bytes */
+    pdf_output_printf(out, "%c%c%c%c%c\r\n", 0x25, 0xc7, 0xec, 0x8f, 0xa2);
+}
+
+/**
+ * Write the xref table & trailer, once all objects have been written
+ */
+static void pdf_save_xref(struct pdf_doc *pdf, struct pdf_output *out,
+                          int xref_count)
+{
+    struct pdf_object *obj;
+    size_t xref_offset;
+    uint64_t id1, id2;
+    time_t now = time(NULL);
+
+    /* xref */
+    xref_offset = out->offset;
+    pdf_output_printf(out, "xref\r\n");
+    pdf_output_printf(out, "0 %d\r\n", xref_count + 1);
+    pdf_output_printf(out, "0000000000 65535 f\r\n");
+    for (int i = 0; i < flexarray_size(&pdf->objects); i++) {
+        /* Equivalent to "%10.10zu 00000 n\r\n", but much faster */
+        char line[] = "0000000000 00000 n\r\n";
+
+        obj = pdf_get_object(pdf, i);
+        if (obj->type == OBJ_none)
+            continue;
+        if (obj->offset > 9999999999ULL) {
+            pdf_output_printf(out, "%10.10zu 00000 n\r\n", obj->offset);
+            continue;
+        }
+        format_uint(line + 10, obj->offset, 10, false);
+        pdf_output_write(out, line, sizeof(line) - 1);
+    }
+
+    pdf_output_printf(out,
+                      "trailer\r\n"
+                      "<<\r\n"
+                      "/Size %d\r\n",
+                      xref_count + 1);
+    obj = pdf_find_first_object(pdf, OBJ_catalog);
+    pdf_output_printf(out, "/Root %d 0 R\r\n", obj->index);
+    obj = pdf_find_first_object(pdf, OBJ_info);
+    pdf_output_printf(out, "/Info %d 0 R\r\n", obj->index);
+    /* Generate document unique IDs */
+    id1 = hash(5381, obj->info, sizeof(struct pdf_info));
+    id1 = hash(id1, &xref_count, sizeof(xref_count));
+    id2 = hash(5381, &now, sizeof(now));
+    pdf_output_printf(out, "/ID [<%16.16" PRIx64 "> <%16.16" PRIx64 ">]\r\n",
+                      id1, id2);
+    pdf_output_printf(out, ">>\r\n"
+                      "startxref\r\n");
+    pdf_output_printf(out, "%zu\r\n", xref_offset);
+    pdf_output_printf(out, "%%%%EOF\r\n");
+}
+
+/**
+ * Report any error from writing to an output
+ */
+static int pdf_output_check(struct pdf_doc *pdf, struct pdf_output *out)
+{
+    if (out->error == -ENOMEM)
+        return pdf_set_err(pdf, out->error, "Unable to allocate PDF output");
+    if (out->error < 0)
+        return pdf_set_err(pdf, out->error, "Unable to write PDF: %s",
+                           strerror(-out->error));
+    return 0;
+}
+
+static int pdf_save_output(struct pdf_doc *pdf, struct pdf_output *out)
+{
+    int xref_count = 0;
+    int e;
+
+    if (pdf->stream)
+        return pdf_set_err(pdf, -EINVAL,
+                           "Streaming documents are saved with pdf_finish");
+
+    e = pdf_prepare_fonts(pdf);
+    if (e < 0)
+        return e;
+
+    /* Batch output in the document's buffer, kept from any previous save */
+    out->pending = pdf->output_pending;
+    pdf->output_pending = INIT_DSTR;
+
+    pdf_save_header(out);
+
+    /* Dump all the objects & get their file offsets */
+    for (int i = 0; i < flexarray_size(&pdf->objects); i++)
+        if (pdf_save_object(pdf, out, i) >= 0)
+            xref_count++;
+
+    pdf_save_xref(pdf, out, xref_count);
+    pdf_output_flush(out);
+
+    e = pdf_output_check(pdf, out);
+    out->pending.used_len = 0;
+    pdf->output_pending = out->pending;
+    return e;
+}
+
+int pdf_save_writer(struct pdf_doc *pdf, pdf_writer_fn writer, void *user)
+{
+    struct pdf_output out = {
+        .writer = writer, .user = user, .pending = INIT_DSTR};
+
+    if (!writer)
+        return pdf_set_err(pdf, -EINVAL, "No writer supplied");
+    return pdf_save_output(pdf, &out);
+}
+
+int pdf_save_file(struct pdf_doc *pdf, FILE *fp)
+{
+    struct pdf_output out = {
+        .writer = pdf_file_writer, .user = fp, .pending = INIT_DSTR};
+    long pos = ftell(fp);
+
+    /* Offsets are from the start of the file, if we aren't there already */
+    if (pos > 0)
+        out.offset = pos;
+    return pdf_save_output(pdf, &out);
+}
+
+/**
+ * Rough upper bound on the saved size of a document, so the output buffer
+ * can be allocated up front
+ */
+static size_t pdf_estimate_size(const struct pdf_doc *pdf)
+{
+    size_t size = 1024;
+
+    for (int i = 0; i < flexarray_size(&pdf->objects); i++) {
+        const struct pdf_object *obj = pdf_get_object(pdf, i);
+
+        switch (obj->type) {
+        case OBJ_stream:
+            /* Content streams typically deflate to well under a third */
+            size += pdf->compression ? dbuf_len(&obj->stream.stream) / 3
+                                     : dbuf_len(&obj->stream.stream);
+            break;
+        case OBJ_image:
+            size += dbuf_len(&obj->stream.stream);
+            break;
+        case OBJ_template:
+            size += dbuf_len(&obj->form.stream);
+            break;
+        case OBJ_page:
+            size += 256;
+            break;
+        default:
+            break;
+        }
+        size += 128; /* Object header, dictionary & xref entry */
+    }
+    return size;
+}
+
+int pdf_save_buffer(struct pdf_doc *pdf, char **data, size_t *len)
+{
+    struct dstr buf = INIT_DSTR;
+    struct pdf_output out = {.buf = &buf, .pending = INIT_DSTR};
+    size_t size = pdf_estimate_size(pdf);
+    int e;
+
+    if (dstr_ensure(&buf, size) < 0)
+        return pdf_set_err(pdf, -ENOMEM,
+                           "Unable to allocate %zu bytes for PDF", size);
+    e = pdf_save_output(pdf, &out);
+    if (e < 0) {
+        dstr_free(&buf);
+        return e;
+    }
+
+    /* Hand the buffer over to the caller, rather than copying it */
+    *len = dstr_len(&buf);
+    if (buf.data) {
+        *data = buf.data;
+    } else {
+        *data = (char *)malloc(*len + 1);
+        if (!*data)
+            return pdf_set_err(pdf, -ENOMEM, "Unable to allocate PDF buffer");
+        memcpy(*data, dstr_data(&buf), *len + 1);
+    }
+    return 0;
+}
+
+/**
+ * Objects which are only needed by a single page (or already referenced
+ * by index) can be written out as soon as that page is finished.
+ * Templates can be written once they have been recorded, those still
+ * being recorded are written by pdf_end_template instead.
+ */
+static bool pdf_object_is_flushable(const struct pdf_doc *pdf,
+                                    const struct pdf_object *obj)
+{
+    switch (obj->type) {
+    case OBJ_stream:
+    case OBJ_image:
+    case OBJ_page:
+    case OBJ_link:
+        return true;
+    case OBJ_template:
+        return obj != pdf->current_template;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Release the contents of an object which has been written out. The object
+ * itself is kept, so that its index & offset remain available.
+ */
+static void pdf_object_release(struct pdf_object *obj)
+{
+    switch (obj->type) {
+    case OBJ_stream:
+    case OBJ_image:
+        dbuf_free(&obj->stream.stream);
+        break;
+    case OBJ_template:
+        dbuf_free(&obj->form.stream);
+        break;
+    }
+}
+
+/**
+ * Write out a finished object of a streaming document, and release its
+ * contents
+ */
+static int pdf_flush_object(struct pdf_doc *pdf, struct pdf_object *obj)
+{
+    int e = pdf_save_object(pdf, pdf->stream, obj->index);
+
+    if (e < 0)
+        return e;
+    pdf_output_release(pdf->stream);
+    pdf_object_release(obj);
+    return 0;
+}
+
+struct pdf_doc *pdf_create_streaming_writer(float width, float height,
+                                            const struct pdf_info *info,
+                                            pdf_writer_fn writer, void *user)
+{
+    struct pdf_doc *pdf;
+
+    if (!writer)
+        return NULL;
+    pdf = pdf_create(width, height, info);
+    if (!pdf)
+        return NULL;
+    pdf->stream = (struct pdf_output *)calloc(1, sizeof(*pdf->stream));
+    if (!pdf->stream) {
+        pdf_destroy(pdf);
+        return NULL;
+    }
+    pdf->stream->writer = writer;
+    pdf->stream->user = user;
+    pdf->stream->pending = INIT_DSTR;
+    pdf_save_header(pdf->stream);
+    return pdf;
+}
+
+struct pdf_doc *pdf_create_streaming(float width, float height,
+                                     const struct pdf_info *info, FILE *fp)
+{
+    if (!fp)
+        return NULL;
+    return pdf_create_streaming_writer(width, height, info, pdf_file_writer,
+                                       fp);
+}
+
+int pdf_flush(struct pdf_doc *pdf)
+{
+    int e = 0;
+    int i;
+
+    if (!pdf->stream)
+        return pdf_set_err(pdf, -EINVAL, "Document is not streaming");
+
+    for (i = pdf->flushed_objects; i < flexarray_size(&pdf->objects); i++) {
+        struct pdf_object *obj = pdf_get_object(pdf, i);
+
+        if (!pdf_object_is_flushable(pdf, obj))
+            continue;
+        e = pdf_flush_object(pdf, obj);
+        if (e < 0)
+            break;
+    }
+    pdf->flushed_objects = i;
+    pdf_output_flush(pdf->stream);
+
+    if (e >= 0)
+        e = pdf_output_check(pdf, pdf->stream);
+    return e;
+}
+
+int pdf_finish(struct pdf_doc *pdf)
+{
+    int xref_count = 0;
+    int e;
+
+    /* Write out everything except the document-wide objects first */
+    e = pdf_flush(pdf);
+    if (e >= 0)
+        e = pdf_prepare_fonts(pdf);
+    if (e < 0)
+        return e;
+
+    for (int i = 0; i < flexarray_size(&pdf->objects); i++) {
+        struct pdf_object *obj = pdf_get_object(pdf, i);
+
+        if (obj->type == OBJ_none)
+            continue;
+        if (obj->offset == 0 && pdf_save_object(pdf, pdf->stream, i) < 0)
+            continue;
+        xref_count++;
+    }
+    pdf_save_xref(pdf, pdf->stream, xref_count);
+    pdf_output_flush(pdf->stream);
+
+    if (pdf->stream->writer == pdf_file_writer &&
+        fflush((FILE *)pdf->stream->user) != 0 && !pdf->stream->error)
+        pdf->stream->error = -errno;
+    return pdf_output_check(pdf, pdf->stream);
+}
+
+int pdf_save_fd(struct pdf_doc *pdf, int fd)
+{
+    struct pdf_output out = {.fd = fd, .pending = INIT_DSTR};
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+
+    /* Offsets are from the start of the file, if we aren't there already */
+    if (pos > 0)
+        out.offset = (size_t)pos;
+    return pdf_save_output(pdf, &out);
+}
+
+int pdf_save(struct pdf_doc *pdf, const char *filename)
+{
+    int fd;
+    int e;
+
+    if (filename == NULL)
+        return pdf_save_file(pdf, stdout);
+
+    fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+    if (fd < 0)
+        return pdf_set_err(pdf, -errno, "Unable to open '%s': %s", filename,
+                           strerror(errno));
+
+    e = pdf_save_fd(pdf, fd);
+
+    if (close(fd) != 0 && e >= 0)
+        return pdf_set_err(pdf, -errno, "Unable to close '%s': %s", filename,
+                           strerror(errno));
+
+    return e;
+}
+
+/**
+ * Append a fragment of page markup to the page's content stream.
+ * Every page owns a single content stream object, created on first use, and
+ * all drawing operations on that page are appended to it. This keeps the
+ * object count, xref table & /Contents array independent of the number of
+ * drawing operations performed.
+ */
+static int pdf_add_stream(struct pdf_doc *pdf, struct pdf_object *page,
+                          const char *buffer)
+{
+    struct dbuf *content;
+    size_t len;
+    int e;
+
+    if (!page)
+        page = pdf_default_page(pdf);
+
+    e = pdf_check_drawable(pdf, page);
+    if (e < 0)
+        return e;
+
+    len = strlen(buffer);
+    /* We don't want any trailing whitespace in the stream */
+    while (len >= 1 && (buffer[len - 1] == '\r' || buffer[len - 1] == '\n'))
+        len--;
+
+    if (page->type == OBJ_template) {
+        /* Templates hold their own content, as they are a stream */
+        content = &page->form.stream;
+        if (dbuf_len(content) > 0 && dbuf_append_data(content, "\r\n", 2) < 0)
+            return pdf_set_err(pdf, -ENOMEM, "Unable to grow template");
+    } else {
+        struct pdf_object *obj = page->page.contents;
+
+        if (!obj) {
+            obj = pdf_add_object(pdf, OBJ_stream);
+            if (!obj)
+                return pdf->errval;
+            obj->stream.page = page;
+            if (pdf->spare_count > 0)
+                obj->stream.stream = pdf->spare_buffers[--pdf->spare_count];
+            page->page.contents = obj;
+        } else if (dbuf_append_data(&obj->stream.stream, "\r\n", 2) < 0) {
+            return pdf_set_err(pdf, -ENOMEM, "Unable to grow page content");
+        }
+        content = &obj->stream.stream;
+    }
+
+    if (dbuf_append_data(content, buffer, len) < 0)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to grow page content");
+
+    return 0;
+}
+
+int pdf_add_bookmark(struct pdf_doc *pdf, struct pdf_object *page, int parent,
+                     const char *name)
+{
+    struct pdf_object *obj, *outline = NULL, *parent_obj = NULL;
+    char *title;
+
+    if (!page)
+        page = pdf_find_last_object(pdf, OBJ_page);
+
+    if (!page || page->type != OBJ_page)
+        return pdf_set_err(pdf, -EINVAL,
+                           "Unable to add bookmark, no pages available");
+
+    if (parent >= 0) {
+        parent_obj = pdf_get_object(pdf, parent);
+        if (!parent_obj || parent_obj->type != OBJ_bookmark)
+            return pdf_set_err(pdf, -EINVAL, "Invalid parent ID %d supplied",
+                               parent);
+    }
+
+    title = pdf_arena_strdup(pdf, name);
+    if (!title)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate bookmark name");
+
+    if (!pdf_find_first_object(pdf, OBJ_outline)) {
+        outline = pdf_add_object(pdf, OBJ_outline);
+        if (!outline)
+            return pdf->errval;
+    }
+
+    obj = pdf_add_object(pdf, OBJ_bookmark);
+    if (!obj) {
+        if (outline)
+            pdf_del_object(pdf, outline);
+        return pdf->errval;
+    }
+
+    obj->bookmark.name = title;
+    obj->bookmark.page = page;
+    if (parent_obj) {
+        obj->bookmark.parent = parent_obj;
+        objlist_append(pdf, &parent_obj->bookmark.children, obj);
+    }
+
+    return obj->index;
+}
+
+int pdf_add_link(struct pdf_doc *pdf, struct pdf_object *page, float x,
+                 float y, float width, float height,
+                 struct pdf_object *target_page, float target_x,
+                 float target_y)
+{
+    struct pdf_object *obj;
+
+    if (!page)
+        page = pdf_find_last_object(pdf, OBJ_page);
+
+    if (!page || page->type != OBJ_page)
+        return pdf_set_err(pdf, -EINVAL,
+                           "Unable to add link, no pages available");
+
+    if (!target_page)
+        return pdf_set_err(pdf, -EINVAL, "Unable to link, no target page");
+
+    if (pdf_page_is_flushed(pdf, page))
+        return pdf_set_err(pdf, -EINVAL, "Page has already been written");
+
+    obj = pdf_add_object(pdf, OBJ_link);
+    if (!obj) {
+        return pdf->errval;
+    }
+
+    obj->link.target_page = target_page;
+    obj->link.target_x = target_x;
+    obj->link.target_y = target_y;
+    obj->link.llx = x;
+    obj->link.lly = y;
+    obj->link.urx = x + width;
+    obj->link.ury = y + height;
+    objlist_append(pdf, &page->page.annotations, obj);
+
+    return obj->index;
+}
+
+static int utf8_to_utf32(const char *utf8, int len, uint32_t *utf32)
+{
+    uint32_t ch;
+    uint8_t mask;
+
+    if (len <= 0 || !utf8 || !utf32)
+        return -EINVAL;
+
+    ch = *(uint8_t *)utf8;
+    if ((ch & 0x80) == 0) {
+        len = 1;
+        mask = 0x7f;
+    } else if ((ch & 0xe0) == 0xc0 && len >= 2) {
+        len = 2;
+        mask = 0x1f;
+    } else if ((ch & 0xf0) == 0xe0 && len >= 3) {
+        len = 3;
+        mask = 0xf;
+    } else if ((ch & 0xf8) == 0xf0 && len >= 4) {
+        len = 4;
+        mask = 0x7;
+    } else
+        return -EINVAL;
+
+    ch = 0;
+    for (int i = 0; i < len; i++) {
+        int shift = (len - i - 1) * 6;
+        if (!*utf8)
+            return -EINVAL;
+        if (i == 0)
+            ch |= ((uint32_t)(*utf8++) & mask) << shift;
+        else
+            ch |= ((uint32_t)(*utf8++) & 0x3f) << shift;
+    }
+
+    *utf32 = ch;
+
+    return len;
+}
+
+/**
+ * The characters above U+00FF that are in WinAnsiEncoding, sorted by code
+ * point. See Appendix D of
+ * https://opensource.adobe.com/dc-acrobat-sdk-docs/pdfstandards/pdfreference1.7old.pdf
+ */
+static const struct {
+    uint16_t code;
+    uint8_t pdf_char;
+} winansi_extra[] = {
+    {0x152, 0214}, // Latin Capital Ligature OE
+    {0x153, 0234}, // Latin Small Ligature oe
+    {0x160, 0212}, // Latin Capital Letter S with caron
+    {0x161, 0232}, // Latin Small Letter S with caron
+    {0x178, 0237}, // Latin Capital Letter y with diaeresis
+    {0x17d, 0216}, // Latin Capital Letter Z with caron
+    {0x17e, 0236}, // Latin Small Letter Z with caron
+    {0x192, 0203}, // Latin Small Letter F with hook
+    {0x2c6, 0210}, // Modifier Letter Circumflex Accent
+    {0x2dc, 0230}, // Small Tilde
+    {0x2013, 0226}, // Endash
+    {0x2014, 0227}, // Emdash
+    {0x2018, 0221}, // Left Single Quote
+    {0x2019, 0222}, // Right Single Quote
+    {0x201a, 0202}, // Single low-9 Quotation Mark
+    {0x201c, 0223}, // Left Double Quote
+    {0x201d, 0224}, // Right Double Quote
+    {0x201e, 0204}, // Double low-9 Quotation Mark
+    {0x2020, 0206}, // Dagger
+    {0x2021, 0207}, // Double Dagger
+    {0x2022, 0225}, // Bullet
+    {0x2026, 0205}, // Horizontal Ellipsis
+    {0x2030, 0211}, // Per Mille Sign
+    {0x2039, 0213}, // Single Left-pointing Angle Quotation Mark
+    {0x203a, 0233}, // Single Right-pointing Angle Quotation Mark
+    {0x20ac, 0200}, // Euro
+    {0x2122, 0231}, // Trade Mark Sign
+};
+
+static int utf8_to_pdfencoding(struct pdf_doc *pdf, const char *utf8, int len,
+                               uint8_t *res)
+{
+    uint32_t code;
+    int code_len;
+
+    *res = 0;
+
+    /* Plain ASCII is by far the most common case */
+    if (len > 0 && !(*(const uint8_t *)utf8 & 0x80)) {
+        *res = *(const uint8_t *)utf8;
+        return 1;
+    }
+
+    code_len = utf8_to_utf32(utf8, len, &code);
+    if (code_len < 0) {
+        return pdf_set_err(pdf, -EINVAL, "Invalid UTF-8 encoding");
+    }
+
+    if (code > 255) {
+        /* We support *some* minimal UTF-8 characters */
+        int lo = 0, hi = (int)ARRAY_SIZE(winansi_extra) - 1;
+
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            if (winansi_extra[mid].code == code) {
+                *res = winansi_extra[mid].pdf_char;
+                return code_len;
+            }
+            if (winansi_extra[mid].code < code)
+                lo = mid + 1;
+            else
+                hi = mid - 1;
+        }
+        return pdf_set_err(pdf, -EINVAL,
+                           "Unsupported UTF-8 character: 0x%x 0o%o %s", code,
+                           code, utf8);
+    } else {
+        *res = code;
+    }
+    return code_len;
+}
+
+/**
+ * How each PDF encoded character is written inside a text string
+ */
+enum {
+    TEXT_PLAIN,  /* Copied as is */
+    TEXT_ESCAPE, /* Preceded by a backslash */
+    TEXT_SKIP,   /* Left out */
+};
+
+static const uint8_t text_escape[256] = {
+    /* \b, \t, \n, \f and \r are left out */
+    ['\b'] = TEXT_SKIP,
+    ['\t'] = TEXT_SKIP,
+    ['\n'] = TEXT_SKIP,
+    ['\f'] = TEXT_SKIP,
+    ['\r'] = TEXT_SKIP,
+    /* (, ) and \\ are escaped */
+    ['('] = TEXT_ESCAPE,
+    [')'] = TEXT_ESCAPE,
+    ['\\'] = TEXT_ESCAPE,
+    /* Everything else is TEXT_PLAIN */
+};
+
+/**
+ * Decode UTF-8 text into the PDF encoding of a font, or its glyph IDs for
+ * TrueType fonts. If measure is set, the running width of the characters
+ * is also recorded.
+ */
+static int pdf_decode_text(struct pdf_doc *pdf, const char *text, size_t len,
+                           const struct pdf_object *font, bool measure,
+                           struct pdf_glyphs *glyphs)
+{
+    const uint16_t *widths = measure ? font->font.widths : NULL;
+    const struct kern_table *kerns =
+        measure ? pdf_font_kerns(pdf, font) : NULL;
+    const struct pdf_ttf *ttf =
+        font->font.embed ? font->font.embed->ttf : NULL;
+    uint32_t width = 0;
+    int count = 0;
+
+    if (len >= UINT32_MAX || len >= INT_MAX)
+        return pdf_set_err(pdf, -EINVAL, "Text is too long");
+
+    /* There are never more characters than bytes */
+    if (len + 1 > glyphs->alloc) {
+        size_t alloc = len + 1 > glyphs->alloc * 2 ? len + 1 : glyphs->alloc * 2;
+        uint8_t *codes = (uint8_t *)realloc(glyphs->codes, alloc);
+        if (codes)
+            glyphs->codes = codes;
+        uint32_t *offsets = (uint32_t *)realloc(glyphs->offsets,
+                                                alloc * sizeof(*offsets));
+        if (offsets)
+            glyphs->offsets = offsets;
+        uint32_t *new_widths =
+            (uint32_t *)realloc(glyphs->widths, alloc * sizeof(*new_widths));
+        if (new_widths)
+            glyphs->widths = new_widths;
+        uint16_t *gids =
+            (uint16_t *)realloc(glyphs->gids, alloc * sizeof(*gids));
+        if (gids)
+            glyphs->gids = gids;
+        if (!codes || !offsets || !new_widths || !gids)
+            return pdf_set_err(pdf, -ENOMEM, "Unable to allocate text buffer");
+        glyphs->alloc = alloc;
+    }
+
+    for (size_t i = 0; i < len;) {
+        uint8_t pdf_char;
+        int code_len;
+
+        glyphs->widths[count] = width;
+        if (ttf) {
+            uint32_t code = (uint8_t)text[i];
+            uint16_t gid;
+
+            code_len = 1;
+            if (code & 0x80) {
+                code_len = utf8_to_utf32(&text[i], len - i, &code);
+                if (code_len < 0)
+                    return pdf_set_err(pdf, -EINVAL, "Invalid UTF-8 encoding");
+            }
+            /* Only ASCII is kept, for finding line breaks */
+            pdf_char = code < 0x80 ? (uint8_t)code : 0x80;
+            gid = ttf_glyph(ttf, code);
+            glyphs->gids[count] = gid;
+            if (measure && text_escape[pdf_char] != TEXT_SKIP)
+                width += ttf->advances[gid];
+        } else {
+            code_len =
+                utf8_to_pdfencoding(pdf, &text[i], len - i, &pdf_char);
+            if (code_len < 0)
+                return code_len;
+            if (widths && pdf_char != '\n' && pdf_char != '\r')
+                width += widths[pdf_char];
+            /* The kerning between two characters counts towards the
+             * second one */
+            if (kerns && count)
+                width += KERN_WIDTH(
+                    font_kerning(kerns, glyphs->codes[count - 1], pdf_char));
+        }
+
+        glyphs->codes[count] = pdf_char;
+        glyphs->offsets[count] = (uint32_t)i;
+        count++;
+        i += code_len;
+    }
+    glyphs->offsets[count] = (uint32_t)len;
+    glyphs->widths[count] = width;
+    glyphs->count = count;
+
+    return 0;
+}
+
+/**
+ * Add a run of PDF encoded text to the page
+ */
+static int pdf_add_encoded_text(struct pdf_doc *pdf, struct pdf_object *page,
+                                const uint8_t *codes, const uint16_t *gids,
+                                size_t len, const struct pdf_object *font,
+                                const struct kern_table *kerns, float size,
+                                float xoff, float yoff, uint32_t colour,
+                                float spacing, float angle)
+{
+    int ret;
+    struct dstr str = INIT_DSTR;
+    int alpha = (colour >> 24) >> 4;
+
+    /* Don't bother adding empty/null strings */
+    if (!len)
+        return 0;
+
+    dstr_append(&str, "BT ");
+    dstr_printf(&str, "/GS%d gs ", alpha);
+    if (angle != 0) {
+        dstr_printf(&str, "%f %f %f %f %f %f Tm ", cosf(angle), sinf(angle),
+                    -sinf(angle), cosf(angle), xoff, yoff);
+    } else {
+        dstr_printf(&str, "%f %f TD ", xoff, yoff);
+    }
+    dstr_printf(&str, "/F%d %f Tf ", font->font.index, size);
+    dstr_printf(&str, "%f %f %f rg ", PDF_RGB_R(colour), PDF_RGB_G(colour),
+                PDF_RGB_B(colour));
+    dstr_printf(&str, "%f Tc ", spacing);
+
+    if (font->font.embed) {
+        /* TrueType fonts are drawn by glyph ID, as hex */
+        static const char hex[] = "0123456789ABCDEF";
+        uint8_t *used = font->font.embed->used;
+
+        dstr_append(&str, "<");
+        for (size_t i = 0; i < len; i++) {
+            char buf[4];
+            uint16_t gid = gids[i];
+
+            if (text_escape[codes[i]] == TEXT_SKIP)
+                continue;
+            if (gid >= font->font.embed->ttf->glyph_count)
+                gid = 0;
+            used[gid >> 3] |= 1 << (gid & 7);
+            buf[0] = hex[gid >> 12];
+            buf[1] = hex[(gid >> 8) & 0xf];
+            buf[2] = hex[(gid >> 4) & 0xf];
+            buf[3] = hex[gid & 0xf];
+            dstr_append_data(&str, buf, 4);
+        }
+        dstr_append(&str, "> Tj ET");
+
+        ret = pdf_add_stream(pdf, page, dstr_data(&str));
+        dstr_free(&str);
+        return ret;
+    }
+
+    dstr_append(&str, kerns ? "[(" : "(");
+    /* Escape magic characters properly, and copy the runs of plain text
+     * between them in one go */
+    for (size_t i = 0; i < len;) {
+        size_t run = i;
+
+        while (run < len && text_escape[codes[run]] == TEXT_PLAIN) {
+            run++;
+            /* Kerned text is split into runs between the adjustments */
+            if (kerns && run < len) {
+                int kern = font_kerning(kerns, codes[run - 1], codes[run]);
+                if (kern) {
+                    dstr_append_data(&str, &codes[i], run - i);
+                    dstr_printf(&str, ") %d (", -kern);
+                    i = run;
+                }
+            }
+        }
+        if (run > i) {
+            dstr_append_data(&str, &codes[i], run - i);
+            i = run;
+            continue;
+        }
+
+        if (text_escape[codes[i]] == TEXT_ESCAPE) {
+            char buf[2];
+            int kern;
+            buf[0] = '\\';
+            buf[1] = (char)codes[i];
+            dstr_append_data(&str, buf, 2);
+            if (kerns && i + 1 < len &&
+                (kern = font_kerning(kerns, codes[i], codes[i + 1])) != 0)
+                dstr_printf(&str, ") %d (", -kern);
+        }
+        /* Otherwise skip over it */
+        i++;
+    }
+    dstr_append(&str, kerns ? ")] TJ " : ") Tj ");
+    dstr_append(&str, "ET");
+
+    ret = pdf_add_stream(pdf, page, dstr_data(&str));
+    dstr_free(&str);
+    return ret;
+}
+
+static int pdf_add_text_spacing(struct pdf_doc *pdf, struct pdf_object *page,
+                                const char *text, float size, float xoff,
+                                float yoff, uint32_t colour, float spacing,
+                                float angle)
+{
+    size_t len = text ? strlen(text) : 0;
+    int e;
+
+    /* Don't bother adding empty/null strings */
+    if (!len)
+        return 0;
+
+    e = pdf_decode_text(pdf, text, len, pdf->current_font, false,
+                        &pdf->glyphs);
+    if (e < 0)
+        return e;
+    return pdf_add_encoded_text(
+        pdf, page, pdf->glyphs.codes, pdf->glyphs.gids, pdf->glyphs.count,
+        pdf->current_font, pdf_font_kerns(pdf, pdf->current_font), size, xoff,
+        yoff, colour, spacing, angle);
+}
+
+int pdf_add_text(struct pdf_doc *pdf, struct pdf_object *page,
+                 const char *text, float size, float xoff, float yoff,
+                 uint32_t colour)
+{
+    return pdf_add_text_spacing(pdf, page, text, size, xoff, yoff, colour, 0,
+                                0);
+}
+
+int pdf_add_text_rotate(struct pdf_doc *pdf, struct pdf_object *page,
+                        const char *text, float size, float xoff, float yoff,
+                        float angle, uint32_t colour)
+{
+    return pdf_add_text_spacing(pdf, page, text, size, xoff, yoff, colour, 0,
+                                angle);
+}
+
+/* How wide is each character, in points, at size 14 */
+static const uint16_t helvetica_widths[256] = {
+    280, 280, 280, 280,  280, 280, 280, 280,  280,  280, 280,  280, 280,
+    280, 280, 280, 280,  280, 280, 280, 280,  280,  280, 280,  280, 280,
+    280, 280, 280, 280,  280, 280, 280, 280,  357,  560, 560,  896, 672,
+    192, 335, 335, 392,  588, 280, 335, 280,  280,  560, 560,  560, 560,
+    560, 560, 560, 560,  560, 560, 280, 280,  588,  588, 588,  560, 1023,
+    672, 672, 727, 727,  672, 615, 784, 727,  280,  504, 672,  560, 839,
+    727, 784, 672, 784,  727, 672, 615, 727,  672,  951, 672,  672, 615,
+    280, 280, 280, 472,  560, 335, 560, 560,  504,  560, 560,  280, 560,
+    560, 223, 223, 504,  223, 839, 560, 560,  560,  560, 335,  504, 280,
+    560, 504, 727, 504,  504, 504, 336, 262,  336,  588, 352,  560, 352,
+    223, 560, 335, 1008, 560, 560, 335, 1008, 672,  335, 1008, 352, 615,
+    352, 352, 223, 223,  335, 335, 352, 560,  1008, 335, 1008, 504, 335,
+    951, 352, 504, 672,  280, 335, 560, 560,  560,  560, 262,  560, 335,
+    742, 372, 560, 588,  335, 742, 335, 403,  588,  335, 335,  335, 560,
+    541, 280, 335, 335,  367, 560, 840, 840,  840,  615, 672,  672, 672,
+    672, 672, 672, 1008, 727, 672, 672, 672,  672,  280, 280,  280, 280,
+    727, 727, 784, 784,  784, 784, 784, 588,  784,  727, 727,  727, 727,
+    672, 672, 615, 560,  560, 560, 560, 560,  560,  896, 504,  560, 560,
+    560, 560, 280, 280,  280, 280, 560, 560,  560,  560, 560,  560, 560,
+    588, 615, 560, 560,  560, 560, 504, 560,  504,
+};
+
+static const uint16_t helvetica_bold_widths[256] = {
+    280,  280, 280,  280, 280, 280, 280, 280,  280, 280, 280, 280,  280, 280,
+    280,  280, 280,  280, 280, 280, 280, 280,  280, 280, 280, 280,  280, 280,
+    280,  280, 280,  280, 280, 335, 477, 560,  560, 896, 727, 239,  335, 335,
+    392,  588, 280,  335, 280, 280, 560, 560,  560, 560, 560, 560,  560, 560,
+    560,  560, 335,  335, 588, 588, 588, 615,  982, 727, 727, 727,  727, 672,
+    615,  784, 727,  280, 560, 727, 615, 839,  727, 784, 672, 784,  727, 672,
+    615,  727, 672,  951, 672, 672, 615, 335,  280, 335, 588, 560,  335, 560,
+    615,  560, 615,  560, 335, 615, 615, 280,  280, 560, 280, 896,  615, 615,
+    615,  615, 392,  560, 335, 615, 560, 784,  560, 560, 504, 392,  282, 392,
+    588,  352, 560,  352, 280, 560, 504, 1008, 560, 560, 335, 1008, 672, 335,
+    1008, 352, 615,  352, 352, 280, 280, 504,  504, 352, 560, 1008, 335, 1008,
+    560,  335, 951,  352, 504, 672, 280, 335,  560, 560, 560, 560,  282, 560,
+    335,  742, 372,  560, 588, 335, 742, 335,  403, 588, 335, 335,  335, 615,
+    560,  280, 335,  335, 367, 560, 840, 840,  840, 615, 727, 727,  727, 727,
+    727,  727, 1008, 727, 672, 672, 672, 672,  280, 280, 280, 280,  727, 727,
+    784,  784, 784,  784, 784, 588, 784, 727,  727, 727, 727, 672,  672, 615,
+    560,  560, 560,  560, 560, 560, 896, 560,  560, 560, 560, 560,  280, 280,
+    280,  280, 615,  615, 615, 615, 615, 615,  615, 588, 615, 615,  615, 615,
+    615,  560, 615,  560,
+};
+
+static const uint16_t helvetica_bold_oblique_widths[256] = {
+    280,  280, 280,  280, 280, 280, 280, 280,  280, 280, 280, 280,  280, 280,
+    280,  280, 280,  280, 280, 280, 280, 280,  280, 280, 280, 280,  280, 280,
+    280,  280, 280,  280, 280, 335, 477, 560,  560, 896, 727, 239,  335, 335,
+    392,  588, 280,  335, 280, 280, 560, 560,  560, 560, 560, 560,  560, 560,
+    560,  560, 335,  335, 588, 588, 588, 615,  982, 727, 727, 727,  727, 672,
+    615,  784, 727,  280, 560, 727, 615, 839,  727, 784, 672, 784,  727, 672,
+    615,  727, 672,  951, 672, 672, 615, 335,  280, 335, 588, 560,  335, 560,
+    615,  560, 615,  560, 335, 615, 615, 280,  280, 560, 280, 896,  615, 615,
+    615,  615, 392,  560, 335, 615, 560, 784,  560, 560, 504, 392,  282, 392,
+    588,  352, 560,  352, 280, 560, 504, 1008, 560, 560, 335, 1008, 672, 335,
+    1008, 352, 615,  352, 352, 280, 280, 504,  504, 352, 560, 1008, 335, 1008,
+    560,  335, 951,  352, 504, 672, 280, 335,  560, 560, 560, 560,  282, 560,
+    335,  742, 372,  560, 588, 335, 742, 335,  403, 588, 335, 335,  335, 615,
+    560,  280, 335,  335, 367, 560, 840, 840,  840, 615, 727, 727,  727, 727,
+    727,  727, 1008, 727, 672, 672, 672, 672,  280, 280, 280, 280,  727, 727,
+    784,  784, 784,  784, 784, 588, 784, 727,  727, 727, 727, 672,  672, 615,
+    560,  560, 560,  560, 560, 560, 896, 560,  560, 560, 560, 560,  280, 280,
+    280,  280, 615,  615, 615, 615, 615, 615,  615, 588, 615, 615,  615, 615,
+    615,  560, 615,  560,
+};
+
+static const uint16_t helvetica_oblique_widths[256] = {
+    280, 280, 280, 280,  280, 280, 280, 280,  280,  280, 280,  280, 280,
+    280, 280, 280, 280,  280, 280, 280, 280,  280,  280, 280,  280, 280,
+    280, 280, 280, 280,  280, 280, 280, 280,  357,  560, 560,  896, 672,
+    192, 335, 335, 392,  588, 280, 335, 280,  280,  560, 560,  560, 560,
+    560, 560, 560, 560,  560, 560, 280, 280,  588,  588, 588,  560, 1023,
+    672, 672, 727, 727,  672, 615, 784, 727,  280,  504, 672,  560, 839,
+    727, 784, 672, 784,  727, 672, 615, 727,  672,  951, 672,  672, 615,
+    280, 280, 280, 472,  560, 335, 560, 560,  504,  560, 560,  280, 560,
+    560, 223, 223, 504,  223, 839, 560, 560,  560,  560, 335,  504, 280,
+    560, 504, 727, 504,  504, 504, 336, 262,  336,  588, 352,  560, 352,
+    223, 560, 335, 1008, 560, 560, 335, 1008, 672,  335, 1008, 352, 615,
+    352, 352, 223, 223,  335, 335, 352, 560,  1008, 335, 1008, 504, 335,
+    951, 352, 504, 672,  280, 335, 560, 560,  560,  560, 262,  560, 335,
+    742, 372, 560, 588,  335, 742, 335, 403,  588,  335, 335,  335, 560,
+    541, 280, 335, 335,  367, 560, 840, 840,  840,  615, 672,  672, 672,
+    672, 672, 672, 1008, 727, 672, 672, 672,  672,  280, 280,  280, 280,
+    727, 727, 784, 784,  784, 784, 784, 588,  784,  727, 727,  727, 727,
+    672, 672, 615, 560,  560, 560, 560, 560,  560,  896, 504,  560, 560,
+    560, 560, 280, 280,  280, 280, 560, 560,  560,  560, 560,  560, 560,
+    588, 615, 560, 560,  560, 560, 504, 560,  504,
+};
+
+static const uint16_t symbol_widths[256] = {
+    252, 252, 252, 252,  252, 252, 252,  252, 252,  252,  252, 252, 252, 252,
+    252, 252, 252, 252,  252, 252, 252,  252, 252,  252,  252, 252, 252, 252,
+    252, 252, 252, 252,  252, 335, 718,  504, 553,  839,  784, 442, 335, 335,
+    504, 553, 252, 553,  252, 280, 504,  504, 504,  504,  504, 504, 504, 504,
+    504, 504, 280, 280,  553, 553, 553,  447, 553,  727,  672, 727, 616, 615,
+    769, 607, 727, 335,  636, 727, 691,  896, 727,  727,  774, 746, 560, 596,
+    615, 695, 442, 774,  650, 801, 615,  335, 869,  335,  663, 504, 504, 636,
+    553, 553, 497, 442,  525, 414, 607,  331, 607,  553,  553, 580, 525, 553,
+    553, 525, 553, 607,  442, 580, 718,  691, 496,  691,  497, 483, 201, 483,
+    553, 0,   0,   0,    0,   0,   0,    0,   0,    0,    0,   0,   0,   0,
+    0,   0,   0,   0,    0,   0,   0,    0,   0,    0,    0,   0,   0,   0,
+    0,   0,   0,   0,    0,   0,   756,  624, 248,  553,  168, 718, 504, 759,
+    759, 759, 759, 1050, 994, 607, 994,  607, 403,  553,  414, 553, 553, 718,
+    497, 463, 553, 553,  553, 553, 1008, 607, 1008, 663,  829, 691, 801, 994,
+    774, 774, 829, 774,  774, 718, 718,  718, 718,  718,  718, 718, 774, 718,
+    796, 796, 897, 829,  553, 252, 718,  607, 607,  1050, 994, 607, 994, 607,
+    497, 331, 796, 796,  792, 718, 387,  387, 387,  387,  387, 387, 497, 497,
+    497, 497, 0,   331,  276, 691, 691,  691, 387,  387,  387, 387, 387, 387,
+    497, 497, 497, 0,
+};
+
+static const uint16_t times_widths[256] = {
+    252, 252, 252, 252, 252, 252, 252, 252,  252, 252, 252, 252,  252, 252,
+    252, 252, 252, 252, 252, 252, 252, 252,  252, 252, 252, 252,  252, 252,
+    252, 252, 252, 252, 252, 335, 411, 504,  504, 839, 784, 181,  335, 335,
+    504, 568, 252, 335, 252, 280, 504, 504,  504, 504, 504, 504,  504, 504,
+    504, 504, 280, 280, 568, 568, 568, 447,  928, 727, 672, 672,  727, 615,
+    560, 727, 727, 335, 392, 727, 615, 896,  727, 727, 560, 727,  672, 560,
+    615, 727, 727, 951, 727, 727, 615, 335,  280, 335, 472, 504,  335, 447,
+    504, 447, 504, 447, 335, 504, 504, 280,  280, 504, 280, 784,  504, 504,
     504, 504, 335, 392, 280, 504, 504, 727,  504, 504, 447, 483,  201, 483,
     545, 352, 504, 352, 335, 504, 447, 1008, 504, 504, 335, 1008, 560, 335,
     896, 352, 615, 352, 352, 335, 335, 447,  447, 352, 504, 1008, 335, 987,
@@ -1713,319 +4850,2293 @@ static const uint16_t times_widths[256] = {
     504, 504, 504, 504,
 };
 
-static const uint16_t times_bold_widths[256] = {
-    252, 252, 252, 252,  252, 252, 252, 252,  252,  252,  252,  252,  252,
-    252, 252, 252, 252,  252, 252, 252, 252,  252,  252,  252,  252,  252,
-    252, 252, 252, 252,  252, 252, 252, 335,  559,  504,  504,  1008, 839,
-    280, 335, 335, 504,  574, 252, 335, 252,  280,  504,  504,  504,  504,
-    504, 504, 504, 504,  504, 504, 335, 335,  574,  574,  574,  504,  937,
-    727, 672, 727, 727,  672, 615, 784, 784,  392,  504,  784,  672,  951,
-    727, 784, 615, 784,  727, 560, 672, 727,  727,  1008, 727,  727,  672,
-    335, 280, 335, 585,  504, 335, 504, 560,  447,  560,  447,  335,  504,
-    560, 280, 335, 560,  280, 839, 560, 504,  560,  560,  447,  392,  335,
-    560, 504, 727, 504,  504, 447, 397, 221,  397,  524,  352,  504,  352,
-    335, 504, 504, 1008, 504, 504, 335, 1008, 560,  335,  1008, 352,  672,
-    352, 352, 335, 335,  504, 504, 352, 504,  1008, 335,  1008, 392,  335,
-    727, 352, 447, 727,  252, 335, 504, 504,  504,  504,  221,  504,  335,
-    752, 302, 504, 574,  335, 752, 335, 403,  574,  302,  302,  335,  560,
-    544, 252, 335, 302,  332, 504, 756, 756,  756,  504,  727,  727,  727,
-    727, 727, 727, 1008, 727, 672, 672, 672,  672,  392,  392,  392,  392,
-    727, 727, 784, 784,  784, 784, 784, 574,  784,  727,  727,  727,  727,
-    727, 615, 560, 504,  504, 504, 504, 504,  504,  727,  447,  447,  447,
-    447, 447, 280, 280,  280, 280, 504, 560,  504,  504,  504,  504,  504,
-    574, 504, 560, 560,  560, 560, 504, 560,  504,
+static const uint16_t times_bold_widths[256] = {
+    252, 252, 252, 252,  252, 252, 252, 252,  252,  252,  252,  252,  252,
+    252, 252, 252, 252,  252, 252, 252, 252,  252,  252,  252,  252,  252,
+    252, 252, 252, 252,  252, 252, 252, 335,  559,  504,  504,  1008, 839,
+    280, 335, 335, 504,  574, 252, 335, 252,  280,  504,  504,  504,  504,
+    504, 504, 504, 504,  504, 504, 335, 335,  574,  574,  574,  504,  937,
+    727, 672, 727, 727,  672, 615, 784, 784,  392,  504,  784,  672,  951,
+    727, 784, 615, 784,  727, 560, 672, 727,  727,  1008, 727,  727,  672,
+    335, 280, 335, 585,  504, 335, 504, 560,  447,  560,  447,  335,  504,
+    560, 280, 335, 560,  280, 839, 560, 504,  560,  560,  447,  392,  335,
+    560, 504, 727, 504,  504, 447, 397, 221,  397,  524,  352,  504,  352,
+    335, 504, 504, 1008, 504, 504, 335, 1008, 560,  335,  1008, 352,  672,
+    352, 352, 335, 335,  504, 504, 352, 504,  1008, 335,  1008, 392,  335,
+    727, 352, 447, 727,  252, 335, 504, 504,  504,  504,  221,  504,  335,
+    752, 302, 504, 574,  335, 752, 335, 403,  574,  302,  302,  335,  560,
+    544, 252, 335, 302,  332, 504, 756, 756,  756,  504,  727,  727,  727,
+    727, 727, 727, 1008, 727, 672, 672, 672,  672,  392,  392,  392,  392,
+    727, 727, 784, 784,  784, 784, 784, 574,  784,  727,  727,  727,  727,
+    727, 615, 560, 504,  504, 504, 504, 504,  504,  727,  447,  447,  447,
+    447, 447, 280, 280,  280, 280, 504, 560,  504,  504,  504,  504,  504,
+    574, 504, 560, 560,  560, 560, 504, 560,  504,
+};
+
+static const uint16_t times_bold_italic_widths[256] = {
+    252, 252, 252, 252, 252, 252, 252, 252,  252, 252, 252, 252,  252, 252,
+    252, 252, 252, 252, 252, 252, 252, 252,  252, 252, 252, 252,  252, 252,
+    252, 252, 252, 252, 252, 392, 559, 504,  504, 839, 784, 280,  335, 335,
+    504, 574, 252, 335, 252, 280, 504, 504,  504, 504, 504, 504,  504, 504,
+    504, 504, 335, 335, 574, 574, 574, 504,  838, 672, 672, 672,  727, 672,
+    672, 727, 784, 392, 504, 672, 615, 896,  727, 727, 615, 727,  672, 560,
+    615, 727, 672, 896, 672, 615, 615, 335,  280, 335, 574, 504,  335, 504,
+    504, 447, 504, 447, 335, 504, 560, 280,  280, 504, 280, 784,  560, 504,
+    504, 504, 392, 392, 280, 560, 447, 672,  504, 447, 392, 350,  221, 350,
+    574, 352, 504, 352, 335, 504, 504, 1008, 504, 504, 335, 1008, 560, 335,
+    951, 352, 615, 352, 352, 335, 335, 504,  504, 352, 504, 1008, 335, 1008,
+    392, 335, 727, 352, 392, 615, 252, 392,  504, 504, 504, 504,  221, 504,
+    335, 752, 268, 504, 610, 335, 752, 335,  403, 574, 302, 302,  335, 580,
+    504, 252, 335, 302, 302, 504, 756, 756,  756, 504, 672, 672,  672, 672,
+    672, 672, 951, 672, 672, 672, 672, 672,  392, 392, 392, 392,  727, 727,
+    727, 727, 727, 727, 727, 574, 727, 727,  727, 727, 727, 615,  615, 504,
+    504, 504, 504, 504, 504, 504, 727, 447,  447, 447, 447, 447,  280, 280,
+    280, 280, 504, 560, 504, 504, 504, 504,  504, 574, 504, 560,  560, 560,
+    560, 447, 504, 447,
+};
+
+static const uint16_t times_italic_widths[256] = {
+    252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252,  252, 252,
+    252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252,  252, 252,
+    252, 252, 252, 252, 252, 335, 423, 504, 504, 839, 784, 215,  335, 335,
+    504, 680, 252, 335, 252, 280, 504, 504, 504, 504, 504, 504,  504, 504,
+    504, 504, 335, 335, 680, 680, 680, 504, 927, 615, 615, 672,  727, 615,
+    615, 727, 727, 335, 447, 672, 560, 839, 672, 727, 615, 727,  615, 504,
+    560, 727, 615, 839, 615, 560, 560, 392, 280, 392, 425, 504,  335, 504,
+    504, 447, 504, 447, 280, 504, 504, 280, 280, 447, 280, 727,  504, 504,
+    504, 504, 392, 392, 280, 504, 447, 672, 447, 447, 392, 403,  277, 403,
+    545, 352, 504, 352, 335, 504, 560, 896, 504, 504, 335, 1008, 504, 335,
+    951, 352, 560, 352, 352, 335, 335, 560, 560, 352, 504, 896,  335, 987,
+    392, 335, 672, 352, 392, 560, 252, 392, 504, 504, 504, 504,  277, 504,
+    335, 766, 278, 504, 680, 335, 766, 335, 403, 680, 302, 302,  335, 504,
+    527, 252, 335, 302, 312, 504, 756, 756, 756, 504, 615, 615,  615, 615,
+    615, 615, 896, 672, 615, 615, 615, 615, 335, 335, 335, 335,  727, 672,
+    727, 727, 727, 727, 727, 680, 727, 727, 727, 727, 727, 560,  615, 504,
+    504, 504, 504, 504, 504, 504, 672, 447, 447, 447, 447, 447,  280, 280,
+    280, 280, 504, 504, 504, 504, 504, 504, 504, 680, 504, 504,  504, 504,
+    504, 447, 504, 447,
+};
+
+static const uint16_t zapfdingbats_widths[256] = {
+    0,   0,   0,   0,   0,    0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,    0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   280,  981, 968, 981, 987, 724, 795, 796, 797, 695,
+    967, 946, 553, 861, 918,  940, 918, 952, 981, 761, 852, 768, 767, 575,
+    682, 769, 766, 765, 760,  497, 556, 541, 581, 697, 792, 794, 794, 796,
+    799, 800, 822, 829, 795,  847, 829, 839, 822, 837, 930, 749, 728, 754,
+    796, 798, 700, 782, 774,  798, 765, 712, 713, 687, 706, 832, 821, 795,
+    795, 712, 692, 701, 694,  792, 793, 718, 797, 791, 797, 879, 767, 768,
+    768, 765, 765, 899, 899,  794, 790, 441, 139, 279, 418, 395, 395, 673,
+    673, 0,   393, 393, 319,  319, 278, 278, 513, 513, 413, 413, 235, 235,
+    336, 336, 0,   0,   0,    0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,    0,   0,   737, 548, 548, 917, 672, 766, 766,
+    782, 599, 699, 631, 794,  794, 794, 794, 794, 794, 794, 794, 794, 794,
+    794, 794, 794, 794, 794,  794, 794, 794, 794, 794, 794, 794, 794, 794,
+    794, 794, 794, 794, 794,  794, 794, 794, 794, 794, 794, 794, 794, 794,
+    794, 794, 901, 844, 1024, 461, 753, 931, 753, 925, 934, 935, 935, 840,
+    879, 834, 931, 931, 924,  937, 938, 466, 890, 842, 842, 873, 873, 701,
+    701, 880, 0,   880, 766,  953, 777, 871, 777, 895, 974, 895, 837, 879,
+    934, 977, 925, 0,
+};
+
+static const uint16_t courier_widths[256] = {
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
+    604,
+};
+
+static int pdf_text_point_width(struct pdf_doc *pdf, const char *text,
+                                ptrdiff_t text_len, float size,
+                                const uint16_t *widths,
+                                const struct kern_table *kerns,
+                                float *point_width)
+{
+    uint32_t len = 0;
+    uint8_t prev = 0;
+    if (text_len < 0)
+        text_len = strlen(text);
+    *point_width = 0.0f;
+
+    for (int i = 0; i < (int)text_len;) {
+        uint8_t pdf_char = 0;
+        int code_len;
+        code_len =
+            utf8_to_pdfencoding(pdf, &text[i], text_len - i, &pdf_char);
+        if (code_len < 0)
+            return pdf_set_err(pdf, code_len,
+                               "Invalid unicode string at position %d in %s",
+                               i, text);
+        i += code_len;
+
+        if (pdf_char != '\n' && pdf_char != '\r')
+            len += widths[pdf_char];
+        if (kerns)
+            len += KERN_WIDTH(font_kerning(kerns, prev, pdf_char));
+        prev = pdf_char;
+    }
+
+    /* Our widths arrays are for 14pt fonts */
+    *point_width = len * size / (14.0f * 72.0f);
+
+    return 0;
+}
+
+static const uint16_t *find_font_widths(const char *font_name)
+{
+    if (strcasecmp(font_name, "Helvetica") == 0)
+        return helvetica_widths;
+    if (strcasecmp(font_name, "Helvetica-Bold") == 0)
+        return helvetica_bold_widths;
+    if (strcasecmp(font_name, "Helvetica-BoldOblique") == 0)
+        return helvetica_bold_oblique_widths;
+    if (strcasecmp(font_name, "Helvetica-Oblique") == 0)
+        return helvetica_oblique_widths;
+    if (strcasecmp(font_name, "Courier") == 0 ||
+        strcasecmp(font_name, "Courier-Bold") == 0 ||
+        strcasecmp(font_name, "Courier-BoldOblique") == 0 ||
+        strcasecmp(font_name, "Courier-Oblique") == 0)
+        return courier_widths;
+    if (strcasecmp(font_name, "Times-Roman") == 0)
+        return times_widths;
+    if (strcasecmp(font_name, "Times-Bold") == 0)
+        return times_bold_widths;
+    if (strcasecmp(font_name, "Times-Italic") == 0)
+        return times_italic_widths;
+    if (strcasecmp(font_name, "Times-BoldItalic") == 0)
+        return times_bold_italic_widths;
+    if (strcasecmp(font_name, "Symbol") == 0)
+        return symbol_widths;
+    if (strcasecmp(font_name, "ZapfDingbats") == 0)
+        return zapfdingbats_widths;
+
+    return NULL;
+}
+
+/*
+ * Kerning pairs of the standard fonts, from the Adobe Core14 AFM files,
+ * for the characters in WinAnsiEncoding. (The Courier fonts, Symbol and
+ * ZapfDingbats have none.)
+ *
+ * Each table is a minimal perfect hash: the pair picks a bucket, whose
+ * seed gives the one slot the pair could be in. Characters that never
+ * start a pair are rejected by the bitmap before any hashing is done.
+ */
+struct kern_pair {
+    uint16_t pair; /* Left character << 8 | right character */
+    int16_t kern;  /* Adjustment, in thousandths of an em */
+};
+
+struct kern_table {
+    const uint16_t *seeds; /* Hash seed of each bucket */
+    const struct kern_pair *pairs;
+    uint16_t bucket_count;
+    uint16_t pair_count;
+    uint8_t left[32]; /* Bitmap of the characters that start a pair */
+};
+
+static const uint16_t helvetica_kern_seeds[512] = {
+    2, 8, 7, 2, 19, 3, 15, 5, 8, 0, 6, 5, 2, 1, 29, 3, 7, 10, 8, 2, 7, 2, 6, 2,
+    33, 5, 5, 1, 2, 2, 4, 1, 4, 8, 37, 9, 4, 9, 1, 14, 16, 2, 10, 2, 2, 1, 6,
+    15, 5, 11, 10, 6, 6, 0, 2, 0, 1, 4, 18, 21, 4, 4, 3, 9, 8, 23, 1, 2, 1, 10,
+    25, 7, 10, 2, 2, 12, 3, 2, 6, 13, 29, 34, 3, 2, 6, 9, 51, 14, 28, 5, 0, 1,
+    2, 25, 2, 10, 5, 48, 5, 26, 29, 9, 10, 5, 2, 0, 7, 4, 3, 36, 61, 0, 4, 2,
+    30, 2, 36, 4, 12, 20, 15, 18, 12, 1, 22, 18, 38, 1, 14, 7, 17, 10, 6, 9, 0,
+    8, 18, 44, 18, 81, 3, 35, 2, 0, 0, 0, 1, 16, 6, 12, 52, 1, 0, 9, 11, 4, 5,
+    62, 6, 7, 28, 4, 6, 8, 36, 2, 4, 45, 5, 16, 43, 15, 1, 2, 7, 14, 2, 135,
+    81, 6, 6, 8, 18, 3, 6, 25, 67, 0, 1, 16, 17, 0, 1, 7, 0, 10, 4, 2, 16, 5,
+    10, 13, 0, 7, 14, 35, 54, 78, 29, 14, 2, 0, 5, 71, 40, 22, 0, 2, 0, 2, 2,
+    1, 22, 4, 14, 11, 11, 0, 45, 4, 23, 20, 14, 41, 1, 15, 34, 16, 1, 64, 54,
+    1, 44, 11, 13, 1, 7, 28, 4, 0, 0, 9, 77, 0, 15, 12, 16, 36, 73, 3, 13, 7,
+    5, 4, 23, 46, 1, 7, 0, 11, 4, 0, 24, 66, 13, 2, 12, 206, 1, 1, 9, 30, 8,
+    43, 11, 4, 17, 2, 55, 13, 4, 0, 70, 39, 99, 7, 20, 2, 77, 0, 203, 16, 0,
+    62, 3, 1, 1, 0, 1, 1, 61, 287, 1, 29, 3, 0, 1, 1, 8, 84, 37, 132, 27, 8, 3,
+    0, 54, 3, 0, 152, 11, 7, 50, 27, 22, 9, 19, 1, 104, 2, 9, 0, 11, 17, 24,
+    101, 2, 0, 3, 50, 1, 4, 3, 26, 53, 84, 1, 32, 1, 72, 61, 29, 3, 10, 1, 220,
+    0, 1, 1, 8, 30, 15, 1, 3, 39, 163, 1, 0, 14, 9, 13, 8, 7, 21, 0, 2, 10, 10,
+    14, 218, 46, 25, 183, 45, 46, 2, 13, 120, 28, 112, 43, 1, 96, 1, 216, 28,
+    28, 33, 42, 13, 0, 28, 1, 1, 38, 1, 3, 1, 12, 22, 2, 32, 0, 9, 46, 2, 55,
+    233, 21, 6, 44, 7, 5, 1, 19, 9, 5, 29, 10, 154, 5, 8, 61, 0, 0, 0, 3, 76,
+    10, 0, 5, 58, 15, 3, 260, 166, 1, 137, 0, 14, 19, 6, 10, 50, 1, 188, 1, 18,
+    0, 1, 41, 46, 1099, 9, 22, 3, 22, 350, 37, 36, 46, 6, 58, 14, 25, 171, 40,
+    104, 57, 24, 0, 5, 81, 138, 19, 30, 913, 22, 6, 723, 33, 3, 0, 279, 12,
+    339, 20, 1, 76, 118, 1, 19,
 };
 
-static const uint16_t times_bold_italic_widths[256] = {
-    252, 252, 252, 252, 252, 252, 252, 252,  252, 252, 252, 252,  252, 252,
-    252, 252, 252, 252, 252, 252, 252, 252,  252, 252, 252, 252,  252, 252,
-    252, 252, 252, 252, 252, 392, 559, 504,  504, 839, 784, 280,  335, 335,
-    504, 574, 252, 335, 252, 280, 504, 504,  504, 504, 504, 504,  504, 504,
-    504, 504, 335, 335, 574, 574, 574, 504,  838, 672, 672, 672,  727, 672,
-    672, 727, 784, 392, 504, 672, 615, 896,  727, 727, 615, 727,  672, 560,
-    615, 727, 672, 896, 672, 615, 615, 335,  280, 335, 574, 504,  335, 504,
-    504, 447, 504, 447, 335, 504, 560, 280,  280, 504, 280, 784,  560, 504,
-    504, 504, 392, 392, 280, 560, 447, 672,  504, 447, 392, 350,  221, 350,
-    574, 352, 504, 352, 335, 504, 504, 1008, 504, 504, 335, 1008, 560, 335,
-    951, 352, 615, 352, 352, 335, 335, 504,  504, 352, 504, 1008, 335, 1008,
-    392, 335, 727, 352, 392, 615, 252, 392,  504, 504, 504, 504,  221, 504,
-    335, 752, 268, 504, 610, 335, 752, 335,  403, 574, 302, 302,  335, 580,
-    504, 252, 335, 302, 302, 504, 756, 756,  756, 504, 672, 672,  672, 672,
-    672, 672, 951, 672, 672, 672, 672, 672,  392, 392, 392, 392,  727, 727,
-    727, 727, 727, 727, 727, 574, 727, 727,  727, 727, 727, 615,  615, 504,
-    504, 504, 504, 504, 504, 504, 727, 447,  447, 447, 447, 447,  280, 280,
-    280, 280, 504, 560, 504, 504, 504, 504,  504, 574, 504, 560,  560, 560,
-    560, 447, 504, 447,
+static const struct kern_pair helvetica_kern_pairs[1302] = {
+    {0xf86a, -55}, {0xdde0, -140}, {0xfd6f, -20}, {0x57e3, -40}, {0x666f, -30},
+    {0xf8fb, -55}, {0xc177, -40}, {0xffe5, -20}, {0x77eb, -10}, {0x57c3, -50},
+    {0x5665, -80}, {0x542d, -140}, {0xf578, -30}, {0xc3fd, -40}, {0xe376, -20},
+    {0x4cfd, -30}, {0xc3c7, -30}, {0x9fe8, -140}, {0x50c0, -120},
+    {0x50e0, -40}, {0x9273, -50}, {0x54c3, -120}, {0x50e2, -40}, {0xf8e9, -55},
+    {0xc59f, -100}, {0x76ea, -25}, {0x54c1, -120}, {0x6bf2, -20},
+    {0x592e, -140}, {0x762c, -80}, {0x4f2c, -40}, {0xc255, -50}, {0x4179, -40},
+    {0xc379, -40}, {0x4457, -40}, {0x6665, -30}, {0xf878, -85}, {0x59c4, -110},
+    {0x532e, -20}, {0x4bf4, -40}, {0xc4d9, -50}, {0xe576, -20}, {0xe879, -20},
+    {0xc356, -70}, {0xf377, -15}, {0x5256, -50}, {0x7761, -15}, {0xc275, -30},
+    {0x59c3, -110}, {0x50e5, -40}, {0x50f8, -50}, {0xc251, -30}, {0xe8fd, -20},
+    {0xe579, -30}, {0x592c, -140}, {0x5155, -10}, {0x44c3, -40}, {0xf6ff, -30},
+    {0xf1f9, -10}, {0xf1fd, -15}, {0x65ff, -20}, {0x546f, -120}, {0xf62c, -40},
+    {0x54c4, -120}, {0xfde4, -20}, {0xc0d6, -30}, {0xc575, -30}, {0x52d5, -20},
+    {0xf89e, -55}, {0xd2c0, -20}, {0xdb2c, -40}, {0xf874, -55}, {0x59e3, -140},
+    {0xc051, -30}, {0x2056, -50}, {0x57f5, -30}, {0x422c, -20}, {0x9191, -57},
+    {0x54e3, -60}, {0xddfc, -110}, {0x76e9, -25}, {0x41c7, -30}, {0x52d3, -20},
+    {0x4177, -40}, {0xa057, -40}, {0xfff8, -20}, {0x796f, -20}, {0x50e8, -50},
+    {0x4c92, -160}, {0xda2c, -40}, {0x4ac3, -20}, {0x9fe0, -140},
+    {0x596f, -140}, {0xc1fd, -40}, {0xf576, -15}, {0xd3dd, -70}, {0x4143, -30},
+    {0xd32c, -40}, {0xf8ee, -55}, {0x46c2, -80}, {0xdd2c, -140},
+    {0x9fad, -140}, {0x52d8, -20}, {0x929a, -50}, {0xd9c1, -40}, {0xc5d6, -30},
+    {0xc354, -120}, {0x50c1, -120}, {0xc3da, -50}, {0x46f8, -30},
+    {0x66e5, -30}, {0xc5d4, -30}, {0x46f5, -30}, {0x41f9, -30}, {0x54d5, -40},
+    {0xea2c, -15}, {0x59e4, -140}, {0x54fc, -120}, {0x6e75, -10},
+    {0xddf8, -140}, {0x72ee, 15}, {0x572d, -40}, {0xc0fd, -40}, {0x9292, -57},
+    {0xc3f9, -30}, {0xc39f, -100}, {0x563a, -40}, {0xddc1, -110},
+    {0xc557, -50}, {0xd92c, -40}, {0x54e2, -120}, {0xd2c4, -20}, {0x4fc2, -20},
+    {0xc3db, -50}, {0x4fc5, -20}, {0x56f3, -80}, {0x652e, -15}, {0xfde5, -20},
+    {0x726c, 15}, {0xd6c3, -20}, {0xc4db, -50}, {0x54ad, -140}, {0xeb2e, -15},
+    {0xe077, -20}, {0xd657, -30}, {0x4151, -30}, {0xff61, -20}, {0x766f, -25},
+    {0x6576, -30}, {0x4a41, -20}, {0x9ffb, -110}, {0xf1fa, -10}, {0xe577, -20},
+    {0x4af9, -20}, {0xc5dc, -50}, {0x56fa, -70}, {0x552e, -40}, {0xfde3, -20},
+    {0xd29f, -70}, {0xc551, -30}, {0x9fc1, -110}, {0xc0db, -50}, {0x4afb, -20},
+    {0xc3ff, -40}, {0xfd2c, -100}, {0xd4c1, -20}, {0xc357, -50}, {0x59d6, -85},
+    {0xe76b, -20}, {0xf8ed, -55}, {0xdde3, -70}, {0x61ff, -30}, {0x564f, -40},
+    {0x6661, -30}, {0x77ea, -10}, {0x7665, -25}, {0x54c2, -120}, {0xc4d8, -30},
+    {0x59fa, -110}, {0x4ae3, -20}, {0xc056, -70}, {0x46ea, -30}, {0x62fc, -20},
+    {0x4bfb, -30}, {0x57f2, -30}, {0x44c1, -40}, {0x4bd8, -50}, {0xc0d8, -30},
+    {0x4b79, -50}, {0xf677, -15}, {0xd841, -20}, {0xf2ff, -30}, {0xd9c3, -40},
+    {0x57ff, -20}, {0x9ff4, -140}, {0xc147, -30}, {0x6279, -20}, {0xc3fc, -30},
+    {0xf863, -55}, {0xe476, -20}, {0xda2e, -40}, {0x9fd4, -85}, {0xd52e, -40},
+    {0x9ff8, -140}, {0xdd75, -110}, {0xe4fd, -30}, {0x4bd2, -50},
+    {0x56d3, -40}, {0x41da, -50}, {0x78ea, -30}, {0xc3d3, -30}, {0x59e9, -140},
+    {0xdde8, -140}, {0xd457, -30}, {0xd3c0, -20}, {0x432e, -30}, {0x6dfb, -10},
+    {0x51dc, -10}, {0x7377, -30}, {0xd22c, -40}, {0x57fa, -30}, {0x4bd4, -50},
+    {0x41d6, -30}, {0xd354, -40}, {0xc2fa, -30}, {0xc043, -30}, {0x4ac2, -20},
+    {0x41dc, -50}, {0x5257, -30}, {0xd6c2, -20}, {0xf861, -55}, {0xc1d8, -30},
+    {0x563b, -40}, {0x9fe4, -140}, {0x2093, -30}, {0x5775, -30}, {0xf5fd, -30},
+    {0xdd65, -140}, {0xc447, -30}, {0x50eb, -50}, {0x56e3, -70},
+    {0x4c9f, -140}, {0x2e92, -100}, {0x54e9, -120}, {0x72e5, -10},
+    {0x59c2, -110}, {0xf8e8, -55}, {0x50c2, -120}, {0xddfa, -110},
+    {0xa09f, -90}, {0x2091, -60}, {0x4c59, -140}, {0xd541, -20}, {0x56f4, -80},
+    {0x46f3, -30}, {0xf1fc, -10}, {0x4bd6, -50}, {0xc5d9, -50}, {0xd32e, -40},
+    {0x54eb, -120}, {0x2e94, -100}, {0x57d8, -20}, {0x79ea, -20},
+    {0x593b, -60}, {0x57e9, -30}, {0x594f, -85}, {0xc2ff, -40}, {0xe9ff, -20},
+    {0x79f5, -20}, {0x76f5, -25}, {0xd8c2, -20}, {0x792e, -100}, {0x76e4, -25},
+    {0xc1d5, -30}, {0x59e8, -140}, {0x76e0, -25}, {0xc243, -30}, {0x543b, -20},
+    {0x422e, -20}, {0x6772, -10}, {0x9fd2, -85}, {0xfdf4, -20}, {0xddd8, -85},
+    {0x68fd, -30}, {0x562d, -80}, {0xfff4, -20}, {0xd257, -30}, {0x59e2, -140},
+    {0xc4fa, -30}, {0xd5c2, -20}, {0x56d6, -40}, {0x622c, -40}, {0xd641, -20},
+    {0x56d2, -40}, {0x61fd, -30}, {0x54ea, -120}, {0x54fa, -120},
+    {0x544f, -40}, {0x4fc0, -20}, {0x6bf8, -20}, {0x6df9, -10}, {0xea77, -20},
+    {0xc4dd, -100}, {0x51d9, -10}, {0xc1d3, -30}, {0x723a, 30}, {0x46c3, -80},
+    {0xd357, -30}, {0x6179, -30}, {0x56f9, -70}, {0x46f6, -30}, {0x4fc3, -20},
+    {0xebfd, -20}, {0x7a6f, -15}, {0x57d2, -20}, {0x51da, -10}, {0x41d2, -30},
+    {0x4b6f, -40}, {0x4456, -70}, {0x4154, -120}, {0xc49f, -100},
+    {0xc151, -30}, {0x54d8, -40}, {0x9264, -50}, {0xd554, -40}, {0x72ef, 15},
+    {0xd941, -40}, {0xf89a, -55}, {0xe5fd, -30}, {0x5969, -20}, {0x56e1, -70},
+    {0xf476, -15}, {0xc29f, -100}, {0x4a2e, -30}, {0xe9fd, -20}, {0xd259, -70},
+    {0xf32e, -40}, {0x77f3, -10}, {0xd62e, -40}, {0x76f6, -25}, {0x54f6, -120},
+    {0xf8ec, -55}, {0xdcc5, -40}, {0x762e, -80}, {0xc1ff, -40}, {0x72fc, 15},
+    {0x66f3, -30}, {0xd654, -40}, {0xd856, -50}, {0xf877, -70}, {0xc44f, -30},
+    {0x66e1, -30}, {0xc2dd, -100}, {0x4fc1, -20}, {0x46e9, -30}, {0xd42c, -40},
+    {0xc1dd, -100}, {0x59d8, -85}, {0xd557, -30}, {0x50f2, -50}, {0xc075, -30},
+    {0x9fe2, -140}, {0xc3d6, -30}, {0xc4d2, -30}, {0xfdf6, -20}, {0x9f3a, -60},
+    {0x9ff3, -140}, {0xeb78, -30}, {0xf8e4, -55}, {0xea78, -30}, {0xc556, -70},
+    {0x54d6, -40}, {0x9fd5, -85}, {0x51db, -10}, {0x76eb, -25}, {0x41fb, -30},
+    {0x2c94, -100}, {0x54e4, -120}, {0xc4d6, -30}, {0x76f4, -25},
+    {0x46e3, -50}, {0x7079, -30}, {0x4175, -30}, {0x9fc0, -110}, {0x77e1, -15},
+    {0xc1db, -50}, {0x6694, 60}, {0x726d, 25}, {0xf865, -55}, {0x6f78, -30},
+    {0x5941, -110}, {0x572e, -80}, {0x6b6f, -20}, {0x42d9, -10}, {0xddd5, -85},
+    {0x70ff, -30}, {0xd9c4, -40}, {0x6177, -20}, {0x79e5, -20}, {0x52d2, -20},
+    {0x6879, -30}, {0xc09f, -100}, {0x79e1, -20}, {0xe2fd, -30}, {0xc2c7, -30},
+    {0xc1da, -50}, {0x9420, -40}, {0x79f3, -20}, {0x4ac1, -20}, {0x462c, -150},
+    {0x46e4, -50}, {0xf871, -55}, {0x726b, 15}, {0x4bfa, -30}, {0xffe2, -20},
+    {0x46e0, -50}, {0x6be9, -20}, {0x9a2c, -15}, {0x59d4, -85}, {0x44c0, -40},
+    {0x59d2, -85}, {0x66e2, -30}, {0xc1d4, -30}, {0x4f56, -50}, {0xea2e, -15},
+    {0x572c, -80}, {0xe177, -20}, {0x502e, -180}, {0xd2c2, -20}, {0x5779, -20},
+    {0x59c0, -110}, {0xddd6, -85}, {0x9f6f, -140}, {0xddc5, -110},
+    {0xfff3, -20}, {0x4459, -90}, {0x55c1, -40}, {0x46e5, -50}, {0x6f2c, -40},
+    {0xc276, -40}, {0xe82e, -15}, {0xd89f, -70}, {0xc4d3, -30}, {0xf86d, -55},
+    {0x7961, -20}, {0x442c, -70}, {0xf8e5, -55}, {0x57c0, -50}, {0xc0dd, -100},
+    {0x46f2, -30}, {0x4ae1, -20}, {0xf3ff, -30}, {0x46e1, -50}, {0xc547, -30},
+    {0x9ff5, -140}, {0x55c2, -40}, {0xd4dd, -70}, {0x56d5, -40}, {0x42dc, -10},
+    {0x77f4, -10}, {0x57e8, -30}, {0xc475, -30}, {0x2059, -90}, {0xf8e2, -55},
+    {0x9a77, -30}, {0x79e0, -20}, {0x57d6, -20}, {0xc4fb, -30}, {0x9fc2, -110},
+    {0xf879, -70}, {0x6dff, -15}, {0x4bf6, -40}, {0x57fc, -30}, {0xc3d4, -30},
+    {0xf277, -15}, {0x7af3, -15}, {0x4157, -50}, {0x6bea, -20}, {0x4be9, -40},
+    {0x4c56, -110}, {0xd5c0, -20}, {0x9ff2, -140}, {0x55c4, -40},
+    {0x76e2, -25}, {0xc4ff, -40}, {0x6e76, -20}, {0xe979, -20}, {0xdd2e, -140},
+    {0xd859, -70}, {0x41d3, -30}, {0x50e1, -40}, {0x72ec, 15}, {0x4c79, -30},
+    {0xc254, -120}, {0x50c5, -120}, {0xf867, -55}, {0x57c1, -50},
+    {0x449f, -90}, {0x59f6, -140}, {0x7ae9, -15}, {0x5041, -120},
+    {0xe0ff, -30}, {0x4f41, -20}, {0xd39f, -70}, {0x4ac5, -20}, {0xf4ff, -30},
+    {0xc343, -30}, {0xdac1, -40}, {0xdb41, -40}, {0x9f65, -140}, {0xdb2e, -40},
+    {0xddf5, -140}, {0x552c, -40}, {0xf62e, -40}, {0xe2ff, -30}, {0x6efc, -10},
+    {0x62ff, -20}, {0x7aea, -15}, {0x54f9, -120}, {0x7269, 15}, {0xc5d2, -30},
+    {0xfdea, -20}, {0x4ac0, -20}, {0x4bfd, -50}, {0x5477, -120}, {0x56ea, -80},
+    {0x9ffa, -110}, {0xd4c4, -20}, {0xdac5, -40}, {0xc0f9, -30}, {0x4f9f, -70},
+    {0x59fc, -110}, {0x4c94, -140}, {0x56fc, -70}, {0xc5f9, -30},
+    {0xdbc2, -40}, {0xf8f1, -55}, {0xdd2d, -140}, {0xf8e7, -55}, {0xd3c4, -20},
+    {0xd4c5, -20}, {0xc2d2, -30}, {0x56f8, -80}, {0x62fa, -20}, {0x9272, -50},
+    {0x9ef8, -15}, {0x6f2e, -40}, {0x50e3, -40}, {0x7661, -25}, {0x5641, -80},
+    {0xdd69, -20}, {0xf579, -30}, {0x78e9, -30}, {0xc19f, -100}, {0x432c, -30},
+    {0x59e0, -140}, {0x62fd, -20}, {0xc2dc, -50}, {0x9fe5, -140},
+    {0xc2db, -50}, {0x50f5, -50}, {0xc454, -120}, {0xeb79, -20}, {0xd5c3, -20},
+    {0x55c0, -40}, {0x6f77, -15}, {0xc155, -50}, {0x6fff, -30}, {0x76e8, -25},
+    {0x59c1, -110}, {0xc14f, -30}, {0xc179, -40}, {0x66e0, -30}, {0xf8f3, -55},
+    {0x562c, -125}, {0xf279, -30}, {0xd82c, -40}, {0x56e9, -80}, {0x56c4, -80},
+    {0x5541, -40}, {0x592d, -140}, {0xe8ff, -20}, {0xd341, -20},
+    {0xc259, -100}, {0x57c4, -50}, {0x7af4, -15}, {0x574f, -20}, {0xc3fb, -30},
+    {0xc0dc, -50}, {0xc72c, -30}, {0x79e8, -20}, {0x4afa, -20}, {0x20dd, -90},
+    {0xffe8, -20}, {0x5661, -70}, {0x2054, -50}, {0xc5fd, -40}, {0xd459, -70},
+    {0xddad, -140}, {0x78e8, -30}, {0x56f5, -80}, {0xd8c4, -20}, {0xc2da, -50},
+    {0x6692, 50}, {0xc4d4, -30}, {0x4bf5, -40}, {0x56e4, -70}, {0xc34f, -30},
+    {0xdd4f, -85}, {0x5741, -50}, {0xdde9, -140}, {0xdde4, -140},
+    {0xf175, -10}, {0xd6c0, -20}, {0x59c5, -110}, {0xc5d8, -30}, {0xf577, -15},
+    {0x50e4, -40}, {0xf678, -30}, {0xdc2c, -40}, {0x7a65, -15}, {0x4c57, -70},
+    {0x76e1, -25}, {0x9ef6, -15}, {0xdc2e, -40}, {0x4b4f, -50}, {0xc4fd, -40},
+    {0x4441, -40}, {0xc059, -100}, {0xf378, -30}, {0x5259, -50}, {0x50f6, -50},
+    {0xf873, -55}, {0x4c54, -110}, {0xddd3, -85}, {0xdd41, -110},
+    {0xe82c, -15}, {0xc077, -40}, {0xa0dd, -90}, {0xc04f, -30}, {0xd659, -70},
+    {0xc457, -50}, {0xd3c3, -20}, {0xc175, -30}, {0x4b65, -40}, {0xc376, -40},
+    {0x52d6, -20}, {0xc0d9, -50}, {0x79f4, -20}, {0x72e1, -10}, {0x42db, -10},
+    {0xe379, -30}, {0xc2d8, -30}, {0xdd3a, -60}, {0x41fc, -30}, {0xd5c1, -20},
+    {0xc351, -30}, {0xfdf2, -20}, {0x66f4, -30}, {0xddf6, -140}, {0x6dfc, -10},
+    {0x57d4, -20}, {0x6f79, -30}, {0x57f8, -30}, {0xa054, -50}, {0x722e, -50},
+    {0xa093, -30}, {0x46f4, -30}, {0xc143, -30}, {0xc0fc, -30}, {0x50f4, -50},
+    {0x4ae2, -20}, {0x66f2, -30}, {0xf3fd, -30}, {0x4bf8, -40}, {0xf22c, -40},
+    {0x54f8, -120}, {0x7270, 30}, {0x6bf5, -20}, {0x4cdd, -140}, {0x4bf2, -40},
+    {0x7af8, -15}, {0xeb2c, -15}, {0x76f8, -25}, {0x77f6, -10}, {0xc154, -120},
+    {0x77e8, -10}, {0xd656, -50}, {0x6beb, -20}, {0x466f, -30}, {0xf875, -55},
+    {0x41d5, -30}, {0xd456, -50}, {0x6bf3, -20}, {0xa056, -50}, {0x50c3, -120},
+    {0x5647, -40}, {0xc1dc, -50}, {0xe179, -30}, {0x72e3, -10}, {0x9eea, -15},
+    {0xc0da, -50}, {0x56d4, -40}, {0x6276, -20}, {0x57f6, -30}, {0x6d75, -10},
+    {0x59ed, -20}, {0x4ae0, -20}, {0x9f4f, -85}, {0xffe3, -20}, {0xeafd, -20},
+    {0x5965, -140}, {0xc2d5, -30}, {0x72e0, -10}, {0x4155, -50}, {0x76f2, -25},
+    {0x59d3, -85}, {0x57f9, -30}, {0x65fd, -20}, {0x4bd5, -50}, {0x44c5, -40},
+    {0xdd61, -140}, {0x4f2e, -40}, {0xc54f, -30}, {0xc3dc, -50}, {0xd6dd, -70},
+    {0x9ef5, -15}, {0xf478, -30}, {0xc1fb, -30}, {0xddf4, -140}, {0x56e8, -80},
+    {0x41d8, -30}, {0xfff2, -20}, {0x4be8, -40}, {0xc4c7, -30}, {0xc1d9, -50},
+    {0xc5dd, -100}, {0xdbc0, -40}, {0x9f61, -140}, {0x626c, -20},
+    {0xc347, -30}, {0xd857, -30}, {0xc5d3, -30}, {0x9fc4, -110}, {0x56f6, -80},
+    {0xfd65, -20}, {0xe479, -30}, {0x59f4, -140}, {0xc0ff, -40}, {0x576f, -30},
+    {0x50e9, -50}, {0xd241, -20}, {0x79e2, -20}, {0xff6f, -20}, {0xdac4, -40},
+    {0x6e79, -15}, {0xffe1, -20}, {0xc555, -50}, {0x57d5, -20}, {0x4afc, -20},
+    {0x7af6, -15}, {0x77f2, -10}, {0x55c5, -40}, {0x66f8, -30}, {0xd6c4, -20},
+    {0xf868, -55}, {0x59d5, -85}, {0xd359, -70}, {0x59fb, -110}, {0x566f, -80},
+    {0x4ae4, -20}, {0xfde2, -20}, {0x3aa0, -50}, {0x59eb, -140},
+    {0x54f4, -120}, {0xeaff, -20}, {0x57e1, -40}, {0x72fb, 15}, {0x4672, -45},
+    {0x593a, -60}, {0x2ea0, -60}, {0x9ee9, -15}, {0xd5dd, -70}, {0x54e0, -120},
+    {0xdde2, -140}, {0x9f2c, -140}, {0xf864, -55}, {0x46c5, -80},
+    {0xf8ff, -70}, {0x6bf4, -20}, {0x54f2, -120}, {0x76e5, -25}, {0xdcc0, -40},
+    {0xfff5, -20}, {0x59f2, -140}, {0xd4c3, -20}, {0xe176, -20}, {0x66e4, -30},
+    {0xd92e, -40}, {0x772e, -60}, {0x4fc4, -20}, {0x4665, -30}, {0x41ff, -40},
+    {0xc543, -30}, {0x79e9, -20}, {0xc476, -40}, {0xdd3b, -60}, {0x529f, -50},
+    {0xdac0, -40}, {0xf8e3, -55}, {0xf86f, -55}, {0xe3ff, -30}, {0xd8c5, -20},
+    {0xf1fb, -10}, {0xc5d5, -30}, {0xdcc4, -40}, {0xddf9, -110}, {0xc579, -40},
+    {0x6dfd, -15}, {0x726e, 25}, {0xdbc3, -40}, {0x46e8, -30}, {0xdac2, -40},
+    {0x3a20, -50}, {0x72e2, -10}, {0xd8dd, -70}, {0x56e0, -70}, {0xddd2, -85},
+    {0xc3dd, -100}, {0x56ad, -80}, {0x44c2, -40}, {0x66f5, -30}, {0xd3c1, -20},
+    {0xc256, -70}, {0x7865, -30}, {0x54fd, -120}, {0x4a2c, -30}, {0xfdf5, -20},
+    {0x57e0, -40}, {0xf679, -30}, {0x9a2e, -15}, {0x59f9, -110}, {0xf676, -15},
+    {0x9fc5, -110}, {0x562e, -125}, {0x72ed, 15}, {0x70fd, -30}, {0xc2fb, -30},
+    {0x7275, 15}, {0xc3d8, -30}, {0xf870, -55}, {0xc456, -70}, {0xd5c4, -20},
+    {0xd62c, -40}, {0x56f2, -80}, {0xe3fd, -30}, {0xd5c5, -20}, {0x5441, -120},
+    {0xd69f, -70}, {0x9e65, -15}, {0x4641, -80}, {0xc079, -40}, {0xc1d6, -30},
+    {0x72f1, 25}, {0x57fd, -20}, {0x72e4, -10}, {0x9e6f, -15}, {0x6dfa, -10},
+    {0x5761, -40}, {0xdde1, -140}, {0xc4fc, -30}, {0xc1fa, -30}, {0xf8eb, -55},
+    {0xd2c5, -20}, {0xf869, -55}, {0xdded, -20}, {0xe1ff, -30}, {0x79f2, -20},
+    {0x3ba0, -50}, {0x506f, -50}, {0xd4c2, -20}, {0xd6c1, -20}, {0xd454, -40},
+    {0xc479, -40}, {0x79e3, -20}, {0x776f, -10}, {0x50ea, -50}, {0xe277, -20},
+    {0x4fdd, -70}, {0x9f41, -110}, {0xfd61, -20}, {0x9fd8, -85},
+    {0xddc0, -110}, {0x41d4, -30}, {0xe878, -30}, {0x722c, -50}, {0xe076, -20},
+    {0xf8f2, -55}, {0xf87a, -55}, {0x5065, -50}, {0x9f2e, -140}, {0xd256, -50},
+    {0x66e8, -30}, {0x68ff, -30}, {0xd2c1, -20}, {0x41dd, -100}, {0x6577, -20},
+    {0xc5fc, -30}, {0x4176, -40}, {0xf2fd, -30}, {0x56fb, -70}, {0xd8c1, -20},
+    {0x9f75, -110}, {0x46c4, -80}, {0xc5db, -50}, {0x54ff, -60}, {0x41fa, -30},
+    {0xe279, -30}, {0xd9c2, -40}, {0x9fed, -20}, {0x6efb, -10}, {0xc72e, -30},
+    {0x524f, -20}, {0xd82e, -40}, {0xc2fd, -40}, {0xdbc4, -40}, {0x662e, -30},
+    {0xd2c3, -20}, {0x76f3, -25}, {0x9ffc, -110}, {0x66eb, -30}, {0xd9c5, -40},
+    {0x6bf6, -20}, {0x6efd, -15}, {0x57e4, -40}, {0xc5c7, -30}, {0xd2dd, -70},
+    {0xf8f9, -55}, {0x6efa, -10}, {0x723b, 30}, {0x54c5, -120}, {0x462e, -150},
+    {0x6ffd, -30}, {0xc554, -120}, {0xe4ff, -30}, {0x542c, -120},
+    {0x2e20, -60}, {0xc3fa, -30}, {0x4bea, -40}, {0xc176, -40}, {0x59ea, -140},
+    {0x9fe3, -70}, {0x54d2, -40}, {0xf176, -20}, {0x56eb, -80}, {0xfff6, -20},
+    {0xebff, -20}, {0xf1ff, -15}, {0x72fa, 15}, {0xc257, -50}, {0xdbc5, -40},
+    {0xfde0, -20}, {0xc0d3, -30}, {0x414f, -30}, {0xf278, -30}, {0x92a0, -70},
+    {0x79eb, -20}, {0xc159, -100}, {0x54f3, -120}, {0x2c92, -100},
+    {0xe079, -30}, {0x4ac4, -20}, {0xc477, -40}, {0xc576, -40}, {0x6578, -30},
+    {0xc459, -100}, {0x4cff, -30}, {0xff2e, -100}, {0xc5fa, -30},
+    {0x6be8, -20}, {0x4beb, -40}, {0x652c, -15}, {0x622e, -40}, {0x4a61, -20},
+    {0x5765, -30}, {0x792c, -100}, {0x8a2e, -20}, {0x54c0, -120},
+    {0x6b65, -20}, {0xd59f, -70}, {0xf276, -15}, {0xeb77, -20}, {0x9eeb, -15},
+    {0xffe0, -20}, {0xddc2, -110}, {0x79e4, -20}, {0xd558, -60}, {0xc24f, -30},
+    {0xc277, -40}, {0x2057, -40}, {0xc057, -50}, {0x702c, -35}, {0xc1f9, -30},
+    {0xf8f6, -55}, {0x702e, -35}, {0x4255, -10}, {0x4f57, -30}, {0xf376, -15},
+    {0x7af2, -15}, {0x54e5, -120}, {0x3b20, -50}, {0xd9c0, -40}, {0xf8fd, -70},
+    {0xd4c0, -20}, {0x7965, -20}, {0xc0d4, -30}, {0x41db, -50}, {0xdbc1, -40},
+    {0xdc41, -40}, {0xc2fc, -30}, {0x9ef2, -15}, {0xddc4, -110}, {0xe1fd, -30},
+    {0xff2c, -100}, {0x7279, 30}, {0xd559, -70}, {0xf179, -15}, {0xffeb, -20},
+    {0x4bf3, -40}, {0xfdf8, -20}, {0x59ad, -140}, {0xf22e, -40}, {0xc157, -50},
+    {0xc3d9, -50}, {0x76e3, -25}, {0x5675, -70}, {0xf52c, -40}, {0xf8fc, -55},
+    {0xc5fb, -30}, {0xd441, -20}, {0xc375, -30}, {0x57e5, -40}, {0xc3d2, -30},
+    {0xe877, -20}, {0xd22e, -40}, {0xfde8, -20}, {0x8a2c, -20}, {0xd854, -40},
+    {0xfdeb, -20}, {0x9ff6, -140}, {0x4b75, -30}, {0xc451, -30}, {0xf32c, -40},
+    {0x9fc3, -110}, {0xc054, -120}, {0xc2d4, -30}, {0xf52e, -40},
+    {0x44dd, -90}, {0x772c, -60}, {0xc247, -30}, {0xc5ff, -40}, {0xc0d2, -30},
+    {0xc0d5, -30}, {0xf42c, -40}, {0xf872, -55}, {0x9f2d, -140}, {0xc055, -50},
+    {0xda41, -40}, {0x7aeb, -15}, {0x543a, -20}, {0x9220, -70}, {0xddea, -140},
+    {0x54d3, -40}, {0x79f8, -20}, {0x9fe9, -140}, {0xf86b, -55}, {0x77e5, -15},
+    {0x6275, -20}, {0xf8f8, -55}, {0xfdf3, -20}, {0x59f5, -140}, {0xe276, -20},
+    {0xc355, -50}, {0x77e0, -15}, {0xf42e, -40}, {0x46e2, -50}, {0x632c, -15},
+    {0xe876, -30}, {0x54fb, -120}, {0xc279, -40}, {0x732c, -15}, {0x77e2, -15},
+    {0xf8e1, -55}, {0xc1fc, -30}, {0x532c, -20}, {0x50f3, -50}, {0xf8f5, -55},
+    {0x57d3, -20}, {0x77f8, -10}, {0x7276, 30}, {0xddc3, -110}, {0xc1c7, -30},
+    {0xeb76, -30}, {0x732e, -15}, {0x56d8, -40}, {0x54e8, -60}, {0x4a75, -20},
+    {0xc4f9, -30}, {0xc156, -70}, {0x57fb, -30}, {0x5475, -120}, {0xf8ef, -55},
+    {0x442e, -70}, {0xf477, -15}, {0xff65, -20}, {0xdcc2, -40}, {0x5254, -30},
+    {0x59f3, -140}, {0xf82c, -95}, {0xdcc3, -40}, {0x52d9, -40}, {0x636b, -20},
+    {0x59f8, -140}, {0xc2f9, -30}, {0x46eb, -30}, {0x54f5, -60}, {0x57c5, -50},
+    {0xa091, -60}, {0xddd4, -85}, {0x77e4, -15}, {0x7ae8, -15}, {0x6579, -20},
+    {0xddf2, -140}, {0x66e9, -30}, {0xd3c2, -20}, {0xf862, -55}, {0x6f76, -15},
+    {0xddfb, -110}, {0x4f58, -60}, {0x57c2, -50}, {0xdcc1, -40}, {0x6eff, -15},
+    {0xd858, -60}, {0x5961, -140}, {0x56c3, -80}, {0x6176, -20},
+    {0x502c, -180}, {0x56c0, -80}, {0x56c2, -80}, {0x94a0, -40}, {0x9ef4, -15},
+    {0x46c1, -80}, {0xd52c, -40}, {0xd358, -60}, {0xdde5, -140}, {0xd8c3, -20},
+    {0xc443, -30}, {0xe377, -20}, {0x52d4, -20}, {0x44c4, -40}, {0xd658, -60},
+    {0x62fb, -20}, {0x54e1, -120}, {0x9ee8, -15}, {0xf8ea, -55}, {0x56e5, -70},
+    {0x52db, -40}, {0xd356, -50}, {0x4bfc, -30}, {0xc3d5, -30}, {0xffe9, -20},
+    {0xffe4, -20}, {0xf379, -30}, {0xc1d2, -30}, {0x56c5, -80}, {0xd556, -50},
+    {0x9ef3, -15}, {0x42da, -10}, {0x9fd3, -85}, {0xc4d5, -30}, {0x57f4, -30},
+    {0x5975, -110}, {0x77e9, -10}, {0x6ef9, -10}, {0xa059, -90}, {0xc0fb, -30},
+    {0x9fea, -140}, {0xd3c5, -20}, {0xc359, -100}, {0xe5ff, -30},
+    {0x4ae5, -20}, {0x9f69, -20}, {0xd49f, -70}, {0x55c3, -40}, {0xc4dc, -50},
+    {0xe72c, -15}, {0x5061, -40}, {0xd8c0, -20}, {0x50c4, -120}, {0xf8f4, -55},
+    {0xea76, -30}, {0x57ad, -40}, {0xdd6f, -140}, {0xf4fd, -30}, {0xd254, -40},
+    {0xe92c, -15}, {0xf5ff, -30}, {0x66e3, -30}, {0xf86c, -55}, {0xf479, -30},
+    {0x52dd, -50}, {0x4156, -70}, {0xc455, -50}, {0x41d9, -50}, {0x7765, -10},
+    {0x52da, -40}, {0xd6c5, -20}, {0x4bff, -50}, {0xf86e, -55}, {0xc4da, -50},
+    {0xe978, -30}, {0x9fd6, -85}, {0xf8e0, -55}, {0xc559, -100}, {0x5255, -40},
+    {0xc076, -40}, {0x57e2, -40}, {0x56e2, -70}, {0x6262, -10}, {0xc047, -30},
+    {0x72fd, 30}, {0x5479, -120}, {0x62f9, -20}, {0xc5da, -50}, {0x4bd3, -50},
+    {0x9f3b, -60}, {0x542e, -120}, {0xddf3, -140}, {0x59e1, -140},
+    {0x5461, -120}, {0x7274, 40}, {0xc2d9, -50}, {0x9fe1, -140}, {0xea79, -20},
+    {0xc0c7, -30}, {0xfd2e, -100}, {0xe0fd, -30}, {0x59e5, -140},
+    {0x52dc, -40}, {0xf82e, -95}, {0xf866, -55}, {0xe976, -30}, {0xc577, -40},
+    {0xe977, -20}, {0x56c1, -80}, {0x4661, -50}, {0x57eb, -30}, {0x419f, -100},
+    {0x7af5, -15}, {0x7261, -10}, {0x54d4, -40}, {0xc2d3, -30}, {0x77f5, -10},
+    {0xc377, -40}, {0x77e3, -15}, {0x4159, -100}, {0x41fd, -40}, {0xf6fd, -30},
+    {0xddeb, -140}, {0x4f59, -70}, {0xd458, -60}, {0x79f6, -20}, {0x66f6, -30},
+    {0x66ea, -30}, {0x662c, -30}, {0x46c0, -80}, {0x4147, -30}, {0xffea, -20},
+    {0xdac3, -40}, {0x209f, -90}, {0xc0fa, -30}, {0x57ea, -30}, {0xd258, -60},
+    {0x57f3, -30}, {0x5472, -120}, {0x6d79, -15}, {0xfde1, -20},
+    {0x5465, -120}, {0xd42e, -40}, {0x4f54, -40}, {0x72f9, 15}, {0xf876, -70},
+    {0xe92e, -15}, {0x9ff9, -110}, {0x78eb, -30}, {0xe477, -20}, {0xf8fa, -55},
+    {0x72ff, 30}, {0x4bf9, -30}, {0x9feb, -140}, {0xc2d6, -30}, {0xfde9, -20},
 };
 
-static const uint16_t times_italic_widths[256] = {
-    252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252,  252, 252,
-    252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252, 252,  252, 252,
-    252, 252, 252, 252, 252, 335, 423, 504, 504, 839, 784, 215,  335, 335,
-    504, 680, 252, 335, 252, 280, 504, 504, 504, 504, 504, 504,  504, 504,
-    504, 504, 335, 335, 680, 680, 680, 504, 927, 615, 615, 672,  727, 615,
-    615, 727, 727, 335, 447, 672, 560, 839, 672, 727, 615, 727,  615, 504,
-    560, 727, 615, 839, 615, 560, 560, 392, 280, 392, 425, 504,  335, 504,
-    504, 447, 504, 447, 280, 504, 504, 280, 280, 447, 280, 727,  504, 504,
-    504, 504, 392, 392, 280, 504, 447, 672, 447, 447, 392, 403,  277, 403,
-    545, 352, 504, 352, 335, 504, 560, 896, 504, 504, 335, 1008, 504, 335,
-    951, 352, 560, 352, 352, 335, 335, 560, 560, 352, 504, 896,  335, 987,
-    392, 335, 672, 352, 392, 560, 252, 392, 504, 504, 504, 504,  277, 504,
-    335, 766, 278, 504, 680, 335, 766, 335, 403, 680, 302, 302,  335, 504,
-    527, 252, 335, 302, 312, 504, 756, 756, 756, 504, 615, 615,  615, 615,
-    615, 615, 896, 672, 615, 615, 615, 615, 335, 335, 335, 335,  727, 672,
-    727, 727, 727, 727, 727, 680, 727, 727, 727, 727, 727, 560,  615, 504,
-    504, 504, 504, 504, 504, 504, 672, 447, 447, 447, 447, 447,  280, 280,
-    280, 280, 504, 504, 504, 504, 504, 504, 504, 680, 504, 504,  504, 504,
-    504, 447, 504, 447,
+static const struct kern_table helvetica_kerns = {
+    helvetica_kern_seeds,
+    helvetica_kern_pairs,
+    512,
+    1302,
+    {0x00, 0x00, 0x00, 0x00, 0x01, 0x50, 0x00, 0x0c, 0x5e, 0x9c, 0xff,
+     0x02, 0xee, 0xe9, 0xcd, 0x07, 0x00, 0x04, 0x16, 0xc4, 0x01, 0x00,
+     0x00, 0x00, 0xbf, 0x00, 0x7c, 0x3f, 0xbf, 0x0f, 0x7e, 0xa1},
 };
 
-static const uint16_t zapfdingbats_widths[256] = {
-    0,   0,   0,   0,   0,    0,   0,   0,   0,   0,   0,   0,   0,   0,
-    0,   0,   0,   0,   0,    0,   0,   0,   0,   0,   0,   0,   0,   0,
-    0,   0,   0,   0,   280,  981, 968, 981, 987, 724, 795, 796, 797, 695,
-    967, 946, 553, 861, 918,  940, 918, 952, 981, 761, 852, 768, 767, 575,
-    682, 769, 766, 765, 760,  497, 556, 541, 581, 697, 792, 794, 794, 796,
-    799, 800, 822, 829, 795,  847, 829, 839, 822, 837, 930, 749, 728, 754,
-    796, 798, 700, 782, 774,  798, 765, 712, 713, 687, 706, 832, 821, 795,
-    795, 712, 692, 701, 694,  792, 793, 718, 797, 791, 797, 879, 767, 768,
-    768, 765, 765, 899, 899,  794, 790, 441, 139, 279, 418, 395, 395, 673,
-    673, 0,   393, 393, 319,  319, 278, 278, 513, 513, 413, 413, 235, 235,
-    336, 336, 0,   0,   0,    0,   0,   0,   0,   0,   0,   0,   0,   0,
-    0,   0,   0,   0,   0,    0,   0,   737, 548, 548, 917, 672, 766, 766,
-    782, 599, 699, 631, 794,  794, 794, 794, 794, 794, 794, 794, 794, 794,
-    794, 794, 794, 794, 794,  794, 794, 794, 794, 794, 794, 794, 794, 794,
-    794, 794, 794, 794, 794,  794, 794, 794, 794, 794, 794, 794, 794, 794,
-    794, 794, 901, 844, 1024, 461, 753, 931, 753, 925, 934, 935, 935, 840,
-    879, 834, 931, 931, 924,  937, 938, 466, 890, 842, 842, 873, 873, 701,
-    701, 880, 0,   880, 766,  953, 777, 871, 777, 895, 974, 895, 837, 879,
-    934, 977, 925, 0,
+static const uint16_t helvetica_bold_kern_seeds[512] = {
+    1, 2, 2, 2, 3, 2, 10, 26, 3, 10, 1, 23, 2, 7, 2, 4, 1, 2, 5, 2, 4, 14, 4,
+    4, 46, 3, 1, 6, 2, 1, 18, 1, 5, 6, 8, 12, 0, 5, 1, 15, 8, 6, 3, 1, 2, 4, 2,
+    7, 34, 17, 3, 15, 29, 0, 9, 0, 1, 5, 8, 5, 2, 1, 4, 42, 5, 23, 2, 24, 17,
+    12, 10, 4, 12, 2, 2, 24, 0, 2, 1, 5, 4, 16, 3, 5, 2, 6, 13, 10, 6, 4, 43,
+    1, 2, 3, 11, 6, 3, 2, 21, 6, 4, 21, 1, 16, 1, 0, 6, 10, 4, 1, 4, 0, 4, 1,
+    13, 5, 17, 1, 1, 10, 23, 10, 11, 2, 2, 2, 35, 1, 5, 21, 4, 5, 30, 1, 15,
+    10, 11, 5, 1, 16, 10, 3, 29, 0, 0, 0, 1, 15, 9, 3, 4, 2, 0, 12, 1, 4, 6,
+    45, 3, 19, 13, 32, 14, 30, 18, 3, 17, 25, 32, 16, 2, 2, 1, 9, 3, 6, 1, 0,
+    2, 0, 3, 3, 13, 25, 14, 9, 9, 0, 3, 2, 13, 0, 1, 14, 0, 18, 18, 5, 1, 1, 7,
+    5, 0, 1, 4, 7, 2, 15, 7, 1, 29, 0, 2, 70, 28, 8, 7, 1, 0, 1, 2, 1, 35, 34,
+    21, 49, 12, 0, 28, 3, 8, 19, 3, 1, 5, 1, 12, 8, 8, 1, 6, 1, 2, 18, 20, 1,
+    12, 31, 0, 0, 22, 3, 80, 0, 23, 26, 16, 4, 10, 4, 3, 10, 1, 9, 40, 3, 1,
+    14, 0, 49, 2, 0, 9, 3, 57, 2, 2, 26, 11, 11, 43, 3, 17, 0, 9, 3, 8, 5, 3,
+    1, 0, 0, 27, 18, 46, 4, 113, 1, 4, 0, 31, 10, 0, 7, 12, 46, 1, 0, 8, 2, 57,
+    33, 17, 37, 6, 0, 24, 30, 3, 52, 0, 27, 12, 48, 10, 0, 40, 35, 0, 29, 24,
+    10, 2, 30, 9, 12, 7, 5, 15, 4, 7, 0, 8, 17, 28, 22, 6, 0, 22, 50, 1, 1, 7,
+    149, 14, 71, 5, 72, 4, 10, 3, 15, 2, 2, 4, 18, 0, 1, 22, 7, 3, 20, 25, 2,
+    6, 23, 1, 0, 4, 32, 69, 1, 16, 23, 0, 6, 1, 3, 7, 0, 6, 110, 81, 4, 46, 2,
+    1, 9, 24, 10, 1, 1, 32, 11, 12, 54, 46, 64, 93, 6, 0, 3, 8, 1, 130, 5, 6,
+    1, 43, 32, 25, 34, 0, 74, 35, 13, 21, 29, 12, 204, 14, 7, 24, 35, 0, 11,
+    19, 18, 4, 121, 99, 74, 153, 3, 0, 0, 5, 17, 2, 0, 4, 111, 103, 1, 7, 43,
+    4, 115, 0, 5, 46, 6, 2, 129, 2, 28, 1, 85, 373, 17, 125, 129, 226, 31, 130,
+    88, 5, 29, 9, 688, 46, 3, 1177, 12, 16, 20, 181, 46, 19, 12, 0, 3, 0, 53,
+    6, 51, 750, 175, 9, 391, 44, 1, 0, 53, 35, 81, 7, 1, 29, 449, 5, 2,
+};
+
+static const struct kern_pair helvetica_bold_kern_pairs[1180] = {
+    {0x54f8, -80}, {0xc1dc, -50}, {0xfd6f, -25}, {0x6279, -20}, {0x666f, -20},
+    {0xc177, -30}, {0x6e79, -20}, {0x79eb, -10}, {0x59e5, -90}, {0x62f9, -20},
+    {0x542d, -120}, {0x5465, -60}, {0x46e5, -20}, {0x4cfd, -30}, {0xd2c0, -50},
+    {0x56c4, -80}, {0x42c5, -30}, {0x50e0, -30}, {0xe377, -15}, {0xd6c4, -50},
+    {0x4157, -60}, {0xe579, -20}, {0xe4ff, -20}, {0xc077, -30}, {0xddd8, -70},
+    {0x6bf2, -15}, {0x44c2, -40}, {0x4f2c, -40}, {0xe76c, -20}, {0xd5c3, -50},
+    {0xc379, -30}, {0xc4d4, -40}, {0x9eea, 10}, {0xf878, -30}, {0x59c4, -110},
+    {0x4ac5, -20}, {0xc4d9, -50}, {0x79e1, -30}, {0xc251, -40}, {0x722d, -20},
+    {0x5256, -50}, {0xe9fd, -15}, {0xc5d6, -40}, {0xc3db, -50}, {0x6c77, -15},
+    {0x4179, -30}, {0x57d6, -20}, {0xddc4, -110}, {0x70ff, -15}, {0x593a, -50},
+    {0x5155, -10}, {0xc0fd, -30}, {0x6d79, -30}, {0xd556, -50}, {0xf1fd, -20},
+    {0xd456, -50}, {0xc2c7, -40}, {0x54c4, -90}, {0x68ff, -20}, {0xc575, -30},
+    {0x52d5, -20}, {0xfff5, -25}, {0x4afb, -20}, {0x59fa, -100}, {0xc547, -50},
+    {0xa056, -80}, {0xe8ff, -15}, {0x636c, -20}, {0x4ac3, -20}, {0x7aea, 10},
+    {0x2c20, -40}, {0xc1d5, -40}, {0x57c3, -60}, {0x5061, -30}, {0x41fb, -30},
+    {0xc147, -50}, {0xd6c1, -50}, {0x9f65, -80}, {0x5941, -110}, {0x9fd6, -70},
+    {0x57ea, -35}, {0x41d2, -40}, {0xfde4, -30}, {0x57e0, -40}, {0xf179, -20},
+    {0xf576, -20}, {0xd3dd, -70}, {0x62fd, -20}, {0xd5c4, -50}, {0x4177, -30},
+    {0x506f, -40}, {0xe779, -10}, {0x55c5, -50}, {0x56fb, -60}, {0xd9c1, -50},
+    {0x78eb, -10}, {0xc354, -90}, {0x50c1, -100}, {0xc04f, -40}, {0xe079, -20},
+    {0x9f61, -90}, {0x61fd, -20}, {0x41f9, -30}, {0xd22c, -40}, {0xea2c, 10},
+    {0x41d4, -40}, {0x59e9, -80}, {0xc24f, -40}, {0xfdeb, -10}, {0x59fb, -100},
+    {0x66f6, -20}, {0xfde0, -30}, {0xff61, -30}, {0x573b, -10}, {0x66f4, -20},
+    {0x56e5, -60}, {0x46c1, -80}, {0xd92c, -30}, {0xc2d2, -40}, {0x79e4, -30},
+    {0xd5c5, -50}, {0x2ea0, -40}, {0x51da, -10}, {0x4ac0, -20}, {0xc0c7, -40},
+    {0xd241, -50}, {0x50f8, -40}, {0xc2f9, -30}, {0x54ad, -120}, {0xeb2e, 20},
+    {0x57e4, -40}, {0x54f5, -80}, {0x9ff6, -100}, {0x9f3a, -50}, {0x6576, -15},
+    {0xf1fa, -10}, {0xe476, -15}, {0xc0d2, -40}, {0xfde5, -30}, {0xc5f9, -30},
+    {0xc5dc, -50}, {0x56fa, -60}, {0xfde3, -30}, {0x79f3, -25}, {0xd941, -50},
+    {0x9ee8, 10}, {0xffeb, -10}, {0x54fd, -60}, {0x573a, -10}, {0xc2dd, -110},
+    {0x4fc3, -50}, {0xd559, -70}, {0xea78, -15}, {0xdde0, -90}, {0x50e4, -30},
+    {0xf377, -15}, {0xd656, -50}, {0x6ffd, -20}, {0x51dc, -10}, {0x9ffa, -100},
+    {0x77f3, -20}, {0xc047, -50}, {0xf2fd, -20}, {0x7377, -15}, {0xc0d4, -40},
+    {0xdb2e, -30}, {0x57f2, -60}, {0xd459, -70}, {0x6df9, -20}, {0x57c1, -60},
+    {0x56d6, -50}, {0x72f5, -20}, {0x7079, -15}, {0x50e5, -30}, {0x593b, -50},
+    {0x57ff, -20}, {0x9ff4, -100}, {0xc2fc, -30}, {0xfde1, -30}, {0x4459, -70},
+    {0x9276, -20}, {0x4f57, -50}, {0x9fd4, -70}, {0x9fea, -80}, {0xd3c4, -50},
+    {0xdd75, -100}, {0x4bd2, -30}, {0xf3ff, -20}, {0x56f2, -90}, {0x9fe8, -80},
+    {0x51d9, -10}, {0xc5ff, -30}, {0xc155, -50}, {0xc557, -60}, {0xe279, -20},
+    {0x9ffc, -100}, {0x59f2, -100}, {0xc2fb, -30}, {0xd3c0, -50},
+    {0x6879, -20}, {0x57fa, -45}, {0x52dd, -50}, {0x5675, -60}, {0x78e9, -10},
+    {0xc043, -40}, {0x662c, -10}, {0x57d3, -20}, {0xc256, -80}, {0xdc2e, -30},
+    {0xc1d8, -40}, {0x9fc2, -110}, {0xd856, -50}, {0xddeb, -80}, {0xf478, -30},
+    {0x66f8, -20}, {0xfdf5, -25}, {0x76f8, -30}, {0x6f79, -20}, {0x59f3, -100},
+    {0x76e5, -20}, {0x55c4, -50}, {0xd89f, -70}, {0x54fc, -90}, {0xdd41, -110},
+    {0x54f4, -80}, {0xddfc, -100}, {0x7276, 10}, {0x70fd, -15}, {0xd541, -50},
+    {0xc0d8, -40}, {0xe467, -10}, {0xdde4, -90}, {0x6dfd, -30}, {0x56f5, -90},
+    {0x56f3, -90}, {0xe976, -15}, {0x57d8, -20}, {0x79ea, -10}, {0x9fd3, -70},
+    {0x57e9, -35}, {0xddc3, -110}, {0xdde5, -90}, {0xe9ff, -15}, {0x544f, -40},
+    {0x79e2, -30}, {0x56e8, -50}, {0x59e0, -90}, {0x2e92, -120}, {0xd92e, -30},
+    {0x4fc1, -50}, {0xdd3a, -50}, {0x543b, -40}, {0xf2ff, -20}, {0xe076, -15},
+    {0xc579, -30}, {0xc0d6, -40}, {0xf877, -15}, {0x68fd, -20}, {0xf278, -30},
+    {0x59d5, -70}, {0xd254, -40}, {0x6464, -10}, {0x72ad, -20}, {0xddf8, -100},
+    {0xd641, -50}, {0x592e, -100}, {0x56d2, -50}, {0x54ea, -60}, {0x50e2, -30},
+    {0x563b, -40}, {0xc39f, -110}, {0x9f41, -110}, {0xd258, -50},
+    {0xc5dd, -110}, {0xc3fc, -30}, {0xc059, -110}, {0x59c5, -110},
+    {0x4bd3, -30}, {0xc159, -110}, {0xd841, -50}, {0xfde9, -10}, {0x6276, -20},
+    {0xebfd, -15}, {0xd8c5, -50}, {0x5479, -60}, {0xc0fb, -30}, {0x796f, -25},
+    {0x502c, -120}, {0x4456, -40}, {0x4154, -90}, {0xc49f, -110},
+    {0xc151, -40}, {0x54d8, -40}, {0x59f4, -100}, {0x772c, -40}, {0x6275, -20},
+    {0x54f6, -80}, {0xc4d8, -40}, {0xfd61, -30}, {0xd8c2, -50}, {0xc3fb, -30},
+    {0x2091, -60}, {0x59fc, -100}, {0xda41, -50}, {0xdac3, -50}, {0x41fa, -30},
+    {0xe167, -10}, {0xe576, -15}, {0x76f6, -30}, {0xdcc5, -50}, {0x4bfd, -40},
+    {0x762e, -80}, {0xda2e, -30}, {0x9f4f, -70}, {0x50c2, -100}, {0xf477, -15},
+    {0x52d8, -20}, {0x56c3, -80}, {0x5665, -50}, {0x5961, -90}, {0xea79, -15},
+    {0x57f8, -60}, {0xc3d6, -40}, {0xd341, -50}, {0xd557, -50}, {0x442c, -30},
+    {0xd659, -70}, {0x76e1, -20}, {0xc051, -40}, {0xc2d5, -40}, {0xfdf6, -25},
+    {0xf1fb, -10}, {0xeb78, -15}, {0xc0db, -50}, {0xdcc2, -50}, {0x9fe2, -90},
+    {0x54d6, -40}, {0xe8fd, -15}, {0x6c79, -15}, {0x792e, -80}, {0xe978, -15},
+    {0x65fd, -15}, {0x57d4, -20}, {0xc1d3, -40}, {0x46e3, -20}, {0xddd3, -70},
+    {0xd3c2, -50}, {0x41da, -50}, {0xfdea, -10}, {0xd4c2, -50}, {0x59e3, -90},
+    {0x62ff, -20}, {0x6665, -10}, {0xddf3, -100}, {0x572e, -80}, {0xe82c, 10},
+    {0xdbc2, -50}, {0x9fd8, -70}, {0x4c59, -120}, {0xe768, -10}, {0xd654, -40},
+    {0xc2d4, -40}, {0x52d2, -20}, {0xd5c0, -50}, {0x67e9, 10}, {0xc2da, -50},
+    {0xe179, -20}, {0xd2c4, -50}, {0x9420, -80}, {0xdac1, -50}, {0x72f4, -20},
+    {0xc3d4, -40}, {0xe367, -10}, {0xd256, -50}, {0xd9c4, -50}, {0x76e2, -20},
+    {0xc254, -90}, {0xe376, -15}, {0x5975, -100}, {0xdc2c, -30}, {0xc0f9, -30},
+    {0x6bf5, -15}, {0x42d9, -10}, {0xddd4, -70}, {0xddc1, -110}, {0x56ad, -80},
+    {0x5661, -60}, {0x6167, -10}, {0xddd6, -70}, {0x72f3, -20}, {0x59c0, -110},
+    {0xc276, -40}, {0x78ea, -10}, {0x766f, -30}, {0xffe9, -10}, {0x55c1, -50},
+    {0x54fa, -90}, {0xc5d8, -40}, {0x9fe5, -90}, {0x79e5, -30}, {0xe067, -10},
+    {0xd32e, -40}, {0x7961, -30}, {0xc4db, -50}, {0x59c1, -110}, {0x57c0, -60},
+    {0x44dd, -70}, {0xc376, -40}, {0xc179, -30}, {0x6f77, -15}, {0xd32c, -40},
+    {0xddd5, -70}, {0xc3da, -50}, {0x41c7, -40}, {0x9eeb, 10}, {0x42dc, -10},
+    {0xd854, -40}, {0x4cdd, -120}, {0xa093, -80}, {0xc0d9, -50}, {0xebff, -15},
+    {0x79e0, -30}, {0x563a, -40}, {0x59ea, -80}, {0xc454, -90}, {0xf376, -20},
+    {0xc4d2, -40}, {0xea76, -15}, {0x79f6, -25}, {0x4beb, -15}, {0x59c2, -110},
+    {0x636b, -20}, {0x50eb, -30}, {0xd2c2, -50}, {0x652e, 20}, {0x41fd, -30},
+    {0x4fc5, -50}, {0x2059, -120}, {0x2ca0, -40}, {0xc4ff, -30}, {0x9fe0, -90},
+    {0xff2c, -80}, {0x552e, -30}, {0x41d3, -40}, {0x54ff, -60}, {0x42c1, -30},
+    {0xd259, -70}, {0x5647, -50}, {0xdb2c, -30}, {0xe5fd, -20}, {0xe7ff, -10},
+    {0x41d6, -40}, {0x7ae9, 10}, {0x6cfd, -15}, {0xfdf8, -25}, {0x72f6, -20},
+    {0xc5fc, -30}, {0xdbc3, -50}, {0xf4ff, -20}, {0x6bf4, -15}, {0x56e1, -60},
+    {0x729a, -15}, {0x54e9, -60}, {0xc4d5, -40}, {0x56f6, -90}, {0xe2ff, -20},
+    {0xd257, -50}, {0xd8c3, -50}, {0x66eb, -10}, {0x54f9, -90}, {0xc4fd, -30},
+    {0xc5d2, -40}, {0xf578, -30}, {0x5541, -50}, {0xc2fa, -30}, {0xd69f, -70},
+    {0x9264, -80}, {0xf5fd, -20}, {0xddea, -80}, {0x7a65, 10}, {0x46c5, -80},
+    {0x4f9f, -70}, {0xc0dd, -110}, {0x6f78, -30}, {0x4f56, -50}, {0xf279, -20},
+    {0x63fd, -10}, {0x9fe3, -90}, {0xe76b, -20}, {0x6dfa, -20}, {0x9ff2, -100},
+    {0xc1db, -50}, {0xd441, -50}, {0x59e2, -90}, {0x2e20, -40}, {0x57f5, -60},
+    {0x50e3, -30}, {0x7661, -20}, {0xea2e, 20}, {0xdd2c, -100}, {0x56fc, -60},
+    {0xc19f, -110}, {0x529f, -50}, {0x4c94, -140}, {0x56c5, -80},
+    {0x4b79, -40}, {0x9220, -80}, {0xc356, -80}, {0x77f4, -20}, {0x626c, -10},
+    {0xa0dd, -120}, {0x55c0, -50}, {0xdde2, -90}, {0x79e3, -30}, {0x50e8, -30},
+    {0x7271, -20}, {0xfde2, -30}, {0x46c0, -80}, {0x9fc4, -110}, {0xe876, -15},
+    {0xdac2, -50}, {0x46c3, -80}, {0x4a41, -20}, {0xc1d2, -40}, {0xc3d3, -40},
+    {0x4ac1, -20}, {0x56f8, -90}, {0x4143, -40}, {0x722c, -60}, {0xc543, -40},
+    {0xe879, -15}, {0xa054, -100}, {0xc255, -50}, {0xc0dc, -50}, {0x44c3, -40},
+    {0x79e8, -10}, {0xf277, -15}, {0x54e1, -80}, {0xffe8, -10}, {0xc156, -80},
+    {0x6b6f, -15}, {0x57f6, -60}, {0xc143, -40}, {0x78e8, -10}, {0x4bf3, -35},
+    {0x6368, -10}, {0x5255, -20}, {0x56d4, -50}, {0xeb76, -15}, {0x56e4, -60},
+    {0xc34f, -40}, {0xeaff, -15}, {0xdde9, -80}, {0xc4dc, -50}, {0x2093, -80},
+    {0x57c5, -60}, {0x57e5, -40}, {0xc447, -50}, {0x6cff, -15}, {0x59d6, -70},
+    {0xf678, -30}, {0x54c5, -90}, {0xe577, -15}, {0x4c57, -80}, {0xe0ff, -20},
+    {0xe267, -10}, {0x4b4f, -30}, {0xc1fd, -30}, {0x552c, -30}, {0xc1fc, -30},
+    {0xc2d8, -40}, {0xc0da, -50}, {0x662e, -10}, {0x6177, -15}, {0x57d2, -20},
+    {0xc157, -60}, {0x9e65, 10}, {0x52dc, -20}, {0xc2dc, -50}, {0x442e, -30},
+    {0xc554, -90}, {0x54e0, -80}, {0xd3c3, -50}, {0x62fc, -20}, {0x542c, -80},
+    {0xc551, -40}, {0xfff8, -25}, {0x79f4, -25}, {0x6fff, -20}, {0x42db, -10},
+    {0x6578, -15}, {0xf378, -30}, {0xc2ff, -30}, {0xdd6f, -100}, {0x54d5, -40},
+    {0xc3ff, -30}, {0x4641, -80}, {0xddf6, -100}, {0x4fdd, -70}, {0x6f76, -20},
+    {0x44c5, -40}, {0x4176, -40}, {0x56c2, -80}, {0xddd2, -70}, {0xc1fa, -30},
+    {0xd62c, -40}, {0x59f6, -100}, {0x77f5, -20}, {0xc5d3, -40}, {0x42c3, -30},
+    {0x4bea, -15}, {0xe3fd, -20}, {0x56f9, -60}, {0xc3c7, -40}, {0x56d3, -50},
+    {0x4255, -10}, {0x46e0, -20}, {0x54e3, -80}, {0x6767, -10}, {0x77f6, -20},
+    {0xf879, -20}, {0x4241, -30}, {0xea77, -15}, {0x7264, -20}, {0x4bf4, -35},
+    {0xdcc0, -50}, {0xc3fd, -30}, {0xd5dd, -70}, {0x44c1, -40}, {0x57f3, -60},
+    {0x50c3, -100}, {0x6176, -15}, {0xddc5, -110}, {0x52d3, -20},
+    {0xc4d3, -40}, {0x4bf6, -35}, {0xd5c2, -50}, {0xc5d5, -40}, {0xfdf4, -25},
+    {0x4f41, -50}, {0x4afc, -20}, {0xa057, -80}, {0xffe3, -30}, {0x566f, -90},
+    {0x66f3, -20}, {0x5965, -80}, {0xa091, -60}, {0x6692, 30}, {0x6efd, -20},
+    {0xdcc1, -50}, {0xc29f, -110}, {0x592c, -100}, {0xc279, -30},
+    {0xdd61, -90}, {0xddf4, -100}, {0x54f3, -80}, {0xc3dc, -50}, {0xf579, -20},
+    {0xe5ff, -20}, {0xc3dd, -110}, {0xf479, -20}, {0xc377, -30}, {0xc54f, -40},
+    {0xfff2, -25}, {0xa09f, -120}, {0x63ff, -10}, {0x6eff, -20}, {0xdac0, -50},
+    {0xd39f, -70}, {0xdac4, -50}, {0x512e, 20}, {0x67ea, 10}, {0xc275, -30},
+    {0xd2c1, -50}, {0x6476, -15}, {0xfd65, -10}, {0xe479, -20}, {0x5041, -100},
+    {0xc0ff, -30}, {0x576f, -60}, {0x57e3, -40}, {0x50ea, -30}, {0xfdf2, -25},
+    {0x55c3, -50}, {0x44c0, -40}, {0xc4c7, -40}, {0xd859, -70}, {0x9fc1, -110},
+    {0xf3fd, -20}, {0xd454, -40}, {0x77f2, -20}, {0x42c0, -30}, {0xeafd, -15},
+    {0x6477, -15}, {0x4af9, -20}, {0x4156, -80}, {0xfff6, -25}, {0x574f, -20},
+    {0xddc0, -110}, {0x6179, -20}, {0xd359, -70}, {0x54d3, -40}, {0x9fe4, -90},
+    {0x4ac2, -20}, {0xd857, -50}, {0xc0d5, -40}, {0x5257, -40}, {0x9ee9, 10},
+    {0xddfa, -100}, {0x42c2, -30}, {0x59d8, -70}, {0xc576, -40}, {0xfd2e, -80},
+    {0x5779, -20}, {0xc4dd, -110}, {0xf8ff, -20}, {0xd59f, -70},
+    {0x4159, -110}, {0xd8c0, -50}, {0xd8c1, -50}, {0xd4c3, -50},
+    {0x9f2c, -100}, {0xc1d6, -40}, {0xd82c, -40}, {0xc1ff, -30}, {0xe1ff, -20},
+    {0xd9c5, -50}, {0x4bd8, -30}, {0xc4fb, -30}, {0x79e9, -10}, {0x449f, -70},
+    {0xc2d3, -40}, {0xe2fd, -20}, {0xf4fd, -20}, {0xc3d2, -40}, {0x56d8, -50},
+    {0x7279, 10}, {0x9272, -40}, {0xd457, -50}, {0x57fd, -20}, {0x57ad, -40},
+    {0x929a, -60}, {0xf679, -20}, {0x209f, -120}, {0x76e0, -20}, {0x5775, -45},
+    {0x42c4, -30}, {0x46e4, -20}, {0xd8dd, -70}, {0x9ff3, -100}, {0x41d5, -40},
+    {0xc343, -40}, {0xddf9, -100}, {0xc5d9, -50}, {0xc257, -60}, {0x7865, -10},
+    {0x562d, -80}, {0x4bd5, -30}, {0x72e7, -20}, {0x77f8, -20}, {0xc5fd, -30},
+    {0x4bd4, -30}, {0x4be8, -15}, {0x524f, -20}, {0xc556, -80}, {0xd52e, -40},
+    {0xd358, -50}, {0x67e8, 10}, {0x54c2, -90}, {0x72f2, -20}, {0xd42c, -40},
+    {0xc456, -80}, {0x6765, 10}, {0xffe5, -30}, {0xf1f9, -10}, {0xc357, -60},
+    {0x46e1, -20}, {0x462c, -100}, {0x722e, -60}, {0xd4c1, -50}, {0x4ac4, -20},
+    {0xc079, -30}, {0xc154, -90}, {0x9ffb, -100}, {0xdbc5, -50}, {0x50e1, -30},
+    {0xc1fb, -30}, {0xc0fc, -30}, {0xc4fc, -30}, {0xe567, -10}, {0x6694, 30},
+    {0xc259, -110}, {0xd558, -50}, {0xd2c3, -50}, {0x52db, -20}, {0x3ba0, -40},
+    {0x67eb, 10}, {0x50f5, -40}, {0xd4c4, -50}, {0xe979, -15}, {0xd3c1, -50},
+    {0xdd3b, -50}, {0xc457, -60}, {0xc59f, -110}, {0x52d6, -20}, {0x76f4, -30},
+    {0xc1f9, -30}, {0x2c92, -120}, {0x3aa0, -40}, {0x414f, -40}, {0xe878, -15},
+    {0x5475, -90}, {0x4c79, -30}, {0x4155, -50}, {0x6dfc, -20}, {0x5741, -60},
+    {0x79f2, -25}, {0x3a20, -40}, {0x66e8, -10}, {0xc347, -50}, {0xf6ff, -20},
+    {0x6577, -15}, {0xc476, -40}, {0x419f, -110}, {0x50f6, -40}, {0xd4c0, -50},
+    {0x56f4, -90}, {0x46c4, -80}, {0xc4f9, -30}, {0xe4fd, -20}, {0xd6dd, -70},
+    {0xc1d4, -40}, {0x4c9f, -120}, {0x54d2, -40}, {0xfff4, -25}, {0xe1fd, -20},
+    {0xff65, -10}, {0xc2fd, -30}, {0xd22e, -40}, {0xd357, -50}, {0x4f54, -40},
+    {0xe92e, 20}, {0xf676, -20}, {0x3b20, -40}, {0x6bf6, -15}, {0x594f, -70},
+    {0xeb79, -15}, {0xd9c3, -50}, {0xc5c7, -40}, {0x2056, -80}, {0xdcc4, -50},
+    {0x9f6f, -100}, {0xd6c2, -50}, {0xdcc3, -50}, {0xffe2, -30}, {0x56c1, -80},
+    {0xd8c4, -50}, {0xc1c7, -40}, {0x2057, -80}, {0xc3fa, -30}, {0x51db, -10},
+    {0x41fc, -30}, {0x512c, 20}, {0x9a77, -15}, {0x57e8, -35}, {0x4bf2, -35},
+    {0x64fd, -15}, {0xf1ff, -20}, {0xe177, -15}, {0x792c, -80}, {0x72fd, 10},
+    {0x56e0, -60}, {0xc555, -50}, {0x54c3, -90}, {0x6579, -15}, {0xc359, -110},
+    {0xc176, -40}, {0x46c2, -80}, {0xe0fd, -20}, {0xf677, -15}, {0x56ea, -50},
+    {0xe3ff, -20}, {0x5477, -60}, {0x57f9, -45}, {0xc459, -110}, {0x41d8, -40},
+    {0xff2e, -80}, {0xdd2e, -100}, {0x6efc, -10}, {0x652c, 10}, {0x59c3, -110},
+    {0x79f8, -25}, {0x56e9, -50}, {0x76f2, -30}, {0x9273, -60}, {0x54c0, -90},
+    {0xdd4f, -70}, {0xfd2c, -80}, {0x52d9, -20}, {0xeb77, -15}, {0xffe0, -30},
+    {0x50f2, -40}, {0xdac5, -50}, {0xd6c0, -50}, {0xc277, -30}, {0x7263, -20},
+    {0x4be9, -15}, {0xc247, -50}, {0x50c0, -100}, {0x4fc4, -50}, {0x57fc, -45},
+    {0xd62e, -40}, {0x6d75, -20}, {0xc5fb, -30}, {0x926c, -20}, {0x57fb, -45},
+    {0xd2dd, -70}, {0xf8fd, -20}, {0xc44f, -40}, {0x54e2, -80}, {0xf876, -20},
+    {0xe176, -15}, {0x4147, -50}, {0xdc41, -50}, {0xd6c3, -50}, {0x46e2, -20},
+    {0xc175, -30}, {0xc4fa, -30}, {0x42da, -10}, {0x2c94, -120}, {0xc076, -40},
+    {0xd2c5, -50}, {0x5641, -80}, {0xf379, -20}, {0x56c0, -80}, {0x54e4, -80},
+    {0x4bf8, -35}, {0x76e3, -20}, {0xddf5, -100}, {0x2054, -100},
+    {0xd29f, -70}, {0x59f9, -100}, {0xe7fd, -10}, {0x572c, -80}, {0xf176, -40},
+    {0x9f75, -100}, {0xe877, -15}, {0xfde8, -10}, {0xc14f, -40}, {0x4fc2, -50},
+    {0xd9c2, -50}, {0x62fb, -20}, {0x4b75, -30}, {0xc451, -40}, {0x59e8, -80},
+    {0xc054, -90}, {0x50e9, -30}, {0x5765, -35}, {0x4bfb, -30}, {0x54c1, -90},
+    {0x66f2, -20}, {0x9fe1, -90}, {0x546f, -80}, {0x20dd, -120}, {0x76f3, -30},
+    {0x61ff, -20}, {0xe977, -15}, {0xe477, -15}, {0x7aeb, 10}, {0xc1dd, -110},
+    {0x59d4, -70}, {0x64ff, -15}, {0x4441, -40}, {0xc5d4, -40}, {0x72f8, -20},
+    {0xddfb, -100}, {0xddf2, -100}, {0x57d5, -20}, {0xfdf3, -25},
+    {0x59f5, -100}, {0x543a, -40}, {0x5472, -80}, {0x4175, -30}, {0xd858, -50},
+    {0x55c2, -50}, {0xc1d9, -50}, {0x54fb, -90}, {0xd5c1, -50}, {0x4661, -20},
+    {0x4c56, -110}, {0xc479, -30}, {0xe379, -20}, {0x50f3, -40}, {0x72ff, 10},
+    {0xdde8, -80}, {0xc2d6, -40}, {0xc075, -30}, {0xc455, -50}, {0x57e1, -40},
+    {0x9fe9, -80}, {0xe82e, 20}, {0x9191, -46}, {0x54e5, -80}, {0x4a75, -20},
+    {0x4457, -40}, {0x772e, -40}, {0x462e, -100}, {0x54e8, -60},
+    {0x9f2e, -100}, {0xe276, -15}, {0xc057, -60}, {0xe077, -15}, {0x5254, -20},
+    {0xdbc4, -50}, {0xc3d8, -40}, {0x76f5, -30}, {0x4bd6, -30}, {0x59f8, -100},
+    {0x562e, -120}, {0x7965, -10}, {0x6bf3, -15}, {0x6bf8, -15}, {0x54d4, -40},
+    {0xf276, -20}, {0x7ae8, 10}, {0x54f2, -80}, {0x596f, -100}, {0x9292, -46},
+    {0x9ff8, -100}, {0xc355, -50}, {0x7273, -15}, {0x776f, -20}, {0x4f58, -50},
+    {0x57c2, -60}, {0x4afa, -20}, {0xd356, -50}, {0x6e75, -10}, {0xf577, -15},
+    {0x5441, -90}, {0xc243, -40}, {0xc09f, -110}, {0xc2db, -50}, {0xdde1, -90},
+    {0xc443, -40}, {0xd52c, -40}, {0x6e76, -40}, {0x9fc3, -110}, {0xdb41, -50},
+    {0xd9c0, -50}, {0x4c92, -140}, {0x52d4, -20}, {0xd658, -50}, {0x4f2e, -40},
+    {0xd49f, -70}, {0x726f, -20}, {0xf1fc, -10}, {0xdd65, -80}, {0x4a2e, -20},
+    {0xc375, -30}, {0xc3d5, -40}, {0x59eb, -80}, {0xffe4, -30}, {0xc475, -30},
+    {0x6efa, -10}, {0xc1da, -50}, {0xc5fa, -30}, {0x5259, -50}, {0x92a0, -80},
+    {0xc3f9, -30}, {0xda2c, -30}, {0x762c, -80}, {0x41db, -50}, {0x6ef9, -10},
+    {0xa059, -120}, {0x59d2, -70}, {0x4c54, -90}, {0xd3c5, -50}, {0x6dff, -30},
+    {0x62fa, -20}, {0x562c, -120}, {0xd554, -40}, {0x4bfc, -30}, {0x4b65, -15},
+    {0xc0d3, -40}, {0x50c4, -100}, {0x54eb, -60}, {0x9fc0, -110},
+    {0xc055, -50}, {0x59d3, -70}, {0xffe1, -30}, {0x4a2c, -20}, {0x41ff, -30},
+    {0xe92c, 10}, {0xf5ff, -20}, {0x5461, -80}, {0xeb2c, 10}, {0x59e4, -90},
+    {0x56eb, -50}, {0x50c5, -100}, {0x94a0, -80}, {0xf476, -20}, {0x52da, -20},
+    {0xd6c5, -50}, {0x4bff, -40}, {0x66e9, -10}, {0xc4da, -50}, {0xddc2, -110},
+    {0xc4d6, -40}, {0xc559, -110}, {0x57c4, -60}, {0xd4dd, -70}, {0xdbc1, -50},
+    {0x56e2, -60}, {0x7267, -15}, {0xc3d9, -50}, {0x4b6f, -35}, {0x6efb, -10},
+    {0xc5da, -50}, {0xf175, -10}, {0x9f3b, -50}, {0x542e, -80}, {0xe277, -15},
+    {0x59e1, -90}, {0xd657, -50}, {0x7274, 20}, {0xc2d9, -50}, {0x57f4, -60},
+    {0x6dfb, -20}, {0xc351, -40}, {0xdde3, -90}, {0x5065, -30}, {0xfff3, -25},
+    {0x9fd2, -70}, {0xd354, -40}, {0xc477, -30}, {0x5761, -40}, {0x44c4, -40},
+    {0x66f5, -20}, {0x65ff, -15}, {0xc5db, -50}, {0x4cff, -30}, {0x572d, -40},
+    {0xdbc0, -50}, {0xc056, -80}, {0x502e, -120}, {0x76e4, -20}, {0x56d5, -50},
+    {0x4151, -40}, {0xf6fd, -20}, {0x41dc, -50}, {0x4f59, -70}, {0xd458, -50},
+    {0x41dd, -110}, {0x57e2, -40}, {0xd4c5, -50}, {0x9fd5, -70}, {0x41d9, -50},
+    {0xffea, -10}, {0x66ea, -10}, {0x9ff5, -100}, {0xc0fa, -30}, {0xd82e, -40},
+    {0x4fc0, -50}, {0x9fc5, -110}, {0x6479, -15}, {0x79f5, -25}, {0x564f, -50},
+    {0xff6f, -25}, {0xd42e, -40}, {0x4bfa, -30}, {0xc577, -30}, {0x2e94, -120},
+    {0x9ff9, -100}, {0x6379, -10}, {0x4bf5, -35}, {0x50f4, -40}, {0x56e3, -60},
+    {0x4bf9, -30}, {0x9feb, -80}, {0x57eb, -35},
+};
+
+static const struct kern_table helvetica_bold_kerns = {
+    helvetica_bold_kern_seeds,
+    helvetica_bold_kern_pairs,
+    512,
+    1180,
+    {0x00, 0x00, 0x00, 0x00, 0x01, 0x50, 0x00, 0x0c, 0x56, 0x9c, 0xf7,
+     0x02, 0xfe, 0xf9, 0xcd, 0x07, 0x00, 0x00, 0x16, 0xc4, 0x01, 0x00,
+     0x00, 0x00, 0x3f, 0x00, 0x7c, 0x3f, 0xbf, 0x0f, 0x7e, 0xa1},
+};
+
+static const uint16_t times_kern_seeds[256] = {
+    1, 2, 30, 107, 38, 9, 4, 11, 7, 47, 36, 81, 141, 48, 6, 1, 89, 18, 43, 1,
+    7, 2, 20, 4, 123, 31, 187, 121, 1, 253, 26, 115, 312, 1, 127, 26, 10, 24,
+    15, 16, 155, 9, 1, 1, 84, 59, 1, 10, 78, 13, 7, 8, 104, 7, 86, 5, 3, 147,
+    137, 14, 157, 3, 95, 35, 119, 171, 2, 73, 22, 56, 3, 6, 0, 11, 2, 12, 113,
+    106, 158, 27, 172, 186, 238, 261, 386, 450, 1, 4, 50, 19, 224, 230, 13, 31,
+    3, 7, 3, 0, 5, 1, 3, 7, 106, 70, 6, 233, 484, 55, 2, 2, 1, 39, 5, 44, 2,
+    17, 88, 7, 111, 32, 13, 24, 16, 161, 0, 37, 259, 3, 153, 9, 1, 8, 135, 2,
+    74, 8, 200, 14, 8, 4, 314, 172, 77, 52, 25, 0, 237, 1560, 9, 141, 185, 126,
+    5, 2, 7, 406, 1, 15, 31, 6, 133, 5, 1065, 383, 2537, 74, 3, 45, 85, 6, 510,
+    6, 464, 970, 1789, 1, 225, 253, 16, 330, 381, 36, 1065, 1, 13, 15, 4, 16,
+    28, 59, 99, 2, 71, 92, 233, 81, 6, 4, 17, 2, 3, 64, 66, 228, 95, 491, 80,
+    75, 3, 604, 0, 69, 250, 943, 930, 8, 24, 1907, 42, 255, 6, 322, 0, 263, 26,
+    26, 240, 167, 28, 9, 49, 8, 1, 118, 145, 126, 757, 883, 20, 2538, 49, 467,
+    874, 344, 392, 3267, 424, 255, 145, 172, 189, 1286, 125, 1, 44, 1,
+};
+
+static const struct kern_pair times_kern_pairs[1019] = {
+    {0xd354, -40}, {0x91c3, -80}, {0xc355, -55}, {0xf4fd, -10}, {0xe476, -20},
+    {0xddd4, -30}, {0xdbc2, -40}, {0x9220, -74}, {0x59c2, -120},
+    {0xc0dd, -105}, {0xc3da, -55}, {0xe176, -20}, {0x6176, -20}, {0x9fe8, -60},
+    {0xdbc0, -40}, {0x50e0, -15}, {0xe377, -15}, {0x7267, -18}, {0xe076, -20},
+    {0x93c2, -80}, {0x54f5, -80}, {0x6bf2, -10}, {0xa057, -30}, {0x762c, -65},
+    {0x66e3, -10}, {0x9276, -50}, {0x5661, -111}, {0x77e3, -10}, {0xc34f, -55},
+    {0x59c4, -120}, {0x4ac5, -60}, {0xc4d9, -55}, {0xd256, -50}, {0x5669, -60},
+    {0xf377, -25}, {0xe867, -15}, {0xc5d6, -55}, {0xdd61, -100}, {0x9273, -55},
+    {0x56f6, -89}, {0x41d3, -55}, {0x57f3, -80}, {0x59f3, -110}, {0xe876, -25},
+    {0xddad, -111}, {0xdbc1, -40}, {0xf1fd, -15}, {0x4bf4, -35},
+    {0x56e5, -111}, {0xf2fd, -10}, {0xc277, -92}, {0x4154, -111},
+    {0x52d5, -40}, {0xf176, -40}, {0xd9c2, -40}, {0xa0c5, -55}, {0xc459, -105},
+    {0xc051, -55}, {0xc3dd, -105}, {0xc3d9, -55}, {0x59e9, -100},
+    {0xc09f, -105}, {0x57f5, -80}, {0x5061, -15}, {0xd3c5, -35}, {0x6bf4, -10},
+    {0x9f65, -100}, {0x5461, -80}, {0x4ac0, -60}, {0x59f6, -70}, {0x77f5, -10},
+    {0xd5c3, -35}, {0xd341, -35}, {0x41d8, -55}, {0xf576, -15}, {0xc154, -111},
+    {0x20c5, -55}, {0x93c0, -80}, {0xd29f, -50}, {0x762e, -65}, {0x544f, -18},
+    {0x91c0, -80}, {0xeb67, -15}, {0xc0dc, -55}, {0x66e5, -10}, {0x4f57, -35},
+    {0x54e8, -70}, {0x4bf6, -35}, {0xc243, -40}, {0xdde1, -100}, {0x57d6, -10},
+    {0x9ffc, -71}, {0x54fc, -45}, {0x7761, -10}, {0x54f6, -80}, {0x563a, -74},
+    {0x594f, -30}, {0xc39f, -105}, {0xc2d5, -55}, {0xddc1, -120},
+    {0xc557, -90}, {0x4ac4, -60}, {0x622e, -40}, {0xc4db, -55}, {0x42c4, -35},
+    {0x9fc3, -120}, {0x9ffb, -111}, {0x5775, -50}, {0x56fb, -75},
+    {0x56c0, -135}, {0x54ad, -92}, {0xc477, -92}, {0xc4d3, -55}, {0x46e4, -15},
+    {0xe879, -15}, {0xd656, -50}, {0x56fc, -75}, {0xc443, -40}, {0x54d3, -18},
+    {0x57e4, -80}, {0x4143, -40}, {0xc5dc, -55}, {0xd6c1, -35}, {0xc056, -135},
+    {0xc2d8, -55}, {0xf376, -15}, {0xd454, -40}, {0x65fd, -15}, {0x573a, -37},
+    {0xc147, -40}, {0x2057, -30}, {0xea78, -15}, {0xc4d2, -55}, {0x54c2, -93},
+    {0x722c, -40}, {0x56ee, -20}, {0x4457, -30}, {0xc1c7, -40}, {0xc4d8, -55},
+    {0x5779, -73}, {0xc577, -92}, {0x56ed, -60}, {0x4e41, -35}, {0xd4c1, -35},
+    {0xd4c2, -35}, {0x4bd8, -30}, {0xc0d8, -55}, {0x564f, -40}, {0x4f58, -40},
+    {0x4fc5, -35}, {0xf2ff, -10}, {0x57ff, -73}, {0x9ff4, -110}, {0x5472, -35},
+    {0xf179, -15}, {0xdded, -55}, {0x59f5, -70}, {0x5965, -100},
+    {0xc256, -135}, {0xf879, -10}, {0x46c0, -74}, {0x4bd2, -30}, {0xd558, -40},
+    {0x67e4, -5}, {0xd6dd, -50}, {0x6177, -15}, {0x2041, -55}, {0x9f3b, -92},
+    {0xfd2e, -65}, {0x573b, -37}, {0xdd2d, -111}, {0xc076, -74}, {0x57fa, -50},
+    {0x62f9, -20}, {0xeafd, -15}, {0x76e8, -15}, {0xc043, -40}, {0x562c, -129},
+    {0xddfa, -111}, {0x5475, -45}, {0xc1d8, -55}, {0x91c5, -80},
+    {0x4156, -135}, {0xfd2c, -65}, {0xf5fd, -10}, {0xc24f, -55}, {0xc5d2, -55},
+    {0x59eb, -60}, {0xdde9, -100}, {0xc5d3, -55}, {0x6576, -25}, {0xf6ff, -10},
+    {0xa041, -55}, {0xddf2, -70}, {0xc0ff, -92}, {0x9fe4, -60}, {0x76e3, -25},
+    {0xd541, -35}, {0x6e79, -15}, {0xc5d5, -55}, {0xc0d2, -55}, {0xc4dc, -55},
+    {0x57f6, -80}, {0x56c4, -135}, {0x4cff, -55}, {0xc1d4, -55}, {0x42c0, -35},
+    {0xd8c1, -35}, {0x6bfd, -15}, {0x46c4, -74}, {0xd6c0, -35}, {0x57d2, -10},
+    {0x57c5, -120}, {0x4c92, -92}, {0x56c1, -135}, {0x44c4, -40},
+    {0xd4c4, -35}, {0x543b, -55}, {0x68fd, -5}, {0x5257, -55}, {0x59d6, -30},
+    {0xc255, -55}, {0x57f9, -50}, {0xda41, -40}, {0x46c3, -74}, {0x4441, -40},
+    {0xd5c2, -35}, {0xd457, -35}, {0xc359, -105}, {0x57c0, -120},
+    {0xeb77, -25}, {0x6e76, -40}, {0x4bf2, -35}, {0xc579, -92}, {0x59f8, -110},
+    {0xc2fd, -92}, {0xc077, -92}, {0xe376, -20}, {0xddc2, -120}, {0xd1c4, -35},
+    {0xd357, -35}, {0x42c2, -35}, {0x46f6, -15}, {0x5155, -10}, {0xebfd, -15},
+    {0xc177, -92}, {0xd8c3, -35}, {0xc5da, -55}, {0x9fd2, -30}, {0x54d5, -18},
+    {0x542e, -74}, {0xf476, -15}, {0x7661, -25}, {0x59f4, -110}, {0xa0c2, -55},
+    {0xd59f, -50}, {0x5477, -80}, {0x52d3, -40}, {0xc543, -40}, {0xd4dd, -50},
+    {0x56d6, -40}, {0x46c1, -74}, {0x57e2, -80}, {0x54fb, -45}, {0x57e9, -80},
+    {0xd5c5, -35}, {0x78ea, -15}, {0xd5c4, -35}, {0xc5fd, -92}, {0xddd5, -30},
+    {0x792c, -65}, {0x4c9f, -100}, {0x9ff2, -70}, {0x576f, -80}, {0xc44f, -55},
+    {0xc19f, -105}, {0x562e, -129}, {0x4ec2, -35}, {0x46e0, -15},
+    {0x59d8, -30}, {0xd557, -35}, {0x9fd8, -30}, {0x93c1, -80}, {0x76e0, -25},
+    {0xe477, -15}, {0xc592, -111}, {0xdde2, -100}, {0xeb78, -15},
+    {0x70ff, -10}, {0x41d9, -55}, {0xd1c3, -35}, {0xc4dd, -105}, {0xc551, -55},
+    {0xc3fd, -92}, {0xe967, -15}, {0xd4c0, -35}, {0xc4d6, -55}, {0x46e3, -15},
+    {0xc2db, -55}, {0x50e2, -15}, {0x57c4, -120}, {0xc2ff, -92}, {0x7079, -10},
+    {0xc157, -90}, {0x4ec0, -35}, {0x77e0, -10}, {0x55c0, -40}, {0xd859, -50},
+    {0x9fc5, -120}, {0x4c59, -100}, {0xf5ff, -10}, {0x6669, -20},
+    {0xc047, -40}, {0xddf5, -70}, {0xc2da, -55}, {0x50c4, -92}, {0x59c1, -120},
+    {0xddf8, -110}, {0x44c1, -40}, {0x414f, -55}, {0xea76, -25}, {0x5479, -80},
+    {0x57c2, -120}, {0x46f8, -15}, {0x6bf6, -10}, {0x66e1, -10}, {0x9fd5, -30},
+    {0xdcc1, -40}, {0x9fed, -55}, {0xe7fd, -15}, {0xdd65, -100}, {0x57f4, -80},
+    {0x72ad, -20}, {0xc5ff, -92}, {0x42c5, -35}, {0x722e, -55}, {0x52dd, -65},
+    {0x563b, -74}, {0xd858, -40}, {0x4bfd, -25}, {0x56f3, -129}, {0x55c1, -40},
+    {0x592e, -129}, {0x55c5, -40}, {0xe978, -15}, {0x56c5, -135},
+    {0x572e, -92}, {0x70fd, -10}, {0x4ac3, -60}, {0xddc0, -120}, {0x54fd, -80},
+    {0x46f2, -15}, {0x20c3, -55}, {0x7665, -15}, {0xd459, -50}, {0xc49f, -105},
+    {0x55c2, -40}, {0x44c5, -40}, {0x42dc, -10}, {0xd3c2, -35}, {0xd657, -35},
+    {0x56d3, -40}, {0x4ec1, -35}, {0x42db, -10}, {0x78eb, -15}, {0x2059, -90},
+    {0xc259, -105}, {0x91c2, -80}, {0x20dd, -90}, {0x20c1, -55}, {0x529f, -65},
+    {0xc377, -92}, {0x9fc4, -120}, {0x5465, -70}, {0x6bea, -10},
+    {0x4c56, -100}, {0x9fad, -111}, {0x9264, -50}, {0x50c2, -92},
+    {0xdde0, -60}, {0xe8fd, -15}, {0xdd2e, -129}, {0xc0d6, -55}, {0xdac0, -40},
+    {0x59ea, -100}, {0xd259, -50}, {0x6bf8, -10}, {0x50c5, -92}, {0x66e0, -10},
+    {0xec76, -25}, {0xc2d9, -55}, {0x6692, 55}, {0x77f3, -10}, {0xc3d6, -55},
+    {0x4b79, -25}, {0x54eb, -30}, {0xc454, -111}, {0x46c5, -74}, {0xea79, -15},
+    {0xddd8, -30}, {0x41dc, -55}, {0xd39f, -50}, {0x41da, -55}, {0x4fc4, -35},
+    {0xc354, -111}, {0xea77, -25}, {0x562d, -100}, {0xc155, -55},
+    {0xed76, -25}, {0x6be9, -10}, {0x46f4, -15}, {0x5254, -60}, {0x4bd3, -30},
+    {0xdac5, -40}, {0xc3d5, -55}, {0x4f9f, -50}, {0x4f41, -35}, {0xc576, -74},
+    {0xd456, -50}, {0xd1c0, -35}, {0xd5dd, -50}, {0x56c3, -135}, {0xf4ff, -10},
+    {0xd4c5, -35}, {0x6c77, -10}, {0x9272, -50}, {0xc59f, -105}, {0x41d6, -55},
+    {0x50c1, -92}, {0xc347, -40}, {0x4fc2, -35}, {0x56eb, -71}, {0x9fd6, -30},
+    {0x9191, -74}, {0x77f6, -10}, {0xc4da, -55}, {0x59c3, -120}, {0xd2c4, -35},
+    {0xd89f, -50}, {0x93c4, -80}, {0xd857, -35}, {0x9fe2, -100},
+    {0xddfb, -111}, {0xc5d8, -55}, {0x76e9, -15}, {0xe177, -15}, {0xd9c5, -40},
+    {0x9f69, -55}, {0x9fe3, -100}, {0x57e0, -80}, {0xdd75, -111},
+    {0x776f, -10}, {0x76ea, -15}, {0x5975, -111}, {0x51da, -10}, {0xc2c7, -40},
+    {0x6661, -10}, {0xf676, -15}, {0xddf4, -110}, {0xc547, -40}, {0x67e5, -5},
+    {0x44c3, -40}, {0xc4c7, -40}, {0x77f8, -10}, {0xc343, -40}, {0x46f3, -15},
+    {0x67e1, -5}, {0xd2c1, -35}, {0xc29f, -105}, {0x78e8, -15}, {0x6f77, -25},
+    {0x9f6f, -110}, {0x41d5, -55}, {0x4b75, -15}, {0x56ef, -20}, {0x5765, -80},
+    {0x4bff, -25}, {0x59d2, -30}, {0x91c4, -80}, {0x51db, -10}, {0xc356, -135},
+    {0xc254, -111}, {0xd654, -40}, {0x59fc, -71}, {0x4177, -92}, {0xdac4, -40},
+    {0x9141, -80}, {0xc2dc, -55}, {0xc192, -111}, {0xd5c1, -35},
+    {0x4192, -111}, {0x59d4, -30}, {0xa054, -18}, {0x4155, -55}, {0x56d8, -40},
+    {0x56f2, -89}, {0xddd3, -30}, {0xd2dd, -50}, {0xc0c7, -40}, {0xa0dd, -90},
+    {0xd659, -50}, {0x54e0, -40}, {0xf1ff, -15}, {0xd3c3, -35}, {0x6beb, -10},
+    {0x41c7, -40}, {0x50e4, -15}, {0xc0d4, -55}, {0x54d8, -18}, {0x41ff, -92},
+    {0x44c0, -40}, {0x54fa, -45}, {0xc3d3, -55}, {0x59d5, -30}, {0x57fd, -73},
+    {0xd1c1, -35}, {0xd3c4, -35}, {0xc143, -40}, {0xd254, -40}, {0x9f3a, -92},
+    {0xddd2, -30}, {0x4bd6, -30}, {0x59f2, -70}, {0x59ed, -55}, {0x596f, -110},
+    {0x9f2e, -129}, {0xd9c1, -40}, {0x52d9, -40}, {0xc1d2, -55}, {0x4ec3, -35},
+    {0xc3c7, -40}, {0x4bd4, -30}, {0x4c54, -92}, {0x57ea, -80}, {0xc555, -55},
+    {0xd441, -35}, {0xdcc3, -40}, {0x56e4, -71}, {0x56f8, -129}, {0xeb76, -25},
+    {0x57e8, -40}, {0x4456, -40}, {0x6bf3, -10}, {0xd856, -50}, {0x50c3, -92},
+    {0xddea, -100}, {0xdbc5, -40}, {0x5675, -75}, {0xc456, -135},
+    {0xc0da, -55}, {0x41d2, -55}, {0x9f75, -111}, {0x4179, -92}, {0xd2c0, -35},
+    {0xddf3, -110}, {0xd641, -35}, {0xd8c2, -35}, {0xe276, -20}, {0x4bf8, -35},
+    {0xc0d9, -55}, {0x76f2, -20}, {0x52db, -40}, {0xddc4, -120}, {0xc279, -92},
+    {0x54f2, -80}, {0x6379, -15}, {0xc54f, -55}, {0xc3dc, -55}, {0x56f5, -89},
+    {0xd554, -40}, {0x6577, -25}, {0x57c1, -120}, {0x4beb, -25}, {0x77e2, -10},
+    {0xc476, -74}, {0xd359, -50}, {0x4661, -15}, {0xf279, -10}, {0xd356, -50},
+    {0xc479, -92}, {0xd2c2, -35}, {0xddf9, -71}, {0x59e0, -60}, {0x6f79, -10},
+    {0xc0d5, -55}, {0xc3d4, -55}, {0xe277, -15}, {0x66e4, -10}, {0xd1c5, -35},
+    {0xc5d4, -55}, {0x55c4, -40}, {0xc1da, -55}, {0x546f, -80}, {0x4be8, -25},
+    {0xf3fd, -10}, {0x59c0, -120}, {0x77f2, -10}, {0xc559, -105},
+    {0xc057, -90}, {0x5641, -135}, {0x59d3, -30}, {0x59fb, -111},
+    {0x593b, -92}, {0x41dd, -105}, {0x6fff, -10}, {0x6666, -25}, {0xeaff, -15},
+    {0x77f4, -10}, {0x42c1, -35}, {0x59fa, -111}, {0x9fd3, -30}, {0xf276, -15},
+    {0x4a41, -60}, {0x9fe1, -100}, {0xf877, -25}, {0x51dc, -10},
+    {0xc556, -135}, {0x5256, -80}, {0x5969, -55}, {0x59e3, -60}, {0xd8c0, -35},
+    {0xd854, -40}, {0xc392, -111}, {0x5665, -111}, {0x4ac1, -60},
+    {0xc492, -111}, {0xdac2, -40}, {0xc079, -92}, {0x56f9, -75}, {0x722d, -20},
+    {0xc054, -111}, {0xdac3, -40}, {0x54e9, -70}, {0x792e, -65}, {0xd8c4, -35},
+    {0x57f2, -80}, {0xddc5, -120}, {0x5769, -40}, {0x9ff6, -70}, {0x76f6, -20},
+    {0x57e5, -80}, {0xc2dd, -105}, {0x5469, -35}, {0x6578, -15}, {0x4241, -35},
+    {0x57fc, -50}, {0xd8dd, -50}, {0xf8ff, -10}, {0xd1c2, -35}, {0x542d, -92},
+    {0xdbc3, -40}, {0x68ff, -5}, {0x7865, -15}, {0xc247, -40}, {0x5441, -93},
+    {0xe7ff, -15}, {0x6bff, -15}, {0xc0db, -55}, {0xddf6, -70}, {0x66ed, -20},
+    {0x76f8, -20}, {0x56ad, -100}, {0x9ff5, -70}, {0x462e, -80}, {0x4bf9, -15},
+    {0xdde4, -60}, {0xd8c5, -35}, {0xc059, -105}, {0xee76, -25}, {0xd141, -35},
+    {0x46e1, -15}, {0x462c, -80}, {0x4fc1, -35}, {0x4641, -74}, {0x9ff9, -71},
+    {0x76e5, -25}, {0xd9c4, -40}, {0x4ec5, -35}, {0x76e4, -25}, {0x62fb, -20},
+    {0x5761, -80}, {0x4b65, -25}, {0xc251, -55}, {0xdcc4, -40}, {0xdd3a, -92},
+    {0xc554, -111}, {0x4be9, -25}, {0x572d, -65}, {0x6567, -15}, {0xdb41, -40},
+    {0xe979, -15}, {0xa09f, -90}, {0xdd3b, -92}, {0xe577, -15}, {0x4b4f, -30},
+    {0x76f4, -20}, {0x466f, -15}, {0x4b6f, -35}, {0x4176, -74}, {0xd2c5, -35},
+    {0xe878, -15}, {0xc092, -111}, {0xc1dc, -55}, {0x9f61, -100},
+    {0x5741, -120}, {0x57d5, -10}, {0x6761, -5}, {0x59e2, -100}, {0x4459, -55},
+    {0xdd6f, -110}, {0x54ff, -80}, {0x50e1, -15}, {0x6bf5, -10}, {0x2054, -18},
+    {0xe576, -20}, {0xe976, -25}, {0x592c, -129}, {0x4bea, -25}, {0x77e4, -10},
+    {0x63fd, -15}, {0xc376, -74}, {0x524f, -40}, {0x67e3, -5}, {0x42da, -10},
+    {0x57eb, -40}, {0x4fc0, -35}, {0xd2c3, -35}, {0x59c5, -120}, {0x574f, -10},
+    {0x772c, -65}, {0xd4c3, -35}, {0xd9c3, -40}, {0xc5c7, -40}, {0x2056, -50},
+    {0x4f54, -40}, {0xe077, -15}, {0x9f2c, -129}, {0x4255, -10}, {0x766f, -20},
+    {0x542c, -74}, {0xddd6, -30}, {0x54ed, -35}, {0xc447, -40}, {0x566f, -129},
+    {0xe9ff, -15}, {0xd841, -35}, {0xdde8, -60}, {0x4bfb, -15}, {0x59f9, -71},
+    {0xc455, -55}, {0x772e, -65}, {0x6b65, -10}, {0x4bfc, -15}, {0x20c4, -55},
+    {0x54c3, -93}, {0xf579, -10}, {0xc159, -105}, {0xa056, -50}, {0x56ea, -71},
+    {0xc2d4, -55}, {0xd3dd, -50}, {0x6ffd, -10}, {0x57ad, -65}, {0x9fc0, -120},
+    {0x54e5, -80}, {0xff2e, -65}, {0x4f56, -50}, {0xc4d4, -55}, {0x91c1, -80},
+    {0xa0c1, -55}, {0xc2d6, -55}, {0xc5d9, -55}, {0x5647, -15}, {0x54c0, -93},
+    {0xd241, -35}, {0x9fe0, -60}, {0x4ac2, -60}, {0x62fc, -20}, {0xf677, -25},
+    {0x57e3, -80}, {0x44dd, -55}, {0x56e1, -111}, {0xd556, -50}, {0xf8fd, -10},
+    {0x9fc2, -120}, {0x46e5, -15}, {0x52d8, -40}, {0x9fe9, -100},
+    {0x56d5, -40}, {0xc1d5, -55}, {0x4c79, -55}, {0x209f, -90}, {0x4ec4, -35},
+    {0x76eb, -15}, {0x93c5, -80}, {0x4f59, -50}, {0x2c92, -70}, {0xdc41, -40},
+    {0xd257, -35}, {0x20c0, -55}, {0xf477, -25}, {0x6275, -20}, {0x51d9, -10},
+    {0x6b79, -15}, {0x54e4, -40}, {0x9ff3, -110}, {0x59ad, -111},
+    {0x4bd5, -30}, {0x56d4, -40}, {0xddc3, -120}, {0x592d, -111},
+    {0x93c3, -80}, {0x6eff, -15}, {0xc257, -90}, {0x57d8, -10}, {0xddfc, -71},
+    {0xc3d2, -55}, {0xe877, -25}, {0xd6c2, -35}, {0xc04f, -55}, {0x56e9, -111},
+    {0xc2d2, -55}, {0x57c3, -120}, {0xc451, -55}, {0x6276, -15}, {0xd258, -40},
+    {0x46c2, -74}, {0xc3db, -55}, {0xe8ff, -15}, {0xea67, -15}, {0x65ff, -15},
+    {0xebff, -15}, {0x56e8, -71}, {0xf277, -25}, {0xf479, -10}, {0x2e92, -70},
+    {0xc4ff, -92}, {0xc351, -55}, {0xc3ff, -92}, {0xc14f, -55}, {0x929a, -55},
+    {0x55c3, -40}, {0x4cdd, -100}, {0x57d4, -10}, {0x57ed, -40}, {0x20c2, -55},
+    {0x543a, -50}, {0x52dc, -40}, {0x52d2, -40}, {0x63ff, -15}, {0x56f4, -129},
+    {0x9274, -18}, {0xd559, -50}, {0xe779, -15}, {0x52d4, -40}, {0xd3c1, -35},
+    {0xc457, -90}, {0x54d4, -18}, {0xdd69, -55}, {0x50e3, -15}, {0x4159, -105},
+    {0x4c57, -74}, {0xa0c3, -55}, {0xc4d5, -55}, {0xf876, -15}, {0xc379, -92},
+    {0x56c2, -135}, {0x5041, -92}, {0x54c1, -93}, {0xddeb, -60},
+    {0xdd2c, -129}, {0x56fa, -75}, {0x77e5, -10}, {0xc357, -90}, {0x50e5, -15},
+    {0x926c, -10}, {0x54f3, -80}, {0x4157, -90}, {0x54d2, -18}, {0x4fdd, -50},
+    {0xc5db, -55}, {0xf6fd, -10}, {0x6f76, -15}, {0x66e2, -10}, {0xc0d3, -55},
+    {0xc5dd, -105}, {0xd458, -40}, {0xd941, -40}, {0x9ff8, -110},
+    {0xff2c, -65}, {0x54f8, -80}, {0x449f, -55}, {0xc055, -55}, {0x42c3, -35},
+    {0xef76, -25}, {0x54e1, -80}, {0x502c, -111}, {0x57fb, -50}, {0xdac1, -40},
+    {0xc292, -111}, {0x2c94, -70}, {0x76f5, -20}, {0x54d6, -18}, {0xc151, -55},
+    {0x5259, -65}, {0xd9c0, -40}, {0x57d3, -10}, {0xd658, -40}, {0xa0c0, -55},
+    {0xc1d9, -55}, {0x4bfa, -15}, {0x54f9, -45}, {0x6be8, -10}, {0x56e0, -71},
+    {0xdcc0, -40}, {0xc2d3, -55}, {0x54ea, -70}, {0xf379, -10}, {0xc1dd, -105},
+    {0xdd41, -120}, {0x4cfd, -55}, {0x5255, -40}, {0xc176, -74}, {0xd3c0, -35},
+    {0x54c5, -93}, {0x41db, -55}, {0xa059, -90}, {0x76e2, -25}, {0xe9fd, -15},
+    {0xd358, -40}, {0x6879, -5}, {0x62fa, -20}, {0x5541, -40}, {0x9292, -74},
+    {0xdde3, -60}, {0x9f41, -120}, {0x54e3, -40}, {0x9341, -80}, {0x6b6f, -10},
+    {0x6976, -25}, {0x54e2, -80}, {0x9fea, -100}, {0x56ec, -20}, {0x76f3, -20},
+    {0x57f8, -80}, {0x50c0, -92}, {0xd6c3, -35}, {0x92a0, -74}, {0xc4fd, -92},
+    {0xc156, -135}, {0x52da, -40}, {0x4bf3, -35}, {0xd6c5, -35}, {0xc3d8, -55},
+    {0xd49f, -50}, {0x56d2, -40}, {0x572c, -92}, {0xdcc2, -40}, {0x76e1, -25},
+    {0xc1d3, -55}, {0x56e2, -71}, {0x5941, -120}, {0x9f4f, -30}, {0x6579, -15},
+    {0x4fc3, -35}, {0xc0fd, -92}, {0x9f2d, -111}, {0x5961, -100},
+    {0x59e4, -60}, {0x59e1, -100}, {0x77e1, -10}, {0xc276, -74}, {0x78e9, -15},
+    {0xa0c4, -55}, {0xc1db, -55}, {0x44c2, -40}, {0x59e5, -100},
+    {0x9ffa, -111}, {0x4147, -40}, {0x67e2, -5}, {0x6efd, -15}, {0xe977, -25},
+    {0xc1d6, -55}, {0x59e8, -60}, {0x419f, -105}, {0xc1fd, -92},
+    {0x9fe5, -100}, {0xd69f, -50}, {0x502e, -111}, {0x46f5, -15},
+    {0xdd4f, -30}, {0x41fd, -92}, {0x42d9, -10}, {0xc179, -92}, {0xdde5, -100},
+    {0x41d4, -55}, {0xeb79, -15}, {0x4bf5, -35}, {0xdbc4, -40}, {0x593a, -92},
+    {0xd5c0, -35}, {0x54f4, -80}, {0x9fc1, -120}, {0x9fd4, -30}, {0x54c4, -93},
+    {0xc1ff, -92}, {0xf577, -25}, {0xd6c4, -35}, {0xf679, -10}, {0x46e2, -15},
+    {0x67e0, -5}, {0x2e94, -70}, {0x57e1, -80}, {0xf3ff, -10}, {0x52d6, -40},
+    {0x56e3, -71}, {0xdcc5, -40}, {0x9feb, -60}, {0x4151, -55},
+};
+
+static const struct kern_table times_kerns = {
+    times_kern_seeds,
+    times_kern_pairs,
+    256,
+    1019,
+    {0x00, 0x00, 0x00, 0x00, 0x01, 0x50, 0x00, 0x00, 0x56, 0xdc, 0xf7,
+     0x02, 0xee, 0xdb, 0xc5, 0x03, 0x00, 0x00, 0x0e, 0x80, 0x01, 0x00,
+     0x00, 0x00, 0x3f, 0x00, 0x7e, 0x3f, 0xbf, 0xff, 0x7e, 0xa1},
+};
+
+static const uint16_t times_bold_kern_seeds[512] = {
+    1, 2, 4, 2, 4, 1, 13, 15, 7, 9, 1, 2, 1, 44, 23, 13, 10, 6, 2, 13, 14, 10,
+    0, 5, 5, 6, 2, 2, 5, 1, 11, 1, 2, 5, 20, 6, 0, 2, 1, 2, 10, 2, 2, 1, 2, 13,
+    2, 14, 8, 6, 9, 2, 18, 0, 1, 0, 1, 5, 2, 1, 2, 13, 3, 8, 3, 0, 3, 4, 4, 15,
+    6, 6, 1, 10, 10, 10, 0, 5, 1, 0, 13, 2, 0, 1, 6, 1, 7, 28, 5, 10, 9, 1, 1,
+    7, 8, 12, 1, 11, 50, 1, 7, 5, 12, 5, 1, 0, 11, 3, 1, 0, 2, 0, 11, 11, 22,
+    33, 3, 5, 1, 8, 6, 1, 39, 1, 21, 0, 0, 2, 19, 2, 3, 10, 5, 4, 0, 14, 7, 13,
+    0, 16, 10, 4, 2, 0, 9, 0, 4, 4, 12, 3, 3, 2, 0, 4, 4, 4, 26, 19, 1, 13, 0,
+    4, 8, 29, 4, 1, 5, 22, 6, 2, 6, 13, 1, 1, 2, 0, 5, 28, 12, 35, 7, 1, 3, 22,
+    5, 7, 27, 0, 1, 18, 14, 0, 2, 1, 0, 21, 25, 9, 2, 1, 3, 18, 0, 4, 4, 0, 12,
+    2, 16, 1, 19, 0, 4, 22, 0, 13, 0, 3, 0, 7, 4, 1, 24, 12, 10, 3, 7, 0, 7, 2,
+    21, 13, 9, 16, 15, 2, 0, 54, 4, 22, 3, 3, 20, 37, 5, 1, 6, 3, 0, 0, 0, 15,
+    6, 0, 1, 8, 5, 33, 12, 1, 9, 4, 8, 13, 67, 1, 2, 6, 0, 10, 1, 0, 7, 2, 57,
+    4, 2, 13, 0, 16, 23, 20, 30, 0, 0, 19, 19, 0, 6, 5, 0, 0, 2, 52, 78, 2, 59,
+    1, 7, 0, 13, 7, 0, 13, 10, 4, 1, 0, 1, 2, 12, 28, 2, 42, 2, 0, 6, 12, 3, 6,
+    0, 3, 1, 5, 19, 0, 0, 6, 0, 4, 22, 8, 14, 8, 2, 38, 6, 5, 8, 4, 5, 0, 6, 2,
+    57, 3, 8, 0, 14, 51, 2, 2, 10, 23, 2, 44, 3, 31, 5, 2, 4, 0, 11, 5, 41, 51,
+    0, 1, 32, 23, 25, 20, 13, 1, 18, 3, 1, 0, 12, 7, 45, 1, 75, 1, 0, 1, 16,
+    23, 14, 38, 13, 8, 20, 1, 10, 1, 1, 37, 1, 56, 14, 1, 26, 6, 90, 4, 181,
+    22, 24, 8, 0, 12, 4, 2, 35, 1, 6, 34, 136, 8, 0, 121, 0, 1, 135, 41, 7, 6,
+    177, 0, 58, 1, 9, 8, 11, 8, 21, 46, 3, 109, 23, 14, 12, 0, 0, 0, 5, 0, 16,
+    0, 2, 32, 4, 30, 23, 113, 1, 40, 0, 13, 73, 9, 2, 82, 4, 73, 1, 13, 0, 19,
+    10, 400, 121, 14, 16, 41, 54, 0, 50, 106, 15, 10, 198, 29, 16, 11, 12, 445,
+    6, 103, 0, 13, 112, 78, 88, 39, 64, 1, 10, 14, 52, 25, 0, 84, 8, 39, 1, 2,
+    25, 1077, 141, 14,
+};
+
+static const struct kern_pair times_bold_kern_pairs[1080] = {
+    {0x593b, -92}, {0x776f, -10}, {0x9ff9, -92}, {0x4c54, -92}, {0x5041, -74},
+    {0xc177, -90}, {0x79eb, -10}, {0x4f58, -40}, {0xc192, -74}, {0xc051, -45},
+    {0x41fa, -50}, {0x592e, -92}, {0x4ec3, -20}, {0xc3c7, -55}, {0x56f3, -100},
+    {0x42c5, -30}, {0x50e0, -10}, {0x55c4, -60}, {0xc292, -74}, {0x4a65, -15},
+    {0x51db, -10}, {0xc2c7, -55}, {0x6bf2, -15}, {0x42d9, -10}, {0x572c, -92},
+    {0x56e5, -92}, {0xd6dd, -50}, {0x52d8, -30}, {0x462e, -110}, {0x4ec4, -20},
+    {0xc3db, -50}, {0x59c4, -110}, {0xc447, -55}, {0xc4d9, -50}, {0xdd3a, -92},
+    {0xc2fb, -50}, {0xc356, -145}, {0x5256, -55}, {0x54c4, -90}, {0xc275, -50},
+    {0xc257, -130}, {0xd5c3, -40}, {0x9fe4, -85}, {0x56f6, -100},
+    {0x93c2, -10}, {0x593a, -92}, {0x573a, -55}, {0x542d, -92}, {0x50f5, -20},
+    {0xd5c0, -40}, {0x59d6, -35}, {0x5779, -60}, {0x542c, -74}, {0xc277, -90},
+    {0xc575, -50}, {0xc04f, -45}, {0x4afb, -15}, {0xc1f9, -50}, {0xa0c5, -55},
+    {0xfde8, -10}, {0x5259, -35}, {0xd6c1, -40}, {0x9fd8, -35}, {0x6176, -25},
+    {0xdded, -37}, {0xc19f, -100}, {0x5061, -10}, {0x54e2, -52}, {0x52d3, -30},
+    {0x72f3, -18}, {0x9f65, -111}, {0x72ad, -37}, {0xc49f, -100},
+    {0xdbc3, -60}, {0x41d2, -45}, {0x6be8, -10}, {0x2054, -30}, {0x59f4, -111},
+    {0xf576, -10}, {0x44c0, -35}, {0x4cff, -55}, {0x9191, -63}, {0x46c2, -90},
+    {0x54ed, -18}, {0x56d6, -45}, {0x50e9, -20}, {0xc0c7, -55}, {0x57eb, -65},
+    {0xc354, -95}, {0x50c1, -74}, {0x5761, -65}, {0x59f2, -111}, {0xd1c3, -20},
+    {0xdde1, -85}, {0x56e1, -92}, {0x9fe8, -71}, {0x9272, -20}, {0x56fb, -92},
+    {0xfdeb, -10}, {0xc547, -55}, {0xc5fa, -50}, {0x54d2, -18}, {0x594f, -35},
+    {0xc0d3, -45}, {0x4ae9, -15}, {0x5255, -30}, {0x46c1, -90}, {0x93c1, -10},
+    {0xd9c0, -60}, {0x4bfa, -15}, {0x442e, -20}, {0x76e8, -10}, {0x9ffb, -92},
+    {0x6bf5, -15}, {0xc057, -130}, {0xc5db, -50}, {0xc1fc, -50}, {0x54ad, -92},
+    {0x59e2, -85}, {0x57e4, -65}, {0x54f5, -92}, {0xdc41, -60}, {0x766f, -10},
+    {0x6576, -15}, {0x76e1, -10}, {0xd554, -40}, {0xc579, -74}, {0xdd65, -111},
+    {0xc5dc, -50}, {0x4a75, -15}, {0xc3ff, -74}, {0xc5d6, -45}, {0xc551, -45},
+    {0x42db, -10}, {0x51da, -10}, {0x6beb, -10}, {0xd59f, -50}, {0xd9c4, -60},
+    {0x54ea, -92}, {0x4bf4, -25}, {0xc070, -25}, {0x9ff3, -111}, {0x722c, -92},
+    {0xda2e, -50}, {0x4ec1, -20}, {0xc4da, -50}, {0x54e3, -52}, {0x56eb, -100},
+    {0x54ff, -34}, {0x9fc5, -110}, {0x4ae8, -15}, {0xc59f, -100},
+    {0xd4c2, -40}, {0x42c1, -30}, {0x59e9, -111}, {0x57c1, -120},
+    {0x6262, -10}, {0x56e0, -92}, {0xd8c2, -40}, {0x54f2, -92}, {0x57ff, -60},
+    {0x9ff4, -111}, {0x76f5, -10}, {0xdde3, -85}, {0x4af5, -15}, {0xd9c2, -60},
+    {0x6bf8, -15}, {0x9fd4, -35}, {0x72f6, -18}, {0xdd75, -92}, {0x5669, -37},
+    {0x4bd2, -30}, {0x9fd6, -35}, {0x76e4, -10}, {0xd354, -40}, {0x4177, -90},
+    {0xdde8, -71}, {0xc557, -130}, {0xc4d3, -45}, {0xc4d4, -45}, {0x4441, -35},
+    {0x9fe0, -85}, {0xc176, -100}, {0x57fa, -50}, {0xc276, -100},
+    {0xc4f9, -50}, {0xc043, -55}, {0xd1c4, -20}, {0x57c4, -120}, {0x4ac4, -30},
+    {0x59f9, -92}, {0xc1d8, -45}, {0x77f4, -10}, {0xc1dc, -50}, {0x57e1, -65},
+    {0x57c0, -120}, {0xd2c4, -40}, {0xfdf5, -25}, {0x59eb, -71}, {0xfff5, -25},
+    {0xc1da, -50}, {0xddc3, -110}, {0x2041, -55}, {0x54fc, -92}, {0xc2f9, -50},
+    {0x4661, -25}, {0xd9c1, -60}, {0xd559, -50}, {0x9f69, -37}, {0xd541, -40},
+    {0x46f3, -25}, {0xdde4, -85}, {0x9ff8, -111}, {0x54c1, -90}, {0x46f5, -25},
+    {0x4b65, -25}, {0x57d8, -10}, {0x79ea, -10}, {0x9fd3, -35}, {0x57e9, -65},
+    {0x6bfd, -15}, {0x46c4, -90}, {0xd5c4, -40}, {0x42c0, -30}, {0xc351, -45},
+    {0x4fc2, -40}, {0xdac4, -60}, {0x56ec, -37}, {0x4fc1, -40}, {0xc34f, -45},
+    {0x543b, -74}, {0x54f9, -92}, {0x5257, -35}, {0xddc5, -110},
+    {0xdde9, -111}, {0xc5da, -50}, {0x4afa, -15}, {0x5769, -18}, {0xd254, -40},
+    {0x2e94, -55}, {0xc1d6, -45}, {0x46c5, -90}, {0x54c5, -90}, {0x44c5, -35},
+    {0x552e, -50}, {0xc359, -100}, {0xd241, -40}, {0xe176, -25}, {0x4bf9, -15},
+    {0xc2fd, -74}, {0xc3fc, -50}, {0x672e, -15}, {0xc1d3, -45}, {0x4af2, -15},
+    {0x9292, -63}, {0x54fd, -34}, {0xdbc2, -60}, {0x56fa, -92}, {0xc2da, -50},
+    {0xfff2, -25}, {0x50e2, -10}, {0xc270, -25}, {0x4b6f, -25}, {0xdd6f, -111},
+    {0xc3d9, -50}, {0xdac2, -60}, {0xc255, -50}, {0x59fa, -92}, {0x5975, -92},
+    {0xa0c2, -55}, {0x6275, -20}, {0x66f4, -25}, {0x76f6, -10}, {0xdc2e, -50},
+    {0x574f, -10}, {0x59e0, -85}, {0x46f8, -25}, {0xd257, -50}, {0xdac0, -60},
+    {0x41d5, -45}, {0xc092, -74}, {0xe576, -25}, {0x564f, -45}, {0x41ff, -74},
+    {0x5541, -60}, {0x72f4, -18}, {0x91c1, -10}, {0x2059, -55}, {0x4bf8, -25},
+    {0xdcc4, -60}, {0x56c3, -135}, {0x5665, -100}, {0x54fb, -92},
+    {0xc243, -55}, {0x57e3, -65}, {0x4456, -40}, {0xc2d5, -45}, {0xd557, -50},
+    {0xd659, -50}, {0x6669, -25}, {0xc2db, -50}, {0x9fe1, -85}, {0xc0db, -50},
+    {0x9273, -37}, {0xc0fd, -74}, {0x9fd5, -35}, {0x56d3, -45}, {0x9fe2, -85},
+    {0x6e76, -40}, {0x56c1, -135}, {0x792e, -70}, {0x5941, -110},
+    {0xfde9, -10}, {0xa09f, -55}, {0xd258, -40}, {0x46e3, -25}, {0x4f56, -50},
+    {0x5675, -92}, {0x59fc, -92}, {0xc0ff, -74}, {0x62f9, -20}, {0xdbc1, -60},
+    {0x56f5, -100}, {0x4176, -100}, {0x93c0, -10}, {0xd3c2, -40},
+    {0x4ec5, -20}, {0xd454, -40}, {0x4c59, -92}, {0x4c79, -55}, {0xc2d4, -45},
+    {0xc24f, -45}, {0x6bf3, -15}, {0x4179, -74}, {0xc159, -100}, {0x4ac2, -30},
+    {0xf476, -10}, {0xc357, -130}, {0x4a61, -15}, {0x54e5, -92}, {0xc2dc, -50},
+    {0x4bf3, -25}, {0x41d8, -45}, {0x41d9, -50}, {0x6bf6, -15}, {0xe376, -25},
+    {0x59e4, -85}, {0x57d6, -10}, {0xc2d2, -45}, {0xed76, -10}, {0x41fd, -74},
+    {0xddc1, -110}, {0x4cdd, -92}, {0x50e5, -10}, {0x2057, -30}, {0x792c, -55},
+    {0xddd6, -35}, {0x59c0, -110}, {0x4afc, -15}, {0xc44f, -45}, {0x56d5, -45},
+    {0x55c1, -60}, {0x57f3, -75}, {0xef76, -10}, {0x4bd5, -30}, {0xd657, -50},
+    {0xdcc3, -60}, {0x4e41, -20}, {0x4ae0, -15}, {0xda41, -60}, {0x76f4, -10},
+    {0xe276, -25}, {0xfdf4, -25}, {0x4ae1, -15}, {0x5475, -92}, {0xc2d9, -50},
+    {0xddd5, -35}, {0x6bff, -15}, {0x4bd8, -30}, {0xc370, -25}, {0x42dc, -10},
+    {0xc29f, -100}, {0xc5d4, -45}, {0xc0d9, -50}, {0xd858, -40}, {0xc475, -50},
+    {0x563a, -92}, {0x4f54, -40}, {0x9fc2, -110}, {0x91c2, -10}, {0x4bff, -45},
+    {0xd841, -40}, {0xc0dd, -100}, {0xf277, -10}, {0xc455, -50}, {0x4ae2, -15},
+    {0x79f3, -25}, {0xe976, -15}, {0x4ac3, -30}, {0xc0dc, -50}, {0xc3f9, -50},
+    {0x50c3, -74}, {0x56d8, -45}, {0xffe9, -10}, {0x6f76, -10}, {0x59d3, -35},
+    {0xd441, -40}, {0xd641, -40}, {0xc1d5, -45}, {0xddc4, -110}, {0xa041, -55},
+    {0x56ef, -37}, {0xc3d8, -45}, {0x41d6, -45}, {0x57d4, -10}, {0x59c3, -110},
+    {0xd356, -50}, {0xc1fb, -50}, {0xdb2e, -50}, {0xc4d2, -45}, {0x6bf4, -15},
+    {0xddf9, -92}, {0xd3c1, -40}, {0xd941, -60}, {0xc3fb, -50}, {0xf676, -10},
+    {0xd457, -50}, {0xa0c4, -55}, {0x54eb, -52}, {0x9264, -20}, {0x42c2, -30},
+    {0xc5d2, -45}, {0xc457, -130}, {0x7267, -10}, {0x46f4, -25}, {0x59fb, -92},
+    {0x5254, -40}, {0x7271, -18}, {0xd29f, -50}, {0xd656, -50}, {0x4f9f, -50},
+    {0xc3d6, -45}, {0x9ffc, -92}, {0x56ee, -37}, {0xc256, -145}, {0x50c4, -74},
+    {0x51d9, -10}, {0x9f61, -85}, {0xc154, -95}, {0xd3c5, -40}, {0x62fa, -20},
+    {0x546f, -92}, {0xc3d3, -45}, {0x4fdd, -50}, {0x59d8, -35}, {0x7661, -10},
+    {0x542e, -90}, {0xdd2c, -92}, {0xfd2e, -70}, {0x6bea, -10}, {0x529f, -35},
+    {0xc3fd, -74}, {0xc179, -74}, {0xa0c0, -55}, {0x9276, -20}, {0x4fc0, -40},
+    {0x57fc, -50}, {0x46ea, -25}, {0x55c0, -60}, {0xdac3, -60}, {0x7276, -10},
+    {0x76e9, -10}, {0xc5ff, -74}, {0xd39f, -50}, {0x41fb, -50}, {0xd2c5, -40},
+    {0x4af4, -15}, {0x56f9, -92}, {0x4f57, -50}, {0x66f8, -25}, {0x52d4, -30},
+    {0xfd6f, -25}, {0x4cfd, -55}, {0x2e92, -55}, {0x563b, -92}, {0x54d8, -18},
+    {0x419f, -100}, {0x57f6, -75}, {0x9220, -74}, {0x44c3, -35}, {0x79e8, -10},
+    {0x20dd, -55}, {0x54e1, -92}, {0x2c94, -45}, {0x6b6f, -15}, {0xc5f9, -50},
+    {0xddad, -92}, {0xc2ff, -74}, {0x52d9, -30}, {0xc1d4, -45}, {0x20c1, -55},
+    {0x46f2, -25}, {0x41db, -50}, {0x56e4, -92}, {0x50e8, -20}, {0xd89f, -50},
+    {0xc4fa, -50}, {0xc2d6, -45}, {0x9f4f, -35}, {0x59c5, -110}, {0x4147, -55},
+    {0xd654, -40}, {0xd1c2, -20}, {0xd259, -50}, {0x55c2, -60}, {0x4c57, -92},
+    {0xd92e, -50}, {0xee76, -10}, {0x4b4f, -30}, {0x52db, -30}, {0x4be8, -25},
+    {0xc059, -100}, {0xc2d8, -45}, {0xc0da, -50}, {0x4af9, -15}, {0x57d2, -10},
+    {0xc0d6, -45}, {0x54d5, -18}, {0x72eb, -18}, {0xdbc4, -60}, {0xd458, -40},
+    {0xc554, -95}, {0x59ea, -111}, {0xd3c3, -40}, {0x62fc, -20},
+    {0xc156, -145}, {0xfff8, -25}, {0x46f6, -25}, {0x5741, -120},
+    {0x56ea, -100}, {0x50eb, -20}, {0x54fa, -92}, {0x56fc, -92}, {0x91c5, -10},
+    {0x66f3, -25}, {0x4641, -90}, {0x4bd4, -30}, {0x72f8, -18}, {0xc143, -55},
+    {0xd5c1, -40}, {0x77f5, -10}, {0x722e, -100}, {0xfdf6, -25}, {0xddfc, -92},
+    {0xc0fb, -50}, {0xfff6, -25}, {0x52d5, -30}, {0xc2fc, -50}, {0x76f2, -10},
+    {0xd8dd, -50}, {0xc5fd, -74}, {0x4ac1, -30}, {0xd8c4, -40}, {0x506f, -20},
+    {0x46e0, -25}, {0x6976, -10}, {0x5661, -92}, {0x9fe9, -111}, {0x5961, -85},
+    {0x9fad, -92}, {0xd6c2, -40}, {0x726e, -15}, {0xc5d5, -45}, {0x4bd3, -30},
+    {0x57f4, -75}, {0x44c1, -35}, {0x4ae5, -15}, {0x59d4, -35}, {0xc5d3, -45},
+    {0x4aeb, -15}, {0x44c4, -35}, {0xdac5, -60}, {0xc347, -55}, {0x622e, -40},
+    {0x4f41, -40}, {0xc375, -50}, {0x54f6, -92}, {0xddf3, -111}, {0xe076, -25},
+    {0x5765, -65}, {0x50e1, -10}, {0xc1d2, -45}, {0x6692, 55}, {0x52d6, -30},
+    {0xdcc1, -60}, {0xc555, -50}, {0x592c, -92}, {0xc3dc, -50}, {0xdd61, -85},
+    {0xc2d3, -45}, {0x54f3, -92}, {0x4af3, -15}, {0x6be9, -10}, {0x57e5, -65},
+    {0xc355, -50}, {0xc251, -45}, {0x4157, -130}, {0x79f6, -25}, {0x20c3, -55},
+    {0x596f, -111}, {0x4ec0, -20}, {0xc5dd, -100}, {0x552c, -50},
+    {0xea76, -15}, {0xc4d6, -45}, {0x79e9, -10}, {0xd2c1, -40}, {0x46c3, -90},
+    {0xfd65, -10}, {0x4ac5, -30}, {0xc4fb, -50}, {0x576f, -75}, {0xd857, -50},
+    {0xdc2c, -50}, {0xfdf2, -25}, {0xc577, -90}, {0x72f5, -18}, {0xc4c7, -55},
+    {0x72e8, -18}, {0x9fc1, -110}, {0x414f, -45}, {0x77f2, -10},
+    {0xc559, -100}, {0xd5c2, -40}, {0xd5dd, -50}, {0x57fb, -50},
+    {0x4156, -145}, {0x562d, -74}, {0x4ae4, -15}, {0x56c4, -135},
+    {0xddd8, -35}, {0xd359, -50}, {0xc279, -74}, {0xddfb, -92}, {0x79f2, -25},
+    {0xd859, -50}, {0x76e3, -10}, {0xc2fa, -50}, {0xf276, -10}, {0xc576, -100},
+    {0x54c3, -90}, {0xd6c3, -40}, {0x91c4, -10}, {0x4bf2, -25}, {0xd856, -50},
+    {0x54f8, -92}, {0xff2c, -55}, {0xd8c0, -40}, {0xd8c1, -40}, {0xc392, -74},
+    {0x9f2c, -92}, {0x54e8, -52}, {0xffe8, -10}, {0xc1ff, -74}, {0x4665, -25},
+    {0xc556, -145}, {0x59d5, -35}, {0x62fb, -20}, {0xdd3b, -92}, {0x6477, -15},
+    {0x5647, -30}, {0xc247, -55}, {0xc3d2, -45}, {0xfd2c, -55}, {0x4c56, -92},
+    {0xdbc5, -60}, {0x4457, -40}, {0x79f4, -25}, {0x4f59, -50}, {0x9f6f, -111},
+    {0x56c0, -135}, {0x5461, -92}, {0x4175, -50}, {0x42c4, -30}, {0xf877, -10},
+    {0xc0d8, -45}, {0x4bfb, -15}, {0xc343, -55}, {0x512e, -20}, {0xa0c3, -55},
+    {0x44dd, -40}, {0xdde2, -85}, {0xc0d5, -45}, {0x72e7, -18}, {0xdcc0, -60},
+    {0x4192, -74}, {0x57e0, -65}, {0x55c3, -60}, {0x524f, -30}, {0x6b79, -15},
+    {0x5465, -92}, {0x5969, -37}, {0x59c2, -110}, {0x54c2, -90}, {0x72f2, -18},
+    {0xa054, -30}, {0xc492, -74}, {0x50f8, -20}, {0x41da, -50}, {0xd141, -20},
+    {0x46e1, -25}, {0x5441, -90}, {0x56d4, -45}, {0xd4c0, -40}, {0xfdea, -10},
+    {0x76f8, -10}, {0xc377, -90}, {0x54c0, -90}, {0xdb2c, -50}, {0xc454, -95},
+    {0xd6c0, -40}, {0xc5c7, -55}, {0xc4fc, -50}, {0xa0c1, -55}, {0xd358, -40},
+    {0xd2c3, -40}, {0xc543, -55}, {0x4be9, -25}, {0x57c5, -120},
+    {0x566f, -100}, {0x54e4, -52}, {0x41c7, -55}, {0xa057, -30}, {0xe876, -15},
+    {0xd6c4, -40}, {0x50ea, -20}, {0x4fc5, -40}, {0x54d4, -18}, {0x76ea, -10},
+    {0xff6f, -25}, {0x562c, -129}, {0xc1fa, -50}, {0x46e8, -25}, {0x772e, -70},
+    {0xdcc2, -60}, {0xd556, -50}, {0x76e2, -10}, {0x4143, -55}, {0xc155, -50},
+    {0x46e4, -25}, {0x4459, -40}, {0xa0dd, -55}, {0x57f5, -75}, {0x4ec2, -20},
+    {0x4255, -10}, {0xd92c, -50}, {0x4ac0, -30}, {0x50f4, -20}, {0xd4c4, -40},
+    {0xd3c0, -40}, {0x4bea, -25}, {0xc1d9, -50}, {0x9fed, -37}, {0xfff4, -25},
+    {0x77f8, -10}, {0x56ad, -74}, {0x77f6, -10}, {0xd5c5, -40}, {0xd357, -50},
+    {0x4159, -100}, {0x50f2, -20}, {0xd256, -50}, {0x56c5, -135},
+    {0x772c, -55}, {0x4241, -30}, {0xd9c3, -60}, {0x57f9, -50}, {0x2056, -45},
+    {0xc0fa, -50}, {0x929a, -37}, {0xc4fd, -74}, {0x6276, -15}, {0x4a41, -30},
+    {0xc0f9, -50}, {0x57ad, -37}, {0x7665, -10}, {0xc3fa, -50}, {0xd1c0, -20},
+    {0x41fc, -50}, {0x68fd, -15}, {0x56d2, -45}, {0xd4c5, -40}, {0x9fea, -111},
+    {0x662c, -15}, {0x59c1, -110}, {0xdd41, -110}, {0xdde0, -85},
+    {0x46e9, -25}, {0x76eb, -10}, {0x91c0, -10}, {0x562e, -145}, {0xdd2d, -92},
+    {0x5065, -20}, {0x9341, -10}, {0x2c92, -55}, {0xf677, -10}, {0x54d3, -18},
+    {0x50c2, -74}, {0x573b, -55}, {0xc39f, -100}, {0x209f, -55}, {0xff2e, -70},
+    {0xdd2e, -92}, {0x4c9f, -92}, {0x51dc, -10}, {0xddea, -111}, {0xf577, -10},
+    {0xf477, -10}, {0xc254, -95}, {0x57ea, -65}, {0xdd4f, -35}, {0xddf6, -111},
+    {0x9ffa, -92}, {0x7265, -18}, {0xc54f, -45}, {0xd854, -40}, {0x59e8, -71},
+    {0x592d, -92}, {0xc055, -50}, {0xddfa, -92}, {0xdde5, -85}, {0x50c0, -74},
+    {0xc1c7, -55}, {0x46c0, -90}, {0xc170, -25}, {0x5469, -18}, {0xd4dd, -50},
+    {0x4ae3, -15}, {0xd2dd, -50}, {0x9fe5, -85}, {0xc09f, -100},
+    {0x59f6, -111}, {0xf876, -10}, {0x56f2, -100}, {0xdd69, -37},
+    {0xd8c5, -40}, {0x572d, -37}, {0x76e5, -10}, {0x9ff6, -111}, {0xc175, -50},
+    {0x59f8, -111}, {0x5155, -10}, {0x46eb, -25}, {0xc0d2, -45}, {0x59ad, -92},
+    {0x4af8, -15}, {0x41d3, -45}, {0x726f, -18}, {0x46e2, -25}, {0xddf5, -111},
+    {0x72ea, -18}, {0x7270, -10}, {0xddeb, -71}, {0xc3da, -50}, {0x722d, -37},
+    {0x9f75, -92}, {0x46e5, -25}, {0xc4db, -50}, {0xd3c4, -40}, {0xc477, -90},
+    {0x54e9, -92}, {0x4b75, -15}, {0xc451, -45}, {0xd2c0, -40}, {0x796f, -25},
+    {0xc5d9, -50}, {0x52dc, -30}, {0x93c5, -10}, {0x9f41, -110}, {0x57e2, -65},
+    {0x5965, -111}, {0xd1c1, -20}, {0x56f4, -100}, {0x76f3, -10},
+    {0x56e8, -100}, {0x9fc0, -110}, {0x4beb, -25}, {0xc1dd, -100},
+    {0x59e5, -85}, {0xc14f, -45}, {0x57c3, -120}, {0x6f77, -10}, {0x50c5, -74},
+    {0x57ed, -18}, {0x57d5, -10}, {0xfdf3, -25}, {0x662e, -15}, {0xc5fc, -50},
+    {0x7263, -18}, {0x52d2, -30}, {0xc157, -130}, {0x5477, -74}, {0xffeb, -10},
+    {0xc5fb, -50}, {0xc1fd, -74}, {0x4a6f, -15}, {0x41d4, -45}, {0x66f6, -25},
+    {0x543a, -74}, {0x4fc3, -40}, {0x50e3, -10}, {0x41f9, -50}, {0xc075, -50},
+    {0xd4c3, -40}, {0xeb76, -15}, {0xc054, -95}, {0xf377, -10}, {0xc379, -74},
+    {0x4b79, -45}, {0x9f3a, -92}, {0xdac1, -60}, {0x41dd, -100}, {0xda2c, -50},
+    {0x9f2e, -92}, {0xff65, -10}, {0x20c4, -55}, {0xfdf8, -25}, {0x56ed, -37},
+    {0x466f, -25}, {0xc3dd, -100}, {0x4bd6, -30}, {0x56e9, -100},
+    {0x50e4, -10}, {0x6694, 50}, {0xddf2, -111}, {0x572e, -92}, {0xdb41, -60},
+    {0x20c0, -55}, {0xffea, -10}, {0xf176, -40}, {0x4155, -50}, {0xddd3, -35},
+    {0x59f5, -111}, {0xddc0, -110}, {0xc443, -55}, {0xd1c5, -20},
+    {0xc376, -100}, {0x4fc4, -40}, {0x50f3, -20}, {0x57c2, -120},
+    {0x502c, -92}, {0xddd4, -35}, {0x56c2, -135}, {0x59ed, -37}, {0x4bfd, -45},
+    {0xc077, -90}, {0x54d6, -18}, {0xc151, -45}, {0xd8c3, -40}, {0x4154, -95},
+    {0xc0fc, -50}, {0x57d3, -10}, {0x79f5, -25}, {0x76e0, -10}, {0xd49f, -50},
+    {0xec76, -10}, {0x55c5, -60}, {0x59f3, -111}, {0x762e, -70}, {0xc5d8, -45},
+    {0xc3d5, -45}, {0x42c3, -30}, {0xddf8, -111}, {0x57f2, -75}, {0x59e3, -85},
+    {0x462c, -92}, {0x42da, -10}, {0xc0d4, -45}, {0xc4d5, -45}, {0x762c, -55},
+    {0xc047, -55}, {0x77f3, -10}, {0xa059, -55}, {0x59d2, -35}, {0xd4c1, -40},
+    {0x66f5, -25}, {0xf376, -10}, {0xc1db, -50}, {0x57e8, -65}, {0x9fc3, -110},
+    {0xc4dc, -50}, {0x93c3, -10}, {0xd459, -50}, {0xc079, -74}, {0x5641, -135},
+    {0x544f, -18}, {0x4bf6, -25}, {0x57fd, -60}, {0x66f2, -25}, {0xddf4, -111},
+    {0x57f8, -75}, {0x9fd2, -35}, {0xd3dd, -50}, {0x68ff, -15}, {0x52dd, -35},
+    {0xc259, -100}, {0xd341, -40}, {0x52da, -30}, {0x5775, -50}, {0xd6c5, -40},
+    {0x4aea, -15}, {0xc459, -100}, {0xddc2, -110}, {0x4c94, -20},
+    {0xc479, -74}, {0x9fe3, -85}, {0xc4d8, -45}, {0x20c5, -55}, {0x56e2, -92},
+    {0x5472, -74}, {0x56f8, -100}, {0x6b65, -10}, {0xc570, -25}, {0x54e0, -52},
+    {0x9f3b, -92}, {0xa056, -45}, {0x9141, -10}, {0x59e1, -85}, {0xd69f, -50},
+    {0xd558, -40}, {0x4bf5, -25}, {0xc592, -74}, {0xc056, -145}, {0x44c2, -35},
+    {0x666f, -25}, {0xfff3, -25}, {0x56e3, -92}, {0x72e9, -18}, {0x79f8, -25},
+    {0x93c4, -10}, {0xe476, -25}, {0xc456, -145}, {0xddd2, -35}, {0x7965, -10},
+    {0xc076, -100}, {0xdbc0, -60}, {0x5479, -34}, {0x502e, -110},
+    {0xd456, -50}, {0x9fc4, -110}, {0xd658, -40}, {0x41dc, -50}, {0x6879, -15},
+    {0xd2c2, -40}, {0xc470, -25}, {0x20c2, -55}, {0x4bfc, -15}, {0x50f6, -20},
+    {0x4a2e, -20}, {0x449f, -40}, {0x9ff5, -111}, {0x54f4, -92},
+    {0xc2dd, -100}, {0x4c92, -110}, {0xc4ff, -74}, {0xc3d4, -45},
+    {0x9f2d, -92}, {0x91c3, -10}, {0xc4dd, -100}, {0x9ff2, -111},
+    {0xc147, -55}, {0x72f1, -15}, {0x4170, -25}, {0x92a0, -74}, {0xd9c5, -60},
+    {0xc476, -100}, {0x4af6, -15}, {0xdcc5, -60}, {0x9feb, -71}, {0x4151, -45},
+};
+
+static const struct kern_table times_bold_kerns = {
+    times_bold_kern_seeds,
+    times_bold_kern_pairs,
+    512,
+    1080,
+    {0x00, 0x00, 0x00, 0x00, 0x01, 0x50, 0x00, 0x00, 0x56, 0xdc, 0xf7,
+     0x02, 0xf6, 0xcb, 0xc4, 0x02, 0x00, 0x00, 0x0e, 0x80, 0x01, 0x00,
+     0x00, 0x00, 0x3f, 0x00, 0x7e, 0x3f, 0x3f, 0xff, 0x7e, 0xa1},
+};
+
+static const uint16_t times_italic_kern_seeds[512] = {
+    1, 1, 4, 2, 1, 6, 0, 20, 8, 0, 1, 7, 1, 4, 18, 6, 8, 12, 5, 11, 15, 1, 2,
+    5, 16, 11, 1, 2, 11, 2, 3, 1, 4, 0, 9, 18, 0, 1, 1, 3, 7, 3, 14, 1, 6, 1,
+    6, 0, 5, 18, 6, 8, 3, 0, 2, 0, 1, 2, 13, 20, 11, 14, 1, 7, 7, 3, 4, 4, 9,
+    32, 0, 3, 1, 2, 7, 5, 0, 1, 7, 0, 5, 3, 0, 1, 1, 1, 16, 7, 4, 3, 10, 10, 2,
+    9, 7, 2, 5, 6, 1, 1, 8, 6, 3, 21, 1, 0, 3, 21, 4, 0, 0, 0, 5, 4, 10, 3, 6,
+    13, 2, 1, 10, 13, 10, 1, 1, 6, 0, 1, 9, 2, 4, 4, 24, 3, 0, 11, 8, 20, 0,
+    10, 9, 4, 5, 0, 1, 0, 3, 5, 13, 1, 9, 1, 0, 3, 14, 15, 6, 19, 3, 12, 19,
+    17, 0, 12, 11, 14, 31, 9, 10, 17, 1, 8, 4, 1, 2, 0, 5, 3, 5, 0, 5, 7, 5, 3,
+    4, 23, 6, 0, 1, 1, 4, 0, 7, 1, 0, 34, 14, 16, 5, 1, 10, 6, 0, 5, 78, 0, 36,
+    3, 5, 1, 17, 0, 6, 13, 0, 65, 20, 5, 0, 4, 8, 2, 22, 21, 13, 53, 15, 0, 2,
+    1, 37, 11, 1, 0, 5, 1, 5, 7, 3, 4, 20, 1, 4, 23, 1, 5, 3, 4, 6, 0, 0, 7, 6,
+    20, 1, 13, 1, 12, 23, 1, 1, 10, 96, 4, 12, 23, 3, 28, 0, 40, 1, 0, 4, 66,
+    43, 2, 2, 13, 0, 9, 25, 10, 21, 0, 0, 5, 25, 0, 6, 1, 0, 0, 5, 2, 1, 5, 11,
+    3, 13, 0, 58, 69, 0, 0, 15, 10, 1, 3, 6, 2, 23, 17, 2, 5, 2, 0, 27, 49, 2,
+    28, 6, 18, 16, 14, 6, 0, 0, 21, 1, 3, 21, 3, 1, 16, 1, 22, 3, 5, 0, 2, 5,
+    0, 11, 3, 43, 7, 10, 0, 81, 25, 1, 2, 35, 75, 4, 20, 3, 36, 4, 38, 9, 5,
+    23, 10, 9, 14, 0, 1, 14, 16, 16, 9, 15, 3, 45, 3, 1, 0, 4, 1, 10, 2, 5, 6,
+    0, 1, 8, 16, 7, 6, 2, 12, 11, 1, 13, 1, 1, 68, 1, 64, 18, 3, 29, 1, 7, 0,
+    2, 21, 1, 24, 0, 8, 74, 13, 9, 116, 1, 66, 21, 2, 0, 15, 0, 47, 121, 29,
+    30, 59, 3, 0, 187, 7, 2, 16, 2, 56, 7, 18, 14, 88, 59, 5, 83, 0, 0, 0, 1,
+    25, 43, 0, 4, 41, 1, 18, 4, 56, 1, 36, 0, 2, 1, 23, 1, 20, 14, 12, 1, 4, 0,
+    13, 84, 243, 6, 21, 12, 36, 54, 0, 2, 6, 72, 1, 124, 24, 220, 175, 128,
+    147, 1, 43, 0, 3, 197, 83, 18, 26, 72, 1, 3, 574, 209, 1, 174, 826, 20, 87,
+    2, 7, 73, 2012, 12, 16,
+};
+
+static const struct kern_pair times_italic_kern_pairs[1048] = {
+    {0xd5dd, -50}, {0x41d3, -40}, {0x9ff9, -92}, {0x57f6, -92}, {0x50f5, -80},
+    {0xdbc5, -40}, {0x57fb, -55}, {0x4f58, -40}, {0xc475, -20}, {0xc051, -40},
+    {0x4afc, -35}, {0x46e5, -75}, {0x4cfd, -30}, {0xc3c7, -30}, {0x42c5, -25},
+    {0x50e0, -80}, {0x9273, -40}, {0xddc5, -50}, {0xc292, -37}, {0x4fc4, -55},
+    {0x51db, -10}, {0x54c1, -50}, {0x6bf2, -10}, {0xc5dd, -55}, {0x56e5, -111},
+    {0x9fd6, -15}, {0x546f, -92}, {0xc379, -55}, {0x54ff, -34}, {0x54d2, -18},
+    {0x59c4, -50}, {0xc2ff, -55}, {0xc4d9, -50}, {0x672c, -10}, {0x44c5, -35},
+    {0xea67, -40}, {0x46f5, -105}, {0x4bf8, -40}, {0x72e3, -15}, {0x9fc2, -50},
+    {0x57d6, -25}, {0xc3dd, -55}, {0xc0d8, -40}, {0x9fee, -34}, {0x593a, -65},
+    {0xddad, -74}, {0xc4d3, -40}, {0x9ffa, -92}, {0xc447, -35}, {0x59d6, -15},
+    {0x4ec3, -27}, {0x4255, -10}, {0x54d8, -18}, {0xc575, -20}, {0x52d5, -40},
+    {0x4afb, -35}, {0xa0c5, -18}, {0x41d6, -40}, {0x57f8, -92}, {0xe8ff, -30},
+    {0x5641, -60}, {0x54fb, -55}, {0x59e9, -92}, {0x6bf3, -10}, {0x5061, -80},
+    {0x72e9, -37}, {0x50c5, -90}, {0x4ae8, -25}, {0x9f65, -92}, {0xc4dd, -55},
+    {0xc49f, -55}, {0x54ed, -55}, {0x4143, -30}, {0x5775, -55}, {0x592d, -74},
+    {0x59f4, -92}, {0xf576, -10}, {0x57f9, -55}, {0x52dd, -18}, {0xd341, -55},
+    {0x20c5, -18}, {0xd5c3, -55}, {0x50e4, -80}, {0x41f9, -20}, {0x50f3, -80},
+    {0xc354, -37}, {0x4a2e, -25}, {0xc04f, -40}, {0xd5c4, -55}, {0xd1c3, -27},
+    {0xdd4f, -15}, {0xe76b, -20}, {0x54d5, -18}, {0x9fe8, -52}, {0xea77, -15},
+    {0x4af9, -35}, {0xf267, -10}, {0x4179, -55}, {0x574f, -25}, {0xd857, -50},
+    {0xc3fd, -55}, {0x46c5, -115}, {0x42c2, -25}, {0xc2d2, -40}, {0xd9c0, -40},
+    {0xd241, -55}, {0x72e5, -15}, {0x9fd8, -15}, {0x6368, -15}, {0x9ffb, -92},
+    {0x6bf5, -10}, {0xd6c3, -55}, {0x4457, -40}, {0x4bf4, -40}, {0xeb2e, -15},
+    {0x57e4, -92}, {0xd456, -50}, {0xd6dd, -50}, {0x9fd2, -15}, {0xc1ff, -55},
+    {0xc151, -40}, {0x4ac5, -40}, {0x4159, -55}, {0x20c4, -18}, {0xe768, -15},
+    {0x57c3, -60}, {0xc3ff, -55}, {0xc5d6, -40}, {0xc551, -40}, {0x9fc1, -50},
+    {0x54e4, -92}, {0xc276, -55}, {0xc0d4, -40}, {0x5461, -92}, {0xd559, -50},
+    {0xe9fd, -30}, {0x41d2, -40}, {0x419f, -55}, {0x652c, -10}, {0x9ffc, -92},
+    {0x51dc, -10}, {0x54c2, -50}, {0x57ed, -55}, {0xc147, -35}, {0x56e1, -111},
+    {0xc0dd, -55}, {0x54ad, -74}, {0xc5d5, -40}, {0x72f6, -45}, {0xc077, -55},
+    {0xc5d8, -40}, {0x6bfd, -10}, {0x5259, -18}, {0xd656, -50}, {0xe067, -10},
+    {0x57ff, -70}, {0x9ff4, -92}, {0xd858, -40}, {0xc2fc, -20}, {0xe267, -10},
+    {0x4af5, -25}, {0x42db, -10}, {0x9fd4, -15}, {0x529f, -18}, {0x59c3, -50},
+    {0x41ff, -55}, {0x4bd2, -50}, {0x9fe0, -92}, {0x41da, -50}, {0x4bfb, -40},
+    {0xd9c4, -40}, {0xc557, -95}, {0x56fb, -74}, {0x563b, -74}, {0x4441, -35},
+    {0xc2fb, -20}, {0x59ec, -34}, {0xc0d9, -50}, {0x4177, -55}, {0x46c2, -115},
+    {0xc247, -35}, {0xc256, -105}, {0x72ea, -37}, {0x4ac4, -40}, {0xd6c2, -55},
+    {0xc1d8, -40}, {0xc2d3, -40}, {0xc3d2, -40}, {0x6f67, -10}, {0x65fd, -30},
+    {0xdac5, -40}, {0xeb67, -40}, {0x6567, -40}, {0x50f4, -80}, {0xc1da, -50},
+    {0xebfd, -30}, {0x9ff8, -92}, {0x54fc, -55}, {0xdd61, -92}, {0x4b79, -40},
+    {0xc454, -37}, {0xa09f, -75}, {0x9f69, -74}, {0xd541, -55}, {0x9f75, -92},
+    {0xdde4, -92}, {0xd5c1, -55}, {0x56d8, -30}, {0xc456, -105}, {0xdcc5, -40},
+    {0x57d8, -25}, {0x9fd3, -15}, {0x52d3, -40}, {0xddc3, -50}, {0x55c2, -40},
+    {0x50c0, -90}, {0x662c, -10}, {0xd89f, -50}, {0x59e0, -92}, {0xc2d9, -50},
+    {0x50f6, -80}, {0x4fc1, -55}, {0xd459, -50}, {0x543b, -65}, {0x54fa, -55},
+    {0xc3da, -50}, {0x5257, -18}, {0xd1c1, -27}, {0xc5da, -50}, {0xc3d6, -40},
+    {0xc1fc, -20}, {0xd2c4, -55}, {0x6b65, -10}, {0x5765, -92}, {0x7271, -37},
+    {0x592e, -92}, {0xc4c7, -30}, {0x564f, -30}, {0xd59f, -50}, {0xa041, -18},
+    {0xc0fd, -55}, {0x59c2, -50}, {0xddf2, -92}, {0xc3fc, -20}, {0x563a, -65},
+    {0x4af2, -25}, {0x56c3, -60}, {0x54fd, -74}, {0x72f3, -45}, {0x56fa, -74},
+    {0xf567, -10}, {0xea78, -20}, {0xc177, -55}, {0xc5f9, -20}, {0xc3dc, -50},
+    {0x57c4, -60}, {0x4456, -40}, {0x4154, -37}, {0x46ed, -45}, {0xdbc2, -40},
+    {0x5975, -92}, {0xa0c2, -18}, {0xc2c7, -30}, {0x54f6, -92}, {0xd141, -27},
+    {0x46f8, -105}, {0xc577, -55}, {0x54f5, -92}, {0x4afa, -35}, {0x57e2, -92},
+    {0xc4da, -50}, {0xe92e, -15}, {0x57e9, -92}, {0x4aea, -25}, {0x5255, -40},
+    {0xc0dc, -50}, {0xa0c4, -18}, {0x5541, -40}, {0xd257, -50}, {0x50c2, -90},
+    {0xd254, -40}, {0x72f5, -45}, {0x5665, -111}, {0xdd69, -74}, {0x54f9, -55},
+    {0x4ae9, -25}, {0xdbc1, -40}, {0x50eb, -80}, {0xd557, -50}, {0xdcc1, -40},
+    {0xc5dc, -50}, {0x5477, -74}, {0x9fe1, -92}, {0xc057, -95}, {0xddc2, -50},
+    {0xeb78, -20}, {0x9fd5, -15}, {0xdcc2, -40}, {0x9fe2, -92}, {0x56d5, -30},
+    {0x4fc2, -55}, {0x4ae3, -35}, {0x4192, -37}, {0x72ad, -20}, {0x6bea, -10},
+    {0xd258, -40}, {0xc1d2, -40}, {0xddfb, -92}, {0x59fc, -92}, {0x50e9, -80},
+    {0xebff, -30}, {0x2059, -75}, {0xd9c2, -40}, {0xc375, -20}, {0x4176, -55},
+    {0x572e, -92}, {0xd3c2, -55}, {0xddd5, -15}, {0x50e2, -80}, {0x56d6, -30},
+    {0x4ec4, -27}, {0xc543, -30}, {0xddf5, -92}, {0x573a, -65}, {0xddee, -34},
+    {0x4ac2, -40}, {0x72e1, -15}, {0xc357, -95}, {0xddfc, -92}, {0x54e5, -92},
+    {0x7264, -37}, {0x54e8, -52}, {0xe867, -40}, {0xd1c4, -27}, {0xd2c2, -55},
+    {0x6be9, -10}, {0x59e4, -92}, {0xd654, -40}, {0x54f8, -92}, {0x41fd, -55},
+    {0x46e8, -75}, {0x9264, -25}, {0xd9c5, -40}, {0x5661, -111}, {0x2057, -40},
+    {0x792c, -55}, {0x56d2, -30}, {0xddd6, -15}, {0x72f4, -45}, {0x55c4, -40},
+    {0x4459, -40}, {0x55c1, -40}, {0x6669, -20}, {0x4175, -20}, {0xc5d3, -40},
+    {0xd657, -50}, {0xddeb, -52}, {0xfd2e, -55}, {0xda2e, -25}, {0x46ec, -45},
+    {0xc547, -35}, {0x56d4, -30}, {0x4ae1, -35}, {0xc0fa, -20}, {0xd6c0, -55},
+    {0x9ff5, -92}, {0xd6c1, -55}, {0xd2dd, -50}, {0x42dc, -10}, {0x59e5, -92},
+    {0x4ac3, -40}, {0x56d3, -30}, {0xddf6, -92}, {0x4ec1, -27}, {0x54c0, -50},
+    {0x4a2c, -25}, {0xc0d6, -40}, {0xea2e, -15}, {0x9220, -111}, {0x4bff, -40},
+    {0xdd75, -92}, {0x4beb, -35}, {0x4b65, -35}, {0x636b, -20}, {0x57d3, -25},
+    {0x59f2, -92}, {0xd5c0, -55}, {0x4aeb, -25}, {0xc3f9, -20}, {0xc4ff, -55},
+    {0xc043, -30}, {0xe979, -30}, {0x59ed, -74}, {0x7261, -15}, {0xd441, -55},
+    {0xd641, -55}, {0xc1d5, -40}, {0xc254, -37}, {0xd556, -50}, {0xc479, -55},
+    {0x57d4, -25}, {0x4fc0, -55}, {0x52d4, -40}, {0x56ad, -55}, {0x4f41, -55},
+    {0xd841, -55}, {0xdb2e, -25}, {0x572d, -37}, {0x6bf4, -10}, {0xd3c1, -55},
+    {0x4cdd, -20}, {0x59c1, -50}, {0x9fc0, -50}, {0xd457, -50}, {0xe167, -10},
+    {0xd8c5, -55}, {0xc3d3, -40}, {0xc2d8, -40}, {0xc477, -55}, {0xc5d2, -40},
+    {0xd558, -40}, {0xddec, -34}, {0x59fb, -92}, {0x56ea, -111}, {0xd4c4, -55},
+    {0xe8fd, -30}, {0xc2d6, -40}, {0x4f9f, -50}, {0x4ac1, -40}, {0x56f6, -111},
+    {0x57d5, -25}, {0xddf4, -92}, {0x42d9, -10}, {0x4bf2, -40}, {0x41c7, -30},
+    {0x4fc5, -55}, {0xc1db, -50}, {0x62fa, -20}, {0x4f54, -40}, {0x4fdd, -50},
+    {0x4bd8, -50}, {0x52d8, -40}, {0x59d5, -15}, {0xdd2c, -92}, {0xdbc3, -40},
+    {0xc19f, -55}, {0x4ac0, -40}, {0xd941, -40}, {0xc255, -50}, {0xa0c0, -18},
+    {0x44c1, -35}, {0x59ef, -34}, {0xd4c5, -55}, {0x46ea, -75}, {0x55c0, -40},
+    {0xdde2, -92}, {0x9fe3, -92}, {0x566f, -111}, {0x449f, -40}, {0xc14f, -40},
+    {0x6577, -15}, {0xe876, -15}, {0x59d3, -15}, {0x9fe4, -92}, {0x57e3, -92},
+    {0x414f, -40}, {0x72e4, -15}, {0x56f8, -111}, {0xdcc0, -40}, {0x772e, -74},
+    {0xd856, -50}, {0xa054, -18}, {0x41d5, -40}, {0xc3fb, -20}, {0x44c3, -35},
+    {0xd659, -50}, {0xc5fb, -20}, {0x20dd, -75}, {0x46f3, -105}, {0x54f4, -92},
+    {0xf867, -10}, {0x41d9, -50}, {0xc29f, -55}, {0xda2c, -25}, {0x56c2, -60},
+    {0x20c1, -18}, {0x41fb, -20}, {0x46f2, -105}, {0x56e4, -111},
+    {0xc34f, -40}, {0x59f3, -92}, {0x5779, -70}, {0xe467, -10}, {0x593b, -65},
+    {0x59c5, -50}, {0x54c5, -50}, {0x4c79, -30}, {0x59e3, -92}, {0xd259, -50},
+    {0x5669, -74}, {0x54d6, -18}, {0xc056, -105}, {0xdc2e, -25}, {0x4b4f, -50},
+    {0x57c0, -60}, {0x59d8, -15}, {0xc1fa, -20}, {0x42da, -10}, {0x46e2, -75},
+    {0xd5c2, -55}, {0xc0ff, -55}, {0xc157, -95}, {0x52d2, -40}, {0x4157, -95},
+    {0x41db, -50}, {0xc554, -37}, {0xc275, -20}, {0x67eb, -10}, {0xd554, -40},
+    {0xc156, -105}, {0x596f, -92}, {0x46f6, -105}, {0x5741, -60},
+    {0xddf8, -92}, {0x5465, -92}, {0xdd3a, -65}, {0x56fc, -74}, {0xd356, -50},
+    {0xc5d4, -40}, {0x4641, -115}, {0xff2c, -55}, {0x552c, -25}, {0x72e8, -37},
+    {0xc457, -95}, {0x4a61, -35}, {0xda41, -40}, {0xdde0, -92}, {0x46f4, -105},
+    {0xc0fb, -20}, {0x4af3, -25}, {0x56c4, -60}, {0xd4c0, -55}, {0x56eb, -71},
+    {0xc5fd, -55}, {0x552e, -25}, {0xd8c2, -55}, {0x4bd4, -50}, {0xf467, -10},
+    {0xeb2c, -10}, {0x6767, -10}, {0x9fe9, -92}, {0xc079, -55}, {0xa0c3, -18},
+    {0xc192, -37}, {0x2e94, -140}, {0xdc2c, -25}, {0x4c54, -20}, {0x57f4, -92},
+    {0xd256, -50}, {0x4ae5, -35}, {0x4ae0, -35}, {0xc4fb, -20}, {0x9fad, -74},
+    {0x59d4, -15}, {0x4bf6, -40}, {0xc054, -37}, {0xdac2, -40}, {0xc4d4, -40},
+    {0x56f5, -111}, {0xc4d6, -40}, {0x52db, -40}, {0x6beb, -10}, {0x50e1, -80},
+    {0x5965, -92}, {0x6692, 92}, {0x4155, -50}, {0xc1dc, -50}, {0xc2fa, -20},
+    {0x592c, -92}, {0x9f3b, -65}, {0x57d2, -25}, {0xc179, -55}, {0x57fa, -55},
+    {0xc2dc, -50}, {0x4c56, -55}, {0x562d, -55}, {0xc1fb, -20}, {0xc176, -55},
+    {0xc5fa, -20}, {0x4f57, -50}, {0x20c3, -18}, {0x56c1, -60}, {0x4ec0, -27},
+    {0xdbc0, -40}, {0x9feb, -52}, {0x4a65, -25}, {0x67ea, -10}, {0xc143, -30},
+    {0xc092, -37}, {0x542d, -74}, {0x46e9, -75}, {0xc3d9, -50}, {0xe82c, -10},
+    {0x576f, -92}, {0x57eb, -52}, {0xd1c5, -27}, {0xc3d4, -40}, {0xdac4, -40},
+    {0x46c3, -115}, {0x72eb, -37}, {0x4f59, -50}, {0x57ad, -37}, {0x20c2, -18},
+    {0xd5c5, -55}, {0x42c0, -25}, {0xeafd, -30}, {0x57fd, -70}, {0xd359, -50},
+    {0xc0da, -50}, {0x4ae4, -35}, {0x2c94, -140}, {0xdded, -74}, {0x59eb, -52},
+    {0xc279, -55}, {0xeb76, -15}, {0xc4f9, -20}, {0xdb2c, -25}, {0x59e2, -92},
+    {0xc2db, -50}, {0xf276, -10}, {0xd458, -40}, {0x5041, -90}, {0xd358, -40},
+    {0x54e2, -92}, {0x54c4, -50}, {0x5256, -18}, {0xc392, -37}, {0xd8c0, -55},
+    {0xd8c1, -55}, {0x2041, -18}, {0x57f2, -92}, {0xc1d6, -40}, {0xd92e, -25},
+    {0xdcc4, -40}, {0x4665, -75}, {0xc556, -105}, {0x7267, -37}, {0x62fb, -20},
+    {0xdd3b, -65}, {0x46ef, -45}, {0xf676, -10}, {0x672e, -15}, {0xd8c4, -55},
+    {0xc44f, -40}, {0xddd2, -15}, {0x6765, -10}, {0x5769, -55}, {0xddf9, -92},
+    {0xa056, -35}, {0x56c0, -60}, {0x56f3, -111}, {0xc0c7, -30}, {0x42c4, -25},
+    {0xd39f, -50}, {0xd8dd, -50}, {0xc579, -55}, {0x59c0, -50}, {0xc343, -30},
+    {0x5155, -10}, {0x9f6f, -92}, {0xa057, -40}, {0x9274, -30}, {0x50e3, -80},
+    {0x72e7, -37}, {0x6be8, -10}, {0x59f9, -92}, {0x57e0, -92}, {0x6bff, -10},
+    {0x46e0, -75}, {0x7265, -37}, {0x41dd, -55}, {0xc159, -55}, {0x57ea, -92},
+    {0x56ee, -34}, {0xdac3, -40}, {0xc492, -37}, {0x462c, -135}, {0xc0d3, -40},
+    {0xd357, -50}, {0x46e1, -75}, {0x5441, -50}, {0x722e, -111}, {0xe82e, -15},
+    {0xe367, -10}, {0x4be8, -35}, {0x4bf9, -40}, {0x4151, -40}, {0x41fc, -20},
+    {0x9fef, -34}, {0xdde1, -92}, {0xc4fc, -20}, {0xeb77, -15}, {0x9f41, -50},
+    {0xc59f, -55}, {0x2e92, -140}, {0xc376, -55}, {0x466f, -105},
+    {0x506f, -80}, {0xdbc4, -40}, {0xdcc3, -40}, {0x9f2c, -92}, {0x9fc4, -50},
+    {0x4ae2, -35}, {0x50ea, -80}, {0x52d6, -40}, {0x4bd5, -50}, {0xc1f9, -20},
+    {0x55c5, -40}, {0x44c0, -35}, {0xe878, -20}, {0x722c, -111}, {0x5475, -55},
+    {0x59ee, -34}, {0xc377, -55}, {0x6bf8, -10}, {0xc24f, -40}, {0xc4d5, -40},
+    {0xd2c1, -55}, {0x5675, -74}, {0xddd8, -15}, {0x4ec2, -27}, {0x46e3, -75},
+    {0x57e8, -52}, {0x56f4, -111}, {0xc251, -40}, {0x46c4, -115},
+    {0x52d9, -40}, {0x4bea, -35}, {0xf476, -10}, {0x4bd6, -50}, {0x67e8, -10},
+    {0x6578, -20}, {0xc3d8, -40}, {0xc2fd, -55}, {0xc155, -50}, {0xd6c4, -55},
+    {0xf176, -40}, {0xc257, -95}, {0x50f2, -80}, {0xdde3, -92}, {0x6bf6, -10},
+    {0xdde9, -92}, {0xd9c3, -40}, {0xc5c7, -30}, {0x2056, -35}, {0x4e41, -27},
+    {0xe9ff, -30}, {0x56c5, -60}, {0xc055, -50}, {0x4a41, -40}, {0x4bf3, -40},
+    {0xc1c7, -30}, {0xc555, -50}, {0x62fc, -20}, {0xdac0, -40}, {0x46eb, -75},
+    {0x59fa, -92}, {0x54eb, -52}, {0xdde8, -52}, {0x4be9, -35}, {0xdd65, -92},
+    {0x4f56, -50}, {0x5761, -92}, {0x7263, -37}, {0xc0db, -50}, {0x524f, -40},
+    {0x6579, -30}, {0xddf3, -92}, {0x54e3, -92}, {0x54f3, -92}, {0x5961, -92},
+    {0xd3dd, -50}, {0xc592, -37}, {0xc1d9, -50}, {0x573b, -65}, {0xc39f, -55},
+    {0x67e9, -10}, {0xff2e, -55}, {0xdd2e, -92}, {0x56f2, -111}, {0x4669, -45},
+    {0xddea, -92}, {0x6b79, -10}, {0x41fa, -20}, {0xd29f, -50}, {0x562c, -129},
+    {0x50c4, -90}, {0x9ff6, -92}, {0xc4fd, -55}, {0xc3db, -50}, {0xc54f, -40},
+    {0xd854, -40}, {0x792e, -55}, {0xc277, -55}, {0x652e, -15}, {0x726f, -45},
+    {0xe978, -20}, {0x9292, -111}, {0x57fc, -55}, {0xc0f9, -20}, {0xd4dd, -50},
+    {0xc243, -30}, {0x542c, -74}, {0xd2c3, -55}, {0xc076, -55}, {0xc09f, -55},
+    {0x44c2, -35}, {0xf876, -10}, {0x9fe5, -92}, {0x2c92, -140}, {0xdc41, -40},
+    {0xe879, -30}, {0xc443, -30}, {0xc4fa, -20}, {0xddc1, -50}, {0x9ff3, -92},
+    {0xc5d9, -50}, {0x9276, -10}, {0x4661, -75}, {0x4af8, -25}, {0x5065, -80},
+    {0xd354, -40}, {0xdb41, -40}, {0xc459, -55}, {0xf376, -10}, {0x6666, -18},
+    {0x56f9, -74}, {0x572c, -92}, {0x722d, -20}, {0x9fed, -74}, {0xe877, -15},
+    {0xc175, -20}, {0xd3c4, -55}, {0x4bfd, -40}, {0xa0dd, -75}, {0x4b75, -40},
+    {0xc451, -40}, {0x57f3, -92}, {0x9fc3, -50}, {0xe977, -15}, {0x52dc, -40},
+    {0x59ad, -74}, {0xc075, -20}, {0xc5ff, -55}, {0x65ff, -30}, {0xc0d5, -40},
+    {0xc1fd, -55}, {0x2054, -18}, {0xeb79, -30}, {0x5469, -55}, {0x57c1, -60},
+    {0xc1dd, -55}, {0x4241, -25}, {0xc2d4, -40}, {0xea2c, -10}, {0xd92c, -25},
+    {0x54d4, -18}, {0x6275, -20}, {0xc4db, -50}, {0x662e, -15}, {0xc356, -105},
+    {0xd3c0, -55}, {0xddfa, -92}, {0x51d9, -10}, {0xd1c2, -27}, {0x729a, -10},
+    {0x57c5, -60}, {0x50e8, -80}, {0x4a6f, -25}, {0x9fc5, -50}, {0x4c59, -20},
+    {0x543a, -55}, {0x4fc3, -55}, {0x54e0, -92}, {0x50e5, -80}, {0xc455, -50},
+    {0xd4c3, -55}, {0x57e1, -92}, {0x72e0, -15}, {0x9191, -111}, {0x4a75, -35},
+    {0x57e5, -92}, {0x9f3a, -65}, {0x462e, -135}, {0x50c1, -90}, {0x56ef, -34},
+    {0x544f, -18}, {0x59f6, -92}, {0xd2c0, -55}, {0x9272, -25}, {0x56ed, -74},
+    {0x4c92, -37}, {0x4af4, -25}, {0x59f8, -92}, {0x562e, -129}, {0xddef, -34},
+    {0x59ea, -92}, {0xddd4, -15}, {0x5969, -74}, {0x20c0, -18}, {0x54f2, -92},
+    {0x6167, -10}, {0x5941, -50}, {0xddd3, -15}, {0x6f76, -10}, {0x59e8, -52},
+    {0xeaff, -30}, {0x57c2, -60}, {0x54ea, -52}, {0xea79, -30}, {0x44c4, -35},
+    {0xc2da, -50}, {0x502c, -135}, {0xc0d2, -40}, {0xd9c1, -40}, {0x57f5, -92},
+    {0x9fec, -34}, {0x46c1, -115}, {0x46e4, -75}, {0x42c1, -25}, {0xc2f9, -20},
+    {0x54e9, -92}, {0xc1d4, -40}, {0xd658, -40}, {0x41dc, -50}, {0x54e1, -92},
+    {0xd49f, -50}, {0x4c9f, -20}, {0xd4c2, -55}, {0xc3fa, -20}, {0xdd2d, -74},
+    {0xc3d5, -40}, {0x42c3, -25}, {0xc351, -40}, {0xc355, -50}, {0x9f61, -92},
+    {0xc576, -55}, {0xd3c5, -55}, {0x92a0, -111}, {0xdac1, -40}, {0x762c, -74},
+    {0xc047, -35}, {0xc059, -55}, {0xa059, -75}, {0x59d2, -15}, {0xd4c1, -55},
+    {0xc359, -55}, {0x50f8, -80}, {0x9f4f, -15}, {0xd859, -50}, {0x56ec, -34},
+    {0xc4dc, -50}, {0xd454, -40}, {0xc0fc, -20}, {0x4ec5, -27}, {0x72f8, -45},
+    {0xc154, -37}, {0xdd6f, -92}, {0xdd41, -50}, {0x4156, -105}, {0xe92c, -10},
+    {0xc4d8, -40}, {0x6b6f, -10}, {0x772c, -74}, {0xa0c1, -18}, {0xc259, -55},
+    {0x6e76, -40}, {0xf667, -10}, {0x52da, -40}, {0xd6c5, -55}, {0xfd2c, -55},
+    {0x4bd3, -50}, {0x50c3, -90}, {0xc5db, -50}, {0xc559, -55}, {0xd3c3, -55},
+    {0x6576, -15}, {0xc1d3, -40}, {0x56e2, -111}, {0x5472, -55}, {0x4b6f, -40},
+    {0xddc0, -50}, {0x56e0, -111}, {0x4bf5, -40}, {0x54d3, -18}, {0x542e, -74},
+    {0xf367, -10}, {0x59e1, -92}, {0xd69f, -50}, {0xc347, -35}, {0x44dd, -40},
+    {0x9fea, -92}, {0x56e9, -111}, {0xd1c0, -27}, {0x41d8, -40}, {0x7273, -10},
+    {0x56e3, -111}, {0xe976, -15}, {0xe967, -40}, {0x622e, -40}, {0x51da, -10},
+    {0xc5fc, -20}, {0x4cff, -30}, {0xc2d5, -40}, {0x762e, -74}, {0x5479, -74},
+    {0x502e, -135}, {0x54c3, -50}, {0x594f, -15}, {0xd2c5, -55}, {0x4c57, -55},
+    {0x55c3, -40}, {0x72f2, -45}, {0xdde5, -92}, {0x4bfc, -40}, {0xea76, -15},
+    {0x46c0, -115}, {0x59f5, -92}, {0xe567, -10}, {0xc4d2, -40}, {0x209f, -75},
+    {0xc2dd, -55}, {0x56e8, -71}, {0xc476, -55}, {0x9f2d, -74}, {0x46ee, -45},
+    {0x929a, -40}, {0xd8c3, -55}, {0x41d4, -40}, {0x62f9, -20}, {0x9f2e, -92},
+    {0x4672, -55}, {0xddc4, -50}, {0x9ff2, -92}, {0x4af6, -25}, {0x72e2, -15},
+    {0x4147, -35}, {0x4bfa, -40},
+};
+
+static const struct kern_table times_italic_kerns = {
+    times_italic_kern_seeds,
+    times_italic_kern_pairs,
+    512,
+    1048,
+    {0x00, 0x00, 0x00, 0x00, 0x01, 0x50, 0x00, 0x00, 0x56, 0xdc, 0xf7,
+     0x02, 0xee, 0xc8, 0xc4, 0x02, 0x00, 0x00, 0x06, 0x80, 0x01, 0x00,
+     0x00, 0x00, 0x3f, 0x00, 0x7e, 0x3f, 0xbf, 0x0f, 0x7e, 0xa1},
+};
+
+static const uint16_t times_bold_italic_kern_seeds[256] = {
+    1, 50, 8, 333, 74, 13, 2, 31, 49, 11, 35, 329, 7, 43, 2, 7, 189, 20, 98, 1,
+    12, 1, 12, 146, 30, 12, 53, 65, 1, 317, 22, 289, 162, 3, 86, 176, 4, 28,
+    11, 199, 153, 21, 1, 17, 46, 204, 1, 5, 121, 1, 15, 36, 2, 7, 34, 12, 3,
+    528, 199, 3, 732, 1, 34, 2, 46, 162, 3, 72, 430, 70, 1, 3, 60, 110, 6, 6,
+    2, 9, 118, 3, 141, 19, 59, 310, 27, 152, 2, 12, 198, 27, 27, 43, 7, 86, 3,
+    119, 14, 149, 12, 1, 11, 45, 411, 3, 1, 125, 298, 275, 132, 192, 1, 369,
+    39, 188, 1, 204, 32, 14, 67, 27, 14, 50, 2, 24, 5, 229, 781, 4, 12, 1, 15,
+    35, 157, 1, 265, 51, 55, 5, 8, 107, 347, 17, 24, 455, 1247, 0, 596, 18, 1,
+    62, 151, 0, 2, 6, 2, 87, 2, 34, 4, 13, 4012, 21, 1793, 620, 218, 8, 3, 20,
+    56, 1, 71, 16, 289, 29, 317, 1, 52, 37, 37, 2, 6, 304, 80, 6, 13, 53, 8,
+    73, 21, 13, 69, 6, 56, 46, 56, 34, 18, 27, 40, 2, 5, 235, 263, 143, 138,
+    303, 7, 181, 8, 531, 434, 786, 49, 57, 507, 20, 3, 519, 310, 166, 63, 80,
+    0, 144, 552, 27, 1780, 1255, 75, 223, 53, 6, 25, 6, 1474, 2011, 172, 2060,
+    165, 246, 1, 4, 1159, 704, 180, 36, 1985, 49, 1, 8, 71, 1488, 309, 2, 96,
+    7,
+};
+
+static const struct kern_pair times_bold_italic_kern_pairs[1012] = {
+    {0xc276, -74}, {0xd254, -40}, {0xc1f9, -30}, {0xd1c0, -30}, {0x59e1, -92},
+    {0x76ea, -15}, {0x6368, -10}, {0xc475, -30}, {0x9276, -15}, {0xc577, -74},
+    {0xc3da, -50}, {0xdbc2, -45}, {0xd341, -40}, {0xf477, -25}, {0x50f6, -55},
+    {0x5469, -37}, {0x50f4, -55}, {0x76e9, -15}, {0x9f6f, -111}, {0x78e8, -10},
+    {0x57e8, -50}, {0x6bf2, -10}, {0x9fd8, -25}, {0xf8ff, -10}, {0x56f4, -111},
+    {0xf376, -15}, {0xdbc3, -45}, {0x4ae0, -40}, {0xc0ff, -74}, {0xd256, -50},
+    {0x57d8, -15}, {0x4154, -55}, {0x6bea, -30}, {0xd6dd, -50}, {0x77e0, -10},
+    {0x4661, -95}, {0xc5d6, -50}, {0x78ea, -10}, {0xa0dd, -70}, {0x792e, -37},
+    {0xc155, -50}, {0x55c0, -45}, {0x59c0, -74}, {0x59ed, -55}, {0xddad, -92},
+    {0xeb62, -10}, {0x9fd6, -25}, {0x636b, -10}, {0x50e1, -40}, {0x50e8, -50},
+    {0xc277, -74}, {0xc4d9, -50}, {0x52d5, -40}, {0x59f2, -111}, {0xa0c5, -37},
+    {0x66f5, -10}, {0x57f8, -80}, {0x51dc, -10}, {0xd554, -40}, {0x4f59, -50},
+    {0x9f3b, -92}, {0xf279, -10}, {0x5061, -40}, {0x54e2, -92}, {0xd3c5, -40},
+    {0xc2d9, -50}, {0x9f65, -111}, {0x5641, -85}, {0xddf9, -92}, {0xd856, -50},
+    {0xf479, -10}, {0x59d6, -25}, {0x57d5, -15}, {0xf576, -15}, {0xdd65, -111},
+    {0xc2f9, -30}, {0x6ffd, -10}, {0x56fa, -55}, {0x92a0, -74}, {0x50e9, -50},
+    {0x41f9, -30}, {0x592c, -92}, {0x772c, -37}, {0x5775, -55}, {0xd559, -50},
+    {0x9f4f, -25}, {0xc275, -30}, {0xc29f, -70}, {0x929a, -74}, {0x9fe8, -71},
+    {0xdcc1, -45}, {0x722c, -65}, {0xd5c3, -40}, {0x4bf4, -25}, {0xc0d6, -50},
+    {0x41da, -50}, {0xddf4, -111}, {0x56d8, -30}, {0xdd4f, -25}, {0x54fb, -37},
+    {0x54e0, -92}, {0x9fc1, -74}, {0x622e, -40}, {0x4459, -50}, {0x42c4, -25},
+    {0x5779, -55}, {0x6bf5, -10}, {0x4bd5, -30}, {0x4192, -74}, {0xc077, -74},
+    {0x54ad, -92}, {0x57e4, -85}, {0xd8c5, -40}, {0xd59f, -50}, {0xd2c5, -40},
+    {0x56fc, -55}, {0x9ffb, -92}, {0xa0c0, -37}, {0x56e5, -111}, {0x59eb, -71},
+    {0x55c2, -45}, {0x4a75, -40}, {0x4151, -55}, {0x4af9, -40}, {0x4ae9, -40},
+    {0xc3d2, -50}, {0x59ea, -71}, {0x573a, -55}, {0x57fa, -55}, {0xc459, -70},
+    {0xd3c0, -40}, {0x56ed, -55}, {0x576f, -80}, {0xf5fd, -10}, {0xd656, -50},
+    {0x4457, -40}, {0x54c2, -55}, {0xf476, -15}, {0xc257, -100}, {0xf6fd, -10},
+    {0x57fb, -55}, {0x4ae8, -40}, {0xd359, -50}, {0xc2ff, -74}, {0x59f5, -111},
+    {0x57c1, -74}, {0x46e8, -100}, {0xf677, -25}, {0x4fc5, -40}, {0x4a2e, -10},
+    {0x20c2, -37}, {0xc157, -100}, {0xc451, -55}, {0xdde1, -92}, {0x4af5, -40},
+    {0x56d6, -30}, {0x7765, -10}, {0xc1d6, -50}, {0xdde5, -92}, {0x5675, -55},
+    {0x4bd2, -30}, {0xddea, -71}, {0x414f, -50}, {0xda41, -45}, {0x54f6, -95},
+    {0xc557, -100}, {0xc351, -55}, {0x54d4, -18}, {0x51d9, -10}, {0x54d2, -18},
+    {0xd6c0, -40}, {0x50e5, -40}, {0x4177, -74}, {0x9fd3, -25}, {0xc256, -95},
+    {0xc043, -65}, {0xc259, -70}, {0x5257, -18}, {0xf2ff, -10}, {0xc1d8, -50},
+    {0x54fa, -37}, {0x66e9, -10}, {0xc255, -50}, {0xf8fd, -10}, {0xc0d5, -50},
+    {0x4fc0, -40}, {0x20c0, -37}, {0x50f8, -55}, {0xc2d2, -50}, {0x50e2, -40},
+    {0x54fc, -37}, {0xc5fb, -30}, {0x56fb, -55}, {0xc19f, -70}, {0x9274, -37},
+    {0x59d5, -25}, {0xd356, -50}, {0x9273, -74}, {0x4ec0, -30}, {0x4beb, -25},
+    {0xd5dd, -50}, {0xe962, -10}, {0xc5d3, -50}, {0xd454, -40}, {0xc179, -74},
+    {0x4bf3, -25}, {0x4f54, -40}, {0x46c4, -100}, {0x9fc5, -74}, {0x57e1, -85},
+    {0xc059, -70}, {0x9264, -15}, {0xd2c1, -40}, {0xc04f, -50}, {0x4fc1, -40},
+    {0x44c5, -25}, {0x59d3, -25}, {0xea62, -10}, {0x6beb, -30}, {0x20c4, -37},
+    {0x9ff2, -111}, {0xc3d6, -50}, {0x57e2, -85}, {0x57f2, -80}, {0x77f6, -15},
+    {0xd357, -50}, {0xdb41, -45}, {0x57c0, -74}, {0x56d2, -30}, {0xc575, -30},
+    {0x9f75, -92}, {0xa041, -37}, {0x9f69, -55}, {0xc2fd, -74}, {0x4179, -74},
+    {0xc3fc, -30}, {0xdcc0, -45}, {0xc5ff, -74}, {0x54fd, -37}, {0xc3d5, -50},
+    {0xc2c7, -65}, {0x56eb, -71}, {0x62fb, -20}, {0xc3d8, -50}, {0x6be8, -30},
+    {0x4bf5, -25}, {0x44c0, -25}, {0x56c3, -85}, {0x506f, -55}, {0xc151, -55},
+    {0x2c94, -95}, {0x5975, -92}, {0xa0c2, -37}, {0x776f, -15}, {0x54f3, -95},
+    {0x566f, -111}, {0x662e, -10}, {0x9fe5, -92}, {0x4b6f, -25}, {0x59e0, -92},
+    {0x4456, -50}, {0x77f3, -15}, {0x46c0, -100}, {0x54c5, -55}, {0xc4d2, -50},
+    {0xdcc5, -45}, {0x9272, -15}, {0xd558, -40}, {0xd8c4, -40}, {0xddc2, -74},
+    {0xc5d2, -50}, {0xc0d4, -50}, {0x4cfd, -37}, {0x76f4, -15}, {0xc0d2, -50},
+    {0x5541, -45}, {0x46e0, -95}, {0x59f3, -111}, {0xd557, -50}, {0x5065, -50},
+    {0xc076, -74}, {0x6e76, -40}, {0xe768, -10}, {0x5769, -37}, {0x46e5, -95},
+    {0x9fd5, -25}, {0x4bf2, -25}, {0xdcc2, -45}, {0x54d6, -18}, {0x56d3, -30},
+    {0xc492, -74}, {0xc143, -65}, {0x5255, -40}, {0x52d9, -40}, {0x66f2, -10},
+    {0x46e3, -95}, {0xc2db, -50}, {0xc24f, -50}, {0xd1c4, -30}, {0x5477, -37},
+    {0x4bf8, -25}, {0x4afb, -40}, {0x4ec4, -30}, {0x54f5, -95}, {0x4ac2, -25},
+    {0x6fff, -10}, {0x54e1, -92}, {0xc3d9, -50}, {0x564f, -30}, {0xddc1, -74},
+    {0x52d2, -40}, {0xddf5, -111}, {0xc2da, -50}, {0xc159, -70}, {0xc447, -60},
+    {0x4af6, -40}, {0xc357, -100}, {0x54e5, -92}, {0x59d4, -25}, {0x76f2, -15},
+    {0x59c3, -74}, {0x52d3, -40}, {0x6bf6, -10}, {0x4bfb, -20}, {0x9f2e, -74},
+    {0xc0d9, -50}, {0x46f5, -70}, {0x41db, -50}, {0x41fd, -74}, {0x9fed, -55},
+    {0xf878, -10}, {0x57eb, -50}, {0x41c7, -65}, {0x41d6, -50}, {0xc3d3, -50},
+    {0xc1dd, -70}, {0xd2c3, -40}, {0xd4c1, -40}, {0x4aea, -40}, {0x55c1, -45},
+    {0x574f, -15}, {0xddc4, -74}, {0xf679, -10}, {0xc3db, -50}, {0x9fc3, -74},
+    {0x41d3, -50}, {0x78eb, -10}, {0x46c5, -100}, {0x59c4, -74}, {0x57f3, -80},
+    {0x5965, -111}, {0x54d8, -18}, {0xf577, -25}, {0x592e, -74}, {0x4bd8, -30},
+    {0xc3d4, -50}, {0x42dc, -10}, {0x54f8, -95}, {0x5741, -74}, {0x46f4, -70},
+    {0xd858, -40}, {0x52db, -40}, {0xc5db, -50}, {0xd5c0, -40}, {0x52d6, -40},
+    {0x9220, -74}, {0xdac5, -45}, {0xc375, -30}, {0xf277, -25}, {0xdbc4, -45},
+    {0x4ae2, -40}, {0x41ff, -74}, {0x5647, -10}, {0xc44f, -50}, {0xc34f, -50},
+    {0x50c3, -85}, {0xd1c3, -30}, {0x77e2, -10}, {0x41dd, -70}, {0x4af3, -40},
+    {0xf578, -10}, {0x6f78, -10}, {0xd259, -50}, {0x2e94, -95}, {0xd2c2, -40},
+    {0x46ec, -40}, {0x59d8, -25}, {0xddc3, -74}, {0xc057, -100}, {0x466f, -70},
+    {0xddf8, -111}, {0xc2fa, -30}, {0xc4d8, -50}, {0x54eb, -52}, {0x6bf4, -10},
+    {0xdbc5, -45}, {0xd941, -45}, {0xc251, -55}, {0x9ff3, -111}, {0x4f58, -40},
+    {0x56f2, -111}, {0xd8c3, -40}, {0x6665, -10}, {0x4f56, -50}, {0x4ae4, -40},
+    {0x57c5, -74}, {0x54e3, -92}, {0x5969, -55}, {0x59fb, -92}, {0xf478, -10},
+    {0x4c54, -18}, {0x57ed, -37}, {0x55c5, -45}, {0x56c5, -85}, {0xd459, -50},
+    {0x56f6, -111}, {0xddc5, -74}, {0xdd2d, -92}, {0x7865, -10}, {0xd3dd, -50},
+    {0xd4c5, -40}, {0x20c1, -37}, {0x4b65, -25}, {0xc579, -74}, {0x9fe1, -92},
+    {0x50e3, -40}, {0xc347, -60}, {0x542e, -92}, {0x462c, -129}, {0xc5d4, -50},
+    {0xa056, -70}, {0xd9c5, -45}, {0x56ad, -70}, {0x54c1, -55}, {0xd2c4, -40},
+    {0xe862, -10}, {0x5665, -111}, {0x4255, -10}, {0x46ea, -100},
+    {0xd5c4, -40}, {0x4f41, -40}, {0x77f2, -15}, {0x5669, -55}, {0x449f, -50},
+    {0x77e3, -10}, {0xc4fb, -30}, {0xc055, -50}, {0x56e0, -111}, {0x4f57, -50},
+    {0xc376, -74}, {0xc292, -74}, {0x44c2, -25}, {0x9ffa, -92}, {0x4155, -50},
+    {0x77e8, -10}, {0xd6c2, -40}, {0x419f, -70}, {0x59fa, -92}, {0x44c3, -25},
+    {0xc4c7, -65}, {0x5472, -37}, {0x50f5, -55}, {0x54f4, -95}, {0xdd61, -92},
+    {0x4b79, -20}, {0x55c3, -45}, {0xc454, -55}, {0xd141, -30}, {0x6692, 55},
+    {0xd458, -40}, {0x46f2, -70}, {0xc175, -30}, {0xddfb, -92}, {0x4ac5, -25},
+    {0x57f9, -55}, {0x51db, -10}, {0xd39f, -50}, {0x59c5, -74}, {0xc355, -50},
+    {0x50e4, -40}, {0xf678, -10}, {0xc0da, -50}, {0x6b6f, -10}, {0xd1c2, -30},
+    {0xc176, -74}, {0xddfa, -92}, {0x42c5, -25}, {0x4fc4, -40}, {0xd659, -50},
+    {0xc2d8, -50}, {0xc0d8, -50}, {0xc479, -74}, {0x56e9, -111}, {0x76f6, -15},
+    {0xdd6f, -111}, {0x772e, -37}, {0xdde9, -111}, {0xd9c1, -45},
+    {0xd6c4, -40}, {0xd3c3, -40}, {0x20c5, -37}, {0xc54f, -50}, {0xd857, -50},
+    {0x46f6, -70}, {0x4147, -60}, {0xdd75, -92}, {0xc3fd, -74}, {0x4bf6, -25},
+    {0xd641, -40}, {0x56c4, -85}, {0x46ee, -40}, {0x4641, -100},
+    {0xddf6, -111}, {0x4c79, -37}, {0xc4d5, -50}, {0x41fb, -30}, {0x4a61, -40},
+    {0xddd2, -25}, {0x59f4, -111}, {0xc0fb, -30}, {0x4ac3, -25}, {0xc49f, -70},
+    {0x54d5, -18}, {0xdd41, -74}, {0x50e0, -40}, {0x52dd, -18}, {0xc3c7, -65},
+    {0x5479, -37}, {0xf377, -25}, {0x4fc3, -40}, {0x57ea, -90}, {0x6562, -10},
+    {0xc443, -65}, {0xf378, -10}, {0x41d9, -50}, {0xc2d4, -50}, {0x56e8, -71},
+    {0xdded, -55}, {0x6bf3, -10}, {0xd4dd, -50}, {0xc5dd, -70}, {0xfd2c, -37},
+    {0x5041, -85}, {0x9fad, -92}, {0x9ff5, -111}, {0xc4fc, -30},
+    {0x9ff4, -111}, {0x62fc, -20}, {0xc5d5, -50}, {0xd2c0, -40}, {0xd1c1, -30},
+    {0x6b65, -30}, {0x66f3, -10}, {0x50eb, -50}, {0x4a6f, -40}, {0xd4c0, -40},
+    {0x46eb, -100}, {0xc1fd, -74}, {0x4ec3, -30}, {0xc3dc, -50}, {0x41d4, -50},
+    {0x5461, -92}, {0x5441, -55}, {0x76f5, -15}, {0xd4c4, -40}, {0x9fe4, -92},
+    {0x66f8, -10}, {0x59ad, -92}, {0x4c59, -37}, {0x50f2, -55}, {0xc476, -74},
+    {0xc5fc, -30}, {0xc14f, -50}, {0xdbc0, -45}, {0x9f41, -74}, {0xc3dd, -70},
+    {0xc154, -55}, {0xd89f, -50}, {0xddd3, -25}, {0x9fe3, -92}, {0xdd3a, -92},
+    {0x4bfa, -20}, {0x4ac4, -25}, {0x4bd6, -30}, {0xd1c5, -30}, {0x54e8, -52},
+    {0x662c, -10}, {0xc1da, -50}, {0xdcc3, -45}, {0x57e9, -90}, {0xf3fd, -10},
+    {0xd69f, -50}, {0xc559, -70}, {0xc547, -60}, {0x4665, -100}, {0x42c1, -25},
+    {0x4156, -95}, {0xd9c2, -45}, {0x543b, -74}, {0xc4d4, -50}, {0x4241, -25},
+    {0x4bd4, -30}, {0x562e, -129}, {0x563a, -74}, {0xd859, -50}, {0xd354, -40},
+    {0xdac4, -45}, {0xf276, -15}, {0x5941, -74}, {0xf877, -25}, {0xc5fa, -30},
+    {0x9ffc, -92}, {0x762e, -37}, {0xf2fd, -10}, {0x52d4, -40}, {0xd8c0, -40},
+    {0x4afc, -40}, {0xd854, -40}, {0xd4c3, -40}, {0x54d3, -18}, {0xd441, -40},
+    {0x7761, -10}, {0xc079, -74}, {0x54f9, -37}, {0xd258, -40}, {0x4669, -40},
+    {0xc054, -55}, {0x57f6, -80}, {0xc1dc, -50}, {0x4ec5, -30}, {0xd541, -40},
+    {0x4fdd, -50}, {0x4c56, -37}, {0xdac1, -45}, {0x9ff6, -111}, {0x9fea, -71},
+    {0x57e5, -85}, {0x7665, -15}, {0xc1db, -50}, {0xd3c2, -40}, {0x572d, -50},
+    {0xd8dd, -50}, {0x57f5, -80}, {0x592d, -92}, {0xc343, -65}, {0xc457, -100},
+    {0xc5dc, -50}, {0xc2d6, -50}, {0xc247, -60}, {0x41fa, -30}, {0x56c1, -85},
+    {0x573b, -55}, {0x42c0, -25}, {0x55c4, -45}, {0x6f79, -10}, {0xc556, -95},
+    {0xd257, -50}, {0xc0fc, -30}, {0x209f, -70}, {0x4e41, -30}, {0x57d6, -15},
+    {0x20c3, -37}, {0xc1fb, -30}, {0x57d2, -15}, {0xf379, -10}, {0x46e1, -95},
+    {0x5254, -30}, {0x56d4, -30}, {0xf278, -10}, {0xddd8, -25}, {0x57ff, -55},
+    {0xd9c4, -45}, {0x54c0, -55}, {0x59fc, -92}, {0x5475, -37}, {0x5761, -85},
+    {0xf579, -10}, {0xc354, -55}, {0x524f, -40}, {0x77e5, -10}, {0xf4fd, -10},
+    {0x9fc4, -74}, {0x46e4, -95}, {0x50c2, -85}, {0x56e3, -111}, {0xd841, -40},
+    {0x4159, -70}, {0xdd3b, -92}, {0xc4d6, -50}, {0x50ea, -50}, {0xc1d2, -50},
+    {0xc1fa, -30}, {0x62f9, -20}, {0x59e8, -71}, {0x562c, -129}, {0x4176, -74},
+    {0x5465, -92}, {0xc1d4, -50}, {0x56d5, -30}, {0x54ed, -37}, {0x78e9, -10},
+    {0xc4db, -50}, {0x59e2, -92}, {0xdac2, -45}, {0x46ed, -40}, {0xc0db, -50},
+    {0x50f3, -55}, {0x59f6, -111}, {0xd5c2, -40}, {0x4ac1, -25}, {0x52dc, -40},
+    {0x544f, -18}, {0x4bea, -25}, {0x42d9, -10}, {0xc359, -70}, {0xc1d5, -50},
+    {0xc177, -74}, {0xd5c5, -40}, {0x766f, -15}, {0x4b4f, -30}, {0x6be9, -30},
+    {0x9292, -74}, {0x4fc2, -40}, {0xa0c4, -37}, {0x4af2, -40}, {0xc254, -55},
+    {0xd9c3, -45}, {0xc5c7, -65}, {0x2056, -70}, {0xd6c1, -40}, {0x56e1, -111},
+    {0x4bd3, -30}, {0xf4ff, -10}, {0xc554, -55}, {0x77f5, -15}, {0x56c0, -85},
+    {0xff2c, -37}, {0xc0c7, -65}, {0x77e4, -10}, {0xf3ff, -10}, {0x9f3a, -92},
+    {0xdde8, -71}, {0x4be9, -25}, {0xc4dd, -70}, {0xc051, -55}, {0x6f76, -15},
+    {0xc5d9, -50}, {0xc0d3, -50}, {0x76eb, -15}, {0xddfc, -92}, {0x2041, -37},
+    {0x4be8, -25}, {0x77ea, -10}, {0x5961, -92}, {0x57d4, -15}, {0xc0fd, -74},
+    {0xc1d9, -50}, {0x572c, -74}, {0xc39f, -70}, {0x593b, -92}, {0xf879, -10},
+    {0xdd2e, -74}, {0x4c9f, -37}, {0x76f8, -15}, {0xa0c1, -37}, {0x54e9, -92},
+    {0x546f, -95}, {0xd29f, -50}, {0xc1c7, -65}, {0x4aeb, -40}, {0xdac3, -45},
+    {0x792c, -37}, {0xf6ff, -10}, {0x9fc0, -74}, {0xddf2, -111},
+    {0x56f3, -111}, {0xd556, -50}, {0xa0c3, -37}, {0x50c0, -85}, {0x76e8, -15},
+    {0x46c3, -100}, {0xddd5, -25}, {0xc1fc, -30}, {0xc056, -95}, {0xdac0, -45},
+    {0xd2dd, -50}, {0xf176, -40}, {0x57e3, -85}, {0x46f8, -70}, {0x57fc, -55},
+    {0x2c92, -95}, {0xdc41, -45}, {0xdde3, -92}, {0xc3fb, -30}, {0xa09f, -70},
+    {0xc4fa, -30}, {0xc3fa, -30}, {0x4ae1, -40}, {0xc047, -60}, {0xc243, -65},
+    {0xd6c3, -40}, {0x4af8, -40}, {0x5256, -18}, {0xc192, -74}, {0xc2dd, -70},
+    {0x4b75, -20}, {0x59e3, -92}, {0xddd4, -25}, {0x46f3, -70}, {0x77f4, -15},
+    {0x51da, -10}, {0x41d8, -50}, {0x9fe0, -92}, {0x9fc2, -74}, {0x4143, -65},
+    {0x4afa, -40}, {0x57c3, -74}, {0x44c4, -25}, {0xd654, -40}, {0xc377, -74},
+    {0xd8c2, -40}, {0xc592, -74}, {0x41fc, -30}, {0xc075, -30}, {0xd3c4, -40},
+    {0x4f9f, -50}, {0x56ea, -111}, {0xa057, -70}, {0x543a, -74}, {0x666f, -10},
+    {0xfd2e, -37}, {0x57fd, -55}, {0x56c2, -85}, {0x4ec1, -30}, {0x4441, -25},
+    {0x50c5, -85}, {0x4cdd, -37}, {0x6f77, -25}, {0xc59f, -70}, {0xc279, -74},
+    {0x41dc, -50}, {0x54ff, -37}, {0x722e, -65}, {0x4175, -30}, {0x57f4, -80},
+    {0xc0fa, -30}, {0x2e92, -95}, {0x59c1, -74}, {0xd457, -50}, {0xc4d3, -50},
+    {0x54e4, -92}, {0x4157, -100}, {0xc0f9, -30}, {0xdd69, -55},
+    {0xddf3, -111}, {0x542c, -92}, {0xc3f9, -30}, {0x9fe2, -92}, {0x54c3, -55},
+    {0x9191, -74}, {0x4ac0, -25}, {0x4672, -50}, {0xc392, -74}, {0x44c1, -25},
+    {0xdd2c, -92}, {0x2059, -70}, {0x4a41, -25}, {0x57e0, -85}, {0xd241, -40},
+    {0xd3c1, -40}, {0x6666, -18}, {0x4af4, -40}, {0x9fe9, -111}, {0x529f, -18},
+    {0xc092, -74}, {0xdde4, -92}, {0x572e, -74}, {0xdcc4, -45}, {0x5661, -111},
+    {0x54f2, -95}, {0xc543, -65}, {0x56f9, -55}, {0x9ff8, -111}, {0xddc0, -74},
+    {0xc1ff, -74}, {0x66f4, -10}, {0x56e2, -111}, {0xd8c1, -40}, {0x4cff, -37},
+    {0x57c2, -74}, {0x502c, -129}, {0xc3ff, -74}, {0xc4f9, -30}, {0x563b, -74},
+    {0x4bf9, -20}, {0x46c1, -100}, {0x50c1, -85}, {0xc456, -95}, {0x5259, -18},
+    {0xd9c0, -45}, {0x4ae3, -40}, {0xd658, -40}, {0xd456, -50}, {0xd49f, -50},
+    {0x50c4, -85}, {0xd4c2, -40}, {0x57c4, -74}, {0x77eb, -10}, {0xf676, -15},
+    {0x54ea, -92}, {0x42c2, -25}, {0x20dd, -70}, {0x54c4, -55}, {0x42da, -10},
+    {0xc09f, -70}, {0x57ad, -50}, {0xc5f9, -30}, {0x762c, -37}, {0x4bfd, -20},
+    {0x462e, -129}, {0xa059, -70}, {0x59d2, -25}, {0x77e1, -10}, {0x9f2c, -92},
+    {0x62fa, -20}, {0x4ae5, -40}, {0x562d, -70}, {0xc156, -95}, {0xc4dc, -50},
+    {0xc551, -55}, {0x46e2, -95}, {0xe76b, -10}, {0x42db, -10}, {0x2057, -70},
+    {0x596f, -111}, {0x59e4, -92}, {0x46e9, -100}, {0x76f3, -15},
+    {0xc4ff, -74}, {0xc379, -74}, {0xc2d3, -50}, {0x77f8, -15}, {0x4a65, -40},
+    {0xc4da, -50}, {0x52da, -40}, {0xd6c5, -40}, {0x4bff, -20}, {0x5765, -90},
+    {0x42c3, -25}, {0x4c92, -55}, {0xddd6, -25}, {0xc0dd, -70}, {0xf5ff, -10},
+    {0xc1d3, -50}, {0xd358, -40}, {0xc356, -95}, {0xc2fb, -30}, {0x46ef, -40},
+    {0xc5da, -50}, {0xc2d5, -50}, {0x542d, -92}, {0x9f61, -92}, {0x6275, -20},
+    {0xd657, -50}, {0x52d8, -40}, {0x44dd, -50}, {0xc477, -74}, {0xc2fc, -30},
+    {0x56e4, -111}, {0x59e5, -92}, {0xd5c1, -40}, {0xc576, -74}, {0x5155, -10},
+    {0xff2e, -37}, {0x57d3, -15}, {0xc2dc, -50}, {0x77e9, -10}, {0x4ec2, -30},
+    {0x9fd4, -25}, {0xc5fd, -74}, {0x59c2, -74}, {0x502e, -129}, {0xdde2, -92},
+    {0x594f, -25}, {0x59f9, -92}, {0xc5d8, -50}, {0x59e9, -111}, {0x41d5, -50},
+    {0xc4fd, -74}, {0x4bfc, -20}, {0x4a2c, -10}, {0x6bf8, -10}, {0x593a, -92},
+    {0xc555, -50}, {0xddeb, -71}, {0x4c57, -37}, {0x59f8, -111}, {0x41d2, -50},
+    {0xdde0, -92}, {0x9f2d, -92}, {0x9fd2, -25}, {0xc147, -60}, {0x56f8, -111},
+    {0xf876, -15}, {0xc455, -50}, {0x9ff9, -92}, {0xc0dc, -50}, {0x56f5, -111},
+    {0xdbc1, -45}, {0x6262, -10}, {0x9feb, -71}, {0x46c2, -100},
+};
+
+static const struct kern_table times_bold_italic_kerns = {
+    times_bold_italic_kern_seeds,
+    times_bold_italic_kern_pairs,
+    256,
+    1012,
+    {0x00, 0x00, 0x00, 0x00, 0x01, 0x50, 0x00, 0x00, 0x56, 0xdc, 0xf7,
+     0x02, 0x6c, 0xc8, 0xc4, 0x03, 0x00, 0x00, 0x06, 0x80, 0x01, 0x00,
+     0x00, 0x00, 0x3f, 0x00, 0x7e, 0x3f, 0x80, 0x0f, 0x7e, 0xa1},
+};
+
+static inline uint32_t kern_hash(uint16_t pair, uint16_t seed,
+                                 uint32_t range)
+{
+    uint32_t x = pair | (uint32_t)seed << 16;
+
+    x ^= x >> 16;
+    x *= 0x85ebca6b;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35;
+    x ^= x >> 16;
+    return (uint32_t)(((uint64_t)x * range) >> 32);
+}
+
+/**
+ * Look up the kerning between two characters
+ * @return Adjustment in thousandths of an em, 0 if the pair isn't kerned
+ */
+static int font_kerning(const struct kern_table *kerns, uint8_t left,
+                        uint8_t right)
+{
+    uint16_t pair = (uint16_t)(left << 8 | right);
+    const struct kern_pair *entry;
+    uint16_t seed;
+
+    if (!(kerns->left[left >> 3] & (1 << (left & 7))))
+        return 0;
+    seed = kerns->seeds[kern_hash(pair, 0, kerns->bucket_count)];
+    entry = &kerns->pairs[kern_hash(pair, seed, kerns->pair_count)];
+    return entry->pair == pair ? entry->kern : 0;
+}
+
+static const struct kern_table *find_font_kerns(const char *font_name)
+{
+    if (strcasecmp(font_name, "Helvetica") == 0 ||
+        strcasecmp(font_name, "Helvetica-Oblique") == 0)
+        return &helvetica_kerns;
+    if (strcasecmp(font_name, "Helvetica-Bold") == 0 ||
+        strcasecmp(font_name, "Helvetica-BoldOblique") == 0)
+        return &helvetica_bold_kerns;
+    if (strcasecmp(font_name, "Times-Roman") == 0)
+        return &times_kerns;
+    if (strcasecmp(font_name, "Times-Bold") == 0)
+        return &times_bold_kerns;
+    if (strcasecmp(font_name, "Times-Italic") == 0)
+        return &times_italic_kerns;
+    if (strcasecmp(font_name, "Times-BoldItalic") == 0)
+        return &times_bold_italic_kerns;
+
+    return NULL;
+}
+
+int pdf_get_font_text_width(struct pdf_doc *pdf, const char *font_name,
+                            const char *text, float size, float *text_width)
+{
+    const struct pdf_object *font = pdf->current_font;
+    const uint16_t *widths;
+    const struct kern_table *kerns;
+
+    /* Fonts in the document have their widths looked up already */
+    if (font_name)
+        font = pdf_find_font(pdf, font_name);
+    if (font && font->font.embed) {
+        int e = pdf_decode_text(pdf, text, strlen(text), font, true,
+                                &pdf->glyphs);
+        if (e < 0)
+            return e;
+        *text_width = pdf->glyphs.widths[pdf->glyphs.count] * size /
+                      pdf_font_units(font);
+        return 0;
+    }
+    if (font) {
+        widths = font->font.widths;
+        kerns = font->font.kerns;
+    } else {
+        widths = find_font_widths(font_name);
+        kerns = find_font_kerns(font_name);
+    }
+    if (!pdf->kerning)
+        kerns = NULL;
+
+    if (!widths)
+        return pdf_set_err(pdf, -EINVAL,
+                           "Unable to determine width for font '%s'",
+                           font ? font->font.name : font_name);
+    return pdf_text_point_width(pdf, text, -1, size, widths, kerns,
+                                text_width);
+}
+
+/**
+ * State for breaking a run of decoded text into lines
+ */
+struct text_wrap {
+    const struct pdf_glyphs *glyphs;
+    float size;
+    float units; /* Font width units per point of size */
+    const struct kern_table *kerns; /* Kerning the text was measured with */
+    float wrap_width;
+    int start;      /* First character of the next line */
+    int line_start; /* First character of the most recent line */
+    int line_end;   /* Character after the most recent line */
+    int scan_from;  /* Characters in [scan_from, scan_end) are not spaces */
+    int scan_end;
+};
+
+static float text_wrap_width(const struct text_wrap *wrap, int start, int end)
+{
+    const uint8_t *codes = wrap->glyphs->codes;
+    uint32_t len = wrap->glyphs->widths[end] - wrap->glyphs->widths[start];
+
+    /* The kerning with the character before the line isn't drawn */
+    if (wrap->kerns && start > 0 && end > start)
+        len -= KERN_WIDTH(
+            font_kerning(wrap->kerns, codes[start - 1], codes[start]));
+
+    return len * wrap->size / wrap->units;
+}
+
+static int text_wrap_is_space(const struct text_wrap *wrap, int pos)
+{
+    uint8_t code = wrap->glyphs->codes[pos];
+
+    return code < 0x80 && isspace(code);
+}
+
+/**
+ * Find the first whitespace character (or the end of the text) at or after
+ * @from. The last word found is remembered, so that chopping up a long
+ * word doesn't scan over the rest of it again for every piece.
+ */
+static int text_wrap_find_break(struct text_wrap *wrap, int from)
+{
+    int end;
+
+    if (from >= wrap->scan_from && from <= wrap->scan_end)
+        end = wrap->scan_end;
+    else
+        end = from;
+    while (end < wrap->glyphs->count && !text_wrap_is_space(wrap, end))
+        end++;
+
+    if (from < wrap->scan_from || from > wrap->scan_end)
+        wrap->scan_from = from;
+    wrap->scan_end = end;
+    return end;
+}
+
+/**
+ * Work out the next line of wrapped text, which is stored in
+ * wrap->line_start and wrap->line_end.
+ * @return 1 if a line was found, 0 at the end of the text, < 0 on failure
+ */
+static int text_wrap_next(struct pdf_doc *pdf, struct text_wrap *wrap)
+{
+    const struct pdf_glyphs *glyphs = wrap->glyphs;
+    int start = wrap->start;
+    int last_best = start;
+    int end = start;
+
+    if (start >= glyphs->count)
+        return 0;
+
+    /* Move through the text, stopping at word boundaries, trying to find
+     * the longest run of text we can fit in the given width */
+    for (;;) {
+        end = text_wrap_find_break(wrap, end + 1);
+
+        if (text_wrap_width(wrap, start, end) >= wrap->wrap_width) {
+            if (last_best == start) {
+                /* There is a single word that is too long for the line, so
+                 * find the longest piece of it that fits */
+                int lo = start + 1, hi = end - 1;
+
+                if (hi < lo ||
+                    text_wrap_width(wrap, start, lo) >= wrap->wrap_width)
+                    return pdf_set_err(pdf, -EINVAL,
+                                       "Unable to find suitable line break");
+                while (lo < hi) {
+                    int mid = lo + (hi - lo + 1) / 2;
+                    if (text_wrap_width(wrap, start, mid) < wrap->wrap_width)
+                        lo = mid;
+                    else
+                        hi = mid - 1;
+                }
+                end = lo;
+            } else
+                end = last_best;
+            break;
+        }
+        if (end >= glyphs->count || glyphs->codes[end] == '\n' ||
+            glyphs->codes[end] == '\r')
+            break;
+        last_best = end;
+    }
+
+    wrap->line_start = start;
+    wrap->line_end = end;
+    if (end < glyphs->count && glyphs->codes[end] == ' ')
+        end++;
+    wrap->start = end;
+
+    return 1;
+}
+
+static int text_wrap_init(struct pdf_doc *pdf, struct text_wrap *wrap,
+                          const char *text, float size, float wrap_width)
+{
+    const struct pdf_object *font = pdf->current_font;
+    int e;
+
+    if (!font->font.widths && !font->font.embed)
+        return pdf_set_err(pdf, -EINVAL,
+                           "Unable to determine width for font '%s'",
+                           font->font.name);
+
+    e = pdf_decode_text(pdf, text, text ? strlen(text) : 0, font, true,
+                        &pdf->glyphs);
+    if (e < 0)
+        return e;
+
+    memset(wrap, 0, sizeof(*wrap));
+    wrap->glyphs = &pdf->glyphs;
+    wrap->size = size;
+    wrap->units = pdf_font_units(font);
+    wrap->kerns = pdf_font_kerns(pdf, font);
+    wrap->wrap_width = wrap_width;
+
+    return 0;
+}
+
+int pdf_get_text_wrap_lines(struct pdf_doc *pdf, const char *text,
+                            float size, float wrap_width,
+                            struct pdf_text_line *lines, int max_lines,
+                            float *height)
+{
+    struct text_wrap wrap;
+    int count = 0;
+    int e;
+
+    e = text_wrap_init(pdf, &wrap, text, size, wrap_width);
+    if (e < 0)
+        return e;
+
+    while ((e = text_wrap_next(pdf, &wrap)) > 0) {
+        if (count < max_lines) {
+            const uint32_t *offsets = wrap.glyphs->offsets;
+            struct pdf_text_line *line = &lines[count];
+
+            line->offset = offsets[wrap.line_start];
+            line->length = offsets[wrap.line_end] - offsets[wrap.line_start];
+            line->width = text_wrap_width(&wrap, wrap.line_start,
+                                          wrap.line_end);
+        }
+        count++;
+    }
+    if (e < 0)
+        return e;
+
+    if (height)
+        *height = count * size;
+    return count;
+}
+
+/**
+ * Draw one line of wrapped text with the given alignment
+ * @param codes PDF encoded characters of the line
+ * @param gids Glyph IDs of the line, for TrueType fonts
+ * @param len Number of characters in the line
+ * @param byte_len Length of the line in the original text
+ * @param line_width Width of the line
+ * @param hard_break Whether the line ends at a newline or the end of the text
+ */
+static int pdf_add_wrapped_line(struct pdf_doc *pdf, struct pdf_object *page,
+                                const uint8_t *codes, const uint16_t *gids,
+                                int len, int byte_len, float line_width,
+                                int hard_break,
+                                const struct pdf_object *font,
+                                const struct kern_table *kerns, float size,
+                                float xoff, float yoff, float angle,
+                                uint32_t colour, float wrap_width, int align)
+{
+    float char_spacing = 0;
+
+    switch (align) {
+    case PDF_ALIGN_RIGHT:
+        xoff += wrap_width - line_width;
+        break;
+    case PDF_ALIGN_CENTER:
+        xoff += (wrap_width - line_width) / 2;
+        break;
+    /* Spacing is spread over the bytes of the line, as it always has been,
+     * rather than the characters */
+    case PDF_ALIGN_JUSTIFY:
+        if (byte_len > 2 && !hard_break)
+            char_spacing = (wrap_width - line_width) / (byte_len - 2);
+        break;
+    case PDF_ALIGN_JUSTIFY_ALL:
+        if (byte_len > 2)
+            char_spacing = (wrap_width - line_width) / (byte_len - 2);
+        break;
+    case PDF_ALIGN_NO_WRITE:
+        return 0;
+    }
+
+    return pdf_add_encoded_text(pdf, page, codes, gids, len, font, kerns,
+                                size, xoff, yoff, colour, char_spacing,
+                                angle);
+}
+
+static int text_wrap_hard_break(const struct text_wrap *wrap)
+{
+    const struct pdf_glyphs *glyphs = wrap->glyphs;
+    int end = wrap->line_end;
+
+    return end >= glyphs->count || glyphs->codes[end] == '\r' ||
+           glyphs->codes[end] == '\n';
+}
+
+int pdf_add_text_wrap(struct pdf_doc *pdf, struct pdf_object *page,
+                      const char *text, float size, float xoff, float yoff,
+                      float angle, uint32_t colour, float wrap_width,
+                      int align, float *height)
+{
+    struct text_wrap wrap;
+    float orig_yoff = yoff;
+    int e;
+
+    e = text_wrap_init(pdf, &wrap, text, size, wrap_width);
+    if (e < 0)
+        return e;
+
+    while ((e = text_wrap_next(pdf, &wrap)) > 0) {
+        const struct pdf_glyphs *glyphs = wrap.glyphs;
+        int start = wrap.line_start, end = wrap.line_end;
+
+        e = pdf_add_wrapped_line(
+            pdf, page, &glyphs->codes[start], &glyphs->gids[start],
+            end - start,
+            (int)(glyphs->offsets[end] - glyphs->offsets[start]),
+            text_wrap_width(&wrap, start, end), text_wrap_hard_break(&wrap),
+            pdf->current_font, wrap.kerns, size, xoff, yoff, angle, colour,
+            wrap_width, align);
+        if (e < 0)
+            return e;
+
+        yoff -= size;
+    }
+    if (e < 0)
+        return e;
+
+    if (height)
+        *height = orig_yoff - yoff;
+    return 0;
+}
+
+struct text_layout_line {
+    struct pdf_text_line line;
+    int start; /* First character of the line in codes */
+    int count; /* Number of characters in the line */
+    int hard_break;
 };
 
-static const uint16_t courier_widths[256] = {
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604, 604,
-    604,
+struct pdf_text_layout {
+    int font; /* Font handle the text was measured in */
+    char font_name[64]; /* and its name, to check it's the same font */
+    const struct pdf_ttf *ttf; /* and its TrueType data, for embedded fonts */
+    const struct kern_table *kerns; /* Kerning the text was measured with */
+    float size;
+    float wrap_width;
+    int line_count;
+    struct text_layout_line *lines;
+    uint8_t *codes; /* PDF encoded characters of the whole text */
+    uint16_t *gids; /* Glyph IDs of the whole text, for TrueType fonts */
 };
 
-static int pdf_text_point_width(struct pdf_doc *pdf, const char *text,
-                                ptrdiff_t text_len, float size,
-                                const uint16_t *widths, float *point_width)
+struct pdf_text_layout *pdf_create_text_layout(struct pdf_doc *pdf,
+                                               const char *text, float size,
+                                               float wrap_width)
 {
-    uint32_t len = 0;
-    if (text_len < 0)
-        text_len = strlen(text);
-    *point_width = 0.0f;
+    struct pdf_text_layout *layout;
+    struct text_wrap wrap;
+    int alloc = 0;
+    int e;
 
-    for (int i = 0; i < (int)text_len;) {
-        uint8_t pdf_char = 0;
-        int code_len;
-        code_len =
-            utf8_to_pdfencoding(pdf, &text[i], text_len - i, &pdf_char);
-        if (code_len < 0)
-            return pdf_set_err(pdf, code_len,
-                               "Invalid unicode string at position %d in %s",
-                               i, text);
-        i += code_len;
+    e = text_wrap_init(pdf, &wrap, text, size, wrap_width);
+    if (e < 0)
+        return NULL;
 
-        if (pdf_char != '\n' && pdf_char != '\r')
-            len += widths[pdf_char];
+    layout = (struct pdf_text_layout *)calloc(1, sizeof(*layout));
+    if (!layout) {
+        pdf_set_err(pdf, -ENOMEM, "Unable to allocate text layout");
+        return NULL;
     }
+    layout->font = pdf->current_font->font.index;
+    strcpy(layout->font_name, pdf->current_font->font.name);
+    layout->kerns = wrap.kerns;
+    layout->size = size;
+    layout->wrap_width = wrap_width;
+    layout->codes = (uint8_t *)malloc(wrap.glyphs->count + 1);
+    if (!layout->codes) {
+        pdf_set_err(pdf, -ENOMEM, "Unable to allocate text layout");
+        pdf_destroy_text_layout(layout);
+        return NULL;
+    }
+    memcpy(layout->codes, wrap.glyphs->codes, wrap.glyphs->count);
+    if (pdf->current_font->font.embed) {
+        layout->gids = (uint16_t *)malloc((wrap.glyphs->count + 1) *
+                                          sizeof(*layout->gids));
+        if (!layout->gids) {
+            pdf_set_err(pdf, -ENOMEM, "Unable to allocate text layout");
+            pdf_destroy_text_layout(layout);
+            return NULL;
+        }
+        memcpy(layout->gids, wrap.glyphs->gids,
+               wrap.glyphs->count * sizeof(*layout->gids));
+        layout->ttf = pdf->current_font->font.embed->ttf;
+    }
+
+    while ((e = text_wrap_next(pdf, &wrap)) > 0) {
+        const uint32_t *offsets = wrap.glyphs->offsets;
+        struct text_layout_line *line;
+
+        if (layout->line_count == alloc) {
+            int new_alloc = alloc ? alloc * 2 : 8;
+            struct text_layout_line *lines = (struct text_layout_line *)realloc(
+                layout->lines, new_alloc * sizeof(*lines));
+            if (!lines) {
+                pdf_set_err(pdf, -ENOMEM, "Unable to allocate text layout");
+                pdf_destroy_text_layout(layout);
+                return NULL;
+            }
+            layout->lines = lines;
+            alloc = new_alloc;
+        }
 
-    /* Our widths arrays are for 14pt fonts */
-    *point_width = len * size / (14.0f * 72.0f);
+        line = &layout->lines[layout->line_count++];
+        line->line.offset = offsets[wrap.line_start];
+        line->line.length = offsets[wrap.line_end] - offsets[wrap.line_start];
+        line->line.width =
+            text_wrap_width(&wrap, wrap.line_start, wrap.line_end);
+        line->start = wrap.line_start;
+        line->count = wrap.line_end - wrap.line_start;
+        line->hard_break = text_wrap_hard_break(&wrap);
+    }
+    if (e < 0) {
+        pdf_destroy_text_layout(layout);
+        return NULL;
+    }
 
-    return 0;
+    return layout;
 }
 
-static const uint16_t *find_font_widths(const char *font_name)
+void pdf_destroy_text_layout(struct pdf_text_layout *layout)
 {
-    if (strcasecmp(font_name, "Helvetica") == 0)
-        return helvetica_widths;
-    if (strcasecmp(font_name, "Helvetica-Bold") == 0)
-        return helvetica_bold_widths;
-    if (strcasecmp(font_name, "Helvetica-BoldOblique") == 0)
-        return helvetica_bold_oblique_widths;
-    if (strcasecmp(font_name, "Helvetica-Oblique") == 0)
-        return helvetica_oblique_widths;
-    if (strcasecmp(font_name, "Courier") == 0 ||
-        strcasecmp(font_name, "Courier-Bold") == 0 ||
-        strcasecmp(font_name, "Courier-BoldOblique") == 0 ||
-        strcasecmp(font_name, "Courier-Oblique") == 0)
-        return courier_widths;
-    if (strcasecmp(font_name, "Times-Roman") == 0)
-        return times_widths;
-    if (strcasecmp(font_name, "Times-Bold") == 0)
-        return times_bold_widths;
-    if (strcasecmp(font_name, "Times-Italic") == 0)
-        return times_italic_widths;
-    if (strcasecmp(font_name, "Times-BoldItalic") == 0)
-        return times_bold_italic_widths;
-    if (strcasecmp(font_name, "Symbol") == 0)
-        return symbol_widths;
-    if (strcasecmp(font_name, "ZapfDingbats") == 0)
-        return zapfdingbats_widths;
-
-    return NULL;
+    if (layout) {
+        free(layout->lines);
+        free(layout->codes);
+        free(layout->gids);
+        free(layout);
+    }
 }
 
-int pdf_get_font_text_width(struct pdf_doc *pdf, const char *font_name,
-                            const char *text, float size, float *text_width)
+int pdf_text_layout_line_count(const struct pdf_text_layout *layout)
 {
-    if (!font_name)
-        font_name = pdf->current_font->font.name;
-    const uint16_t *widths = find_font_widths(font_name);
-
-    if (!widths)
-        return pdf_set_err(pdf, -EINVAL,
-                           "Unable to determine width for font '%s'",
-                           pdf->current_font->font.name);
-    return pdf_text_point_width(pdf, text, -1, size, widths, text_width);
+    return layout->line_count;
 }
 
-static const char *find_word_break(const char *string)
+float pdf_text_layout_height(const struct pdf_text_layout *layout)
 {
-    if (!string)
-        return NULL;
-    /* Skip over the actual word */
-    while (*string && !isspace(*string))
-        string++;
+    return layout->line_count * layout->size;
+}
 
-    return string;
+int pdf_text_layout_get_line(const struct pdf_text_layout *layout, int n,
+                             struct pdf_text_line *line)
+{
+    if (n < 0 || n >= layout->line_count)
+        return -EINVAL;
+    *line = layout->lines[n].line;
+    return 0;
 }
 
-int pdf_add_text_wrap(struct pdf_doc *pdf, struct pdf_object *page,
-                      const char *text, float size, float xoff, float yoff,
-                      float angle, uint32_t colour, float wrap_width,
-                      int align, float *height)
+int pdf_add_text_layout(struct pdf_doc *pdf, struct pdf_object *page,
+                        const struct pdf_text_layout *layout, float xoff,
+                        float yoff, float angle, uint32_t colour, int align)
 {
-    /* Move through the text string, stopping at word boundaries,
-     * trying to find the longest text string we can fit in the given width
-     */
-    const char *start = text;
-    const char *last_best = text;
-    const char *end = text;
-    char line[512];
-    const uint16_t *widths;
-    float orig_yoff = yoff;
+    const struct pdf_object *font = NULL;
 
-    widths = find_font_widths(pdf->current_font->font.name);
-    if (!widths)
+    if (layout->font > 0)
+        font = (struct pdf_object *)flexarray_get(&pdf->fonts,
+                                                  layout->font - 1);
+    if (!font || strcmp(font->font.name, layout->font_name) != 0 ||
+        (font->font.embed ? font->font.embed->ttf : NULL) != layout->ttf)
         return pdf_set_err(pdf, -EINVAL,
-                           "Unable to determine width for font '%s'",
-                           pdf->current_font->font.name);
+                           "Text layout font %d is not in this document",
+                           layout->font);
 
-    while (start && *start) {
-        const char *new_end = find_word_break(end + 1);
-        float line_width;
-        int output = 0;
-        float xoff_align = xoff;
+    for (int i = 0; i < layout->line_count; i++) {
+        const struct text_layout_line *line = &layout->lines[i];
         int e;
 
-        end = new_end;
-
-        e = pdf_text_point_width(pdf, start, end - start, size, widths,
-                                 &line_width);
+        e = pdf_add_wrapped_line(
+            pdf, page, &layout->codes[line->start],
+            layout->gids ? &layout->gids[line->start] : NULL, line->count,
+            (int)line->line.length, line->line.width, line->hard_break, font,
+            layout->kerns, layout->size, xoff, yoff, angle, colour,
+            layout->wrap_width, align);
         if (e < 0)
             return e;
 
-        if (line_width >= wrap_width) {
-            if (last_best == start) {
-                /* There is a single word that is too long for the line */
-                ptrdiff_t i;
-                /* Find the best character to chop it at */
-                for (i = end - start - 1; i > 0; i--) {
-                    float this_width;
-                    // Don't look at places that are in the middle of a utf-8
-                    // sequence
-                    if ((start[i - 1] & 0xc0) == 0xc0 ||
-                        ((start[i - 1] & 0xc0) == 0x80 &&
-                         (start[i] & 0xc0) == 0x80))
-                        continue;
-                    e = pdf_text_point_width(pdf, start, i, size, widths,
-                                             &this_width);
-                    if (e < 0)
-                        return e;
-                    if (this_width < wrap_width)
-                        break;
-                }
-                if (i == 0)
-                    return pdf_set_err(pdf, -EINVAL,
-                                       "Unable to find suitable line break");
-
-                end = start + i;
-            } else
-                end = last_best;
-            output = 1;
-        }
-        if (*end == '\0')
-            output = 1;
-
-        if (*end == '\n' || *end == '\r')
-            output = 1;
-
-        if (output) {
-            int len = end - start;
-            float char_spacing = 0;
-            if (len >= (int)sizeof(line))
-                len = (int)sizeof(line) - 1;
-            strncpy(line, start, len);
-            line[len] = '\0';
-
-            e = pdf_text_point_width(pdf, start, len, size, widths,
-                                     &line_width);
-            if (e < 0)
-                return e;
-
-            switch (align) {
-            case PDF_ALIGN_RIGHT:
-                xoff_align += wrap_width - line_width;
-                break;
-            case PDF_ALIGN_CENTER:
-                xoff_align += (wrap_width - line_width) / 2;
-                break;
-            case PDF_ALIGN_JUSTIFY:
-                if ((len - 1) > 0 && *end != '\r' && *end != '\n' &&
-                    *end != '\0')
-                    char_spacing = (wrap_width - line_width) / (len - 2);
-                break;
-            case PDF_ALIGN_JUSTIFY_ALL:
-                if ((len - 1) > 0)
-                    char_spacing = (wrap_width - line_width) / (len - 2);
-                break;
-            }
-
-            if (align != PDF_ALIGN_NO_WRITE) {
-                pdf_add_text_spacing(pdf, page, line, size, xoff_align, yoff,
-                                     colour, char_spacing, angle);
-            }
-
-            if (*end == ' ')
-                end++;
-
-            start = last_best = end;
-            yoff -= size;
-        } else
-            last_best = end;
+        yoff -= layout->size;
     }
 
-    if (height)
-        *height = orig_yoff - yoff;
     return 0;
 }
 
@@ -2048,6 +7159,39 @@ int pdf_add_line(struct pdf_doc *pdf, struct pdf_object *page, float x1,
     return ret;
 }
 
+int pdf_add_lines(struct pdf_doc *pdf, struct pdf_object *page,
+                  const float *points, int count, float width,
+                  uint32_t colour)
+{
+    int ret;
+    bool failed = false;
+    struct dstr str = INIT_DSTR;
+
+    if (count < 0 || (count > 0 && !points))
+        return pdf_set_err(pdf, -EINVAL, "Invalid line count %d", count);
+    if (count == 0)
+        return 0;
+
+    /* Every line becomes a subpath of a single path, so the width & colour
+     * are only set once and the lot is stroked with one operator */
+    failed |= dstr_printf(&str, "%f w\r\n", width) < 0;
+    failed |= dstr_printf(&str, "/DeviceRGB CS\r\n") < 0;
+    failed |= dstr_printf(&str, "%f %f %f RG\r\n", PDF_RGB_R(colour),
+                          PDF_RGB_G(colour), PDF_RGB_B(colour)) < 0;
+    for (int i = 0; i < count && !failed; i++, points += 4)
+        failed |= dstr_printf(&str, "%f %f m %f %f l\r\n", points[0],
+                              points[1], points[2], points[3]) < 0;
+    failed |= dstr_append(&str, "S") < 0;
+
+    if (failed)
+        ret = pdf_set_err(pdf, -ENOMEM, "Unable to allocate lines");
+    else
+        ret = pdf_add_stream(pdf, page, dstr_data(&str));
+    dstr_free(&str);
+
+    return ret;
+}
+
 int pdf_add_cubic_bezier(struct pdf_doc *pdf, struct pdf_object *page,
                          float x1, float y1, float x2, float y2, float xq1,
                          float yq1, float xq2, float yq2, float width,
@@ -2242,6 +7386,44 @@ int pdf_add_filled_rectangle(struct pdf_doc *pdf, struct pdf_object *page,
     return ret;
 }
 
+int pdf_add_rectangles(struct pdf_doc *pdf, struct pdf_object *page,
+                       const float *rects, int count, float border_width,
+                       uint32_t colour, uint32_t fill_colour)
+{
+    int ret;
+    bool failed = false;
+    bool fill = !PDF_IS_TRANSPARENT(fill_colour);
+    bool stroke = !fill || border_width > 0;
+    struct dstr str = INIT_DSTR;
+
+    if (count < 0 || (count > 0 && !rects))
+        return pdf_set_err(pdf, -EINVAL, "Invalid rectangle count %d", count);
+    if (count == 0)
+        return 0;
+
+    if (fill)
+        failed |= dstr_printf(&str, "%f %f %f rg ", PDF_RGB_R(fill_colour),
+                              PDF_RGB_G(fill_colour),
+                              PDF_RGB_B(fill_colour)) < 0;
+    if (stroke) {
+        failed |= dstr_printf(&str, "%f %f %f RG ", PDF_RGB_R(colour),
+                              PDF_RGB_G(colour), PDF_RGB_B(colour)) < 0;
+        failed |= dstr_printf(&str, "%f w ", border_width) < 0;
+    }
+    for (int i = 0; i < count && !failed; i++, rects += 4)
+        failed |= dstr_printf(&str, "%f %f %f %f re ", rects[0], rects[1],
+                              rects[2], rects[3]) < 0;
+    failed |= dstr_append(&str, fill ? (stroke ? "B" : "f") : "S") < 0;
+
+    if (failed)
+        ret = pdf_set_err(pdf, -ENOMEM, "Unable to allocate rectangles");
+    else
+        ret = pdf_add_stream(pdf, page, dstr_data(&str));
+    dstr_free(&str);
+
+    return ret;
+}
+
 int pdf_add_polygon(struct pdf_doc *pdf, struct pdf_object *page, float x[],
                     float y[], int count, float border_width, uint32_t colour)
 {
@@ -2329,9 +7511,20 @@ static int find_128_encoding(char ch)
     return -1;
 }
 
-static float pdf_barcode_128a_ch(struct pdf_doc *pdf, struct pdf_object *page,
-                                 float x, float y, float width, float height,
-                                 uint32_t colour, int index, int code_len)
+/**
+ * Append a single bar to the path being built for a barcode
+ */
+static int pdf_barcode_bar(struct pdf_doc *pdf, struct dstr *bars, float x,
+                           float y, float width, float height)
+{
+    if (dstr_printf(bars, "%f %f %f %f re ", x, y, width, height) < 0)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate barcode");
+    return 0;
+}
+
+static int pdf_barcode_128a_ch(struct pdf_doc *pdf, struct dstr *bars,
+                               float x, float y, float width, float height,
+                               int index, int code_len, float *new_x)
 {
     uint32_t code = code_128a_encoding[index].code;
     float line_width = width / 11.0f;
@@ -2340,22 +7533,24 @@ static float pdf_barcode_128a_ch(struct pdf_doc *pdf, struct pdf_object *page,
         uint8_t shift = (code_len - 1 - i) * 4;
         uint8_t mask = (code >> shift) & 0xf;
 
-        if (!(i % 2))
-            pdf_add_filled_rectangle(pdf, page, x, y, line_width * mask,
-                                     height, 0, colour, PDF_TRANSPARENT);
+        if (!(i % 2) && pdf_barcode_bar(pdf, bars, x, y, line_width * mask,
+                                        height) < 0)
+            return pdf->errval;
         x += line_width * mask;
     }
-    return x;
+    if (new_x)
+        *new_x = x;
+    return 0;
 }
 
-static int pdf_add_barcode_128a(struct pdf_doc *pdf, struct pdf_object *page,
+static int pdf_add_barcode_128a(struct pdf_doc *pdf, struct dstr *bars,
                                 float x, float y, float width, float height,
-                                const char *string, uint32_t colour)
+                                const char *string)
 {
     const char *s;
     size_t len = strlen(string) + 3;
     float char_width = width / len;
-    int checksum, i;
+    int checksum, i, e;
 
     if (char_width / 11.0f <= 0)
         return pdf_set_err(pdf, -EINVAL,
@@ -2366,8 +7561,9 @@ static int pdf_add_barcode_128a(struct pdf_doc *pdf, struct pdf_object *page,
             return pdf_set_err(pdf, -EINVAL, "Invalid barcode character 0x%x",
                                *s);
 
-    x = pdf_barcode_128a_ch(pdf, page, x, y, char_width, height, colour, 104,
-                            6);
+    e = pdf_barcode_128a_ch(pdf, bars, x, y, char_width, height, 104, 6, &x);
+    if (e < 0)
+        return e;
     checksum = 104;
 
     for (i = 1, s = string; *s; s++, i++) {
@@ -2377,14 +7573,18 @@ static int pdf_add_barcode_128a(struct pdf_doc *pdf, struct pdf_object *page,
         if (index < 0)
             return pdf_set_err(pdf, -EINVAL,
                                "Invalid 128a barcode character 0x%x", *s);
-        x = pdf_barcode_128a_ch(pdf, page, x, y, char_width, height, colour,
-                                index, 6);
+        e = pdf_barcode_128a_ch(pdf, bars, x, y, char_width, height, index,
+                                6, &x);
+        if (e < 0)
+            return e;
         checksum += index * i;
     }
-    x = pdf_barcode_128a_ch(pdf, page, x, y, char_width, height, colour,
-                            checksum % 103, 6);
-    pdf_barcode_128a_ch(pdf, page, x, y, char_width, height, colour, 106, 7);
-    return 0;
+    e = pdf_barcode_128a_ch(pdf, bars, x, y, char_width, height,
+                            checksum % 103, 6, &x);
+    if (e < 0)
+        return e;
+    return pdf_barcode_128a_ch(pdf, bars, x, y, char_width, height, 106, 7,
+                               NULL);
 }
 
 /* Code 39 character encoding. Each 4-bit value indicates:
@@ -2422,9 +7622,9 @@ static int find_39_encoding(char ch)
     return -1;
 }
 
-static int pdf_barcode_39_ch(struct pdf_doc *pdf, struct pdf_object *page,
-                             float x, float y, float char_width, float height,
-                             uint32_t colour, char ch, float *new_x)
+static int pdf_barcode_39_ch(struct pdf_doc *pdf, struct dstr *bars, float x,
+                             float y, float char_width, float height, char ch,
+                             float *new_x)
 {
     float nw = char_width / 12.0f;
     float ww = char_width / 4.0f;
@@ -2438,14 +7638,12 @@ static int pdf_barcode_39_ch(struct pdf_doc *pdf, struct pdf_object *page,
     for (int i = 5; i >= 0; i--) {
         int pattern = (code >> i * 4) & 0xf;
         if (pattern == 0) { // wide
-            if (pdf_add_filled_rectangle(pdf, page, x, y, ww - 1, height, 0,
-                                         colour, PDF_TRANSPARENT) < 0)
+            if (pdf_barcode_bar(pdf, bars, x, y, ww - 1, height) < 0)
                 return pdf->errval;
             x += ww;
         }
         if (pattern == 1) { // narrow
-            if (pdf_add_filled_rectangle(pdf, page, x, y, nw - 1, height, 0,
-                                         colour, PDF_TRANSPARENT) < 0)
+            if (pdf_barcode_bar(pdf, bars, x, y, nw - 1, height) < 0)
                 return pdf->errval;
             x += nw;
         }
@@ -2458,29 +7656,27 @@ static int pdf_barcode_39_ch(struct pdf_doc *pdf, struct pdf_object *page,
     return 0;
 }
 
-static int pdf_add_barcode_39(struct pdf_doc *pdf, struct pdf_object *page,
-                              float x, float y, float width, float height,
-                              const char *string, uint32_t colour)
+static int pdf_add_barcode_39(struct pdf_doc *pdf, struct dstr *bars, float x,
+                              float y, float width, float height,
+                              const char *string)
 {
     size_t len = strlen(string);
     float char_width = width / (len + 2);
     int e;
 
-    e = pdf_barcode_39_ch(pdf, page, x, y, char_width, height, colour, '*',
-                          &x);
+    e = pdf_barcode_39_ch(pdf, bars, x, y, char_width, height, '*', &x);
     if (e < 0)
         return e;
 
     while (string && *string) {
-        e = pdf_barcode_39_ch(pdf, page, x, y, char_width, height, colour,
-                              *string, &x);
+        e = pdf_barcode_39_ch(pdf, bars, x, y, char_width, height, *string,
+                              &x);
         if (e < 0)
             return e;
         string++;
     }
 
-    e = pdf_barcode_39_ch(pdf, page, x, y, char_width, height, colour, '*',
-                          NULL);
+    e = pdf_barcode_39_ch(pdf, bars, x, y, char_width, height, '*', NULL);
     if (e < 0)
         return e;
 
@@ -2598,10 +7794,9 @@ static void pdf_barcode_eanupc_calc_dims(int type, float width, float height,
     *y_off = (height - *new_height) / 2.0f;
 }
 
-static int pdf_barcode_eanupc_ch(struct pdf_doc *pdf, struct pdf_object *page,
+static int pdf_barcode_eanupc_ch(struct pdf_doc *pdf, struct dstr *bars,
                                  float x, float y, float x_width,
-                                 float height, uint32_t colour, char ch,
-                                 int set, float *new_x)
+                                 float height, char ch, int set, float *new_x)
 {
     if ('0' > ch || ch > '9')
         return pdf_set_err(pdf, -EINVAL, "Invalid EAN/UPC character %c 0x%x",
@@ -2637,8 +7832,7 @@ static int pdf_barcode_eanupc_ch(struct pdf_doc *pdf, struct pdf_object *page,
 
         width *= x_width;
         if (bar) {
-            if (pdf_add_filled_rectangle(pdf, page, x, y, width, height, 0,
-                                         colour, PDF_TRANSPARENT) < 0)
+            if (pdf_barcode_bar(pdf, bars, x, y, width, height) < 0)
                 return pdf->errval;
         }
         x += width;
@@ -2648,11 +7842,9 @@ static int pdf_barcode_eanupc_ch(struct pdf_doc *pdf, struct pdf_object *page,
     return 0;
 }
 
-static int pdf_barcode_eanupc_aux(struct pdf_doc *pdf,
-                                  struct pdf_object *page, float x, float y,
-                                  float x_width, float height,
-                                  uint32_t colour, int guard_type,
-                                  float *new_x)
+static int pdf_barcode_eanupc_aux(struct pdf_doc *pdf, struct dstr *bars,
+                                  float x, float y, float x_width,
+                                  float height, int guard_type, float *new_x)
 {
     int code = code_eanupc_aux_encoding[guard_type];
 
@@ -2660,9 +7852,8 @@ static int pdf_barcode_eanupc_aux(struct pdf_doc *pdf,
         int value = code >> i * 2 & 0x3;
         if (value) {
             if ((i & 0x1) == 0) {
-                if (pdf_add_filled_rectangle(pdf, page, x, y, x_width * value,
-                                             height, 0, colour,
-                                             PDF_TRANSPARENT) < 0)
+                if (pdf_barcode_bar(pdf, bars, x, y, x_width * value,
+                                    height) < 0)
                     return pdf->errval;
             }
             x += x_width * value;
@@ -2674,8 +7865,9 @@ static int pdf_barcode_eanupc_aux(struct pdf_doc *pdf,
 }
 
 static int pdf_add_barcode_ean13(struct pdf_doc *pdf, struct pdf_object *page,
-                                 float x, float y, float width, float height,
-                                 const char *string, uint32_t colour)
+                                 struct dstr *bars, float x, float y,
+                                 float width, float height, const char *string,
+                                 uint32_t colour)
 {
     if (!string)
         return 0;
@@ -2706,7 +7898,7 @@ static int pdf_add_barcode_ean13(struct pdf_doc *pdf, struct pdf_object *page,
     float bar_y = y + new_height - bar_height;
 
     int e;
-    const char *save_font = pdf->current_font->font.name;
+    int save_font = pdf->current_font->font.index;
     e = pdf_set_font(pdf, "Courier"); /* Built-in monospace font */
     if (e < 0)
         return e;
@@ -2716,16 +7908,15 @@ static int pdf_add_barcode_ean13(struct pdf_doc *pdf, struct pdf_object *page,
     text[0] = lead + '0';
     e = pdf_add_text(pdf, page, text, font, x, y, colour);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
     x += eanupc_dimensions[0].quiet_left * x_width;
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y - bar_ext, x_width,
-                               bar_height + bar_ext, colour, GUARD_NORMAL,
-                               &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y - bar_ext, x_width,
+                               bar_height + bar_ext, GUARD_NORMAL, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -2734,25 +7925,24 @@ static int pdf_add_barcode_ean13(struct pdf_doc *pdf, struct pdf_object *page,
         e = pdf_add_text_wrap(pdf, page, text, font, x, y, 0, colour,
                               7 * x_width, PDF_ALIGN_CENTER, NULL);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
 
         int set = (set_ean13_encoding[lead] & 1 << i) ? 1 : 0;
-        e = pdf_barcode_eanupc_ch(pdf, page, x, bar_y, x_width, bar_height,
-                                  colour, *string, set, &x);
+        e = pdf_barcode_eanupc_ch(pdf, bars, x, bar_y, x_width, bar_height,
+                                  *string, set, &x);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
         string++;
     }
 
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y - bar_ext, x_width,
-                               bar_height + bar_ext, colour, GUARD_CENTRE,
-                               &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y - bar_ext, x_width,
+                               bar_height + bar_ext, GUARD_CENTRE, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -2761,24 +7951,23 @@ static int pdf_add_barcode_ean13(struct pdf_doc *pdf, struct pdf_object *page,
         e = pdf_add_text_wrap(pdf, page, text, font, x, y, 0, colour,
                               7 * x_width, PDF_ALIGN_CENTER, NULL);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
 
-        e = pdf_barcode_eanupc_ch(pdf, page, x, bar_y, x_width, bar_height,
-                                  colour, *string, 2, &x);
+        e = pdf_barcode_eanupc_ch(pdf, bars, x, bar_y, x_width, bar_height,
+                                  *string, 2, &x);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
         string++;
     }
 
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y - bar_ext, x_width,
-                               bar_height + bar_ext, colour, GUARD_NORMAL,
-                               &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y - bar_ext, x_width,
+                               bar_height + bar_ext, GUARD_NORMAL, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -2787,16 +7976,17 @@ static int pdf_add_barcode_ean13(struct pdf_doc *pdf, struct pdf_object *page,
          604.0f * font / (14.0f * 72.0f);
     e = pdf_add_text(pdf, page, text, font, x, y, colour);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
-    pdf_set_font(pdf, save_font);
+    pdf_set_font_handle(pdf, save_font);
     return 0;
 }
 
 static int pdf_add_barcode_upca(struct pdf_doc *pdf, struct pdf_object *page,
-                                float x, float y, float width, float height,
-                                const char *string, uint32_t colour)
+                                struct dstr *bars, float x, float y,
+                                float width, float height, const char *string,
+                                uint32_t colour)
 {
     if (!string)
         return 0;
@@ -2819,7 +8009,7 @@ static int pdf_add_barcode_upca(struct pdf_doc *pdf, struct pdf_object *page,
     float bar_y = y + new_height - bar_height;
 
     int e;
-    const char *save_font = pdf->current_font->font.name;
+    int save_font = pdf->current_font->font.index;
     e = pdf_set_font(pdf, "Courier");
     if (e < 0)
         return e;
@@ -2829,16 +8019,15 @@ static int pdf_add_barcode_upca(struct pdf_doc *pdf, struct pdf_object *page,
     text[0] = *string;
     e = pdf_add_text(pdf, page, text, font * 4.0f / 7.0f, x, y, colour);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
     x += eanupc_dimensions[1].quiet_left * x_width;
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y - bar_ext, x_width,
-                               bar_height + bar_ext, colour, GUARD_NORMAL,
-                               &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y - bar_ext, x_width,
+                               bar_height + bar_ext, GUARD_NORMAL, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -2848,26 +8037,25 @@ static int pdf_add_barcode_upca(struct pdf_doc *pdf, struct pdf_object *page,
             e = pdf_add_text_wrap(pdf, page, text, font, x, y, 0, colour,
                                   7 * x_width, PDF_ALIGN_CENTER, NULL);
             if (e < 0) {
-                pdf_set_font(pdf, save_font);
+                pdf_set_font_handle(pdf, save_font);
                 return e;
             }
         }
 
-        e = pdf_barcode_eanupc_ch(pdf, page, x, bar_y - (i ? 0 : bar_ext),
+        e = pdf_barcode_eanupc_ch(pdf, bars, x, bar_y - (i ? 0 : bar_ext),
                                   x_width, bar_height + (i ? 0 : bar_ext),
-                                  colour, *string, 0, &x);
+                                  *string, 0, &x);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
         string++;
     }
 
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y - bar_ext, x_width,
-                               bar_height + bar_ext, colour, GUARD_CENTRE,
-                               &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y - bar_ext, x_width,
+                               bar_height + bar_ext, GUARD_CENTRE, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -2877,26 +8065,25 @@ static int pdf_add_barcode_upca(struct pdf_doc *pdf, struct pdf_object *page,
             e = pdf_add_text_wrap(pdf, page, text, font, x, y, 0, colour,
                                   7 * x_width, PDF_ALIGN_CENTER, NULL);
             if (e < 0) {
-                pdf_set_font(pdf, save_font);
+                pdf_set_font_handle(pdf, save_font);
                 return e;
             }
         }
 
         e = pdf_barcode_eanupc_ch(
-            pdf, page, x, bar_y - (i != 5 ? 0 : bar_ext), x_width,
-            bar_height + (i != 5 ? 0 : bar_ext), colour, *string, 2, &x);
+            pdf, bars, x, bar_y - (i != 5 ? 0 : bar_ext), x_width,
+            bar_height + (i != 5 ? 0 : bar_ext), *string, 2, &x);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
         string++;
     }
 
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y - bar_ext, x_width,
-                               bar_height + bar_ext, colour, GUARD_NORMAL,
-                               &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y - bar_ext, x_width,
+                               bar_height + bar_ext, GUARD_NORMAL, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -2906,16 +8093,17 @@ static int pdf_add_barcode_upca(struct pdf_doc *pdf, struct pdf_object *page,
          604.0f * font * 4.0f / 7.0f / (14.0f * 72.0f);
     e = pdf_add_text(pdf, page, text, font * 4.0f / 7.0f, x, y, colour);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
-    pdf_set_font(pdf, save_font);
+    pdf_set_font_handle(pdf, save_font);
     return 0;
 }
 
 static int pdf_add_barcode_ean8(struct pdf_doc *pdf, struct pdf_object *page,
-                                float x, float y, float width, float height,
-                                const char *string, uint32_t colour)
+                                struct dstr *bars, float x, float y,
+                                float width, float height, const char *string,
+                                uint32_t colour)
 {
     if (!string)
         return 0;
@@ -2938,7 +8126,7 @@ static int pdf_add_barcode_ean8(struct pdf_doc *pdf, struct pdf_object *page,
     float bar_y = y + new_height - bar_height;
 
     int e;
-    const char *save_font = pdf->current_font->font.name;
+    int save_font = pdf->current_font->font.index;
     e = pdf_set_font(pdf, "Courier"); /* Built-in monospace font */
     if (e < 0)
         return e;
@@ -2948,16 +8136,15 @@ static int pdf_add_barcode_ean8(struct pdf_doc *pdf, struct pdf_object *page,
     text[0] = '<';
     e = pdf_add_text(pdf, page, text, font, x, y, colour);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
     x += eanupc_dimensions[2].quiet_left * x_width;
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y - bar_ext, x_width,
-                               bar_height + bar_ext, colour, GUARD_NORMAL,
-                               &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y - bar_ext, x_width,
+                               bar_height + bar_ext, GUARD_NORMAL, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -2966,24 +8153,23 @@ static int pdf_add_barcode_ean8(struct pdf_doc *pdf, struct pdf_object *page,
         e = pdf_add_text_wrap(pdf, page, text, font, x, y, 0, colour,
                               7 * x_width, PDF_ALIGN_CENTER, NULL);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
 
-        e = pdf_barcode_eanupc_ch(pdf, page, x, bar_y, x_width, bar_height,
-                                  colour, *string, 0, &x);
+        e = pdf_barcode_eanupc_ch(pdf, bars, x, bar_y, x_width, bar_height,
+                                  *string, 0, &x);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
         string++;
     }
 
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y - bar_ext, x_width,
-                               bar_height + bar_ext, colour, GUARD_CENTRE,
-                               &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y - bar_ext, x_width,
+                               bar_height + bar_ext, GUARD_CENTRE, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -2992,24 +8178,23 @@ static int pdf_add_barcode_ean8(struct pdf_doc *pdf, struct pdf_object *page,
         e = pdf_add_text_wrap(pdf, page, text, font, x, y, 0, colour,
                               7 * x_width, PDF_ALIGN_CENTER, NULL);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
 
-        e = pdf_barcode_eanupc_ch(pdf, page, x, bar_y, x_width, bar_height,
-                                  colour, *string, 2, &x);
+        e = pdf_barcode_eanupc_ch(pdf, bars, x, bar_y, x_width, bar_height,
+                                  *string, 2, &x);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
         string++;
     }
 
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y - bar_ext, x_width,
-                               bar_height + bar_ext, colour, GUARD_NORMAL,
-                               &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y - bar_ext, x_width,
+                               bar_height + bar_ext, GUARD_NORMAL, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -3018,16 +8203,17 @@ static int pdf_add_barcode_ean8(struct pdf_doc *pdf, struct pdf_object *page,
          604.0f * font / (14.0f * 72.0f);
     e = pdf_add_text(pdf, page, text, font, x, y, colour);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
-    pdf_set_font(pdf, save_font);
+    pdf_set_font_handle(pdf, save_font);
     return 0;
 }
 
 static int pdf_add_barcode_upce(struct pdf_doc *pdf, struct pdf_object *page,
-                                float x, float y, float width, float height,
-                                const char *string, uint32_t colour)
+                                struct dstr *bars, float x, float y,
+                                float width, float height, const char *string,
+                                uint32_t colour)
 {
     if (!string)
         return 0;
@@ -3060,7 +8246,7 @@ static int pdf_add_barcode_upce(struct pdf_doc *pdf, struct pdf_object *page,
     float bar_y = y + new_height - bar_height;
 
     int e;
-    const char *save_font = pdf->current_font->font.name;
+    int save_font = pdf->current_font->font.index;
     e = pdf_set_font(pdf, "Courier");
     if (e < 0)
         return e;
@@ -3070,15 +8256,15 @@ static int pdf_add_barcode_upce(struct pdf_doc *pdf, struct pdf_object *page,
     text[0] = string[0];
     e = pdf_add_text(pdf, page, text, font * 4.0f / 7.0f, x, y, colour);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
     x += eanupc_dimensions[2].quiet_left * x_width;
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y, x_width, bar_height,
-                               colour, GUARD_NORMAL, &x);
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y, x_width, bar_height,
+                               GUARD_NORMAL, &x);
     if (e < 0) {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return e;
     }
 
@@ -3106,7 +8292,7 @@ static int pdf_add_barcode_upce(struct pdf_doc *pdf, struct pdf_object *page,
         X[4] = string[10];
         X[5] = 3;
     } else {
-        pdf_set_font(pdf, save_font);
+        pdf_set_font_handle(pdf, save_font);
         return pdf_set_err(pdf, -EINVAL, "Invalid UPCE string format");
     }
 
@@ -3115,153 +8301,358 @@ static int pdf_add_barcode_upce(struct pdf_doc *pdf, struct pdf_object *page,
         e = pdf_add_text_wrap(pdf, page, text, font, x, y, 0, colour,
                               7 * x_width, PDF_ALIGN_CENTER, NULL);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
 
         int set = (set_upce_encoding[string[11] - '0'] & 1 << i) ? 1 : 0;
-        e = pdf_barcode_eanupc_ch(pdf, page, x, bar_y, x_width, bar_height,
-                                  colour, X[i], set, &x);
+        e = pdf_barcode_eanupc_ch(pdf, bars, x, bar_y, x_width, bar_height,
+                                  X[i], set, &x);
         if (e < 0) {
-            pdf_set_font(pdf, save_font);
+            pdf_set_font_handle(pdf, save_font);
             return e;
         }
     }
 
-    e = pdf_barcode_eanupc_aux(pdf, page, x, bar_y, x_width, bar_height,
-                               colour, GUARD_SPECIAL, &x);
-    if (e < 0) {
-        pdf_set_font(pdf, save_font);
-        return e;
+    e = pdf_barcode_eanupc_aux(pdf, bars, x, bar_y, x_width, bar_height,
+                               GUARD_SPECIAL, &x);
+    if (e < 0) {
+        pdf_set_font_handle(pdf, save_font);
+        return e;
+    }
+
+    text[0] = string[11];
+    x += eanupc_dimensions[0].quiet_right * x_width -
+         604.0f * font * 4.0f / 7.0f / (14.0f * 72.0f);
+    e = pdf_add_text(pdf, page, text, font * 4.0f / 7.0f, x, y, colour);
+    if (e < 0) {
+        pdf_set_font_handle(pdf, save_font);
+        return e;
+    }
+
+    pdf_set_font_handle(pdf, save_font);
+    return 0;
+}
+
+int pdf_add_barcode(struct pdf_doc *pdf, struct pdf_object *page, int code,
+                    float x, float y, float width, float height,
+                    const char *string, uint32_t colour)
+{
+    struct dstr bars = INIT_DSTR;
+    int e;
+
+    if (!string || !*string)
+        return 0;
+
+    /* The bars are gathered into a single path, and filled in one go once
+     * the whole barcode has been laid out */
+    if (dstr_printf(&bars, "%f %f %f rg ", PDF_RGB_R(colour),
+                    PDF_RGB_G(colour), PDF_RGB_B(colour)) < 0)
+        return pdf_set_err(pdf, -ENOMEM, "Unable to allocate barcode");
+
+    switch (code) {
+    case PDF_BARCODE_128A:
+        e = pdf_add_barcode_128a(pdf, &bars, x, y, width, height, string);
+        break;
+    case PDF_BARCODE_39:
+        e = pdf_add_barcode_39(pdf, &bars, x, y, width, height, string);
+        break;
+    case PDF_BARCODE_EAN13:
+        e = pdf_add_barcode_ean13(pdf, page, &bars, x, y, width, height,
+                                  string, colour);
+        break;
+    case PDF_BARCODE_UPCA:
+        e = pdf_add_barcode_upca(pdf, page, &bars, x, y, width, height,
+                                 string, colour);
+        break;
+    case PDF_BARCODE_EAN8:
+        e = pdf_add_barcode_ean8(pdf, page, &bars, x, y, width, height,
+                                 string, colour);
+        break;
+    case PDF_BARCODE_UPCE:
+        e = pdf_add_barcode_upce(pdf, page, &bars, x, y, width, height,
+                                 string, colour);
+        break;
+    default:
+        e = pdf_set_err(pdf, -EINVAL, "Invalid barcode code %d", code);
+        break;
+    }
+
+    if (e >= 0) {
+        if (dstr_append(&bars, "f") < 0)
+            e = pdf_set_err(pdf, -ENOMEM, "Unable to allocate barcode");
+        else
+            e = pdf_add_stream(pdf, page, dstr_data(&bars));
+    }
+    dstr_free(&bars);
+    return e;
+}
+
+/**
+ * Incremental builder for 8-bit raw image XObjects.
+ * Rows are supplied top to bottom. When the document has compression
+ * enabled, each row is PNG filtered and fed directly to the compressor,
+ * so an uncompressed copy of the whole image is never held in memory.
+ */
+struct raw_image {
+    struct pdf_doc *pdf;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    size_t row_len;
+    uint32_t rows_added;
+    bool compress;
+    struct dstr data;  /* The whole image object, header included */
+    size_t length_pos; /* Where the compressed length goes in the header */
+    int length_width;  /* and the room left for it */
+    size_t data_start; /* Where the compressed data starts */
+    uint8_t *prev;     /* Previous unfiltered row, for the predictors */
+    uint8_t *filtered; /* Filter type byte followed by the filtered row */
+};
+
+static int raw_image_begin(struct pdf_doc *pdf, struct raw_image *img,
+                           uint32_t width, uint32_t height,
+                           uint32_t channels)
+{
+    memset(img, 0, sizeof(*img));
+    img->pdf = pdf;
+    img->width = width;
+    img->height = height;
+    img->channels = channels;
+    img->row_len = (size_t)width * channels;
+    img->compress = pdf->compression > 0;
+    img->data = INIT_DSTR;
+
+    dstr_printf(&img->data,
+                "<<\r\n"
+                "  /Type /XObject\r\n"
+                "  /Name /Image%d\r\n"
+                "  /Subtype /Image\r\n"
+                "  /ColorSpace %s\r\n"
+                "  /Height %u\r\n"
+                "  /Width %u\r\n"
+                "  /BitsPerComponent 8\r\n",
+                flexarray_size(&pdf->objects),
+                channels == 1 ? "/DeviceGray" : "/DeviceRGB", height, width);
+
+    if (!img->compress) {
+        size_t len = img->row_len * height;
+
+        dstr_printf(&img->data,
+                    "  /Length %zu\r\n"
+                    ">>stream\r\n",
+                    len);
+        len += dstr_len(&img->data) + 16;
+        if (dstr_ensure(&img->data, len) < 0) {
+            dstr_free(&img->data);
+            return pdf_set_err(pdf, -ENOMEM,
+                               "Unable to allocate %zu bytes memory for image",
+                               len);
+        }
+        return 0;
+    }
+
+    /* The data is compressed straight into the object, after its header.
+     * The compressed length isn't known yet, so room is left for it: the
+     * fixed Huffman codes take at most 9 bits for each byte. */
+    size_t bound = ((img->row_len + 1) * height * 9 + 7) / 8 + 64;
+
+    dstr_printf(&img->data,
+                "  /Filter /FlateDecode\r\n"
+                "  /DecodeParms << /Predictor 15 /Colors %u "
+                "/BitsPerComponent 8 /Columns %u >>\r\n"
+                "  /Length ",
+                channels, width);
+    img->length_pos = dstr_len(&img->data);
+    img->length_width = snprintf(NULL, 0, "%zu", bound);
+    dstr_append_data(&img->data, "                    ", img->length_width);
+    dstr_append(&img->data, "\r\n>>stream\r\n");
+    img->data_start = dstr_len(&img->data);
+
+    if (pdf_compress_begin(pdf, &img->data) < 0) {
+        dstr_free(&img->data);
+        return pdf->errval;
+    }
+    img->prev = (uint8_t *)calloc(1, img->row_len * 2 + 1);
+    if (!img->prev)
+        return pdf_set_err(pdf, -ENOMEM,
+                           "Unable to allocate memory for image rows");
+    img->filtered = img->prev + img->row_len;
+    return 0;
+}
+
+static inline uint8_t paeth_predictor(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+/**
+ * Apply PNG filter 'type' to 'row' (with 'prev' as the row above) into
+ * 'out', returning the sum of the absolute values of the output bytes
+ */
+static uint32_t png_filter_row(int type, const uint8_t *row,
+                               const uint8_t *prev, uint8_t *out, size_t len,
+                               uint32_t bpp)
+{
+    uint32_t sum = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        int a = i >= bpp ? row[i - bpp] : 0;
+        int b = prev[i];
+        int c = i >= bpp ? prev[i - bpp] : 0;
+        uint8_t v;
+
+        switch (type) {
+        case 1:
+            v = row[i] - a;
+            break;
+        case 2:
+            v = row[i] - b;
+            break;
+        case 3:
+            v = row[i] - ((a + b) >> 1);
+            break;
+        case 4:
+            v = row[i] - paeth_predictor(a, b, c);
+            break;
+        default:
+            v = row[i];
+            break;
+        }
+        if (out)
+            out[i] = v;
+        sum += v < 128 ? v : 256 - v;
+    }
+    return sum;
+}
+
+static int raw_image_add_row(struct raw_image *img, const uint8_t *row)
+{
+    if (img->rows_added >= img->height)
+        return pdf_set_err(img->pdf, -EINVAL, "Too many image rows");
+    img->rows_added++;
+
+    if (!img->compress) {
+        if (dstr_append_data(&img->data, row, img->row_len) < 0)
+            return pdf_set_err(img->pdf, -ENOMEM,
+                               "Unable to allocate memory for image");
+        return 0;
     }
 
-    text[0] = string[11];
-    x += eanupc_dimensions[0].quiet_right * x_width -
-         604.0f * font * 4.0f / 7.0f / (14.0f * 72.0f);
-    e = pdf_add_text(pdf, page, text, font * 4.0f / 7.0f, x, y, colour);
-    if (e < 0) {
-        pdf_set_font(pdf, save_font);
-        return e;
+    /* Pick the filter with the smallest output, as libpng does */
+    int best = 0;
+    uint32_t best_sum = UINT32_MAX;
+    for (int type = 0; type <= 4; type++) {
+        uint32_t sum = png_filter_row(type, row, img->prev, NULL,
+                                      img->row_len, img->channels);
+        if (sum < best_sum) {
+            best_sum = sum;
+            best = type;
+        }
     }
+    img->filtered[0] = best;
+    png_filter_row(best, row, img->prev, &img->filtered[1], img->row_len,
+                   img->channels);
+    memcpy(img->prev, row, img->row_len);
 
-    pdf_set_font(pdf, save_font);
+    int e = flate_write(img->pdf->flate, img->filtered, img->row_len + 1);
+    if (e < 0)
+        return pdf_set_err(img->pdf, e, "Unable to compress image");
     return 0;
 }
 
-int pdf_add_barcode(struct pdf_doc *pdf, struct pdf_object *page, int code,
-                    float x, float y, float width, float height,
-                    const char *string, uint32_t colour)
+static void raw_image_abort(struct raw_image *img)
 {
-    if (!string || !*string)
-        return 0;
-    switch (code) {
-    case PDF_BARCODE_128A:
-        return pdf_add_barcode_128a(pdf, page, x, y, width, height, string,
-                                    colour);
-    case PDF_BARCODE_39:
-        return pdf_add_barcode_39(pdf, page, x, y, width, height, string,
-                                  colour);
-    case PDF_BARCODE_EAN13:
-        return pdf_add_barcode_ean13(pdf, page, x, y, width, height, string,
-                                     colour);
-    case PDF_BARCODE_UPCA:
-        return pdf_add_barcode_upca(pdf, page, x, y, width, height, string,
-                                    colour);
-    case PDF_BARCODE_EAN8:
-        return pdf_add_barcode_ean8(pdf, page, x, y, width, height, string,
-                                    colour);
-    case PDF_BARCODE_UPCE:
-        return pdf_add_barcode_upce(pdf, page, x, y, width, height, string,
-                                    colour);
-    default:
-        return pdf_set_err(pdf, -EINVAL, "Invalid barcode code %d", code);
-    }
+    dstr_free(&img->data);
+    free(img->prev);
+    img->prev = NULL;
 }
 
-static pdf_object *pdf_add_raw_grayscale8(struct pdf_doc *pdf,
-                                          const uint8_t *data, uint32_t width,
-                                          uint32_t height)
+static struct pdf_object *raw_image_end(struct raw_image *img)
 {
+    struct pdf_doc *pdf = img->pdf;
     struct pdf_object *obj;
-    size_t len;
-    const char *endstream = ">\r\nendstream\r\n";
-    struct dstr str = INIT_DSTR;
-    size_t data_len = (size_t)width * (size_t)height;
-
-    dstr_printf(&str,
-                "<<\r\n"
-                "  /Type /XObject\r\n"
-                "  /Name /Image%d\r\n"
-                "  /Subtype /Image\r\n"
-                "  /ColorSpace /DeviceGray\r\n"
-                "  /Height %d\r\n"
-                "  /Width %d\r\n"
-                "  /BitsPerComponent 8\r\n"
-                "  /Length %zu\r\n"
-                ">>stream\r\n",
-                flexarray_size(&pdf->objects), height, width, data_len + 1);
 
-    len = dstr_len(&str) + data_len + strlen(endstream) + 1;
-    if (dstr_ensure(&str, len) < 0) {
-        dstr_free(&str);
-        pdf_set_err(pdf, -ENOMEM,
-                    "Unable to allocate %zu bytes memory for image", len);
+    if (img->rows_added != img->height) {
+        raw_image_abort(img);
+        pdf_set_err(pdf, -EINVAL, "Image is missing rows");
         return NULL;
     }
-    dstr_append_data(&str, data, data_len);
-    dstr_append(&str, endstream);
+
+    if (img->compress) {
+        int e = flate_finish(pdf->flate);
+        free(img->prev);
+        img->prev = NULL;
+        if (e < 0) {
+            dstr_free(&img->data);
+            pdf_set_err(pdf, e, "Unable to compress image");
+            return NULL;
+        }
+
+        char length[32];
+        size_t len = dstr_len(&img->data) - img->data_start;
+
+        if (snprintf(length, sizeof(length), "%-*zu", img->length_width,
+                     len) != img->length_width) {
+            dstr_free(&img->data);
+            pdf_set_err(pdf, -EINVAL, "Compressed image is too large");
+            return NULL;
+        }
+        memcpy(dstr_data(&img->data) + img->length_pos, length,
+               img->length_width);
+    }
+    dstr_append(&img->data, "\r\nendstream\r\n");
 
     obj = pdf_add_object(pdf, OBJ_image);
     if (!obj) {
-        dstr_free(&str);
+        dstr_free(&img->data);
+        return NULL;
+    }
+    if (dbuf_take_dstr(&obj->stream.stream, &img->data) < 0) {
+        pdf_set_err(pdf, -ENOMEM, "Unable to allocate memory for image");
         return NULL;
     }
-    obj->stream.stream = str;
 
     return obj;
 }
 
-static struct pdf_object *pdf_add_raw_rgb24(struct pdf_doc *pdf,
+static struct pdf_object *pdf_add_raw_image(struct pdf_doc *pdf,
                                             const uint8_t *data,
-                                            uint32_t width, uint32_t height)
+                                            uint32_t width, uint32_t height,
+                                            uint32_t channels)
 {
-    struct pdf_object *obj;
-    size_t len;
-    const char *endstream = ">\r\nendstream\r\n";
-    struct dstr str = INIT_DSTR;
-    size_t data_len = (size_t)width * (size_t)height * 3;
+    struct raw_image img;
+    size_t row_len = (size_t)width * channels;
 
-    dstr_printf(&str,
-                "<<\r\n"
-                "  /Type /XObject\r\n"
-                "  /Name /Image%d\r\n"
-                "  /Subtype /Image\r\n"
-                "  /ColorSpace /DeviceRGB\r\n"
-                "  /Height %d\r\n"
-                "  /Width %d\r\n"
-                "  /BitsPerComponent 8\r\n"
-                "  /Length %zu\r\n"
-                ">>stream\r\n",
-                flexarray_size(&pdf->objects), height, width, data_len + 1);
-
-    len = dstr_len(&str) + data_len + strlen(endstream) + 1;
-    if (dstr_ensure(&str, len) < 0) {
-        dstr_free(&str);
-        pdf_set_err(pdf, -ENOMEM,
-                    "Unable to allocate %zu bytes memory for image", len);
+    if (raw_image_begin(pdf, &img, width, height, channels) < 0)
         return NULL;
+    for (uint32_t row = 0; row < height; row++) {
+        if (raw_image_add_row(&img, &data[row * row_len]) < 0) {
+            raw_image_abort(&img);
+            return NULL;
+        }
     }
-    dstr_append_data(&str, data, data_len);
-    dstr_append(&str, endstream);
+    return raw_image_end(&img);
+}
 
-    obj = pdf_add_object(pdf, OBJ_image);
-    if (!obj) {
-        dstr_free(&str);
-        return NULL;
-    }
-    obj->stream.stream = str;
+static struct pdf_object *pdf_add_raw_grayscale8(struct pdf_doc *pdf,
+                                                 const uint8_t *data,
+                                                 uint32_t width,
+                                                 uint32_t height)
+{
+    return pdf_add_raw_image(pdf, data, width, height, 1);
+}
 
-    return obj;
+static struct pdf_object *pdf_add_raw_rgb24(struct pdf_doc *pdf,
+                                            const uint8_t *data,
+                                            uint32_t width, uint32_t height)
+{
+    return pdf_add_raw_image(pdf, data, width, height, 3);
 }
 
 static uint8_t *get_file(struct pdf_doc *pdf, const char *file_name,
@@ -3312,11 +8703,12 @@ static struct pdf_object *
 pdf_add_raw_jpeg_data(struct pdf_doc *pdf, const struct pdf_img_info *info,
                       const uint8_t *jpeg_data, size_t len)
 {
+    struct dstr str = INIT_DSTR;
     struct pdf_object *obj = pdf_add_object(pdf, OBJ_image);
     if (!obj)
         return NULL;
 
-    dstr_printf(&obj->stream.stream,
+    dstr_printf(&str,
                 "<<\r\n"
                 "  /Type /XObject\r\n"
                 "  /Name /Image%d\r\n"
@@ -3331,9 +8723,10 @@ pdf_add_raw_jpeg_data(struct pdf_doc *pdf, const struct pdf_img_info *info,
                 flexarray_size(&pdf->objects),
                 (info->jpeg.ncolours == 1) ? "/DeviceGray" : "/DeviceRGB",
                 info->width, info->height, len);
-    dstr_append_data(&obj->stream.stream, jpeg_data, len);
+    dstr_append_data(&str, jpeg_data, len);
 
-    dstr_printf(&obj->stream.stream, "\r\nendstream\r\n");
+    dstr_printf(&str, "\r\nendstream\r\n");
+    dbuf_take_dstr(&obj->stream.stream, &str);
 
     return obj;
 }
@@ -3378,6 +8771,44 @@ static int get_img_display_dimensions(struct pdf_doc *pdf, uint32_t img_width,
     return 0;
 }
 
+/**
+ * List an image or template in the resources of the page (or template)
+ * drawing it
+ */
+static int pdf_add_xobject(struct pdf_doc *pdf, struct pdf_object *page,
+                           struct pdf_object *xobject)
+{
+    struct objlist *list = page->type == OBJ_template ? &page->form.xobjects
+                                                      : &page->page.images;
+    struct pdf_object **latest = xobject->type == OBJ_template
+                                     ? &xobject->form.page
+                                     : &xobject->stream.page;
+
+    /* Images may be shared between pages, but only need listing once in
+     * each page's resources. Each image remembers the latest page it has
+     * been listed on, so the page's own list only needs searching when
+     * drawing on an earlier page than that */
+    if (!*latest || page->index > (*latest)->index) {
+        if (objlist_append(pdf, list, xobject) < 0)
+            return pdf_set_err(pdf, -ENOMEM,
+                               "Unable to add image to page resources");
+        *latest = page;
+    } else if (*latest != page) {
+        bool listed = false;
+
+        for (int i = 0; i < objlist_size(list); i++)
+            if (objlist_get(list, i) == xobject) {
+                listed = true;
+                break;
+            }
+        if (!listed && objlist_append(pdf, list, xobject) < 0)
+            return pdf_set_err(pdf, -ENOMEM,
+                               "Unable to add image to page resources");
+    }
+
+    return 0;
+}
+
 static int pdf_add_image(struct pdf_doc *pdf, struct pdf_object *page,
                          struct pdf_object *image, float x, float y,
                          float width, float height)
@@ -3386,20 +8817,20 @@ static int pdf_add_image(struct pdf_doc *pdf, struct pdf_object *page,
     struct dstr str = INIT_DSTR;
 
     if (!page)
-        page = pdf_find_last_object(pdf, OBJ_page);
-
-    if (!page)
-        return pdf_set_err(pdf, -EINVAL, "Invalid pdf page");
+        page = pdf_default_page(pdf);
 
     if (image->type != OBJ_image)
         return pdf_set_err(pdf, -EINVAL,
                            "adding an image, but wrong object type %d",
                            image->type);
 
-    if (image->stream.page != NULL)
-        return pdf_set_err(pdf, -EEXIST, "image already on a page");
+    ret = pdf_check_drawable(pdf, page);
+    if (ret < 0)
+        return ret;
 
-    image->stream.page = page;
+    ret = pdf_add_xobject(pdf, page, image);
+    if (ret < 0)
+        return ret;
 
     dstr_append(&str, "q ");
     dstr_printf(&str, "%f 0 0 %f %f %f cm ", width, height, x, y);
@@ -3411,6 +8842,80 @@ static int pdf_add_image(struct pdf_doc *pdf, struct pdf_object *page,
     return ret;
 }
 
+struct pdf_object *pdf_begin_template(struct pdf_doc *pdf, float width,
+                                      float height)
+{
+    struct pdf_object *obj;
+
+    if (pdf->current_template) {
+        pdf_set_err(pdf, -EINVAL, "A template is already being recorded");
+        return NULL;
+    }
+
+    obj = pdf_add_object(pdf, OBJ_template);
+    if (!obj)
+        return NULL;
+    obj->form.width = width;
+    obj->form.height = height;
+    pdf->current_template = obj;
+
+    return obj;
+}
+
+int pdf_end_template(struct pdf_doc *pdf)
+{
+    struct pdf_object *tmpl = pdf->current_template;
+    int e;
+
+    if (!tmpl)
+        return pdf_set_err(pdf, -EINVAL, "No template is being recorded");
+    pdf->current_template = NULL;
+
+    /* A streaming document which was flushed while the template was being
+     * recorded has gone past it, so it has to be written out now */
+    if (!pdf->stream || tmpl->index >= pdf->flushed_objects)
+        return 0;
+    e = pdf_flush_object(pdf, tmpl);
+    pdf_output_flush(pdf->stream);
+    if (e >= 0)
+        e = pdf_output_check(pdf, pdf->stream);
+    return e;
+}
+
+int pdf_place_template(struct pdf_doc *pdf, struct pdf_object *page,
+                       struct pdf_object *tmpl, float x, float y,
+                       float scale, float angle)
+{
+    int ret;
+    struct dstr str = INIT_DSTR;
+    float sin_angle = sinf(angle) * scale;
+    float cos_angle = cosf(angle) * scale;
+
+    if (!tmpl || tmpl->type != OBJ_template)
+        return pdf_set_err(pdf, -EINVAL, "Invalid template");
+
+    if (tmpl == pdf->current_template)
+        return pdf_set_err(pdf, -EINVAL, "Template is still being recorded");
+
+    if (!page)
+        page = pdf_default_page(pdf);
+
+    ret = pdf_check_drawable(pdf, page);
+    if (ret < 0)
+        return ret;
+
+    ret = pdf_add_xobject(pdf, page, tmpl);
+    if (ret < 0)
+        return ret;
+
+    dstr_printf(&str, "q %f %f %f %f %f %f cm /Form%d Do Q", cos_angle,
+                sin_angle, -sin_angle, cos_angle, x, y, tmpl->index);
+
+    ret = pdf_add_stream(pdf, page, dstr_data(&str));
+    dstr_free(&str);
+    return ret;
+}
+
 // Works like fgets, except it's for a fixed in-memory buffer of data
 static size_t dgets(const uint8_t *data, size_t *pos, size_t len, char *line,
                     size_t line_len)
@@ -3495,11 +9000,10 @@ static int parse_ppm_header(struct pdf_img_info *info, const uint8_t *data,
     return 0;
 }
 
-static int pdf_add_ppm_data(struct pdf_doc *pdf, struct pdf_object *page,
-                            float x, float y, float display_width,
-                            float display_height,
-                            const struct pdf_img_info *info,
-                            const uint8_t *ppm_data, size_t len)
+static struct pdf_object *pdf_add_ppm_data(struct pdf_doc *pdf,
+                                           const struct pdf_img_info *info,
+                                           const uint8_t *ppm_data,
+                                           size_t len)
 {
     char line[1024];
     // We start reading at the position delivered by parse_ppm_header,
@@ -3507,37 +9011,36 @@ static int pdf_add_ppm_data(struct pdf_doc *pdf, struct pdf_object *page,
     size_t pos = info->ppm.data_begin_pos;
 
     /* Skip over the byte-size line */
-    if (!dgets(ppm_data, &pos, len, line, sizeof(line) - 1))
-        return pdf_set_err(pdf, -EINVAL, "No byte-size line in PPM file");
+    if (!dgets(ppm_data, &pos, len, line, sizeof(line) - 1)) {
+        pdf_set_err(pdf, -EINVAL, "No byte-size line in PPM file");
+        return NULL;
+    }
 
     /* Try and limit the memory usage to sane images */
     if (info->width > MAX_IMAGE_WIDTH || info->height > MAX_IMAGE_HEIGHT) {
-        return pdf_set_err(pdf, -EINVAL,
-                           "Invalid width/height in PPM file: %ux%u",
-                           info->width, info->height);
+        pdf_set_err(pdf, -EINVAL, "Invalid width/height in PPM file: %ux%u",
+                    info->width, info->height);
+        return NULL;
     }
 
     if (info->ppm.size > len - pos) {
-        return pdf_set_err(pdf, -EINVAL, "Insufficient image data available");
+        pdf_set_err(pdf, -EINVAL, "Insufficient image data available");
+        return NULL;
     }
 
     switch (info->ppm.color_space) {
     case PPM_BINARY_COLOR_GRAY:
-        return pdf_add_grayscale8(pdf, page, x, y, display_width,
-                                  display_height, &ppm_data[pos], info->width,
-                                  info->height);
-        break;
+        return pdf_add_raw_grayscale8(pdf, &ppm_data[pos], info->width,
+                                      info->height);
 
     case PPM_BINARY_COLOR_RGB:
-        return pdf_add_rgb24(pdf, page, x, y, display_width, display_height,
-                             &ppm_data[pos], info->width, info->height);
-        break;
+        return pdf_add_raw_rgb24(pdf, &ppm_data[pos], info->width,
+                                 info->height);
 
     default:
-        return pdf_set_err(pdf, -EINVAL,
-                           "Invalid color space in ppm file: %i",
-                           info->ppm.color_space);
-        break;
+        pdf_set_err(pdf, -EINVAL, "Invalid color space in ppm file: %i",
+                    info->ppm.color_space);
+        return NULL;
     }
 }
 
@@ -3574,24 +9077,6 @@ static int parse_jpeg_header(struct pdf_img_info *info, const uint8_t *data,
     return -EINVAL;
 }
 
-static int pdf_add_jpeg_data(struct pdf_doc *pdf, struct pdf_object *page,
-                             float x, float y, float display_width,
-                             float display_height, struct pdf_img_info *info,
-                             const uint8_t *jpeg_data, size_t len)
-{
-    struct pdf_object *obj;
-
-    obj = pdf_add_raw_jpeg_data(pdf, info, jpeg_data, len);
-    if (!obj)
-        return pdf->errval;
-
-    if (get_img_display_dimensions(pdf, info->width, info->height,
-                                   &display_width, &display_height)) {
-        return pdf->errval;
-    }
-    return pdf_add_image(pdf, page, obj, x, y, display_width, display_height);
-}
-
 int pdf_add_rgb24(struct pdf_doc *pdf, struct pdf_object *page, float x,
                   float y, float display_width, float display_height,
                   const uint8_t *data, uint32_t width, uint32_t height)
@@ -3678,14 +9163,13 @@ static int parse_png_header(struct pdf_img_info *info, const uint8_t *data,
     return -EINVAL;
 }
 
-static int pdf_add_png_data(struct pdf_doc *pdf, struct pdf_object *page,
-                            float x, float y, float display_width,
-                            float display_height,
-                            const struct pdf_img_info *img_info,
-                            const uint8_t *png_data, size_t png_data_length)
+static struct pdf_object *pdf_add_png_data(struct pdf_doc *pdf,
+                                           const struct pdf_img_info *img_info,
+                                           const uint8_t *png_data,
+                                           size_t png_data_length)
 {
-    // indicates if we return an error or add the img at the
-    // end of the function
+    // indicates if we return an error or the img at the end of the
+    // function
     bool success = false;
 
     // string stream used for writing color space (and palette) info
@@ -3906,12 +9390,7 @@ static int pdf_add_png_data(struct pdf_doc *pdf, struct pdf_object *page,
         goto free_buffers;
     }
 
-    dstr_append_data(&obj->stream.stream, final_data, written);
-
-    if (get_img_display_dimensions(pdf, header->width, header->height,
-                                   &display_width, &display_height)) {
-        goto free_buffers;
-    }
+    dbuf_append_data(&obj->stream.stream, final_data, written);
     success = true;
 
 free_buffers:
@@ -3923,11 +9402,7 @@ free_buffers:
         free(png_data_temp);
     dstr_free(&colour_space);
 
-    if (success)
-        return pdf_add_image(pdf, page, obj, x, y, display_width,
-                             display_height);
-    else
-        return pdf->errval;
+    return success ? obj : NULL;
 }
 
 static int parse_bmp_header(struct pdf_img_info *info, const uint8_t *data,
@@ -3960,108 +9435,94 @@ static int parse_bmp_header(struct pdf_img_info *info, const uint8_t *data,
     return 0;
 }
 
-static int pdf_add_bmp_data(struct pdf_doc *pdf, struct pdf_object *page,
-                            float x, float y, float display_width,
-                            float display_height,
-                            const struct pdf_img_info *info,
-                            const uint8_t *data, const size_t len)
+static struct pdf_object *pdf_add_bmp_data(struct pdf_doc *pdf,
+                                           const struct pdf_img_info *info,
+                                           const uint8_t *data,
+                                           const size_t len)
 {
     const struct bmp_header *header = &info->bmp;
-    uint8_t *bmp_data = NULL;
-    uint8_t row_padding;
+    struct raw_image img;
+    uint8_t *row;
     uint32_t bpp;
-    size_t data_len;
-    int retval;
+    size_t stride;
     const uint32_t width = info->width;
     const uint32_t height = info->height;
 
-    if (header->bfSize != len)
-        return pdf_set_err(pdf, -EINVAL,
-                           "BMP file seems to have wrong length");
-    if (header->biSize != 40)
-        return pdf_set_err(pdf, -EINVAL, "Wrong BMP header: biSize");
-    if (header->biCompression != 0)
-        return pdf_set_err(pdf, -EINVAL, "Wrong BMP compression value: %d",
-                           header->biCompression);
+    if (header->bfSize != len) {
+        pdf_set_err(pdf, -EINVAL, "BMP file seems to have wrong length");
+        return NULL;
+    }
+    if (header->biSize != 40) {
+        pdf_set_err(pdf, -EINVAL, "Wrong BMP header: biSize");
+        return NULL;
+    }
+    if (header->biCompression != 0) {
+        pdf_set_err(pdf, -EINVAL, "Wrong BMP compression value: %d",
+                    header->biCompression);
+        return NULL;
+    }
     if (header->biWidth > MAX_IMAGE_WIDTH || header->biWidth <= 0 ||
-        width > MAX_IMAGE_WIDTH || width == 0)
-        return pdf_set_err(pdf, -EINVAL, "BMP has invalid width: %d",
-                           header->biWidth);
+        width > MAX_IMAGE_WIDTH || width == 0) {
+        pdf_set_err(pdf, -EINVAL, "BMP has invalid width: %d",
+                    header->biWidth);
+        return NULL;
+    }
     if (header->biHeight > MAX_IMAGE_HEIGHT ||
         header->biHeight < -MAX_IMAGE_HEIGHT || header->biHeight == 0 ||
-        height > MAX_IMAGE_HEIGHT || height == 0)
-        return pdf_set_err(pdf, -EINVAL, "BMP has invalid height: %d",
-                           header->biHeight);
-    if (header->biBitCount != 24 && header->biBitCount != 32)
-        return pdf_set_err(pdf, -EINVAL, "Unsupported BMP bitdepth: %d",
-                           header->biBitCount);
+        height > MAX_IMAGE_HEIGHT || height == 0) {
+        pdf_set_err(pdf, -EINVAL, "BMP has invalid height: %d",
+                    header->biHeight);
+        return NULL;
+    }
+    if (header->biBitCount != 24 && header->biBitCount != 32) {
+        pdf_set_err(pdf, -EINVAL, "Unsupported BMP bitdepth: %d",
+                    header->biBitCount);
+        return NULL;
+    }
     bpp = header->biBitCount / 8;
     /* BMP rows are 4-bytes padded! */
-    row_padding = (width * bpp) & 3;
-    data_len = (size_t)width * (size_t)height * 3;
+    stride = ((size_t)width * bpp + 3) & ~(size_t)3;
 
-    if (header->bfOffBits >= len)
-        return pdf_set_err(pdf, -EINVAL, "Invalid BMP image offset");
+    if (header->bfOffBits >= len) {
+        pdf_set_err(pdf, -EINVAL, "Invalid BMP image offset");
+        return NULL;
+    }
 
-    if (len - header->bfOffBits <
-        (size_t)height * (width + row_padding) * bpp)
-        return pdf_set_err(pdf, -EINVAL, "Wrong BMP image size");
+    if (len - header->bfOffBits < (size_t)height * stride) {
+        pdf_set_err(pdf, -EINVAL, "Wrong BMP image size");
+        return NULL;
+    }
 
-    if (bpp == 3) {
-        /* 24 bits: change R and B colors */
-        bmp_data = (uint8_t *)malloc(data_len);
-        if (!bmp_data)
-            return pdf_set_err(pdf, -ENOMEM,
-                               "Insufficient memory for bitmap");
-        for (uint32_t pos = 0; pos < width * height; pos++) {
-            uint32_t src_pos =
-                header->bfOffBits + 3 * (pos + (pos / width) * row_padding);
-
-            bmp_data[pos * 3] = data[src_pos + 2];
-            bmp_data[pos * 3 + 1] = data[src_pos + 1];
-            bmp_data[pos * 3 + 2] = data[src_pos];
-        }
-    } else if (bpp == 4) {
-        /* 32 bits: change R and B colors, remove key color */
-        int offs = 0;
-        bmp_data = (uint8_t *)malloc(data_len);
-        if (!bmp_data)
-            return pdf_set_err(pdf, -ENOMEM,
-                               "Insufficient memory for bitmap");
+    row = (uint8_t *)malloc((size_t)width * 3);
+    if (!row) {
+        pdf_set_err(pdf, -ENOMEM, "Insufficient memory for bitmap");
+        return NULL;
+    }
 
-        for (uint32_t pos = 0; pos < width * height * 4; pos += 4) {
-            bmp_data[offs] = data[header->bfOffBits + pos + 2];
-            bmp_data[offs + 1] = data[header->bfOffBits + pos + 1];
-            bmp_data[offs + 2] = data[header->bfOffBits + pos];
-            offs += 3;
-        }
-    } else {
-        return pdf_set_err(pdf, -EINVAL, "Unsupported BMP bitdepth: %d",
-                           header->biBitCount);
-    }
-    if (header->biHeight >= 0) {
-        // BMP has vertically mirrored representation of lines, so swap them
-        uint8_t *line = (uint8_t *)malloc(width * 3);
-        if (!line) {
-            free(bmp_data);
-            return pdf_set_err(pdf, -ENOMEM,
-                               "Unable to allocate memory for bitmap mirror");
+    if (raw_image_begin(pdf, &img, width, height, 3) < 0) {
+        free(row);
+        return NULL;
+    }
+    for (uint32_t y_pos = 0; y_pos < height; y_pos++) {
+        /* Positive heights mean the rows are stored bottom-up */
+        uint32_t src_row = header->biHeight >= 0 ? height - y_pos - 1 : y_pos;
+        const uint8_t *src = &data[header->bfOffBits + src_row * stride];
+
+        /* Swap B & R, and drop the key colour from 32-bit images */
+        for (uint32_t x_pos = 0; x_pos < width; x_pos++, src += bpp) {
+            row[x_pos * 3] = src[2];
+            row[x_pos * 3 + 1] = src[1];
+            row[x_pos * 3 + 2] = src[0];
         }
-        for (uint32_t pos = 0; pos < (height / 2); pos++) {
-            memcpy(line, &bmp_data[pos * width * 3], width * 3);
-            memcpy(&bmp_data[pos * width * 3],
-                   &bmp_data[(height - pos - 1) * width * 3], width * 3);
-            memcpy(&bmp_data[(height - pos - 1) * width * 3], line,
-                   width * 3);
+        if (raw_image_add_row(&img, row) < 0) {
+            raw_image_abort(&img);
+            free(row);
+            return NULL;
         }
-        free(line);
     }
+    free(row);
 
-    retval = pdf_add_rgb24(pdf, page, x, y, display_width, display_height,
-                           bmp_data, width, height);
-    free(bmp_data);
-
-    return retval;
+    return raw_image_end(&img);
 }
 
 static int determine_image_format(const uint8_t *data, size_t length)
@@ -4109,9 +9570,102 @@ int pdf_parse_image_header(struct pdf_img_info *info, const uint8_t *data,
     }
 }
 
-int pdf_add_image_data(struct pdf_doc *pdf, struct pdf_object *page, float x,
-                       float y, float display_width, float display_height,
-                       const uint8_t *data, size_t len)
+/**
+ * Compute an image cache key over a block of data, followed by some
+ * extra distinguishing details (length, file times etc...)
+ */
+static void image_cache_key(uint64_t key[2], const void *data, size_t len,
+                            const void *extra, size_t extra_len)
+{
+    const uint8_t *d8 = (const uint8_t *)data;
+    uint64_t fnv = 0xcbf29ce484222325ULL; /* FNV-1a offset basis */
+
+    for (size_t i = 0; i < len; i++)
+        fnv = (fnv ^ d8[i]) * 0x100000001b3ULL;
+    d8 = (const uint8_t *)extra;
+    for (size_t i = 0; i < extra_len; i++)
+        fnv = (fnv ^ d8[i]) * 0x100000001b3ULL;
+
+    key[0] = hash(hash(5381, data, len), extra, extra_len);
+    key[1] = fnv;
+}
+
+static struct pdf_image_cache_entry *
+image_cache_slot(const struct pdf_doc *pdf, const uint64_t key[2])
+{
+    size_t mask = pdf->image_cache_size - 1;
+
+    for (size_t i = key[0] & mask;; i = (i + 1) & mask) {
+        struct pdf_image_cache_entry *entry = &pdf->image_cache[i];
+        if (!entry->image ||
+            (entry->key[0] == key[0] && entry->key[1] == key[1]))
+            return entry;
+    }
+}
+
+static struct pdf_object *image_cache_find(const struct pdf_doc *pdf,
+                                           const uint64_t key[2])
+{
+    if (!pdf->image_cache_size)
+        return NULL;
+    return image_cache_slot(pdf, key)->image;
+}
+
+static int image_cache_add(struct pdf_doc *pdf, const uint64_t key[2],
+                           struct pdf_object *image)
+{
+    struct pdf_image_cache_entry *entry;
+
+    /* Keep the table at most half full */
+    if ((pdf->image_cache_count + 1) * 2 > pdf->image_cache_size) {
+        struct pdf_image_cache_entry *old = pdf->image_cache;
+        size_t old_size = pdf->image_cache_size;
+        size_t new_size = old_size ? old_size * 2 : 64;
+
+        pdf->image_cache = (struct pdf_image_cache_entry *)calloc(
+            new_size, sizeof(*pdf->image_cache));
+        if (!pdf->image_cache) {
+            pdf->image_cache = old;
+            return pdf_set_err(pdf, -ENOMEM,
+                               "Unable to allocate image cache");
+        }
+        pdf->image_cache_size = new_size;
+        for (size_t i = 0; i < old_size; i++)
+            if (old[i].image)
+                *image_cache_slot(pdf, old[i].key) = old[i];
+        free(old);
+    }
+
+    entry = image_cache_slot(pdf, key);
+    if (!entry->image)
+        pdf->image_cache_count++;
+    entry->key[0] = key[0];
+    entry->key[1] = key[1];
+    entry->image = image;
+    return 0;
+}
+
+/**
+ * Place an image which has already been embedded in the document
+ */
+static int pdf_add_cached_image(struct pdf_doc *pdf, struct pdf_object *page,
+                                struct pdf_object *image, float x, float y,
+                                float display_width, float display_height)
+{
+    if (get_img_display_dimensions(pdf, image->stream.width,
+                                   image->stream.height, &display_width,
+                                   &display_height))
+        return pdf->errval;
+    return pdf_add_image(pdf, page, image, x, y, display_width,
+                         display_height);
+}
+
+static int pdf_add_image_data_cached(struct pdf_doc *pdf,
+                                     struct pdf_object *page, float x,
+                                     float y, float display_width,
+                                     float display_height,
+                                     const uint8_t *data, size_t len,
+                                     struct pdf_object **image)
 {
     struct pdf_img_info info = {
         .image_format = IMAGE_UNKNOWN,
@@ -4119,26 +9673,38 @@ int pdf_add_image_data(struct pdf_doc *pdf, struct pdf_object *page, float x,
         .height = 0,
         .jpeg = {0},
     };
+    struct pdf_object *obj;
+    uint64_t key[2];
+    int ret;
+
+    /* Identical image data is only ever embedded once */
+    image_cache_key(key, data, len, &len, sizeof(len));
+    obj = image_cache_find(pdf, key);
+    if (obj) {
+        *image = obj;
+        return pdf_add_cached_image(pdf, page, obj, x, y, display_width,
+                                    display_height);
+    }
 
-    int ret = pdf_parse_image_header(&info, data, len, pdf->errstr,
-                                     sizeof(pdf->errstr));
+    ret = pdf_parse_image_header(&info, data, len, pdf->errstr,
+                                 sizeof(pdf->errstr));
     if (ret)
         return ret;
 
     // Try and determine which image format it is based on the content
     switch (info.image_format) {
     case IMAGE_PNG:
-        return pdf_add_png_data(pdf, page, x, y, display_width,
-                                display_height, &info, data, len);
+        obj = pdf_add_png_data(pdf, &info, data, len);
+        break;
     case IMAGE_BMP:
-        return pdf_add_bmp_data(pdf, page, x, y, display_width,
-                                display_height, &info, data, len);
+        obj = pdf_add_bmp_data(pdf, &info, data, len);
+        break;
     case IMAGE_JPG:
-        return pdf_add_jpeg_data(pdf, page, x, y, display_width,
-                                 display_height, &info, data, len);
+        obj = pdf_add_raw_jpeg_data(pdf, &info, data, len);
+        break;
     case IMAGE_PPM:
-        return pdf_add_ppm_data(pdf, page, x, y, display_width,
-                                display_height, &info, data, len);
+        obj = pdf_add_ppm_data(pdf, &info, data, len);
+        break;
 
     // This case should be caught in parse_image_header, but is checked
     // here again for safety
@@ -4146,6 +9712,27 @@ int pdf_add_image_data(struct pdf_doc *pdf, struct pdf_object *page, float x,
     default:
         return pdf_set_err(pdf, -EINVAL, "Unable to determine image format");
     }
+    if (!obj)
+        return pdf->errval;
+
+    obj->stream.width = info.width;
+    obj->stream.height = info.height;
+    *image = obj;
+    ret = image_cache_add(pdf, key, obj);
+    if (ret < 0)
+        return ret;
+    return pdf_add_cached_image(pdf, page, obj, x, y, display_width,
+                                display_height);
+}
+
+int pdf_add_image_data(struct pdf_doc *pdf, struct pdf_object *page, float x,
+                       float y, float display_width, float display_height,
+                       const uint8_t *data, size_t len)
+{
+    struct pdf_object *image;
+
+    return pdf_add_image_data_cached(pdf, page, x, y, display_width,
+                                     display_height, data, len, &image);
 }
 
 int pdf_add_image_file(struct pdf_doc *pdf, struct pdf_object *page, float x,
@@ -4155,13 +9742,32 @@ int pdf_add_image_file(struct pdf_doc *pdf, struct pdf_object *page, float x,
     size_t len;
     uint8_t *data;
     int ret = 0;
+    struct stat buf;
+    struct pdf_object *image = NULL;
+    uint64_t key[2];
+    int64_t file_id[2] = {0, -1};
+
+    /* Avoid re-reading files that have already been embedded, as long as
+     * they haven't changed since */
+    if (stat(image_filename, &buf) == 0) {
+        file_id[0] = (int64_t)buf.st_mtime;
+        file_id[1] = (int64_t)buf.st_size;
+        image_cache_key(key, image_filename, strlen(image_filename),
+                        file_id, sizeof(file_id));
+        image = image_cache_find(pdf, key);
+        if (image)
+            return pdf_add_cached_image(pdf, page, image, x, y,
+                                        display_width, display_height);
+    }
 
     data = get_file(pdf, image_filename, &len);
     if (data == NULL)
         return pdf_get_errval(pdf);
 
-    ret = pdf_add_image_data(pdf, page, x, y, display_width, display_height,
-                             data, len);
+    ret = pdf_add_image_data_cached(pdf, page, x, y, display_width,
+                                    display_height, data, len, &image);
     free(data);
+    if (ret >= 0 && image && (int64_t)len == file_id[1])
+        ret = image_cache_add(pdf, key, image);
     return ret;
 }
@@ -25,9 +25,10 @@ extern "C" {
  * Note: All coordinates/sizes are in points (1/72 of an inch).
  * All coordinates are based on 0,0 being the bottom left of the page.
  * All colours are specified as a packed 32-bit value - see @ref PDF_RGB.
- * Text strings are interpreted as UTF-8 encoded, but only a small subset of
- * characters beyond 7-bit ascii are supported (see @ref pdf_add_text for
- * details).
+ * Text strings are interpreted as UTF-8 encoded. With the standard PDF fonts
+ * only a small subset of characters beyond 7-bit ascii are supported (see
+ * @ref pdf_add_text for details); fonts loaded with @ref pdf_add_font_file
+ * support any character they have a glyph for.
  *
  * @par PDF library example:
  * @code
@@ -53,6 +54,7 @@ pdf_destroy(pdf);
 
 struct pdf_doc;
 struct pdf_object;
+struct pdf_text_layout;
 
 /**
  * pdf_info describes the metadata to be inserted into the
@@ -201,6 +203,16 @@ struct pdf_path_operation {
     float y3; /*!< Y offset of the third point. Used with: c */
 };
 
+/**
+ * pdf_text_line describes one line of wrapped text.
+ * See pdf_get_text_wrap_lines.
+ */
+struct pdf_text_line {
+    size_t offset; /*!< Offset of the start of the line in the text (bytes) */
+    size_t length; /*!< Length of the line in the text (bytes) */
+    float width;   /*!< Width of the line (points) */
+};
+
 /**
  * Convert a value in inches into a number of points.
  * @param inch inches value to convert to points
@@ -302,6 +314,25 @@ struct pdf_doc *pdf_create(float width, float height,
  */
 void pdf_destroy(struct pdf_doc *pdf);
 
+/**
+ * Empty a document so that it can be used to generate another one, as
+ * though it had just been created with pdf_create.
+ * Memory allocated by the document is kept for re-use, so a loop which
+ * resets a single document, rather than creating & destroying one for
+ * each output, needs very few allocations once it's warmed up.
+ * Settings such as compression and kerning are kept.
+ * Objects from the previous contents (such as pages) must not be used
+ * again. Streaming documents can't be reset.
+ * @param pdf PDF document to reset
+ * @param width Width of new pages, in points
+ * @param height Height of new pages, in points
+ * @param info Optional information to be put into the PDF header
+ * @return < 0 on failure, >= 0 on success. On failure the document can
+ *         only be destroyed.
+ */
+int pdf_reset(struct pdf_doc *pdf, float width, float height,
+              const struct pdf_info *info);
+
 /**
  * Retrieve the error message if any operation fails
  * @param pdf pdf document to retrieve error message from
@@ -316,6 +347,29 @@ const char *pdf_get_err(const struct pdf_doc *pdf, int *errval);
  */
 void pdf_clear_err(struct pdf_doc *pdf);
 
+/**
+ * Enable FlateDecode compression of page content streams and raw
+ * (RGB/grayscale/PPM/BMP) images.
+ * Content streams are compressed when the document is saved, images as
+ * they are added. Compression is disabled by default.
+ * @param pdf PDF document to update
+ * @param level Compression level, 0 (disabled) to 9 (smallest output)
+ * @return < 0 on failure, 0 on success
+ */
+int pdf_set_compression(struct pdf_doc *pdf, int level);
+
+/**
+ * Enable kerning of text in the standard PDF fonts, using the kerning
+ * pairs from their Adobe font metrics. Text drawn, measured or wrapped
+ * after this call is kerned, so that its measured width matches what PDF
+ * viewers show. Kerning is disabled by default.
+ * Note: Text layouts keep the kerning they were created with
+ * @param pdf PDF document to update
+ * @param kerning Non-zero to enable kerning, 0 to disable it
+ * @return < 0 on failure, 0 on success
+ */
+int pdf_set_kerning(struct pdf_doc *pdf, int kerning);
+
 /**
  * Sets the font to use for text objects. Default value is Times-Roman if
  * this function is not called.
@@ -326,20 +380,71 @@ void pdf_clear_err(struct pdf_doc *pdf);
  *  Courier, Courier-Bold, Courier-BoldOblique, Courier-Oblique,
  *  Helvetica, Helvetica-Bold, Helvetica-BoldOblique, Helvetica-Oblique,
  *  Times-Roman, Times-Bold, Times-Italic, Times-BoldItalic,
- *  Symbol or ZapfDingbats
+ *  Symbol or ZapfDingbats, or the PostScript name of a font loaded with
+ *  @ref pdf_add_font_file
  * @return < 0 on failure, 0 on success
  */
 int pdf_set_font(struct pdf_doc *pdf, const char *font);
 
+/**
+ * Retrieve a handle for a font, adding it to the document if it hasn't been
+ * used yet. Handles can be passed to @ref pdf_set_font_handle, which avoids
+ * looking the font up by name each time it is selected.
+ * @param pdf PDF document to add the font to
+ * @param font Name of the font, as for @ref pdf_set_font
+ * @return < 0 on failure, font handle (> 0) on success
+ */
+int pdf_get_font_handle(struct pdf_doc *pdf, const char *font);
+
+/**
+ * Sets the font to use for text objects, from a handle returned by
+ * @ref pdf_get_font_handle
+ * @param pdf PDF document to update font on
+ * @param handle Font handle, from the same document
+ * @return < 0 on failure, 0 on success
+ */
+int pdf_set_font_handle(struct pdf_doc *pdf, int handle);
+
+/**
+ * Load a TrueType font file, to be embedded in the document.
+ * Only the glyphs that are drawn are embedded, and text in the font may use
+ * any Unicode character the font has a glyph for.
+ * The font can then be selected with @ref pdf_set_font_handle, or with
+ * @ref pdf_set_font using its PostScript name.
+ * Note: OpenType fonts with CFF (PostScript) outlines are not supported
+ * @param pdf PDF document to add the font to
+ * @param filename Filename of the TrueType (.ttf) font
+ * @return < 0 on failure, font handle (> 0) on success
+ */
+int pdf_add_font_file(struct pdf_doc *pdf, const char *filename);
+
+/**
+ * Load a TrueType font from memory, as for @ref pdf_add_font_file
+ * @param pdf PDF document to add the font to
+ * @param data TrueType font file contents (copied by this function)
+ * @param length Length of the font data, in bytes
+ * @return < 0 on failure, font handle (> 0) on success
+ */
+int pdf_add_font_data(struct pdf_doc *pdf, const void *data, size_t length);
+
+/**
+ * Free the parsed fonts that are no longer used by any document.
+ * Fonts loaded with @ref pdf_add_font_file or @ref pdf_add_font_data are
+ * parsed once and shared (thread-safely) by all documents in the process,
+ * and are kept for later documents even when no document is using them.
+ */
+void pdf_clear_font_cache(void);
+
 /**
  * Calculate the width of a given string in the current font
  * @param pdf PDF document
- * @param font_name Name of the font to get the width of.
- *  This must be one of the standard PDF fonts:
+ * @param font_name Name of the font to get the width of (NULL => current
+ *  font). This must be one of the standard PDF fonts:
  *  Courier, Courier-Bold, Courier-BoldOblique, Courier-Oblique,
  *  Helvetica, Helvetica-Bold, Helvetica-BoldOblique, Helvetica-Oblique,
  *  Times-Roman, Times-Bold, Times-Italic, Times-BoldItalic,
- *  Symbol or ZapfDingbats
+ *  Symbol or ZapfDingbats, or the PostScript name of a font loaded with
+ *  @ref pdf_add_font_file
  * @param text Text to determine width of
  * @param size Size of the text, in points
  * @param text_width area to store calculated width in
@@ -364,15 +469,17 @@ float pdf_width(const struct pdf_doc *pdf);
 
 /**
  * Retrieves page height
- * @param page Page object to get height of
- * @return height of page (in points)
+ * @param page Page object to get height of (or a template, for the height
+ *  of its bounding box)
+ * @return height of page (in points), or 0 for any other object
  */
 float pdf_page_height(const struct pdf_object *page);
 
 /**
  * Retrieves page width
- * @param page Page object to get width of
- * @return width of page (in points)
+ * @param page Page object to get width of (or a template, for the width
+ *  of its bounding box)
+ * @return width of page (in points), or 0 for any other object
  */
 float pdf_page_width(const struct pdf_object *page);
 
@@ -387,6 +494,7 @@ struct pdf_object *pdf_append_page(struct pdf_doc *pdf);
  * Retrieve a page by its number.
  *
  * Note: The page must have already been created via \ref pdf_append_page
+ * Pages are indexed, so this takes constant time.
  *
  * @param pdf PDF document to get page from
  * @param page_number Page number to retrieve, starting from 1.
@@ -394,6 +502,13 @@ struct pdf_object *pdf_append_page(struct pdf_doc *pdf);
  */
 struct pdf_object *pdf_get_page(struct pdf_doc *pdf, int page_number);
 
+/**
+ * Retrieve the number of pages in the document
+ * @param pdf PDF document to count the pages of
+ * @return Number of pages added via \ref pdf_append_page
+ */
+int pdf_page_count(const struct pdf_doc *pdf);
+
 /**
  * Adjust the width/height of a specific page
  * @param pdf PDF document that the page belongs to
@@ -421,6 +536,98 @@ int pdf_save(struct pdf_doc *pdf, const char *filename);
  */
 int pdf_save_file(struct pdf_doc *pdf, FILE *fp);
 
+/**
+ * Save the given pdf document to an already open file descriptor.
+ * Data is written directly with batched (vectored) writes, bypassing stdio
+ * @param pdf PDF document to save
+ * @param fd File descriptor to store the data into (must be writable)
+ * @return < 0 on failure, >= 0 on success
+ */
+int pdf_save_fd(struct pdf_doc *pdf, int fd);
+
+/**
+ * Callback used to write out PDF data, see @ref pdf_save_writer.
+ * Data is passed in reasonably sized chunks, in order.
+ * @param user User supplied context pointer
+ * @param data PDF data to write
+ * @param len Number of bytes in data
+ * @return < 0 on failure (typically a negative errno value), >= 0 on success
+ */
+typedef int (*pdf_writer_fn)(void *user, const void *data, size_t len);
+
+/**
+ * Save the given pdf document by passing it to a writer callback.
+ * This allows documents to be sent to sockets, compression layers etc...
+ * without going via a temporary file.
+ * @param pdf PDF document to save
+ * @param writer Callback to pass the data to. Saving stops at the first
+ *  error it returns, which is then also returned from here
+ * @param user Context pointer passed to the writer
+ * @return < 0 on failure, >= 0 on success
+ */
+int pdf_save_writer(struct pdf_doc *pdf, pdf_writer_fn writer, void *user);
+
+/**
+ * Save the given pdf document into a newly allocated memory buffer
+ * @param pdf PDF document to save
+ * @param data Pointer to store the buffer in. On success, this must be
+ *  released by the caller with free()
+ * @param len Pointer to store the length of the PDF data in (the buffer
+ *  is also nul-terminated, but the PDF data is binary)
+ * @return < 0 on failure, >= 0 on success
+ */
+int pdf_save_buffer(struct pdf_doc *pdf, char **data, size_t *len);
+
+/**
+ * Create a new streaming PDF object, with the given page width/height.
+ * Rather than holding the whole document in memory until it is saved,
+ * each page (with its content and images) is written to 'fp' and freed
+ * once the next page is appended, or pdf_flush is called. Pages which
+ * have been written can no longer be drawn on or resized, although they
+ * may still be the target of links & bookmarks.
+ * Streaming documents are completed with pdf_finish, not pdf_save.
+ * @param width Width of the page
+ * @param height Height of the page
+ * @param info Optional information to be put into the PDF header
+ * @param fp FILE pointer to write the document to. This must remain open
+ *  until pdf_finish has been called
+ * @return PDF document object, or NULL on failure
+ */
+struct pdf_doc *pdf_create_streaming(float width, float height,
+                                     const struct pdf_info *info, FILE *fp);
+
+/**
+ * Create a new streaming PDF object, as for @ref pdf_create_streaming,
+ * but passing the output to a writer callback rather than a FILE.
+ * @param width Width of the page
+ * @param height Height of the page
+ * @param info Optional information to be put into the PDF header
+ * @param writer Callback to pass the document data to. This is called
+ *  during pdf_append_page, pdf_flush & pdf_finish
+ * @param user Context pointer passed to the writer
+ * @return PDF document object, or NULL on failure
+ */
+struct pdf_doc *pdf_create_streaming_writer(float width, float height,
+                                            const struct pdf_info *info,
+                                            pdf_writer_fn writer, void *user);
+
+/**
+ * Write out all pages of a streaming document, including the current one.
+ * No further drawing is possible on those pages.
+ * @param pdf Streaming PDF document to flush
+ * @return < 0 on failure, >= 0 on success
+ */
+int pdf_flush(struct pdf_doc *pdf);
+
+/**
+ * Complete a streaming document, writing out the remaining objects,
+ * the cross-reference table & trailer. The output FILE is flushed, but
+ * not closed.
+ * @param pdf Streaming PDF document to complete
+ * @return < 0 on failure, >= 0 on success
+ */
+int pdf_finish(struct pdf_doc *pdf);
+
 /**
  * Add a text string to the document
  * @param pdf PDF document to add to
@@ -472,6 +679,88 @@ int pdf_add_text_wrap(struct pdf_doc *pdf, struct pdf_object *page,
                       float angle, uint32_t colour, float wrap_width,
                       int align, float *height);
 
+/**
+ * Work out where text will be broken into lines by pdf_add_text_wrap,
+ * without adding anything to the document. The text is measured in the
+ * current font.
+ * @param pdf PDF document to measure the text for
+ * @param text String to measure
+ * @param size Point size of the font
+ * @param wrap_width Width at which to wrap the text
+ * @param lines Store the details of each line here (optional)
+ * @param max_lines Maximum number of entries to store in lines
+ * @param height Store the final height of the wrapped text here (optional)
+ * @return < 0 on failure, otherwise the total number of lines, which may
+ * be more than max_lines
+ */
+int pdf_get_text_wrap_lines(struct pdf_doc *pdf, const char *text,
+                            float size, float wrap_width,
+                            struct pdf_text_line *lines, int max_lines,
+                            float *height);
+
+/**
+ * Break text into lines in the current font, ready to be drawn later with
+ * pdf_add_text_layout. This allows the size of the text to be known before
+ * deciding where to put it, without wrapping it a second time.
+ * @param pdf PDF document the text will be added to
+ * @param text String to lay out
+ * @param size Point size of the font
+ * @param wrap_width Width at which to wrap the text
+ * @return Text layout (free with pdf_destroy_text_layout), or NULL on
+ * failure
+ */
+struct pdf_text_layout *pdf_create_text_layout(struct pdf_doc *pdf,
+                                               const char *text, float size,
+                                               float wrap_width);
+
+/**
+ * Free a text layout
+ * @param layout Text layout to free (may be NULL)
+ */
+void pdf_destroy_text_layout(struct pdf_text_layout *layout);
+
+/**
+ * Retrieve the number of lines in a text layout
+ * @param layout Text layout to query
+ * @return Number of lines
+ */
+int pdf_text_layout_line_count(const struct pdf_text_layout *layout);
+
+/**
+ * Retrieve the height of a text layout
+ * @param layout Text layout to query
+ * @return Height of the text (in points)
+ */
+float pdf_text_layout_height(const struct pdf_text_layout *layout);
+
+/**
+ * Retrieve the details of one line of a text layout
+ * @param layout Text layout to query
+ * @param n Line to retrieve (0 = first line)
+ * @param line Store the details of the line here
+ * @return 0 on success, < 0 if there is no such line
+ */
+int pdf_text_layout_get_line(const struct pdf_text_layout *layout, int n,
+                             struct pdf_text_line *line);
+
+/**
+ * Add previously laid out text to the document. The text is drawn in the
+ * font it was laid out with, and gives the same result as
+ * pdf_add_text_wrap would have.
+ * @param pdf PDF document to add to (the one the layout was created for)
+ * @param page Page to add object to (NULL => most recently added page)
+ * @param layout Text layout to draw
+ * @param xoff X location to put it in
+ * @param yoff Y location to put it in
+ * @param angle Rotation angle of text (in radians)
+ * @param colour Colour to draw the text
+ * @param align Text alignment (see PDF_ALIGN_xxx)
+ * @return 0 on success, < 0 on failure
+ */
+int pdf_add_text_layout(struct pdf_doc *pdf, struct pdf_object *page,
+                        const struct pdf_text_layout *layout, float xoff,
+                        float yoff, float angle, uint32_t colour, int align);
+
 /**
  * Add a line to the document
  * @param pdf PDF document to add to
@@ -487,6 +776,25 @@ int pdf_add_text_wrap(struct pdf_doc *pdf, struct pdf_object *page,
 int pdf_add_line(struct pdf_doc *pdf, struct pdf_object *page, float x1,
                  float y1, float x2, float y2, float width, uint32_t colour);
 
+/**
+ * Add a set of lines to the document, all drawn with the same width and
+ * colour.
+ * This is equivalent to calling pdf_add_line for each line, but the lines
+ * are emitted as a single path, which is much cheaper for large numbers of
+ * lines (eg: grids & charts).
+ * @param pdf PDF document to add to
+ * @param page Page to add object to (NULL => most recently added page)
+ * @param points Array of 4 * count values, holding x1, y1, x2, y2 for
+ *  each line
+ * @param count Number of lines in the points array
+ * @param width Width of the lines
+ * @param colour Colour to draw the lines
+ * @return 0 on success, < 0 on failure
+ */
+int pdf_add_lines(struct pdf_doc *pdf, struct pdf_object *page,
+                  const float *points, int count, float width,
+                  uint32_t colour);
+
 /**
  * Add a cubic bezier curve to the document
  * @param pdf PDF document to add to
@@ -610,6 +918,27 @@ int pdf_add_filled_rectangle(struct pdf_doc *pdf, struct pdf_object *page,
                              float border_width, uint32_t colour_fill,
                              uint32_t colour_border);
 
+/**
+ * Add a set of rectangles to the document, all drawn with the same border
+ * and fill.
+ * The rectangles are emitted as a single path, so any border is stroked on
+ * top of all the fills.
+ * @param pdf PDF document to add to
+ * @param page Page to add object to (NULL => most recently added page)
+ * @param rects Array of 4 * count values, holding x, y, width, height for
+ *  each rectangle
+ * @param count Number of rectangles in the rects array
+ * @param border_width Width of rectangle borders (0 => no border, if the
+ *  rectangles are filled)
+ * @param colour Colour to draw the rectangle borders
+ * @param fill_colour Colour to fill the rectangles
+ *  (PDF_TRANSPARENT => outlines only)
+ * @return 0 on success, < 0 on failure
+ */
+int pdf_add_rectangles(struct pdf_doc *pdf, struct pdf_object *page,
+                       const float *rects, int count, float border_width,
+                       uint32_t colour, uint32_t fill_colour);
+
 /**
  * Add an outline polygon to the document
  * @param pdf PDF document to add to
@@ -708,6 +1037,8 @@ int pdf_add_barcode(struct pdf_doc *pdf, struct pdf_object *page, int code,
  * include the image but not render it visible.
  * Passing a negative number either the display height or width will
  * have the image be resized while keeping the original aspect ratio.
+ * Identical image data is only embedded once per document, and shared
+ * between every place it is drawn.
  * @param pdf PDF document to add image to
  * @param page Page to add image to (NULL => most recently added page)
  * @param x X offset to put image at
@@ -767,6 +1098,8 @@ int pdf_add_grayscale8(struct pdf_doc *pdf, struct pdf_object *page, float x,
  * Passing a negative number either the display height or width will
  * have the image be resized while keeping the original aspect ratio.
  * Supports image formats: JPEG, PNG, PPM, PGM & BMP
+ * Files which have already been added (and not modified since) are not
+ * re-read, and share the same embedded image.
  * @param pdf PDF document to add bookmark to
  * @param page Page to add image to (NULL => most recently added page)
  * @param x X offset to put image at
@@ -780,6 +1113,52 @@ int pdf_add_image_file(struct pdf_doc *pdf, struct pdf_object *page, float x,
                        float y, float display_width, float display_height,
                        const char *image_filename);
 
+/**
+ * Start recording a template: a block of drawing operations which is
+ * stored once in the document, and can then be placed on any number of
+ * pages (eg: a letterhead).
+ * Until @ref pdf_end_template is called, drawing operations given a NULL
+ * page are recorded into the template rather than drawn on the most
+ * recently added page. The template can also be passed as the page to
+ * draw on explicitly, while it is being recorded.
+ * Only one template can be recorded at a time.
+ * @param pdf PDF document to add the template to
+ * @param width Width of the template's bounding box
+ * @param height Height of the template's bounding box
+ * @return Template object on success, NULL on failure
+ */
+struct pdf_object *pdf_begin_template(struct pdf_doc *pdf, float width,
+                                      float height);
+
+/**
+ * Finish recording the current template. Once finished, it can be placed
+ * with @ref pdf_place_template, but no longer drawn on.
+ * In a streaming document, the template is written out by the next
+ * pdf_flush (or page append), or straight away if the document has been
+ * flushed since the template was started.
+ * @param pdf PDF document the template is being recorded in
+ * @return 0 on success, < 0 on failure
+ */
+int pdf_end_template(struct pdf_doc *pdf);
+
+/**
+ * Draw a previously recorded template on a page.
+ * The template's origin is placed at the given location, and its
+ * contents are scaled and rotated around that point.
+ * @param pdf PDF document to add the template to
+ * @param page Page to draw the template on (NULL => most recently added
+ *  page)
+ * @param tmpl Template to draw, from @ref pdf_begin_template
+ * @param x X offset to put the template at
+ * @param y Y offset to put the template at
+ * @param scale Scale factor to draw the template at (1 => unscaled)
+ * @param angle Rotation angle of the template (in radians)
+ * @return 0 on success, < 0 on failure
+ */
+int pdf_place_template(struct pdf_doc *pdf, struct pdf_object *page,
+                       struct pdf_object *tmpl, float x, float y,
+                       float scale, float angle);
+
 /**
  * Parse image data to determine the image type & metadata
  * @param info structure to hold the parsed metadata